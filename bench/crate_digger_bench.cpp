@@ -0,0 +1,474 @@
+/**
+ * @file crate_digger_bench.cpp
+ * @brief Benchmarks for Crate Digger (Google Benchmark)
+ *
+ * Exports of 1k/10k/100k tracks are generated once per run under the system
+ * temp directory with the synthetic export generator. ANLZ trees are capped
+ * at kAnlzTracks files so the 100k export stays a reasonable size.
+ *
+ * Track results over time with:
+ *   crate_digger_bench --benchmark_out=bench.json --benchmark_out_format=json
+ */
+
+#include "cratedigger/cratedigger.hpp"
+#include "cratedigger/rekordbox_anlz.hpp"
+#include "cratedigger/rekordbox_pdb.hpp"
+#include "synthetic_export.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace cratedigger;
+
+namespace {
+
+constexpr size_t kAnlzTracks = 2000;
+
+/// Spec for a benchmark export of the given size
+synthetic::ExportSpec bench_spec(size_t track_count) {
+    synthetic::ExportSpec spec;
+    spec.track_count = track_count;
+    spec.artist_count = std::max<size_t>(20, track_count / 10);
+    spec.album_count = std::max<size_t>(10, track_count / 8);
+    spec.genre_count = 32;
+    spec.playlist_count = 16;
+    spec.tag_count = 24;
+    spec.unicode_titles = true;
+    spec.anlz_track_limit = kAnlzTracks;
+    return spec;
+}
+
+/// Export written on first use for each size
+const std::filesystem::path& export_root(size_t track_count) {
+    static std::map<size_t, std::filesystem::path> roots;
+    auto it = roots.find(track_count);
+    if (it != roots.end()) return it->second;
+
+    auto dir = std::filesystem::temp_directory_path() /
+               ("crate_digger_bench_" + std::to_string(track_count));
+    std::filesystem::remove_all(dir);
+    if (!synthetic::write_export(dir, bench_spec(track_count))) {
+        throw std::runtime_error("Failed to write synthetic export");
+    }
+    return roots.emplace(track_count, dir).first->second;
+}
+
+/// Database opened once per size (for query benchmarks)
+const Database& shared_database(size_t track_count) {
+    static std::map<size_t, std::unique_ptr<Database>> databases;
+    auto& db = databases[track_count];
+    if (!db) {
+        auto result = Database::open(synthetic::pdb_path(export_root(track_count)));
+        if (!result) throw std::runtime_error(result.error().message);
+        db = std::make_unique<Database>(std::move(*result));
+    }
+    return *db;
+}
+
+void set_track_counters(benchmark::State& state, size_t tracks) {
+    state.counters["tracks"] = static_cast<double>(tracks);
+    state.counters["tracks_per_second"] = benchmark::Counter(
+        static_cast<double>(tracks), benchmark::Counter::kIsIterationInvariantRate);
+}
+
+// ============================================================================
+// Open / Index Build
+// ============================================================================
+
+void BM_Open(benchmark::State& state, IoMode io_mode, bool parallel) {
+    auto n = static_cast<size_t>(state.range(0));
+    auto path = synthetic::pdb_path(export_root(n));
+
+    DatabaseOptions options;
+    options.io_mode = io_mode;
+    options.parallel_indexing = parallel;
+    options.thread_count = parallel ? 0 : 1;
+
+    for (auto _ : state) {
+        auto db = Database::open(path, options);
+        if (!db) {
+            state.SkipWithError(db.error().message.c_str());
+            break;
+        }
+        benchmark::DoNotOptimize(db->track_count());
+    }
+    set_track_counters(state, n);
+}
+
+/// Warm open from an index snapshot (written by one untimed open first)
+void BM_OpenSnapshot(benchmark::State& state) {
+    auto n = static_cast<size_t>(state.range(0));
+    auto path = synthetic::pdb_path(export_root(n));
+
+    DatabaseOptions options;
+    options.io_mode = IoMode::MemoryMapped;
+    options.snapshot_dir = export_root(n) / "snapshots";
+    if (!Database::open(path, options)) {
+        state.SkipWithError("open failed");
+        return;
+    }
+
+    for (auto _ : state) {
+        auto db = Database::open(path, options);
+        if (!db) {
+            state.SkipWithError(db.error().message.c_str());
+            break;
+        }
+        benchmark::DoNotOptimize(db->track_count());
+    }
+    set_track_counters(state, n);
+}
+
+/// refresh() after rekordbox edited one track row in place
+void BM_RefreshOnePage(benchmark::State& state) {
+    auto n = static_cast<size_t>(state.range(0));
+    auto dir = export_root(n) / "refresh";
+    auto path = dir / "export.pdb";
+    std::filesystem::create_directories(dir);
+    std::filesystem::copy_file(synthetic::pdb_path(export_root(n)), path,
+                               std::filesystem::copy_options::overwrite_existing);
+
+    // Rating byte of the first track row
+    auto image = synthetic::build_pdb(bench_spec(n));
+    size_t rating_offset = 0;
+    {
+        auto pdb = RekordboxPdb::open(path);
+        if (!pdb) {
+            state.SkipWithError(pdb.error().message.c_str());
+            return;
+        }
+        for (const auto& table : pdb->tables()) {
+            if (table.type != PageType::Tracks) continue;
+            auto cursor = pdb->page_rows(table.first_page_index);
+            size_t row_base = 0;
+            if (cursor.next(row_base)) rating_offset = row_base + offsetof(RawTrackRow, rating);
+        }
+    }
+
+    auto db = Database::open(path);
+    if (!db || rating_offset == 0) {
+        state.SkipWithError("open failed");
+        return;
+    }
+
+    auto mtime = std::filesystem::last_write_time(path);
+    for (auto _ : state) {
+        state.PauseTiming();
+        image[rating_offset] ^= 1;
+        synthetic::write_file(path, image);
+        mtime += std::chrono::seconds(1);
+        std::filesystem::last_write_time(path, mtime);
+        state.ResumeTiming();
+
+        auto stats = db->refresh();
+        if (!stats || stats->pages_changed != 1) {
+            state.SkipWithError("refresh did not see the edit");
+            break;
+        }
+    }
+    set_track_counters(state, n);
+}
+
+/// Raw row scan of one table (the page-walking part of its indexer)
+void BM_ScanTable(benchmark::State& state, PageType type) {
+    auto n = static_cast<size_t>(state.range(0));
+    auto pdb = RekordboxPdb::open(synthetic::pdb_path(export_root(n)), false, IoMode::MemoryMapped);
+    if (!pdb) {
+        state.SkipWithError(pdb.error().message.c_str());
+        return;
+    }
+
+    size_t rows = 0;
+    for (auto _ : state) {
+        rows = 0;
+        for (const auto& table : pdb->tables()) {
+            if (table.type != type) continue;
+            uint32_t page_index = table.first_page_index;
+            while (true) {
+                auto cursor = pdb->page_rows(page_index);
+                if (!cursor.valid()) break;
+                size_t row_base = 0;
+                while (cursor.next(row_base)) {
+                    benchmark::DoNotOptimize(pdb->data_at(row_base, 4));
+                    ++rows;
+                }
+                if (page_index == table.last_page_index) break;
+                page_index = cursor.next_page_index();
+            }
+        }
+    }
+    state.counters["rows"] = static_cast<double>(rows);
+}
+
+// ============================================================================
+// ANLZ
+// ============================================================================
+
+void BM_ScanDirectory(benchmark::State& state, size_t threads, bool snapshot) {
+    auto n = static_cast<size_t>(state.range(0));
+    auto dir = synthetic::anlz_dir(export_root(n));
+    auto snapshot_dir = snapshot ? export_root(n) / "snapshots" : std::filesystem::path();
+    if (snapshot) {
+        CuePointManager warmup;
+        warmup.set_snapshot_dir(snapshot_dir);
+        warmup.scan_directory(dir);
+    }
+
+    for (auto _ : state) {
+        CuePointManager manager;
+        manager.set_thread_count(threads);
+        manager.set_snapshot_dir(snapshot_dir);
+        manager.scan_directory(dir);
+        benchmark::DoNotOptimize(manager.track_count());
+    }
+    state.counters["files"] = static_cast<double>(std::min(n, kAnlzTracks) * 2);
+}
+
+void BM_WaveformDecode(benchmark::State& state) {
+    auto spec = bench_spec(1000);
+    auto expected = synthetic::expected_export(spec);
+    auto path = std::filesystem::temp_directory_path() / "crate_digger_bench_waveform.EXT";
+    if (!synthetic::write_file(path, synthetic::build_anlz(spec, expected.tracks[0], true))) {
+        state.SkipWithError("Failed to write ANLZ file");
+        return;
+    }
+
+    for (auto _ : state) {
+        auto anlz = RekordboxAnlz::open(path, IoMode::MemoryMapped);
+        if (!anlz) {
+            state.SkipWithError(anlz.error().message.c_str());
+            break;
+        }
+        benchmark::DoNotOptimize(anlz->waveforms().has_any());
+    }
+}
+
+void BM_WaveformRender(benchmark::State& state) {
+    auto spec = bench_spec(1000);
+    auto expected = synthetic::expected_export(spec);
+    auto path = std::filesystem::temp_directory_path() / "crate_digger_bench_waveform.EXT";
+    if (!synthetic::write_file(path, synthetic::build_anlz(spec, expected.tracks[0], true))) {
+        state.SkipWithError("Failed to write ANLZ file");
+        return;
+    }
+    auto anlz = RekordboxAnlz::open(path, IoMode::MemoryMapped);
+    if (!anlz || !anlz->waveforms().detail) {
+        state.SkipWithError("No detail waveform");
+        return;
+    }
+
+    DecodedWaveform wave(*anlz->waveforms().detail);
+    WaveformColumns columns;
+    for (auto _ : state) {
+        wave.render_into(0, wave.size(), static_cast<size_t>(state.range(0)), columns);
+        benchmark::DoNotOptimize(columns.max_height.data());
+    }
+    state.counters["entries"] = static_cast<double>(wave.size());
+}
+
+/// Five minutes at 128 BPM with a tempo change every 32 beats, as on a live-played grid
+BeatGrid bench_beat_grid() {
+    BeatGrid grid;
+    double time = 0.0;
+    for (uint32_t i = 0; i < 640; ++i) {
+        uint16_t tempo = (i / 32) % 2 == 0 ? 12800 : 12810;
+        grid.beats.push_back({static_cast<uint16_t>(i % 4 + 1), tempo, static_cast<uint32_t>(time)});
+        time += 6000000.0 / tempo;
+    }
+    return grid;
+}
+
+/// Playhead positions of four decks sampled over the track
+std::vector<double> bench_playheads() {
+    std::vector<double> times;
+    for (size_t i = 0; i < 4096; ++i) times.push_back(static_cast<double>((i * 7919) % 300000));
+    return times;
+}
+
+void BM_BeatGridFindBeat(benchmark::State& state) {
+    auto grid = bench_beat_grid();
+    auto times = bench_playheads();
+    for (auto _ : state) {
+        size_t sum = 0;
+        for (double t : times) sum += grid.find_beat_at(static_cast<uint32_t>(t));
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * times.size()));
+}
+
+void BM_TempoTimesToBeats(benchmark::State& state) {
+    TempoMap tempo(bench_beat_grid());
+    auto times = bench_playheads();
+    if (state.range(0) != 0) std::sort(times.begin(), times.end());
+    std::vector<double> beats(times.size());
+    for (auto _ : state) {
+        tempo.times_to_beats(times.data(), times.size(), beats.data());
+        benchmark::DoNotOptimize(beats.data());
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * times.size()));
+}
+
+// ============================================================================
+// Queries
+// ============================================================================
+
+void BM_FindTracksByBpmRange(benchmark::State& state) {
+    const auto& db = shared_database(static_cast<size_t>(state.range(0)));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(db.find_tracks_by_bpm_range(120.0f, 130.0f));
+    }
+}
+
+void BM_FindTracksByYearRange(benchmark::State& state) {
+    const auto& db = shared_database(static_cast<size_t>(state.range(0)));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(db.find_tracks_by_year_range(2000, 2010));
+    }
+}
+
+void BM_FindTracksByArtist(benchmark::State& state) {
+    const auto& db = shared_database(static_cast<size_t>(state.range(0)));
+    int64_t artist = 1;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(db.find_tracks_by_artist(ArtistId{artist}));
+        artist = artist % 20 + 1;
+    }
+}
+
+void BM_FindArtistsByName(benchmark::State& state) {
+    const auto& db = shared_database(static_cast<size_t>(state.range(0)));
+    auto name = db.get_artist(ArtistId{7})->name;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(db.find_artists_by_name(name));
+    }
+}
+
+void BM_SearchTracks(benchmark::State& state, const char* query, bool prefix_only) {
+    const auto& db = shared_database(static_cast<size_t>(state.range(0)));
+    TextSearchOptions options;
+    options.prefix_only = prefix_only;
+    benchmark::DoNotOptimize(db.search_tracks("warm up"));  // Builds the index
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(db.search_tracks(query, options));
+    }
+}
+
+void BM_GetTrack(benchmark::State& state) {
+    auto n = static_cast<size_t>(state.range(0));
+    const auto& db = shared_database(n);
+    int64_t id = 1;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(db.get_track(TrackId{id}));
+        id = id % static_cast<int64_t>(n) + 1;
+    }
+}
+
+void BM_SimilarTracks(benchmark::State& state) {
+    auto n = static_cast<size_t>(state.range(0));
+    SimilarityIndex index(shared_database(n), false);
+    SimilarityQuery query;
+    query.limit = 20;
+    int64_t seed = 1;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(index.nearest(TrackId{seed}, query));
+        seed = seed % static_cast<int64_t>(n) + 1;
+    }
+    set_track_counters(state, n);
+}
+
+// ============================================================================
+// Bulk Extraction (what the Python get_all_* / *_column() calls wrap)
+// ============================================================================
+
+void BM_GetAllBpms(benchmark::State& state) {
+    const auto& db = shared_database(static_cast<size_t>(state.range(0)));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(db.get_all_bpms());
+    }
+}
+
+void BM_GetAllYears(benchmark::State& state) {
+    const auto& db = shared_database(static_cast<size_t>(state.range(0)));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(db.get_all_years());
+    }
+}
+
+void BM_TrackColumns(benchmark::State& state) {
+    const auto& db = shared_database(static_cast<size_t>(state.range(0)));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(db.track_columns().bpm_100x.data());
+    }
+}
+
+/// Register a benchmark at each export size
+void sizes(benchmark::internal::Benchmark* b) {
+    b->Arg(1000)->Arg(10000)->Arg(100000)->Unit(benchmark::kMicrosecond);
+}
+
+void register_benchmarks() {
+    benchmark::RegisterBenchmark("open/buffered", BM_Open, IoMode::Buffered, false)->Apply(sizes);
+    benchmark::RegisterBenchmark("open/mmap", BM_Open, IoMode::MemoryMapped, false)->Apply(sizes);
+    benchmark::RegisterBenchmark("open/mmap_parallel", BM_Open, IoMode::MemoryMapped, true)->Apply(sizes);
+    benchmark::RegisterBenchmark("open/snapshot", BM_OpenSnapshot)->Apply(sizes);
+    benchmark::RegisterBenchmark("open/refresh_one_page", BM_RefreshOnePage)->Apply(sizes);
+
+    const std::pair<const char*, PageType> tables[] = {
+        {"scan/tracks", PageType::Tracks},
+        {"scan/artists", PageType::Artists},
+        {"scan/albums", PageType::Albums},
+        {"scan/genres", PageType::Genres},
+        {"scan/playlist_entries", PageType::PlaylistEntries},
+    };
+    for (const auto& [name, type] : tables) {
+        benchmark::RegisterBenchmark(name, BM_ScanTable, type)->Apply(sizes);
+    }
+
+    benchmark::RegisterBenchmark("anlz/scan_directory", BM_ScanDirectory, size_t{1}, false)
+        ->Arg(1000)->Unit(benchmark::kMillisecond);
+    benchmark::RegisterBenchmark("anlz/scan_directory_parallel", BM_ScanDirectory, size_t{0}, false)
+        ->Arg(1000)->Unit(benchmark::kMillisecond);
+    benchmark::RegisterBenchmark("anlz/scan_directory_snapshot", BM_ScanDirectory, size_t{1}, true)
+        ->Arg(1000)->Unit(benchmark::kMillisecond);
+    benchmark::RegisterBenchmark("anlz/waveform_decode", BM_WaveformDecode)->Unit(benchmark::kMicrosecond);
+    benchmark::RegisterBenchmark("anlz/waveform_render", BM_WaveformRender)
+        ->Arg(400)->Arg(2000)->Unit(benchmark::kMicrosecond);
+    benchmark::RegisterBenchmark("anlz/beat_grid_find_beat", BM_BeatGridFindBeat)->Unit(benchmark::kMicrosecond);
+    benchmark::RegisterBenchmark("anlz/tempo_times_to_beats", BM_TempoTimesToBeats)
+        ->Arg(0)->Arg(1)->Unit(benchmark::kMicrosecond);  // 0 = unsorted, 1 = sorted
+
+    benchmark::RegisterBenchmark("query/bpm_range", BM_FindTracksByBpmRange)->Apply(sizes);
+    benchmark::RegisterBenchmark("query/year_range", BM_FindTracksByYearRange)->Apply(sizes);
+    benchmark::RegisterBenchmark("query/tracks_by_artist", BM_FindTracksByArtist)->Apply(sizes);
+    benchmark::RegisterBenchmark("query/artists_by_name", BM_FindArtistsByName)->Apply(sizes);
+    benchmark::RegisterBenchmark("query/get_track", BM_GetTrack)->Apply(sizes);
+    benchmark::RegisterBenchmark("query/search_autocomplete", BM_SearchTracks, "artist 01", true)->Apply(sizes);
+    benchmark::RegisterBenchmark("query/search_substring", BM_SearchTracks, "000123", false)->Apply(sizes);
+    benchmark::RegisterBenchmark("query/similar_top20", BM_SimilarTracks)->Apply(sizes);
+
+    benchmark::RegisterBenchmark("bulk/get_all_bpms", BM_GetAllBpms)->Apply(sizes);
+    benchmark::RegisterBenchmark("bulk/get_all_years", BM_GetAllYears)->Apply(sizes);
+    benchmark::RegisterBenchmark("bulk/track_columns", BM_TrackColumns)->Apply(sizes);
+}
+
+} // anonymous namespace
+
+int main(int argc, char** argv) {
+    Logger::instance().set_level(LogLevel::Warning);
+
+    register_benchmarks();
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) return 1;
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
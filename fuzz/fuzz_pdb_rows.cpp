@@ -0,0 +1,109 @@
+/**
+ * @file fuzz_pdb_rows.cpp
+ * @brief libFuzzer target for the PDB page walker, row decoders and indexers
+ *
+ * The input is parsed as a PDB image; every page's row cursor is walked and
+ * each present row is decoded with every table's RowFormat, so truncated
+ * rows, wild string offsets and bogus subtypes all reach the decoders.
+ * Strings that decode must lie inside the image (or the UTF-16 scratch).
+ * The image is then indexed as export.pdb and as exportExt.pdb, so the
+ * values the decoders produce (list positions, folder links) reach the
+ * code that builds indices from them.
+ *
+ *   cmake -S . -B build-fuzz -DCMAKE_CXX_COMPILER=clang++ -DCRATE_DIGGER_BUILD_FUZZERS=ON
+ *   cmake --build build-fuzz --target fuzz_pdb_rows
+ *   ./build-fuzz/fuzz_pdb_rows -max_len=65536 corpus/
+ */
+
+#include "cratedigger/logging.hpp"
+#include "cratedigger/rekordbox_pdb.hpp"
+#include "database_impl.hpp"
+#include "row_decoders.hpp"
+#include <cstdlib>
+
+using namespace cratedigger;
+
+namespace {
+
+/// Upper bound on pages walked per input, so huge page counts stay fast
+constexpr size_t kMaxPages = 256;
+
+/// String reader that checks every decoded view
+struct CheckedStrings {
+    const RekordboxPdb& pdb;
+    const uint8_t* begin;
+    const uint8_t* end;
+    std::string scratch;
+
+    void read(size_t offset, std::string_view& out) {
+        out = pdb.read_string_view(offset, scratch);
+        if (out.empty() || out.data() == scratch.data()) return;
+        const auto* first = reinterpret_cast<const uint8_t*>(out.data());
+        if (first < begin || first + out.size() > end) std::abort();
+    }
+
+    void read(size_t offset, std::string& out) { out = pdb.read_string(offset); }
+};
+
+template<auto Type>
+void decode_as(const detail::RowBytes& bytes, CheckedStrings& strings) {
+    typename detail::RowFormat<Type>::Row row{};
+    detail::decode_row<Type>(bytes, row, strings);
+}
+
+void decode_all(const detail::RowBytes& bytes, CheckedStrings& strings) {
+    decode_as<PageType::Tracks>(bytes, strings);
+    decode_as<PageType::Artists>(bytes, strings);
+    decode_as<PageType::Albums>(bytes, strings);
+    decode_as<PageType::Genres>(bytes, strings);
+    decode_as<PageType::Labels>(bytes, strings);
+    decode_as<PageType::Keys>(bytes, strings);
+    decode_as<PageType::Colors>(bytes, strings);
+    decode_as<PageType::Artwork>(bytes, strings);
+    decode_as<PageType::PlaylistTree>(bytes, strings);
+    decode_as<PageType::PlaylistEntries>(bytes, strings);
+    decode_as<PageType::HistoryPlaylists>(bytes, strings);
+    decode_as<PageType::HistoryEntries>(bytes, strings);
+    decode_as<PageTypeExt::Tags>(bytes, strings);
+    decode_as<PageTypeExt::TagTracks>(bytes, strings);
+}
+
+/// Build every index of the image the way Database::open does (single-threaded, no snapshot)
+void index_image(const uint8_t* data, size_t size, bool is_ext) {
+    auto pdb = RekordboxPdb::from_bytes(std::vector<uint8_t>(data, data + size), is_ext);
+    if (!pdb) return;
+    DatabaseOptions options;
+    DatabaseImpl impl(std::move(*pdb), "fuzz.pdb", options);
+    impl.build_indices();
+    impl.playlist_tree();
+    impl.tag_bitmaps();
+}
+
+} // anonymous namespace
+
+extern "C" int LLVMFuzzerInitialize(int*, char***) {
+    Logger::instance().set_level(LogLevel::Error);
+    Logger::instance().set_callback([](LogLevel, std::string_view) {});  // Corrupt pages log errors
+    return 0;
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    auto pdb = RekordboxPdb::from_bytes(std::vector<uint8_t>(data, data + size));
+    if (!pdb) return 0;
+
+    auto image = pdb->data_at(0, pdb->file_size());
+    CheckedStrings strings{*pdb, image.first, image.first + image.second, {}};
+
+    size_t pages = pdb->file_size() / pdb->page_size();
+    for (size_t page = 0; page < pages && page < kMaxPages; ++page) {
+        PageRowCursor cursor = pdb->page_rows(static_cast<uint32_t>(page));
+        size_t row_base = 0;
+        while (cursor.next(row_base)) {
+            decode_all(detail::row_bytes(*pdb, row_base), strings);
+        }
+    }
+
+    index_image(data, size, false);
+    index_image(data, size, true);
+    return 0;
+}
@@ -0,0 +1,55 @@
+#pragma once
+/**
+ * @file arrow_export.hpp
+ * @brief Columnar export of the track table to Arrow IPC
+ *
+ * Writes one row per track in ascending ID order, with artist, album,
+ * genre, key and label names joined in and, optionally, beat-grid and cue
+ * summaries from loaded ANLZ data. Rows are streamed in record batches of
+ * batch_rows, so memory stays bounded by one batch whatever the library
+ * size. No Arrow library is needed; the output opens directly in pyarrow,
+ * polars or DuckDB. The column layout is listed in IR_SCHEMA.md.
+ *
+ * Built when CRATE_DIGGER_BUILD_ARROW_EXPORT is on (CRATE_DIGGER_ARROW_EXPORT
+ * is then defined for consumers of the library).
+ */
+
+#include "database.hpp"
+#include <filesystem>
+#include <iosfwd>
+
+namespace cratedigger {
+
+/// Arrow IPC container
+enum class ArrowFormat : uint8_t {
+    File,   // Random-access file with footer (.arrow / Feather v2)
+    Stream  // Streaming format (pipes, sockets)
+};
+
+/// Options for export_tracks_arrow
+struct ArrowExportOptions {
+    ArrowFormat format{ArrowFormat::File};
+
+    /// Rows per record batch (0 is treated as 1)
+    size_t batch_rows{65536};
+
+    /// Append beat-grid and cue summary columns (zeros for tracks without ANLZ data)
+    bool include_analysis{true};
+};
+
+/// What export_tracks_arrow wrote
+struct ArrowExportStats {
+    size_t rows{0};
+    size_t batches{0};
+    uint64_t bytes{0};
+};
+
+/// Export every track of db to an Arrow IPC file at path
+[[nodiscard]] Result<ArrowExportStats> export_tracks_arrow(const Database& db, const std::filesystem::path& path,
+                                                           const ArrowExportOptions& options = {});
+
+/// Export every track of db to an output stream (binary)
+[[nodiscard]] Result<ArrowExportStats> export_tracks_arrow(const Database& db, std::ostream& out,
+                                                           const ArrowExportOptions& options = {});
+
+} // namespace cratedigger
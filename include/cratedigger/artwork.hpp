@@ -0,0 +1,125 @@
+#pragma once
+/**
+ * @file artwork.hpp
+ * @brief Cover art files resolved by ArtworkId, read in the background and cached
+ *
+ * The artwork table only stores a path inside the export. An ArtworkCache
+ * resolves it (and rekordbox's larger "_m" variant) against the export root,
+ * reads files on I/O worker threads and keeps the raw bytes (usually JPEG)
+ * in an LRU bounded by total size. Decoding is left to the caller.
+ *
+ *   ArtworkCache covers(db);
+ *   covers.prefetch_tracks(db.get_playlist_view(playlist));  // When the playlist opens
+ *   ...
+ *   if (auto jpeg = covers.peek(track.artwork_id)) draw(*jpeg);  // Never blocks
+ *   else draw_placeholder();                                     // on_loaded repaints later
+ */
+
+#include "types.hpp"
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace cratedigger {
+
+class Database;
+
+/// Which file of an artwork entry to read
+enum class ArtworkVariant : uint8_t {
+    Original = 0,  // The path stored in the artwork table
+    HighRes = 1,   // The "_m" file next to it (the original when there is none)
+};
+
+/// Raw file contents shared between the cache and its readers
+using ArtworkBytes = std::shared_ptr<const std::vector<uint8_t>>;
+
+/// Options for ArtworkCache
+struct ArtworkCacheOptions {
+    /// Upper bound on the bytes held by the LRU
+    size_t capacity_bytes{64u << 20};
+
+    /// I/O worker threads for prefetching (0 = one per hardware thread)
+    size_t thread_count{2};
+
+    /// Directory containing PIONEER/ (empty = Database::export_root())
+    std::filesystem::path export_root;
+
+    /// Called on a worker thread after a prefetched file is cached
+    std::function<void(ArtworkId, ArtworkVariant)> on_loaded;
+};
+
+/// Counters of an ArtworkCache
+struct ArtworkCacheStats {
+    uint64_t hits{0};           // get() / peek() answered from the cache
+    uint64_t misses{0};         // get() / peek() that found nothing cached
+    uint64_t files_read{0};
+    uint64_t files_missing{0};  // Unknown IDs and unreadable files (neither is cached)
+    uint64_t bytes_read{0};
+    uint64_t evictions{0};
+    size_t cached_items{0};
+    size_t cached_bytes{0};
+    size_t pending{0};          // Prefetches queued or being read
+};
+
+/**
+ * @brief Size-bounded cache of artwork files with background prefetch
+ *
+ * The cache pins a snapshot() of the database it was created from, so it
+ * keeps resolving the artwork rows it was built with after a refresh().
+ * All members are thread-safe. Destroying the cache drops queued prefetches
+ * and waits for files being read.
+ */
+class ArtworkCache {
+public:
+    explicit ArtworkCache(const Database& db, ArtworkCacheOptions options = {});
+
+    /// Destructor (stops the workers)
+    ~ArtworkCache();
+
+    /// Not copyable
+    ArtworkCache(const ArtworkCache&) = delete;
+    ArtworkCache& operator=(const ArtworkCache&) = delete;
+
+    /// File an artwork entry resolves to (empty for an unknown ID; HighRes is the "_m" path even if missing)
+    [[nodiscard]] std::filesystem::path path(ArtworkId id, ArtworkVariant variant = ArtworkVariant::Original) const;
+
+    /// Cached bytes, reading the file on this thread if needed (null if unknown or unreadable)
+    [[nodiscard]] ArtworkBytes get(ArtworkId id, ArtworkVariant variant = ArtworkVariant::Original);
+
+    /// Cached bytes only; never touches the disk (null if not cached yet)
+    [[nodiscard]] ArtworkBytes peek(ArtworkId id, ArtworkVariant variant = ArtworkVariant::Original) const;
+
+    /**
+     * @brief Queue files for the workers, in order
+     *
+     * Replaces the prefetches still queued (files already being read
+     * finish), so the latest scroll position or query wins. Cached entries
+     * and duplicates are skipped.
+     */
+    void prefetch(Span<const ArtworkId> ids, ArtworkVariant variant = ArtworkVariant::Original);
+
+    /// prefetch() the artwork of tracks, e.g. a playlist view or query result, in their order
+    void prefetch_tracks(Span<const TrackId> tracks, ArtworkVariant variant = ArtworkVariant::Original);
+
+    /// Drop the prefetches still queued
+    void cancel_prefetch();
+
+    /// Block until no prefetch is queued or being read
+    void wait_idle() const;
+
+    [[nodiscard]] ArtworkCacheStats stats() const;
+
+    /// Drop every cached file (counters are kept)
+    void clear();
+
+private:
+    struct State;
+
+    /// Body of an I/O worker
+    static void run_worker(State& state);
+
+    std::unique_ptr<State> state_;
+};
+
+} // namespace cratedigger
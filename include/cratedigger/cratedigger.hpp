@@ -19,8 +19,20 @@
 
 #include "types.hpp"
 #include "database.hpp"
+#include "database_set.hpp"
+#include "open_task.hpp"
+#include "waveform.hpp"
+#include "tempo_map.hpp"
+#include "track_bitmap.hpp"
+#include "tag_query.hpp"
+#include "similarity.hpp"
+#include "artwork.hpp"
 #include "api_schema.hpp"
 #include "logging.hpp"
+#include "metrics.hpp"
+#ifdef CRATE_DIGGER_ARROW_EXPORT
+#include "arrow_export.hpp"
+#endif
 
 namespace cratedigger {
 
@@ -12,6 +12,10 @@
 
 #include "types.hpp"
 #include "logging.hpp"
+#include "metrics.hpp"
+#include "rekordbox_anlz.hpp"
+#include "tag_query.hpp"
+#include "track_bitmap.hpp"
 #include <filesystem>
 #include <memory>
 #include <functional>
@@ -20,6 +24,10 @@ namespace cratedigger {
 
 // Forward declarations
 class DatabaseImpl;
+class DatabaseGeneration;
+class DatabaseSet;
+class StringPool;
+class CuePointManager;
 class RekordboxPdb;
 
 /**
@@ -31,6 +39,184 @@ class RekordboxPdb;
 template<typename RowType>
 using RowHandler = std::function<void(const RowType&)>;
 
+/**
+ * @brief Options controlling how a database is opened
+ *
+ * Memory-mapping gives a faster cold open and keeps RSS down to the pages
+ * actually touched, but a mapped file that disappears (e.g. a USB stick
+ * being unplugged) faults on access, so buffered reads stay the default.
+ */
+struct DatabaseOptions {
+    /// How export.pdb and ANLZ files are read
+    IoMode io_mode{IoMode::Buffered};
+
+    /// Worker threads for loading ANLZ directories and parallel indexing (0 = one per hardware thread)
+    size_t thread_count{1};
+
+    /// Index independent PDB tables concurrently on thread_count workers
+    bool parallel_indexing{false};
+
+    /**
+     * @brief Directory for index snapshots (empty = disabled)
+     *
+     * open() reuses a snapshot whose source size, mtime and content hash
+     * match the file being opened, and writes a fresh one after a full
+     * parse. load_cue_points() does the same for an ANLZ directory whose
+     * file list, sizes and mtimes are unchanged.
+     */
+    std::filesystem::path snapshot_dir;
+};
+
+/**
+ * @brief Per-track numeric columns (struct-of-arrays)
+ *
+ * Built once when the track table is indexed. Every column has one entry
+ * per track, in ascending track ID order, so index i of any column refers
+ * to track_id[i]. Missing foreign keys are 0.
+ */
+struct TrackColumns {
+    std::vector<int64_t> track_id;
+    std::vector<uint32_t> bpm_100x;
+    std::vector<uint32_t> duration;      // Seconds
+    std::vector<uint16_t> year;
+    std::vector<uint16_t> rating;
+    std::vector<uint32_t> bitrate;
+    std::vector<uint32_t> sample_rate;
+    std::vector<int64_t> key_id;
+    std::vector<int64_t> genre_id;
+    std::vector<int64_t> artist_id;
+    std::vector<uint16_t> play_count;
+
+    /// Number of rows (tracks)
+    [[nodiscard]] size_t size() const { return track_id.size(); }
+};
+
+/**
+ * @brief Playlist folder hierarchy flattened into node columns
+ *
+ * Built on first use from the playlist tree table. Nodes are laid out level
+ * by level in rekordbox sort order, so the children of node i are the
+ * contiguous range [first_child[i], first_child[i] + child_count[i]) and the
+ * top level is [0, root_count). Every column has one entry per node; names
+ * point into the Database.
+ */
+struct PlaylistTree {
+    static constexpr uint32_t kNoParent = 0xFFFFFFFFu;
+
+    std::vector<int64_t> id;              // PlaylistId of the folder or playlist
+    std::vector<uint32_t> parent;         // Node index of the parent folder (kNoParent at top level)
+    std::vector<uint32_t> first_child;
+    std::vector<uint32_t> child_count;
+    std::vector<uint32_t> depth;          // 0 at top level
+    std::vector<uint8_t> is_folder;
+    std::vector<uint32_t> track_count;    // Playlist entries (0 for folders)
+    std::vector<std::string_view> name;
+    std::vector<uint32_t> by_id;          // Node indices in ascending id order
+    uint32_t root_count{0};
+
+    /// Number of nodes
+    [[nodiscard]] size_t size() const { return id.size(); }
+
+    /// Node index of a folder or playlist (kNoParent if it is not in the tree)
+    [[nodiscard]] uint32_t find(PlaylistId playlist) const {
+        auto it = std::lower_bound(by_id.begin(), by_id.end(), playlist.value,
+                                   [this](uint32_t node, int64_t key) { return id[node] < key; });
+        return it != by_id.end() && id[*it] == playlist.value ? *it : kNoParent;
+    }
+};
+
+/**
+ * @brief Caller-provided columns for Database::materialize_playlist
+ *
+ * Set only the columns wanted; each must have room for capacity entries.
+ * Entries whose track is missing get id 0, a null row and empty strings.
+ * Names are joined through the track's foreign keys and point into the
+ * Database.
+ */
+struct PlaylistRowBuffers {
+    size_t capacity{0};
+    int64_t* track_id{nullptr};
+    const TrackRowView** track{nullptr};
+    uint32_t* bpm_100x{nullptr};
+    uint32_t* duration{nullptr};          // Seconds
+    uint16_t* rating{nullptr};
+    int64_t* key_id{nullptr};
+    std::string_view* title{nullptr};
+    std::string_view* artist{nullptr};
+    std::string_view* album{nullptr};
+    std::string_view* genre{nullptr};
+    std::string_view* key{nullptr};
+};
+
+/**
+ * @brief Combined track query (all set predicates must match)
+ *
+ * Unset fields do not constrain the result. Ranges are inclusive; a range
+ * with only one bound set is open on the other side.
+ */
+struct TrackQuery {
+    std::optional<float> min_bpm;
+    std::optional<float> max_bpm;
+    std::optional<KeyId> key;
+    std::optional<GenreId> genre;
+    std::optional<ArtistId> artist;
+    std::optional<uint16_t> min_rating;
+    std::optional<uint16_t> max_rating;
+    std::optional<uint16_t> min_year;
+    std::optional<uint16_t> max_year;
+    std::optional<uint32_t> min_duration;  // Seconds
+    std::optional<uint32_t> max_duration;  // Seconds
+};
+
+/// Track text fields covered by Database::search_tracks (bit flags)
+enum class TextField : uint8_t {
+    Title = 1 << 0,
+    Artist = 1 << 1,    // Primary artist name
+    Album = 1 << 2,     // Album name
+    FileName = 1 << 3,
+    FilePath = 1 << 4
+};
+
+/// Options for Database::search_tracks
+struct TextSearchOptions {
+    /// Maximum number of hits returned (0 = all)
+    size_t limit{50};
+
+    /// Bitmask of TextField values to search
+    uint8_t fields{0x1F};
+
+    /// Only match at the start of a word (autocomplete)
+    bool prefix_only{false};
+
+    /// Add trigram-similarity hits when fewer than limit exact hits are found
+    bool fuzzy{false};
+};
+
+/// One ranked result of Database::search_tracks
+struct TextSearchHit {
+    TrackId track_id;
+    TextField field{TextField::Title};  // Best-matching field
+    float score{0.0f};                  // Higher ranks first
+
+    bool operator==(const TextSearchHit& other) const {
+        return track_id == other.track_id && field == other.field && score == other.score;
+    }
+};
+
+/// What Database::refresh() found changed and re-indexed
+struct RefreshStats {
+    bool pdb_changed{false};        // Source size or mtime differed, so the file was reread
+    size_t pages_changed{0};        // Track pages that are new or differ from the previous file
+    size_t tracks_reparsed{0};      // Track rows parsed from changed pages
+    size_t tracks_reused{0};        // Track rows carried over from unchanged pages
+    size_t tables_reindexed{0};     // Other tables rebuilt because one of their pages changed
+    size_t anlz_files_changed{0};   // ANLZ files added, modified or removed since the last scan
+    size_t anlz_tracks_reloaded{0}; // Track analyses rebuilt (or dropped from the lazy cache)
+
+    /// Check whether anything was re-indexed
+    [[nodiscard]] bool changed() const { return pdb_changed || anlz_files_changed != 0 || anlz_tracks_reloaded != 0; }
+};
+
 /**
  * @brief Main database class for parsing rekordbox export.pdb files
  *
@@ -43,14 +229,32 @@ using RowHandler = std::function<void(const RowType&)>;
  *       auto& db = *result;
  *       auto track = db.get_track(TrackId{1});
  *   }
+ *
+ * Thread safety: everything a Database reads lives in an immutable
+ * generation. The const methods may be called from any number of threads
+ * at once without locking. The non-const methods (refresh() and the ANLZ
+ * loaders) build a new generation and publish it by swapping one pointer;
+ * they must not overlap other calls on the same object, except snapshot().
+ * Reader threads that run alongside a writer take a snapshot() and query
+ * that instead: it pins the generation it was taken from, and nothing a
+ * later refresh or load does can change it or free what it points to.
+ *
+ *   auto snap = db.snapshot();  // Per request, on any thread
+ *   auto hits = snap->find_tracks_by_bpm_range(120.0f, 130.0f);
  */
 class Database {
 public:
     /// Open a database file
-    [[nodiscard]] static Result<Database> open(const std::filesystem::path& path);
+    [[nodiscard]] static Result<Database> open(
+        const std::filesystem::path& path,
+        const DatabaseOptions& options = {}
+    );
 
     /// Open an exportExt.pdb file
-    [[nodiscard]] static Result<Database> open_ext(const std::filesystem::path& path);
+    [[nodiscard]] static Result<Database> open_ext(
+        const std::filesystem::path& path,
+        const DatabaseOptions& options = {}
+    );
 
     /// Move constructor
     Database(Database&& other) noexcept;
@@ -65,6 +269,17 @@ public:
     Database(const Database&) = delete;
     Database& operator=(const Database&) = delete;
 
+    /**
+     * @brief Pin the current generation as an immutable Database
+     *
+     * Safe to call while another thread runs refresh() or an ANLZ loader;
+     * the snapshot sees either the old or the new generation, never a mix.
+     * Its views and pointers stay valid for as long as it is alive. Lazily
+     * loaded ANLZ data can still be evicted from the shared lazy cache; the
+     * by-track ANLZ accessors share ownership of what they return for that.
+     */
+    [[nodiscard]] std::shared_ptr<const Database> snapshot() const;
+
     // ========================================================================
     // Primary Index Access (ID -> Row)
     // ========================================================================
@@ -93,6 +308,73 @@ public:
     /// Get artwork by ID
     [[nodiscard]] std::optional<ArtworkRow> get_artwork(ArtworkId id) const;
 
+    // ========================================================================
+    // Non-owning Row Access (strings valid until refresh() replaces the PDB)
+    // ========================================================================
+
+    /// Get a track without copying its strings (nullptr if not found)
+    [[nodiscard]] const TrackRowView* get_track_view(TrackId id) const;
+
+    /// Get an artist without copying its name (nullptr if not found)
+    [[nodiscard]] const ArtistRowView* get_artist_view(ArtistId id) const;
+
+    /// Get an album without copying its name (nullptr if not found)
+    [[nodiscard]] const AlbumRowView* get_album_view(AlbumId id) const;
+
+    /// Get a genre without copying its name (nullptr if not found)
+    [[nodiscard]] const GenreRowView* get_genre_view(GenreId id) const;
+
+    /// Get a label without copying its name (nullptr if not found)
+    [[nodiscard]] const LabelRowView* get_label_view(LabelId id) const;
+
+    /// Get a color without copying its name (nullptr if not found)
+    [[nodiscard]] const ColorRowView* get_color_view(ColorId id) const;
+
+    /// Get a musical key without copying its name (nullptr if not found)
+    [[nodiscard]] const KeyRowView* get_key_view(KeyId id) const;
+
+    /// Get artwork without copying its path (nullptr if not found)
+    [[nodiscard]] const ArtworkRowView* get_artwork_view(ArtworkId id) const;
+
+    /// Get the track at a position in ascending ID order (position < track_count())
+    [[nodiscard]] const TrackRowView& track_view_at(size_t position) const;
+
+    /// Call visitor(const TrackRowView&) for every track in ascending ID order (no allocation)
+    template<typename Visitor>
+    void for_each_track(Visitor&& visitor) const {
+        for (size_t i = 0, n = track_count(); i < n; ++i) {
+            visitor(track_view_at(i));
+        }
+    }
+
+    // ========================================================================
+    // Posting Views (no allocation; valid until refresh() replaces the PDB)
+    // ========================================================================
+
+    /// Tracks by title (case-insensitive), sorted by ID
+    [[nodiscard]] Span<const TrackId> find_tracks_by_title_view(std::string_view title) const;
+
+    /// Tracks by file name (case-insensitive), sorted by ID
+    [[nodiscard]] Span<const TrackId> find_tracks_by_filename_view(std::string_view filename) const;
+
+    /// Tracks by artist ID, sorted by ID
+    [[nodiscard]] Span<const TrackId> find_tracks_by_artist_view(ArtistId artist_id) const;
+
+    /// Tracks by album ID, sorted by ID
+    [[nodiscard]] Span<const TrackId> find_tracks_by_album_view(AlbumId album_id) const;
+
+    /// Tracks by genre ID, sorted by ID
+    [[nodiscard]] Span<const TrackId> find_tracks_by_genre_view(GenreId genre_id) const;
+
+    /// Tracks with a tag, sorted by ID
+    [[nodiscard]] Span<const TrackId> find_tracks_by_tag_view(TagId tag_id) const;
+
+    /// Tags of a track, sorted by ID
+    [[nodiscard]] Span<const TagId> find_tags_by_track_view(TrackId track_id) const;
+
+    /// Playlist entries in playlist order (empty if not found)
+    [[nodiscard]] Span<const TrackId> get_playlist_view(PlaylistId id) const;
+
     // ========================================================================
     // Secondary Index Access (Name/Key -> IDs)
     // ========================================================================
@@ -100,6 +382,9 @@ public:
     /// Find tracks by title (case-insensitive)
     [[nodiscard]] std::vector<TrackId> find_tracks_by_title(std::string_view title) const;
 
+    /// Find tracks by file name (case-insensitive; a full path is reduced to its last component)
+    [[nodiscard]] std::vector<TrackId> find_tracks_by_filename(std::string_view filename) const;
+
     /// Find tracks by artist ID
     [[nodiscard]] std::vector<TrackId> find_tracks_by_artist(ArtistId artist_id) const;
 
@@ -109,6 +394,21 @@ public:
     /// Find tracks by genre ID
     [[nodiscard]] std::vector<TrackId> find_tracks_by_genre(GenreId genre_id) const;
 
+    // ========================================================================
+    // Text Search
+    // ========================================================================
+
+    /**
+     * @brief Ranked substring search over track titles, artists, albums and paths
+     *
+     * Matching is case-insensitive (ASCII folding). A whole-field match ranks
+     * above a field prefix, a word prefix and then any substring; titles rank
+     * above the other fields. Queries shorter than three bytes only match at
+     * the start of a word. The index is built on the first call.
+     */
+    [[nodiscard]] std::vector<TextSearchHit> search_tracks(std::string_view query,
+                                                           const TextSearchOptions& options = {}) const;
+
     // ========================================================================
     // Range Search
     // ========================================================================
@@ -125,6 +425,9 @@ public:
     /// Find tracks by rating range (inclusive, 0-5)
     [[nodiscard]] std::vector<TrackId> find_tracks_by_rating_range(uint16_t min_rating, uint16_t max_rating) const;
 
+    /// Find tracks matching every predicate of a combined query (sorted by ID)
+    [[nodiscard]] std::vector<TrackId> find_tracks(const TrackQuery& query) const;
+
     /// Find tracks by year
     [[nodiscard]] std::vector<TrackId> find_tracks_by_year(uint16_t year) const;
 
@@ -168,6 +471,18 @@ public:
     /// Find history playlist by name
     [[nodiscard]] std::optional<PlaylistId> find_history_playlist_by_name(std::string_view name) const;
 
+    /// Flattened playlist hierarchy (built on first call, thread-safe)
+    [[nodiscard]] const PlaylistTree& playlist_tree() const;
+
+    /**
+     * @brief Join entries [offset, offset + out.capacity) of a playlist into out
+     *
+     * One pass over the entries with direct index lookups; nothing is
+     * allocated. Returns the number of entries written (0 past the end or
+     * for an unknown playlist).
+     */
+    size_t materialize_playlist(PlaylistId id, const PlaylistRowBuffers& out, size_t offset = 0) const;
+
     // ========================================================================
     // Tag Access (exportExt.pdb)
     // ========================================================================
@@ -190,6 +505,19 @@ public:
     /// Get tag count
     [[nodiscard]] size_t tag_count() const;
 
+    /**
+     * @brief Evaluate a tag query over per-tag track bitmaps
+     *
+     * NOT is relative to tracks: the tracks of that (export.pdb) database
+     * when given, else every track with at least one tag. With tracks given,
+     * the result is also limited to its tracks, dropping tag links to tracks
+     * it does not have. The bitmaps are built on first use.
+     */
+    [[nodiscard]] TrackBitmap find_tracks_by_tags(const TagQuery& query, const Database* tracks = nullptr) const;
+
+    /// Track rows of the IDs in a bitmap, in ascending ID order (IDs without a row are skipped)
+    [[nodiscard]] std::vector<const TrackRowView*> track_views(const TrackBitmap& ids) const;
+
     // ========================================================================
     // Tag Category Access (exportExt.pdb)
     // ========================================================================
@@ -216,11 +544,38 @@ public:
     // Cue Point Access (requires loading ANLZ files)
     // ========================================================================
 
-    /// Load cue points from an ANLZ directory
-    void load_cue_points(const std::filesystem::path& anlz_dir);
-
-    /// Load cue points from a single ANLZ file
-    void load_anlz_file(const std::filesystem::path& path);
+    /**
+     * @brief Load cue points from an ANLZ directory
+     *
+     * The ANLZ loaders publish a new generation like refresh() does: already
+     * loaded analyses are shared with it, and snapshots taken before keep
+     * seeing the data they had. Sections outside the mask (e.g. the detail
+     * waveforms of a cue-only scan) are skipped without being read.
+     */
+    void load_cue_points(const std::filesystem::path& anlz_dir, AnlzSections sections = AnlzSections::All);
+
+    /// Load cue points from a single ANLZ file (publishes a new generation)
+    void load_anlz_file(const std::filesystem::path& path, AnlzSections sections = AnlzSections::All);
+
+    /**
+     * @brief Load ANLZ data on demand instead of scanning the whole directory
+     *
+     * The *_for_track accessors then resolve each track's analyze_path on
+     * first access and keep the parsed result in an LRU cache of at most
+     * cache_capacity tracks. export_root is the directory containing PIONEER/;
+     * when empty it is derived from the export.pdb location.
+     *
+     * The results of the *_for_track accessors and get_cue_points_view()
+     * share ownership of the analysis they point into, so they stay valid
+     * after the track is evicted, whichever thread's lookup evicts it.
+     */
+    void enable_lazy_anlz_loading(size_t cache_capacity = 64, const std::filesystem::path& export_root = {});
+
+    /// Get all analysis data for a track (loading it on demand in lazy mode; valid for as long as it is held)
+    [[nodiscard]] std::shared_ptr<const TrackAnalysis> get_analysis_for_track(TrackId id) const;
+
+    /// Get number of tracks currently held in the lazy ANLZ cache
+    [[nodiscard]] size_t cached_analysis_count() const;
 
     /// Get cue points for a track by its file path
     [[nodiscard]] std::vector<CuePoint> get_cue_points(const std::string& track_path) const;
@@ -231,6 +586,14 @@ public:
     /// Get cue points by matching filename
     [[nodiscard]] std::vector<CuePoint> find_cue_points_by_filename(const std::string& filename) const;
 
+    /**
+     * @brief Get the raw cue points for a track without copying them
+     *
+     * The span holds the analysis it views, so it stays valid for as long
+     * as it is kept, including after a lazy cache eviction or a reload.
+     */
+    [[nodiscard]] PinnedSpan<const CuePointData> get_cue_points_view(TrackId id) const;
+
     /// Get number of tracks with loaded cue points
     [[nodiscard]] size_t cue_point_track_count() const;
 
@@ -241,8 +604,8 @@ public:
     /// Get beat grid for a track by its file path
     [[nodiscard]] const BeatGrid* get_beat_grid(const std::string& track_path) const;
 
-    /// Get beat grid for a track by ID (uses track's file_path)
-    [[nodiscard]] const BeatGrid* get_beat_grid_for_track(TrackId id) const;
+    /// Get beat grid for a track by ID (uses track's file_path; shares ownership of the track's analysis)
+    [[nodiscard]] std::shared_ptr<const BeatGrid> get_beat_grid_for_track(TrackId id) const;
 
     /// Get beat grid by matching filename
     [[nodiscard]] const BeatGrid* find_beat_grid_by_filename(const std::string& filename) const;
@@ -257,8 +620,8 @@ public:
     /// Get waveforms for a track by its file path
     [[nodiscard]] const TrackWaveforms* get_waveforms(const std::string& track_path) const;
 
-    /// Get waveforms for a track by ID (uses track's file_path)
-    [[nodiscard]] const TrackWaveforms* get_waveforms_for_track(TrackId id) const;
+    /// Get waveforms for a track by ID (uses track's file_path; shares ownership of the track's analysis)
+    [[nodiscard]] std::shared_ptr<const TrackWaveforms> get_waveforms_for_track(TrackId id) const;
 
     /// Get waveforms by matching filename
     [[nodiscard]] const TrackWaveforms* find_waveforms_by_filename(const std::string& filename) const;
@@ -273,8 +636,8 @@ public:
     /// Get song structure for a track by its file path
     [[nodiscard]] const SongStructure* get_song_structure(const std::string& track_path) const;
 
-    /// Get song structure for a track by ID (uses track's file_path)
-    [[nodiscard]] const SongStructure* get_song_structure_for_track(TrackId id) const;
+    /// Get song structure for a track by ID (uses track's file_path; shares ownership of the track's analysis)
+    [[nodiscard]] std::shared_ptr<const SongStructure> get_song_structure_for_track(TrackId id) const;
 
     /// Get song structure by matching filename
     [[nodiscard]] const SongStructure* find_song_structure_by_filename(const std::string& filename) const;
@@ -305,6 +668,9 @@ public:
     // Bulk Data Extraction (for NumPy/AI integration)
     // ========================================================================
 
+    /// Get the columnar track store (valid for the lifetime of the Database)
+    [[nodiscard]] const TrackColumns& track_columns() const;
+
     /// Get all track BPMs (for numpy.array)
     [[nodiscard]] std::vector<float> get_all_bpms() const;
 
@@ -342,6 +708,41 @@ public:
     /// Get playlist count
     [[nodiscard]] size_t playlist_count() const;
 
+    /**
+     * @brief Where open and ANLZ load time went
+     *
+     * Phase times and per-table scans of the current generation's open (or
+     * refresh), plus ANLZ counters accumulated since the database was opened.
+     */
+    [[nodiscard]] DatabaseMetrics metrics() const;
+
+    // ========================================================================
+    // Incremental Refresh
+    // ========================================================================
+
+    /**
+     * @brief Pick up changes rekordbox wrote to the export since it was opened
+     *
+     * If the PDB's size or mtime changed, the file is reread and compared
+     * page by page with the current one: rows on identical track pages are
+     * carried over, only new or modified pages are parsed, and other tables
+     * are rebuilt only when one of their pages changed. The result is built
+     * as a new index generation and published by swapping one pointer, so
+     * the Database never exposes a half-updated index. ANLZ directories
+     * loaded with load_cue_points() are re-listed and only tracks whose
+     * files were added, modified or removed (by size or mtime) are reparsed.
+     *
+     * Views and pointers obtained before a refresh that changed the PDB are
+     * invalidated by it, unless they came from a snapshot() that is still
+     * alive. On error the current generation stays in place.
+     * With IoMode::MemoryMapped an in-place rewrite also changes the old
+     * mapping, so a changed file is re-indexed in full.
+     */
+    [[nodiscard]] Result<RefreshStats> refresh();
+
+    /// Number of generations published since open (refreshes that changed anything and ANLZ loads)
+    [[nodiscard]] uint64_t generation() const;
+
     // ========================================================================
     // Source File
     // ========================================================================
@@ -349,11 +750,45 @@ public:
     /// Get the source file path
     [[nodiscard]] const std::filesystem::path& source_file() const;
 
+    /// Directory containing PIONEER/, derived from the source file location
+    [[nodiscard]] std::filesystem::path export_root() const;
+
+    /// Get the options the database was opened with
+    [[nodiscard]] const DatabaseOptions& options() const;
+
 private:
+    friend class DatabaseSet;
+    friend class OpenTask;
+
     /// Private constructor (use open/open_ext factory methods)
-    explicit Database(std::unique_ptr<DatabaseImpl> impl);
+    explicit Database(std::shared_ptr<const DatabaseGeneration> state);
+
+    /// Open with decoded strings interned into a pool shared with other databases (null = private pool)
+    [[nodiscard]] static Result<Database> open_pooled(const std::filesystem::path& path, bool is_ext,
+                                                      const DatabaseOptions& options,
+                                                      std::shared_ptr<StringPool> strings,
+                                                      const LoadObserver* observer = nullptr);
+
+    /// Empty ANLZ data set up with the options' I/O mode, threads and snapshot directory
+    [[nodiscard]] static std::shared_ptr<CuePointManager> make_anlz(const DatabaseOptions& options);
+
+    /// Publish a generation with anlz replacing the current ANLZ data
+    void adopt_anlz(std::shared_ptr<const CuePointManager> anlz);
+
+    /// PDB indices of the current generation
+    const DatabaseImpl& impl() const;
+
+    /// ANLZ data of the current generation
+    const CuePointManager& anlz() const;
+
+    /// Make next the current generation (atomic with respect to snapshot())
+    void publish(std::shared_ptr<const DatabaseGeneration> next);
+
+    /// Publish a generation with a changed copy of the ANLZ data
+    template<typename Change>
+    void change_anlz(Change&& change);
 
-    std::unique_ptr<DatabaseImpl> impl_;
+    std::shared_ptr<const DatabaseGeneration> state_;  // Current generation
 };
 
 } // namespace cratedigger
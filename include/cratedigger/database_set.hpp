@@ -0,0 +1,152 @@
+#pragma once
+/**
+ * @file database_set.hpp
+ * @brief Federation of several exports (e.g. USB sticks) queried as one
+ *
+ * A DatabaseSet opens its members in parallel under one thread budget and
+ * interns their decoded strings into one shared pool, so sticks carrying the
+ * same library store each UTF-16 title once. Global ISRC, title and file
+ * hash indices span all members; every result names the member it came from.
+ *
+ * Global indices are built once at open; members stay individually
+ * accessible (ANLZ loading, refresh), but a member refresh is not reflected
+ * in the global indices until the set is reopened.
+ */
+
+#include "database.hpp"
+#include <filesystem>
+#include <memory>
+#include <vector>
+
+namespace cratedigger {
+
+/// A track qualified by the set member it belongs to
+struct SourcedTrack {
+    uint32_t source{0};  // Member index in the DatabaseSet
+    TrackId track_id;
+
+    bool operator==(const SourcedTrack& other) const {
+        return source == other.source && track_id == other.track_id;
+    }
+    bool operator!=(const SourcedTrack& other) const { return !(*this == other); }
+    bool operator<(const SourcedTrack& other) const {
+        return source != other.source ? source < other.source : track_id < other.track_id;
+    }
+};
+
+/// Options for DatabaseSet::open
+struct DatabaseSetOptions {
+    /// Options for every member (thread_count is replaced by its share of the budget)
+    DatabaseOptions database;
+
+    /// Worker threads shared by all members (0 = one per hardware thread)
+    size_t thread_count{0};
+
+    /// Also load each member's PIONEER/USBANLZ directory
+    bool load_anlz{false};
+};
+
+/// An export that could not be opened
+struct DatabaseSetFailure {
+    std::filesystem::path path;
+    Error error;
+};
+
+/**
+ * @brief Several exports opened and indexed together
+ *
+ *   auto set = DatabaseSet::open({"/media/a/PIONEER/rekordbox/export.pdb",
+ *                                 "/media/b/PIONEER/rekordbox/export.pdb"});
+ *   for (auto hit : set->find_tracks_by_isrc("GBAYE0601498")) {
+ *       std::cout << set->source_path(hit.source) << ": " << hit.track_id.value << "\n";
+ *   }
+ */
+class DatabaseSet {
+public:
+    /**
+     * @brief Open every export in paths concurrently
+     *
+     * Exports that fail to open are skipped and listed in failures(); member
+     * indices follow the order of the exports that opened. Fails only if none
+     * of them could be opened.
+     */
+    [[nodiscard]] static Result<DatabaseSet> open(const std::vector<std::filesystem::path>& paths,
+                                                  const DatabaseSetOptions& options = {});
+
+    DatabaseSet(DatabaseSet&& other) noexcept;
+    DatabaseSet& operator=(DatabaseSet&& other) noexcept;
+    ~DatabaseSet();
+
+    DatabaseSet(const DatabaseSet&) = delete;
+    DatabaseSet& operator=(const DatabaseSet&) = delete;
+
+    // ========================================================================
+    // Members
+    // ========================================================================
+
+    /// Number of opened members
+    [[nodiscard]] size_t size() const;
+
+    /// Member database (source < size())
+    [[nodiscard]] const Database& member(uint32_t source) const;
+    [[nodiscard]] Database& member(uint32_t source);
+
+    /// export.pdb path of a member
+    [[nodiscard]] const std::filesystem::path& source_path(uint32_t source) const;
+
+    /// Exports that could not be opened
+    [[nodiscard]] const std::vector<DatabaseSetFailure>& failures() const;
+
+    /// Tracks across all members
+    [[nodiscard]] size_t track_count() const;
+
+    /// Distinct decoded strings held in the shared pool
+    [[nodiscard]] size_t shared_string_count() const;
+
+    // ========================================================================
+    // Global Indices
+    // ========================================================================
+
+    /// Tracks with an ISRC (case-insensitive), in (source, ID) order
+    [[nodiscard]] std::vector<SourcedTrack> find_tracks_by_isrc(std::string_view isrc) const;
+
+    /// Tracks with a title (case-insensitive), in (source, ID) order
+    [[nodiscard]] std::vector<SourcedTrack> find_tracks_by_title(std::string_view title) const;
+
+    /// Tracks whose audio file has this file_hash(), in (source, ID) order
+    [[nodiscard]] std::vector<SourcedTrack> find_tracks_by_file_hash(uint64_t hash) const;
+
+    /// Copies of a track's audio file on any member, itself included
+    [[nodiscard]] std::vector<SourcedTrack> find_copies(SourcedTrack track) const;
+
+    /**
+     * @brief Identity of a track's audio file
+     *
+     * Hash of the case-folded file name and the file size, so copies of one
+     * file on different sticks match without reading the audio. 0 for rows
+     * without a file name.
+     */
+    [[nodiscard]] static uint64_t file_hash(const TrackRowView& track);
+
+    // ========================================================================
+    // Merged Queries
+    // ========================================================================
+
+    /// Get a member's track without copying (nullptr if not found)
+    [[nodiscard]] const TrackRowView* get_track_view(SourcedTrack track) const;
+
+    /// Combined query on every member, in (source, ID) order
+    [[nodiscard]] std::vector<SourcedTrack> find_tracks(const TrackQuery& query) const;
+
+    /// BPM range query on every member, in (source, ID) order
+    [[nodiscard]] std::vector<SourcedTrack> find_tracks_by_bpm_range(float min_bpm, float max_bpm) const;
+
+private:
+    struct Impl;
+
+    explicit DatabaseSet(std::unique_ptr<Impl> impl);
+
+    std::unique_ptr<Impl> impl_;
+};
+
+} // namespace cratedigger
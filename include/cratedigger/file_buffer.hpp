@@ -0,0 +1,73 @@
+#pragma once
+/**
+ * @file file_buffer.hpp
+ * @brief Read-only file contents, either copied into memory or memory-mapped
+ *
+ * Both RekordboxPdb and RekordboxAnlz parse from a FileBuffer, so the same
+ * data_at()/read_string()/read_page() code runs against a heap copy or a
+ * zero-copy mapping (POSIX mmap / Windows file mapping).
+ */
+
+#include "types.hpp"
+#include <filesystem>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace cratedigger {
+
+/**
+ * @brief Immutable byte view of a file
+ *
+ * In IoMode::Buffered the file is read into an owned vector. In
+ * IoMode::MemoryMapped the file is mapped read-only and only the pages
+ * actually touched are faulted in. The buffer is move-only; moving keeps
+ * data() stable.
+ */
+class FileBuffer {
+public:
+    /// Open a file in the given I/O mode
+    [[nodiscard]] static Result<FileBuffer> open(const std::filesystem::path& path, IoMode mode);
+
+    /// Wrap bytes already in memory (used for in-memory parsing)
+    [[nodiscard]] static FileBuffer from_bytes(std::vector<uint8_t> bytes);
+
+    /// Create an empty buffer
+    FileBuffer() = default;
+
+    /// Move constructor
+    FileBuffer(FileBuffer&& other) noexcept;
+
+    /// Move assignment
+    FileBuffer& operator=(FileBuffer&& other) noexcept;
+
+    /// Destructor (unmaps the file if mapped)
+    ~FileBuffer();
+
+    /// Not copyable
+    FileBuffer(const FileBuffer&) = delete;
+    FileBuffer& operator=(const FileBuffer&) = delete;
+
+    /// Get pointer to the first byte (nullptr if empty)
+    [[nodiscard]] const uint8_t* data() const { return data_; }
+
+    /// Get size in bytes
+    [[nodiscard]] size_t size() const { return size_; }
+
+    /// Check if the buffer holds no bytes
+    [[nodiscard]] bool empty() const { return size_ == 0; }
+
+    /// Check if the buffer is a memory mapping
+    [[nodiscard]] bool is_mapped() const { return mapped_; }
+
+    /// Release the contents (unmaps or frees the copy)
+    void reset();
+
+private:
+    std::vector<uint8_t> owned_;
+    const uint8_t* data_{nullptr};
+    size_t size_{0};
+    bool mapped_{false};
+};
+
+} // namespace cratedigger
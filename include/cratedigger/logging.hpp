@@ -13,6 +13,7 @@
 #include <string>
 #include <string_view>
 #include <functional>
+#include <atomic>
 #include <mutex>
 #include <iostream>
 #include <sstream>
@@ -62,8 +63,12 @@ public:
 
     /// Set minimum log level
     void set_level(LogLevel level) {
-        std::lock_guard<std::mutex> lock(mutex_);
-        min_level_ = level;
+        min_level_.store(level, std::memory_order_relaxed);
+    }
+
+    /// Check whether messages at level are written (one relaxed load)
+    [[nodiscard]] bool enabled(LogLevel level) const {
+        return level >= min_level_.load(std::memory_order_relaxed);
     }
 
     /// Log with source location
@@ -95,15 +100,24 @@ private:
     Logger& operator=(const Logger&) = delete;
 
     LogCallback callback_;
-    LogLevel min_level_{LogLevel::Info};
+    std::atomic<LogLevel> min_level_{LogLevel::Info};
     std::mutex mutex_;
 };
 
+/// Log msg at level; below the active level msg is not evaluated, so no string is built
+#define CRATEDIGGER_LOG(level, msg) \
+    do { \
+        auto& cratedigger_logger_ = cratedigger::Logger::instance(); \
+        if (cratedigger_logger_.enabled(level)) { \
+            cratedigger_logger_.log(level, CRATEDIGGER_CURRENT_LOCATION(), msg); \
+        } \
+    } while (0)
+
 /// Convenience macros for logging (C++17)
-#define LOG_DEBUG(msg) cratedigger::Logger::instance().debug(msg, CRATEDIGGER_CURRENT_LOCATION())
-#define LOG_INFO(msg) cratedigger::Logger::instance().info(msg, CRATEDIGGER_CURRENT_LOCATION())
-#define LOG_WARN(msg) cratedigger::Logger::instance().warn(msg, CRATEDIGGER_CURRENT_LOCATION())
-#define LOG_ERROR(msg) cratedigger::Logger::instance().error(msg, CRATEDIGGER_CURRENT_LOCATION())
+#define LOG_DEBUG(msg) CRATEDIGGER_LOG(cratedigger::LogLevel::Debug, msg)
+#define LOG_INFO(msg) CRATEDIGGER_LOG(cratedigger::LogLevel::Info, msg)
+#define LOG_WARN(msg) CRATEDIGGER_LOG(cratedigger::LogLevel::Warning, msg)
+#define LOG_ERROR(msg) CRATEDIGGER_LOG(cratedigger::LogLevel::Error, msg)
 
 /// Create Error with source location (C++17)
 #define CRATEDIGGER_MAKE_ERROR(code, message) \
@@ -0,0 +1,76 @@
+#pragma once
+/**
+ * @file metrics.hpp
+ * @brief Where open and load time goes: per-phase and per-table counters
+ *
+ * Counters are gathered once per table scan, ANLZ file and cache lookup,
+ * never per row, so they are always on. Parse times are wall time summed
+ * over worker threads, so with parallel indexing they can exceed the
+ * phase times of the open itself.
+ *
+ *   auto metrics = db.metrics();
+ *   for (const auto& table : metrics.tables) {
+ *       std::cout << table.table << ": " << table.parse_ns / 1e6 << " ms\n";
+ *   }
+ *   std::cout << to_json(metrics) << "\n";
+ */
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace cratedigger {
+
+/// One PDB table as scanned while building the indices
+struct TableMetrics {
+    std::string table;      // e.g. "tracks", "tag_tracks"
+    uint64_t pages{0};      // Pages visited along the table's chain
+    uint64_t rows{0};       // Present rows handed to the parser
+    uint64_t bytes{0};      // pages * page size
+    uint64_t parse_ns{0};   // Scanning, decoding and indexing (summed over workers)
+};
+
+/// ANLZ loading, accumulated over every scan, single-file load and lazy lookup
+struct AnlzMetrics {
+    uint64_t files_parsed{0};     // Files opened and parsed
+    uint64_t files_failed{0};     // Files that could not be parsed
+    uint64_t bytes_read{0};       // RekordboxAnlz::bytes_read() summed over parsed files
+    uint64_t load_ns{0};          // Wall time of directory scans and file loads
+    uint64_t snapshot_hits{0};    // Directory scans restored from a snapshot
+    uint64_t snapshot_misses{0};  // Directory scans parsed (snapshots enabled)
+    uint64_t cache_hits{0};       // Lazy lookups answered from the LRU cache
+    uint64_t cache_misses{0};     // Lazy lookups that parsed files
+
+    /// Parsed files per second of load time (0 if nothing was timed)
+    [[nodiscard]] double files_per_second() const {
+        return load_ns != 0 ? static_cast<double>(files_parsed) * 1e9 / static_cast<double>(load_ns) : 0.0;
+    }
+
+    /// Fraction of lazy lookups served from the cache (0 without lookups)
+    [[nodiscard]] double cache_hit_rate() const {
+        uint64_t lookups = cache_hits + cache_misses;
+        return lookups != 0 ? static_cast<double>(cache_hits) / static_cast<double>(lookups) : 0.0;
+    }
+};
+
+/// Cost of opening a database and loading its analysis
+struct DatabaseMetrics {
+    uint64_t open_ns{0};              // Whole open, reading through indexing
+    uint64_t read_ns{0};              // Reading the file and its table directory
+    uint64_t index_ns{0};             // Building the indices (or restoring them)
+    uint64_t file_bytes{0};
+    uint64_t page_size{0};
+    bool snapshot_restored{false};    // Indices came from options.snapshot_dir
+    std::vector<TableMetrics> tables; // Tables in scan order (empty when restored)
+
+    // String pool (shared pools count the strings of every member)
+    uint64_t pooled_strings{0};       // Decoded strings copied into the pool
+    uint64_t pooled_string_bytes{0};
+
+    AnlzMetrics anlz;
+};
+
+/// Metrics as one JSON object
+[[nodiscard]] std::string to_json(const DatabaseMetrics& metrics);
+
+} // namespace cratedigger
@@ -0,0 +1,142 @@
+#pragma once
+/**
+ * @file open_task.hpp
+ * @brief Open a database and load its ANLZ directory in the background
+ *
+ * open_async() returns at once with an OpenTask handle. The PDB is read and
+ * indexed on one thread while the ANLZ directory is scanned on others, so a
+ * slow stick's file reads overlap the CPU-bound index build. Core metadata
+ * (tracks, artists, playlists, ...) can be queried as soon as the indices
+ * are built; the analysis data is published into the same database when the
+ * scan finishes. Both sides report progress and stop early on cancel().
+ *
+ *   AsyncOpenOptions options;
+ *   options.anlz_dir = root / "PIONEER/USBANLZ";
+ *   options.on_progress = [](const OpenProgress& p) { post_to_ui(p); };
+ *   auto task = open_async(root / "PIONEER/rekordbox/export.pdb", options);
+ *
+ *   if (auto meta = task.wait_metadata()) show_library(*meta);  // cues still loading
+ *   auto db = task.get();  // or task.cancel() when the user backs out
+ */
+
+#include "database.hpp"
+#include <chrono>
+#include <filesystem>
+#include <functional>
+#include <memory>
+
+namespace cratedigger {
+
+/// Stage an asynchronous open has reached
+enum class OpenPhase : uint8_t {
+    Reading = 0,      // Reading export.pdb and its table directory
+    Indexing = 1,     // Building the PDB indices
+    LoadingAnlz = 2,  // Indices ready (metadata() is set); the ANLZ scan is still running
+    Done = 3,         // get() returns the database
+    Failed = 4,       // get() returns the error (ErrorCode::Cancelled after cancel())
+};
+
+/// Snapshot of an asynchronous open's progress
+struct OpenProgress {
+    OpenPhase phase{OpenPhase::Reading};
+    size_t tables_done{0};       // PDB tables indexed
+    size_t tables_total{0};      // Known once indexing starts
+    size_t anlz_files_done{0};   // ANLZ files parsed (or restored from a snapshot)
+    size_t anlz_files_total{0};  // Known once the directory is listed
+
+    /// Check whether the open has finished, successfully or not
+    [[nodiscard]] bool finished() const { return phase == OpenPhase::Done || phase == OpenPhase::Failed; }
+};
+
+/// Options for open_async
+struct AsyncOpenOptions {
+    DatabaseOptions database;
+
+    /// Open an exportExt.pdb file instead of export.pdb
+    bool ext{false};
+
+    /// ANLZ directory to scan alongside indexing (empty = none)
+    std::filesystem::path anlz_dir;
+    AnlzSections sections{AnlzSections::All};
+
+    /**
+     * Called on every change of progress, one call at a time, from the loader
+     * threads. It may destroy or reassign its OpenTask (the open is then
+     * cancelled and the loader finishes detached) but must not wait on it.
+     */
+    std::function<void(const OpenProgress&)> on_progress;
+};
+
+/**
+ * @brief Handle to a database being opened in the background
+ *
+ * The handle is move-only. Destroying it cancels the open and waits for the
+ * loader threads; snapshots taken from metadata() stay valid regardless.
+ */
+class OpenTask {
+public:
+    /// Move constructor
+    OpenTask(OpenTask&& other) noexcept;
+
+    /// Move assignment (cancels and waits for the open this handle held)
+    OpenTask& operator=(OpenTask&& other) noexcept;
+
+    /// Destructor (cancels and waits)
+    ~OpenTask();
+
+    /// Not copyable
+    OpenTask(const OpenTask&) = delete;
+    OpenTask& operator=(const OpenTask&) = delete;
+
+    /// Ask the loaders to stop at the next table or file; get() then fails with ErrorCode::Cancelled
+    void cancel();
+
+    /// Current progress (safe from any thread)
+    [[nodiscard]] OpenProgress progress() const;
+
+    /// Check whether get() would return without blocking
+    [[nodiscard]] bool ready() const;
+
+    /// Wait up to timeout for the open to finish; true if it has
+    [[nodiscard]] bool wait_for(std::chrono::milliseconds timeout) const;
+
+    /// Block until the open has finished
+    void wait() const;
+
+    /// Core metadata once the indices are built (null before, and if reading or indexing failed)
+    [[nodiscard]] std::shared_ptr<const Database> metadata() const;
+
+    /// Block until the indices are built (or the open fails), then return metadata()
+    [[nodiscard]] std::shared_ptr<const Database> wait_metadata() const;
+
+    /**
+     * @brief Block until the open has finished and take the database
+     *
+     * Returns the database with the ANLZ data loaded, or the error that
+     * stopped the open. Can be called once; later calls return
+     * ErrorCode::InvalidParameter.
+     */
+    [[nodiscard]] Result<Database> get();
+
+private:
+    friend OpenTask open_async(const std::filesystem::path& path, const AsyncOpenOptions& options);
+
+    struct State;
+
+    explicit OpenTask(std::shared_ptr<State> state);
+
+    /// Body of the loader thread
+    static void run(State& state, std::filesystem::path path, AsyncOpenOptions options);
+
+    std::shared_ptr<State> state_;
+};
+
+/**
+ * @brief Start opening a database on background threads
+ *
+ * options.database.thread_count workers parse the ANLZ directory, next to
+ * the thread that reads and indexes the PDB.
+ */
+[[nodiscard]] OpenTask open_async(const std::filesystem::path& path, const AsyncOpenOptions& options = {});
+
+} // namespace cratedigger
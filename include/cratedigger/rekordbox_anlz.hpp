@@ -11,7 +11,15 @@
  */
 
 #include "types.hpp"
+#include "file_buffer.hpp"
+#include "metrics.hpp"
+#include <atomic>
 #include <filesystem>
+#include <deque>
+#include <memory>
+#include <set>
+#include <string_view>
+#include <unordered_map>
 #include <vector>
 #include <cstdint>
 
@@ -41,6 +49,37 @@ enum class AnlzSectionType : uint32_t {
     Unknown = 0
 };
 
+/**
+ * @brief Groups of ANLZ sections to parse (combine with |)
+ *
+ * Sections outside the mask are skipped by their tag header without
+ * reading their payload. The path section (PPTH) is always read, since it
+ * keys the parsed data to its track.
+ */
+enum class AnlzSections : uint32_t {
+    None = 0,
+    CuePoints = 1u << 0,         // PCUE/PCU2/PCX2
+    BeatGrid = 1u << 1,          // PBIT
+    WaveformPreviews = 1u << 2,  // PWAV/PWV2/PWV4/PWV6
+    WaveformDetails = 1u << 3,   // PWV3/PWV5/PWV7 (most of the bytes of .EXT/.2EX files)
+    SongStructure = 1u << 4,     // PSI2
+    Waveforms = WaveformPreviews | WaveformDetails,
+    All = CuePoints | BeatGrid | Waveforms | SongStructure
+};
+
+constexpr AnlzSections operator|(AnlzSections a, AnlzSections b) {
+    return static_cast<AnlzSections>(static_cast<uint32_t>(a) | static_cast<uint32_t>(b));
+}
+
+constexpr AnlzSections operator&(AnlzSections a, AnlzSections b) {
+    return static_cast<AnlzSections>(static_cast<uint32_t>(a) & static_cast<uint32_t>(b));
+}
+
+/// Check if a mask includes any section of a group
+constexpr bool has_sections(AnlzSections mask, AnlzSections group) {
+    return (mask & group) != AnlzSections::None;
+}
+
 // ============================================================================
 // Raw ANLZ Structures
 // ============================================================================
@@ -117,6 +156,20 @@ struct CuePointData {
     bool is_active{true};
 };
 
+/// All analysis data for one track, merged from its .DAT/.EXT/.2EX files
+struct TrackAnalysis {
+    std::vector<CuePointData> cue_points;
+    BeatGrid beat_grid;
+    TrackWaveforms waveforms;
+    SongStructure song_structure;
+
+    /// Check if nothing was found
+    [[nodiscard]] bool empty() const {
+        return cue_points.empty() && beat_grid.empty() &&
+               !waveforms.has_any() && song_structure.empty();
+    }
+};
+
 /// Raw beat grid entry from ANLZ file
 struct RawBeatEntry {
     uint16_t beat_number;      // Beat within bar (1-4)
@@ -136,8 +189,18 @@ struct RawBeatEntry {
  */
 class RekordboxAnlz {
 public:
-    /// Parse an ANLZ file
-    [[nodiscard]] static Result<RekordboxAnlz> open(const std::filesystem::path& path);
+    /**
+     * @brief Parse an ANLZ file
+     *
+     * Only the tag headers are walked: buffered mode reads each wanted
+     * section with a positioned read (memory stays bounded by the largest
+     * one), memory-mapped mode touches only the pages of wanted sections.
+     */
+    [[nodiscard]] static Result<RekordboxAnlz> open(
+        const std::filesystem::path& path,
+        IoMode io_mode = IoMode::Buffered,
+        AnlzSections sections = AnlzSections::All
+    );
 
     /// Move constructor
     RekordboxAnlz(RekordboxAnlz&& other) noexcept;
@@ -179,10 +242,16 @@ public:
     /// Check if song structure is present
     [[nodiscard]] bool has_song_structure() const { return !song_structure_.empty(); }
 
+    /// Bytes read from the file (or touched in the mapping) while parsing
+    [[nodiscard]] uint64_t bytes_read() const { return bytes_read_; }
+
+    /// Move the parsed data out (leaves this parser empty)
+    [[nodiscard]] TrackAnalysis release_analysis();
+
 private:
     RekordboxAnlz() = default;
 
-    void parse_sections();
+    void parse_section(uint32_t type, const uint8_t* data, size_t len);
     void parse_cue_list(const uint8_t* data, size_t len, bool is_extended);
     void parse_beat_grid(const uint8_t* data, size_t len);
     std::string parse_path_section(const uint8_t* data, size_t len);
@@ -193,12 +262,12 @@ private:
     void parse_waveform_3band(const uint8_t* data, size_t len, bool is_preview);
     void parse_song_structure(const uint8_t* data, size_t len);
 
-    std::vector<uint8_t> file_data_;
     std::vector<CuePointData> cue_points_;
     BeatGrid beat_grid_;
     TrackWaveforms waveforms_;
     SongStructure song_structure_;
     std::string track_path_;
+    uint64_t bytes_read_{0};
     bool is_valid_{false};
 };
 
@@ -206,76 +275,287 @@ private:
 // Cue Point Manager
 // ============================================================================
 
+struct SnapshotKey;
+
+/// What CuePointManager::refresh() reloaded
+struct AnlzRefreshStats {
+    size_t files_changed{0};    // ANLZ files added, modified or removed
+    size_t tracks_reloaded{0};  // Track records rebuilt, plus lazy cache entries dropped
+};
+
 /**
  * @brief Manages cue points and beat grids from ANLZ files
  *
  * Scans a directory for ANLZ files and builds an index of cue points
  * and beat grids associated with track file paths.
+ *
+ * The find_*_by_filename lookups first treat the argument as a file name
+ * (optionally with leading directories) and resolve it through an index of
+ * last path components. Only an argument that is not the last component of
+ * any loaded path falls back to a substring scan over every path.
  */
 class CuePointManager {
 public:
     /// Create a cue point manager
-    CuePointManager() = default;
+    CuePointManager();
+
+    /// Destructor
+    ~CuePointManager();
 
-    /// Scan a directory for ANLZ files
-    void scan_directory(const std::filesystem::path& anlz_dir);
+    /// Move constructor
+    CuePointManager(CuePointManager&& other) noexcept;
 
-    /// Load a single ANLZ file
-    void load_anlz_file(const std::filesystem::path& path);
+    /// Move assignment
+    CuePointManager& operator=(CuePointManager&& other) noexcept;
+
+    /**
+     * @brief Copy everything loaded, sharing the parsed analyses
+     *
+     * Analyses are shared until one copy changes a track, which then gets
+     * its own copy of that track only. The lazy cache is shared as well (it
+     * is internally synchronized and always reflects the files on disk).
+     */
+    CuePointManager(const CuePointManager& other);
+
+    /// Not copy-assignable
+    CuePointManager& operator=(const CuePointManager&) = delete;
+
+    /// Set how ANLZ files are read (buffered or memory-mapped)
+    void set_io_mode(IoMode mode) { io_mode_ = mode; }
+
+    /// Get how ANLZ files are read
+    [[nodiscard]] IoMode io_mode() const { return io_mode_; }
+
+    /// Set the number of worker threads used by scan_directory (0 = one per hardware thread)
+    void set_thread_count(size_t count) { thread_count_ = count; }
+
+    /// Get the number of worker threads used by scan_directory
+    [[nodiscard]] size_t thread_count() const { return thread_count_; }
+
+    /// Set a directory for snapshots of scanned ANLZ directories (empty = disabled)
+    void set_snapshot_dir(const std::filesystem::path& dir) { snapshot_dir_ = dir; }
+
+    /// Get the snapshot directory used by scan_directory
+    [[nodiscard]] const std::filesystem::path& snapshot_dir() const { return snapshot_dir_; }
+
+    /**
+     * @brief Scan a directory for ANLZ files
+     *
+     * Files are parsed on thread_count() workers into per-task partial
+     * indices, which are merged in directory order, so the result is the
+     * same as loading each file with load_anlz_file() in turn.
+     *
+     * With a snapshot_dir() set, a directory whose file names, sizes and
+     * mtimes match the last scan (with the same sections) is restored from
+     * its snapshot instead of being parsed again. Only the given sections
+     * are parsed, here and when refresh() reloads the directory.
+     *
+     * An observer is told the file count once the directory is listed and
+     * each file as it is parsed; cancelling it stops the workers and leaves
+     * the manager as it was.
+     */
+    void scan_directory(const std::filesystem::path& anlz_dir, AnlzSections sections = AnlzSections::All,
+                        const LoadObserver* observer = nullptr);
+
+    /// Load a single ANLZ file (only the given sections)
+    void load_anlz_file(const std::filesystem::path& path, AnlzSections sections = AnlzSections::All);
+
+    /**
+     * @brief Reload what changed in the directories passed to scan_directory()
+     *
+     * Each directory is listed again and compared with its last listing by
+     * file size and mtime. Every track with an added, modified or removed
+     * file is rebuilt from all of its current files in directory order, so
+     * the result matches a fresh scan of that directory. Lazily cached
+     * tracks whose files changed are dropped and reload on next access.
+     */
+    AnlzRefreshStats refresh();
+
+    /// Check whether refresh() would change anything (lists the scanned directories again)
+    [[nodiscard]] bool needs_refresh() const;
 
     /// Get cue points for a track by its file path
     [[nodiscard]] std::vector<CuePointData> get_cue_points(const std::string& track_path) const;
 
-    /// Get cue points for a track by partial path match
+    /// Get cue points for a track by file name or partial path
     [[nodiscard]] std::vector<CuePointData> find_cue_points_by_filename(const std::string& filename) const;
 
     /// Get beat grid for a track by its file path
     [[nodiscard]] const BeatGrid* get_beat_grid(const std::string& track_path) const;
 
-    /// Get beat grid for a track by partial path match
+    /// Get beat grid for a track by file name or partial path
     [[nodiscard]] const BeatGrid* find_beat_grid_by_filename(const std::string& filename) const;
 
     /// Get number of tracks with cue points
-    [[nodiscard]] size_t track_count() const { return cue_point_index_.size(); }
+    [[nodiscard]] size_t track_count() const { return cue_point_count_; }
 
     /// Get number of tracks with beat grids
-    [[nodiscard]] size_t beat_grid_count() const { return beat_grid_index_.size(); }
+    [[nodiscard]] size_t beat_grid_count() const { return beat_grid_count_; }
 
     /// Get waveforms for a track by its file path
     [[nodiscard]] const TrackWaveforms* get_waveforms(const std::string& track_path) const;
 
-    /// Get waveforms for a track by partial path match
+    /// Get waveforms for a track by file name or partial path
     [[nodiscard]] const TrackWaveforms* find_waveforms_by_filename(const std::string& filename) const;
 
     /// Get number of tracks with waveforms
-    [[nodiscard]] size_t waveform_count() const { return waveform_index_.size(); }
+    [[nodiscard]] size_t waveform_count() const { return waveform_count_; }
 
     /// Get song structure for a track by its file path
     [[nodiscard]] const SongStructure* get_song_structure(const std::string& track_path) const;
 
-    /// Get song structure for a track by partial path match
+    /// Get song structure for a track by file name or partial path
     [[nodiscard]] const SongStructure* find_song_structure_by_filename(const std::string& filename) const;
 
     /// Get number of tracks with song structure
-    [[nodiscard]] size_t song_structure_count() const { return song_structure_index_.size(); }
+    [[nodiscard]] size_t song_structure_count() const { return song_structure_count_; }
+
+    /**
+     * @brief Get everything loaded for a track path in one lookup (nullptr if none)
+     *
+     * The record stays valid until clear(), or until a later load or
+     * refresh() changes that track in this manager; copies made before
+     * keep the old record.
+     */
+    [[nodiscard]] const TrackAnalysis* get_analysis(std::string_view track_path) const;
+
+    /// Visit every loaded (track path, analysis) record in load order
+    template<typename Visitor>
+    void for_each_analysis(Visitor&& visitor) const {
+        for (const auto& record : records_) {
+            // Records emptied by refresh() keep their slot but are not loaded
+            if (!record.analysis || record.analysis->empty()) continue;
+            visitor(std::string_view(record.path), *record.analysis);
+        }
+    }
+
+    // ========================================================================
+    // Lazy Loading
+    // ========================================================================
+
+    /**
+     * @brief Load ANLZ files on demand instead of scanning a directory
+     *
+     * load_analysis() resolves an analyze_path (as stored in export.pdb)
+     * against export_root, parses the .DAT and any sibling .EXT/.2EX, and
+     * keeps the result in an LRU cache holding at most cache_capacity tracks.
+     */
+    void enable_lazy_loading(const std::filesystem::path& export_root, size_t cache_capacity);
+
+    /// Check if lazy loading is enabled
+    [[nodiscard]] bool lazy_loading_enabled() const { return lazy_ != nullptr; }
+
+    /**
+     * @brief Get the analysis for an analyze_path, parsing it on first access
+     *
+     * Thread-safe. Returns nullptr if lazy loading is disabled or no ANLZ
+     * file exists for the path. The returned data stays alive for as long as
+     * the caller holds the pointer, even after it is evicted from the cache.
+     */
+    [[nodiscard]] std::shared_ptr<const TrackAnalysis> load_analysis(const std::string& analyze_path) const;
+
+    /// Get number of tracks currently held in the lazy cache
+    [[nodiscard]] size_t cached_analysis_count() const;
+
+    /// Files parsed, bytes read, load time and cache hits (shared with copies of this manager)
+    [[nodiscard]] AnlzMetrics metrics() const;
 
     /// Clear all loaded data
-    void clear() {
-        cue_point_index_.clear();
-        beat_grid_index_.clear();
-        waveform_index_.clear();
-        song_structure_index_.clear();
-    }
+    void clear();
 
 private:
-    // Map from track path to cue points
-    std::map<std::string, std::vector<CuePointData>> cue_point_index_;
-    // Map from track path to beat grid
-    std::map<std::string, BeatGrid> beat_grid_index_;
-    // Map from track path to waveforms
-    std::map<std::string, TrackWaveforms> waveform_index_;
-    // Map from track path to song structure
-    std::map<std::string, SongStructure> song_structure_index_;
+    struct PartialIndex;
+    struct LazyCache;
+    struct Counters;
+
+    /// Add n to one of the metrics() counters (no-op on a moved-from manager)
+    void count(std::atomic<uint64_t> Counters::*counter, uint64_t n) const;
+
+    /// RekordboxAnlz::open, counted in metrics()
+    [[nodiscard]] Result<RekordboxAnlz> parse_file(const std::filesystem::path& path, AnlzSections sections) const;
+
+    /// Merge a partial index using the same precedence rules as load_anlz_file
+    void merge_partial(PartialIndex&& partial);
+
+    /// Merge one track's partial analysis (see merge_partial)
+    void merge_entry(const std::string& track_path, TrackAnalysis&& analysis, bool cues_from_ext);
+
+    /// One file of a scanned directory, as of its last listing
+    struct ScannedFile {
+        std::filesystem::path path;
+        uint64_t size{0};
+        int64_t mtime{0};        // last_write_time ticks
+        std::string track_path;  // Record the file was merged into (empty if it failed to parse)
+    };
+
+    /// Listing of a directory passed to scan_directory
+    struct ScannedDirectory {
+        std::filesystem::path dir;
+        std::vector<ScannedFile> files;
+        AnlzSections sections{AnlzSections::All};
+    };
+
+    /// Replay the partials of a previous scan saved at path (false if missing or stale)
+    bool load_snapshot(const std::filesystem::path& path, const SnapshotKey& key,
+                       std::vector<ScannedFile>& files);
+
+    /// Save the partials of a scan so an unchanged directory can skip parsing
+    void save_snapshot(const std::filesystem::path& path, const SnapshotKey& key,
+                       const std::vector<PartialIndex>& partials,
+                       const std::vector<ScannedFile>& files) const;
+
+    /// Remember the listing of a scanned directory for refresh()
+    void remember_scan(const std::filesystem::path& anlz_dir, std::vector<ScannedFile>&& files,
+                       AnlzSections sections);
+
+    /// Reparse the tracks of a directory whose files changed since its last listing
+    void refresh_directory(ScannedDirectory& scanned, AnlzRefreshStats& stats);
+
+    /// Drop lazily cached tracks whose files changed (returns the number dropped)
+    size_t refresh_lazy_cache();
+
+    /// analyze_paths of lazily cached tracks whose files changed since they were parsed
+    [[nodiscard]] std::vector<std::string> stale_lazy_items() const;
+
+    /// Empty a track's record and its counts before it is rebuilt
+    void reset_record(const std::string& track_path);
+
+    /// Everything loaded for one track path
+    struct Record {
+        std::string path;
+        std::shared_ptr<TrackAnalysis> analysis;  // nullptr until loaded; shared with copies
+    };
+
+    /// Find or create the record for a track path
+    Record& record_for(const std::string& track_path);
+
+    /// A record's analysis, first copied if another manager still shares it
+    static TrackAnalysis& writable(Record& record);
+
+    /// Resolve a file name to the first analysis for which has() holds
+    template<typename Predicate>
+    const TrackAnalysis* find_by_filename(const std::string& filename, Predicate has) const;
+
+    // One record per track path (a deque, so records never move)
+    std::deque<Record> records_;
+    // Map from track path (viewing Record::path) to its position in records_
+    std::unordered_map<std::string_view, size_t> path_index_;
+    // Map from last path component to the track paths ending in it
+    std::map<std::string, std::set<std::string>> filename_index_;
+
+    // Records with non-empty cue points / beat grid / waveforms / song structure
+    size_t cue_point_count_{0};
+    size_t beat_grid_count_{0};
+    size_t waveform_count_{0};
+    size_t song_structure_count_{0};
+
+    std::shared_ptr<LazyCache> lazy_;  // Shared with copies
+    std::shared_ptr<Counters> counters_;  // Shared with copies
+    std::vector<ScannedDirectory> scanned_;  // Directories refresh() re-lists
+
+    IoMode io_mode_{IoMode::Buffered};
+    size_t thread_count_{1};
+    std::filesystem::path snapshot_dir_;
 };
 
 } // namespace cratedigger
@@ -8,10 +8,13 @@
  */
 
 #include "types.hpp"
-#include <fstream>
+#include "file_buffer.hpp"
+#include <filesystem>
 #include <memory>
 #include <cstdint>
 #include <vector>
+#include <string>
+#include <string_view>
 
 namespace cratedigger {
 
@@ -59,6 +62,7 @@ enum class PageTypeExt : uint32_t {
 // ============================================================================
 
 class RekordboxPdb;
+class PageRowCursor;
 struct PdbPage;
 struct PdbTable;
 struct RowGroup;
@@ -66,6 +70,9 @@ struct RowGroup;
 // ============================================================================
 // Raw Row Data Structures (direct from binary)
 // ============================================================================
+//
+// Reference layouts. The indexers decode rows through the field tables in
+// src/core/row_decoders.hpp rather than casting to these structs.
 
 /// Raw track row data
 struct RawTrackRow {
@@ -143,10 +150,10 @@ struct RawKeyRow {
     // Followed by device_sql_string for name
 };
 
-/// Raw color row data
+/// Raw color row data (the u16 ID is unaligned, so it is kept as bytes)
 struct RawColorRow {
     uint8_t padding[5];
-    uint16_t id;
+    uint8_t id[2];  // Little-endian
     uint8_t unknown;
     // Followed by device_sql_string for name
 };
@@ -216,16 +223,20 @@ struct RawTagTrackRow {
  * @brief Rekordbox PDB file parser
  *
  * Reads and parses export.pdb and exportExt.pdb files.
- * Uses memory-mapped I/O for efficient access.
+ * The file is either read into memory or memory-mapped (see IoMode).
  */
 class RekordboxPdb {
 public:
     /// Open a PDB file
     [[nodiscard]] static Result<RekordboxPdb> open(
         const std::filesystem::path& path,
-        bool is_ext = false
+        bool is_ext = false,
+        IoMode io_mode = IoMode::Buffered
     );
 
+    /// Parse a PDB image already in memory (used by the fuzz target)
+    [[nodiscard]] static Result<RekordboxPdb> from_bytes(std::vector<uint8_t> bytes, bool is_ext = false);
+
     /// Move constructor
     RekordboxPdb(RekordboxPdb&& other) noexcept;
 
@@ -254,16 +265,37 @@ public:
     /// Read a page at given index
     [[nodiscard]] Result<PdbPage> read_page(uint32_t page_index) const;
 
+    /// Get an allocation-free cursor over a page's present rows (invalid if out of range)
+    [[nodiscard]] PageRowCursor page_rows(uint32_t page_index) const;
+
     /// Parse a device SQL string from the file
     [[nodiscard]] std::string read_string(size_t offset) const;
 
+    /**
+     * @brief Parse a device SQL string without copying ASCII data
+     *
+     * ASCII strings come back as a view into the file (valid while this
+     * object is alive); UTF-16 strings are decoded into scratch and the
+     * view points into it.
+     */
+    [[nodiscard]] std::string_view read_string_view(size_t offset, std::string& scratch) const;
+
     /// Get raw data at offset (returns pointer and size, empty pair if out of bounds)
     [[nodiscard]] std::pair<const uint8_t*, size_t> data_at(size_t offset, size_t size) const;
 
+    /// Get the file size in bytes
+    [[nodiscard]] size_t file_size() const { return file_data_.size(); }
+
+    /// Check if the file is memory-mapped rather than copied
+    [[nodiscard]] bool is_mapped() const { return file_data_.is_mapped(); }
+
 private:
     RekordboxPdb() = default;
 
-    std::vector<uint8_t> file_data_;
+    /// Validate the header of buffer and read its table list
+    [[nodiscard]] static Result<RekordboxPdb> parse(FileBuffer buffer, bool is_ext);
+
+    FileBuffer file_data_;
     std::vector<PdbTable> tables_;
     uint32_t page_size_{0};
     uint32_t table_count_{0};
@@ -312,4 +344,100 @@ struct RowGroup {
     size_t heap_pos{0};  // Position of heap in file
 };
 
+// ============================================================================
+// Row Cursor
+// ============================================================================
+
+/**
+ * @brief Allocation-free cursor over the present rows of one page
+ *
+ * Decodes the row-group present flags and row offsets directly from the
+ * file bytes, yielding the same rows as read_page() + row_groups without
+ * building any vectors. Valid only while the owning RekordboxPdb is alive.
+ */
+class PageRowCursor {
+public:
+    /// Invalid cursor (page out of range)
+    PageRowCursor() = default;
+
+    /// Cursor over the page at page_offset in the file
+    PageRowCursor(const uint8_t* page_data, size_t page_offset, uint32_t page_size)
+        : page_(page_data)
+        , heap_pos_(page_offset + kHeapOffset)
+        , page_size_(page_size)
+    {
+        uint32_t row_info = read_u32(20);
+        auto num_row_offsets = static_cast<uint16_t>(row_info & 0x1FFF);
+        auto page_flags = static_cast<uint8_t>((row_info >> 24) & 0xFF);
+        is_data_page_ = (page_flags & 0x40) == 0;
+        if (is_data_page_ && num_row_offsets > 0) {
+            group_count_ = static_cast<uint16_t>((num_row_offsets - 1) / kRowsPerGroup + 1);
+            load_group();
+        }
+    }
+
+    /// False if the page was out of range
+    [[nodiscard]] bool valid() const { return page_ != nullptr; }
+
+    /// False for index/strange pages (which yield no rows)
+    [[nodiscard]] bool is_data_page() const { return is_data_page_; }
+
+    /// Next page in the table's chain
+    [[nodiscard]] uint32_t next_page_index() const { return page_ ? read_u32(12) : 0; }
+
+    /// Advance to the next present row, storing its file offset in row_base
+    bool next(size_t& row_base) {
+        while (group_ < group_count_) {
+            while (row_ < kRowsPerGroup) {
+                unsigned row = row_++;
+                if (((present_ >> row) & 1) == 0) continue;
+
+                size_t ofs_pos_end = 6 + 2 * static_cast<size_t>(row);
+                if (group_base_ < ofs_pos_end + 2) continue;
+                row_base = heap_pos_ + read_u16(group_base_ - ofs_pos_end);
+                return true;
+            }
+            ++group_;
+            load_group();
+        }
+        return false;
+    }
+
+private:
+    static constexpr size_t kHeapOffset = 40;
+    static constexpr size_t kRowsPerGroup = 16;
+    static constexpr size_t kGroupSize = 0x24;
+
+    void load_group() {
+        row_ = 0;
+        present_ = 0;
+        size_t back = static_cast<size_t>(group_) * kGroupSize;
+        group_base_ = back <= page_size_ ? page_size_ - back : 0;
+        if (group_ < group_count_ && group_base_ >= 4) {
+            present_ = read_u16(group_base_ - 4);
+        }
+    }
+
+    [[nodiscard]] uint16_t read_u16(size_t pos) const {
+        return static_cast<uint16_t>(page_[pos] | (page_[pos + 1] << 8));
+    }
+
+    [[nodiscard]] uint32_t read_u32(size_t pos) const {
+        return static_cast<uint32_t>(page_[pos]) |
+               (static_cast<uint32_t>(page_[pos + 1]) << 8) |
+               (static_cast<uint32_t>(page_[pos + 2]) << 16) |
+               (static_cast<uint32_t>(page_[pos + 3]) << 24);
+    }
+
+    const uint8_t* page_{nullptr};
+    size_t heap_pos_{0};
+    size_t group_base_{0};     // Page-relative end of the current row group
+    uint32_t page_size_{0};
+    uint16_t group_count_{0};
+    uint16_t group_{0};
+    uint16_t present_{0};
+    unsigned row_{0};
+    bool is_data_page_{false};
+};
+
 } // namespace cratedigger
@@ -0,0 +1,143 @@
+#pragma once
+/**
+ * @file similarity.hpp
+ * @brief Nearest-neighbour track recommendations over compact feature columns
+ *
+ * A SimilarityIndex copies each track's tempo, Camelot key, genre, year,
+ * waveform energy and song-structure mood into float columns once. A query
+ * scores every track against a seed in one pass (4-wide SSE2 / NEON, with a
+ * scalar fallback), drops tracks outside the tempo and harmonic limits, and
+ * keeps the best k in a bounded heap:
+ *
+ *   SimilarityIndex similar(db);  // after load_cue_points() for energy and mood
+ *   SimilarityQuery query;
+ *   query.limit = 20;
+ *   for (const auto& hit : similar.nearest(current_track, query)) queue(hit.id);
+ */
+
+#include "types.hpp"
+#include <string_view>
+#include <vector>
+
+namespace cratedigger {
+
+class Database;
+
+/// Position on the Camelot wheel (number 0 = unknown key)
+struct CamelotKey {
+    uint8_t number{0};   // 1-12
+    bool major{false};   // B (major) or A (minor)
+
+    [[nodiscard]] bool valid() const { return number != 0; }
+};
+
+/**
+ * @brief Camelot position of a key name
+ *
+ * Accepts musical names as rekordbox writes them ("Am", "F#", "Dbm", "C#min",
+ * "Ebmaj") and Camelot codes ("8A", "12B"); anything else is unknown.
+ */
+[[nodiscard]] CamelotKey camelot_key(std::string_view name);
+
+/**
+ * @brief Harmonic distance in Camelot steps
+ *
+ * Steps around the wheel, plus one to change between A and B: 0 for the same
+ * key, 1 for a neighbour or the relative major/minor. 0xFF if either key is
+ * unknown.
+ */
+[[nodiscard]] uint8_t camelot_distance(CamelotKey a, CamelotKey b);
+
+/// Relative weight of each feature in the distance (0 ignores the feature)
+struct SimilarityWeights {
+    float bpm{1.0f};      // Per 6% of tempo (after half/double-time folding)
+    float key{1.0f};      // Per Camelot step
+    float genre{0.5f};    // Different genre
+    float year{0.25f};    // Per 10 years
+    float energy{0.5f};   // Per quarter of the energy range
+    float mood{0.25f};    // Per mood level (High / Mid / Low)
+};
+
+/// Constraints and weights of a nearest() call
+struct SimilarityQuery {
+    /// Maximum number of hits
+    size_t limit{20};
+
+    /// Maximum tempo deviation as a fraction of the seed's (0 = no limit)
+    float bpm_tolerance{0.08f};
+
+    /// Treat half and double tempo as equal (70 BPM matches 140)
+    bool half_double_time{true};
+
+    /// Maximum camelot_distance() (kAnyKey = no limit; tracks without a key then pass)
+    uint8_t max_key_distance{1};
+
+    /// Only tracks of the seed's genre
+    bool same_genre{false};
+
+    SimilarityWeights weights;
+
+    static constexpr uint8_t kAnyKey = 0xFF;
+};
+
+/// Result of a nearest() query
+struct SimilarityHit {
+    TrackId id;
+    float distance{0.0f};  // Weighted squared distance to the seed (0 = identical features)
+};
+
+/// Feature vector of one track, as stored in the index
+struct TrackFeatures {
+    TrackId id;
+    float bpm{0.0f};         // 0 if the track has no tempo
+    CamelotKey key;
+    GenreId genre_id;
+    uint16_t year{0};        // 0 if unknown
+    float energy{-1.0f};     // Mean preview waveform height in [0, 1] (-1 without a waveform)
+    float mood{-1.0f};       // 1 High, 0.5 Mid, 0 Low (-1 without song structure)
+};
+
+/**
+ * @brief Feature columns of a track database with k-NN search
+ *
+ * The index is a snapshot: it does not follow refresh() or later ANLZ loads.
+ * Energy and mood come from analysis data that is already loaded; with lazy
+ * ANLZ loading, construction loads every track's files through the cache.
+ */
+class SimilarityIndex {
+public:
+    SimilarityIndex() = default;
+
+    /// Extract the features of every track of db (use_analysis = false skips energy and mood)
+    explicit SimilarityIndex(const Database& db, bool use_analysis = true);
+
+    /// Number of tracks
+    [[nodiscard]] size_t size() const { return track_id_.size(); }
+
+    [[nodiscard]] bool empty() const { return track_id_.empty(); }
+
+    /// Features of a track (id 0 if not indexed)
+    [[nodiscard]] TrackFeatures features(TrackId id) const;
+
+    /**
+     * @brief Most similar tracks to seed, closest first (ties by ascending ID)
+     *
+     * The seed itself is never returned. Features the seed or a candidate
+     * lacks cost one unit of their weight. Empty if seed is not indexed.
+     */
+    [[nodiscard]] std::vector<SimilarityHit> nearest(TrackId seed, const SimilarityQuery& query = {}) const;
+
+private:
+    [[nodiscard]] size_t position(TrackId id) const;
+
+    // One entry per track, in ascending ID order; unknown values are NaN (key 0, genre 0)
+    std::vector<int64_t> track_id_;
+    std::vector<float> log_bpm_;       // log2(BPM)
+    std::vector<float> year_;
+    std::vector<float> energy_;
+    std::vector<float> mood_;
+    std::vector<uint8_t> key_;         // 0 unknown, else 1-24: (number - 1) * 2 + major + 1
+    std::vector<int32_t> genre_;
+};
+
+} // namespace cratedigger
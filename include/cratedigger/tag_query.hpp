@@ -0,0 +1,90 @@
+#pragma once
+/**
+ * @file tag_query.hpp
+ * @brief Boolean queries over exportExt.pdb tags and tag categories
+ *
+ * A TagQuery is built from tags and categories with &, | and !, or parsed
+ * from text, and evaluated by Database::find_tracks_by_tags() over per-tag
+ * track bitmaps:
+ *
+ *   auto query = TagQuery::parse("(Peak Time OR Warmup) AND Vocal AND NOT Remix", ext);
+ *   if (query) {
+ *       auto hits = ext.find_tracks_by_tags(*query, &db);
+ *       for (const TrackRowView* track : db.track_views(hits)) show(*track);
+ *   }
+ */
+
+#include "types.hpp"
+#include <string_view>
+#include <vector>
+
+namespace cratedigger {
+
+class Database;
+
+/**
+ * @brief Boolean expression over tags, held in postfix order
+ *
+ * A default-constructed query matches every track. Queries are only built
+ * through the factories and operators below, so the term list is always a
+ * well-formed expression.
+ */
+class TagQuery {
+public:
+    /// Term kinds; And / Or pop two operands, Not pops one
+    enum class Op : uint8_t {
+        All = 0,       // Every track
+        Tag = 1,       // Tracks with the tag
+        Category = 2,  // Tracks with any tag of the category
+        And = 3,
+        Or = 4,
+        Not = 5,
+    };
+
+    struct Term {
+        Op op{Op::All};
+        TagId id;  // Tag and Category only
+    };
+
+    /// Match every track
+    TagQuery() = default;
+
+    /// Tracks with a tag
+    [[nodiscard]] static TagQuery tag(TagId id);
+
+    /// Tracks with any tag of a category
+    [[nodiscard]] static TagQuery category(TagId id);
+
+    /**
+     * @brief Parse a query against the tags of an exportExt.pdb database
+     *
+     * Grammar, loosest first: OR (or |), AND (or &), NOT (or !), parentheses.
+     * The keywords are upper case; everything else between them is a name,
+     * so multi-word names need no quotes ("Peak Time AND Vocal"). Quote a
+     * name that contains a keyword or operator character. Names match tags
+     * case-insensitively (several tags of the same name match any of them),
+     * then categories. Unknown names, syntax errors and more than 256
+     * nested parentheses or NOTs return ErrorCode::InvalidParameter.
+     */
+    [[nodiscard]] static Result<TagQuery> parse(std::string_view text, const Database& ext);
+
+    /// Tracks matching both
+    [[nodiscard]] TagQuery operator&(const TagQuery& other) const;
+
+    /// Tracks matching either
+    [[nodiscard]] TagQuery operator|(const TagQuery& other) const;
+
+    /// Tracks not matching
+    [[nodiscard]] TagQuery operator!() const;
+
+    /// Terms in postfix order (empty for the match-all query)
+    [[nodiscard]] const std::vector<Term>& terms() const { return terms_; }
+
+private:
+    std::vector<Term> terms_;
+
+    /// Append other's terms (All for the empty query)
+    void append(const TagQuery& other);
+};
+
+} // namespace cratedigger
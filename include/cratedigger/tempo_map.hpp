@@ -0,0 +1,111 @@
+#pragma once
+/**
+ * @file tempo_map.hpp
+ * @brief Beat grids precomputed into constant-tempo segments for O(1) lookups
+ *
+ * BeatGrid::find_beat_at() binary-searches the beats on every call. A
+ * TempoMap splits the grid once into runs of equal tempo and keeps a bucket
+ * table over time and a per-beat segment table, so converting a playhead
+ * position to a fractional beat (or back) is a table lookup plus one
+ * multiply-add. Batched conversions write into caller-provided arrays and
+ * transform runs of values that fall in one segment with 2-wide double
+ * vectors (SSE2 / NEON), with a scalar fallback.
+ *
+ *   TempoMap tempo(*db.get_beat_grid_for_track(id));
+ *   auto pos = tempo.position_at(playhead_ms);
+ *   // pos.beat_in_bar, pos.bar_phase drive the lighting controller
+ */
+
+#include "types.hpp"
+#include <vector>
+
+namespace cratedigger {
+
+/// A run of beats with one tempo
+struct TempoSegment {
+    double start_ms{0.0};      // Time of the segment's first beat
+    double ms_per_beat{0.0};   // Beat length; reaches the next segment's first beat exactly
+    uint32_t first_beat{0};    // Index of the segment's first beat in the grid
+    uint32_t beat_count{0};
+    uint16_t tempo_100x{0};    // Tempo stored in the grid (BPM * 100)
+
+    [[nodiscard]] float bpm() const { return tempo_100x / 100.0f; }
+};
+
+/// Musical position of a point in time
+struct BeatPosition {
+    double beat{0.0};          // Fractional beat index (0 = first grid beat, negative before it)
+    int64_t bar{0};            // Bar index (bar 0 holds the first grid beat)
+    uint16_t beat_in_bar{1};   // 1-4, as BeatEntry::beat_number
+    double beat_phase{0.0};    // Position within the beat [0, 1)
+    double bar_phase{0.0};     // Position within the bar [0, 1)
+    float bpm{0.0f};           // Tempo of the segment
+};
+
+/**
+ * @brief Piecewise-constant tempo view of a beat grid
+ *
+ * Consecutive beats with the same tempo_100x form one segment; within a
+ * segment beats are evenly spaced, so a segment's beat length is derived from
+ * the stored beat times rather than the rounded tempo. Times before the first
+ * beat and after the last extrapolate the first and last segment. Bars are
+ * four beats, counted from the first beat's beat_number, as on every
+ * rekordbox grid.
+ */
+class TempoMap {
+public:
+    TempoMap() = default;
+
+    /// Split grid into tempo segments and build the lookup tables
+    explicit TempoMap(const BeatGrid& grid);
+
+    [[nodiscard]] bool empty() const { return segments_.empty(); }
+
+    /// Number of beats in the source grid
+    [[nodiscard]] size_t beat_count() const { return beat_count_; }
+
+    [[nodiscard]] const std::vector<TempoSegment>& segments() const { return segments_; }
+
+    /// Segment containing time_ms (the first or last segment outside the grid)
+    [[nodiscard]] const TempoSegment& segment_at(double time_ms) const { return segments_[segment_index(time_ms)]; }
+
+    /// Fractional beat at time_ms (0 for an empty grid)
+    [[nodiscard]] double time_to_beat(double time_ms) const;
+
+    /// Time of fractional beat (0 for an empty grid)
+    [[nodiscard]] double beat_to_time(double beat) const;
+
+    /// Beat, bar and phases at time_ms
+    [[nodiscard]] BeatPosition position_at(double time_ms) const;
+
+    /// Tempo at time_ms (0 for an empty grid)
+    [[nodiscard]] float bpm_at(double time_ms) const { return empty() ? 0.0f : segment_at(time_ms).bpm(); }
+
+    /**
+     * @brief time_to_beat() for count values, into beats
+     *
+     * Sorted input is fastest (each segment's run is transformed at once),
+     * but any order is accepted. beats may alias times.
+     */
+    void times_to_beats(const double* times, size_t count, double* beats) const;
+
+    /// beat_to_time() for count values, into times (times may alias beats)
+    void beats_to_times(const double* beats, size_t count, double* times) const;
+
+    /// Snap each time to the nearest multiple of resolution beats (e.g. 1 = beat, 4 = bar)
+    void quantize(const double* times, size_t count, double* out, double resolution = 1.0) const;
+
+private:
+    [[nodiscard]] size_t segment_index(double time_ms) const;
+    [[nodiscard]] size_t segment_index_for_beat(double beat) const;
+
+    std::vector<TempoSegment> segments_;
+    std::vector<uint32_t> time_buckets_;    // Segment at the start of each bucket (multi-segment grids in time order only)
+    std::vector<uint32_t> beat_segments_;   // Segment of each beat (multi-segment grids only)
+    double bucket_origin_ms_{0.0};
+    double buckets_per_ms_{0.0};
+    size_t beat_count_{0};
+    uint16_t first_beat_number_{1};
+};
+
+} // namespace cratedigger
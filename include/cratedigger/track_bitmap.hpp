@@ -0,0 +1,106 @@
+#pragma once
+/**
+ * @file track_bitmap.hpp
+ * @brief Compressed track ID sets (roaring-style) for fast boolean filtering
+ *
+ * Track IDs are split by their high 16 bits into containers. A container with
+ * at most 4096 members is a sorted array of the low 16 bits; a fuller one is
+ * a 65536-bit bitmap. Rekordbox numbers tracks densely from 1, so a library
+ * of N tracks needs about N / 65536 containers and AND / OR / AND NOT run
+ * word-wise over bitmaps or as merges over arrays.
+ */
+
+#include "types.hpp"
+#include <cstdint>
+#include <vector>
+
+namespace cratedigger {
+
+/**
+ * @brief Immutable-by-convention set of track IDs
+ *
+ * IDs must fit in 32 bits, as they do in every PDB row. Results of the set
+ * operations are new bitmaps; none of them modify their operands.
+ */
+class TrackBitmap {
+public:
+    TrackBitmap() = default;
+
+    /// Build from IDs in any order (duplicates are ignored)
+    [[nodiscard]] static TrackBitmap from_ids(Span<const TrackId> ids);
+
+    /// Check membership
+    [[nodiscard]] bool contains(TrackId id) const;
+
+    /// Number of IDs in the set
+    [[nodiscard]] size_t cardinality() const;
+
+    [[nodiscard]] bool empty() const { return containers_.empty(); }
+
+    /// IDs in ascending order
+    [[nodiscard]] std::vector<TrackId> to_vector() const;
+
+    /// Call f(TrackId) for every member in ascending order
+    template<typename F>
+    void for_each(F&& f) const {
+        for (const auto& c : containers_) {
+            int64_t high = static_cast<int64_t>(c.key) << 16;
+            if (c.words.empty()) {
+                for (uint16_t low : c.values) f(TrackId{high | low});
+                continue;
+            }
+            for (size_t w = 0; w < c.words.size(); ++w) {
+                for (uint64_t word = c.words[w]; word != 0; word &= word - 1) {
+                    f(TrackId{high | static_cast<int64_t>(w * 64 + lowest_bit(word))});
+                }
+            }
+        }
+    }
+
+    /// Members of both
+    [[nodiscard]] TrackBitmap operator&(const TrackBitmap& other) const;
+
+    /// Members of either
+    [[nodiscard]] TrackBitmap operator|(const TrackBitmap& other) const;
+
+    /// Members of this that are not in other
+    [[nodiscard]] TrackBitmap operator-(const TrackBitmap& other) const;
+
+    /// Number of array and bitmap containers
+    [[nodiscard]] size_t container_count() const { return containers_.size(); }
+
+    /// Approximate heap footprint in bytes
+    [[nodiscard]] size_t bytes() const;
+
+    bool operator==(const TrackBitmap& other) const;
+    bool operator!=(const TrackBitmap& other) const { return !(*this == other); }
+
+private:
+    /// IDs sharing their high 16 bits: values (sorted lows) or words (1024 x 64 bits), never both
+    struct Container {
+        uint16_t key{0};
+        uint32_t cardinality{0};
+        std::vector<uint16_t> values;
+        std::vector<uint64_t> words;
+    };
+
+    struct Ops;
+
+    /// Index of the lowest set bit (word != 0)
+    static unsigned lowest_bit(uint64_t word) {
+#if defined(__GNUC__) || defined(__clang__)
+        return static_cast<unsigned>(__builtin_ctzll(word));
+#else
+        unsigned bit = 0;
+        while ((word & 1) == 0) {
+            word >>= 1;
+            ++bit;
+        }
+        return bit;
+#endif
+    }
+
+    std::vector<Container> containers_;  // Ascending key, none empty
+};
+
+} // namespace cratedigger
@@ -9,7 +9,10 @@
  * - MUST: Deterministic (Time Injection, Random Injection)
  */
 
+#include <atomic>
 #include <cstdint>
+#include <functional>
+#include <memory>
 #include <string>
 #include <string_view>
 #include <optional>
@@ -17,6 +20,9 @@
 #include <vector>
 #include <map>
 #include <set>
+#include <algorithm>
+#include <tuple>
+#include <type_traits>
 
 namespace cratedigger {
 
@@ -108,7 +114,8 @@ enum class ErrorCode {
     OutOfMemory,
     IoError,
     InvalidParameter,
-    UnknownError
+    UnknownError,
+    Cancelled          // Stopped by a cancellation request
 };
 
 /// Error information with source location (for AI debugging)
@@ -235,6 +242,208 @@ struct ArtworkRow {
     std::string path;
 };
 
+// ============================================================================
+// Span (non-owning view of contiguous elements)
+// ============================================================================
+
+/**
+ * @brief Read-only view of a contiguous array owned by someone else
+ *
+ * A C++17 stand-in for std::span. Spans returned by Database stay valid
+ * for the lifetime of the Database unless documented otherwise.
+ */
+template<typename T>
+class Span {
+public:
+    using value_type = std::remove_cv_t<T>;
+    using iterator = T*;
+
+    constexpr Span() = default;
+    constexpr Span(T* data, size_t size) : data_(data), size_(size) {}
+
+    /// View an entire vector
+    template<typename U>
+    Span(const std::vector<U>& v) : data_(v.data()), size_(v.size()) {}
+
+    [[nodiscard]] constexpr T* data() const { return data_; }
+    [[nodiscard]] constexpr size_t size() const { return size_; }
+    [[nodiscard]] constexpr bool empty() const { return size_ == 0; }
+    [[nodiscard]] constexpr iterator begin() const { return data_; }
+    [[nodiscard]] constexpr iterator end() const { return data_ + size_; }
+    [[nodiscard]] constexpr T& operator[](size_t i) const { return data_[i]; }
+    [[nodiscard]] constexpr T& front() const { return data_[0]; }
+    [[nodiscard]] constexpr T& back() const { return data_[size_ - 1]; }
+
+    /// Copy out as a vector
+    [[nodiscard]] std::vector<value_type> to_vector() const { return std::vector<value_type>(begin(), end()); }
+
+private:
+    T* data_{nullptr};
+    size_t size_{0};
+};
+
+/**
+ * @brief Span that keeps the storage it views alive
+ *
+ * Used for data that can be released while the caller still reads it,
+ * such as lazily loaded ANLZ analysis evicted by another thread's lookup.
+ */
+template<typename T>
+class PinnedSpan : public Span<T> {
+public:
+    PinnedSpan() = default;
+    PinnedSpan(std::shared_ptr<const void> owner, Span<T> span) : Span<T>(span), owner_(std::move(owner)) {}
+
+private:
+    std::shared_ptr<const void> owner_;
+};
+
+// ============================================================================
+// Row Views (non-owning, strings borrowed from the Database)
+// ============================================================================
+
+/// Track row whose strings point into the Database (see Database::get_track_view)
+struct TrackRowView {
+    TrackId id;
+    std::string_view title;
+    ArtistId artist_id;
+    ArtistId composer_id;
+    ArtistId original_artist_id;
+    ArtistId remixer_id;
+    AlbumId album_id;
+    GenreId genre_id;
+    LabelId label_id;
+    KeyId key_id;
+    ColorId color_id;
+    ArtworkId artwork_id;
+    uint32_t duration_seconds{0};
+    uint32_t bpm_100x{0};  // BPM * 100
+    uint16_t rating{0};
+    std::string_view file_path;
+    std::string_view comment;
+    uint32_t bitrate{0};
+    uint32_t sample_rate{0};
+    uint16_t year{0};
+    uint32_t file_size{0};
+    uint32_t track_number{0};
+    uint16_t disc_number{0};
+    uint16_t play_count{0};
+    uint16_t sample_depth{0};
+    std::string_view isrc;
+    std::string_view texter;
+    std::string_view message;
+    std::string_view kuvo_public;
+    std::string_view autoload_hot_cues;
+    std::string_view date_added;
+    std::string_view release_date;
+    std::string_view mix_name;
+    std::string_view analyze_path;
+    std::string_view analyze_date;
+    std::string_view filename;
+
+    /// Get BPM as float
+    float bpm() const { return bpm_100x / 100.0f; }
+
+    /// Copy into an owning TrackRow
+    [[nodiscard]] TrackRow to_row() const {
+        TrackRow row;
+        row.id = id;
+        row.title = std::string(title);
+        row.artist_id = artist_id;
+        row.composer_id = composer_id;
+        row.original_artist_id = original_artist_id;
+        row.remixer_id = remixer_id;
+        row.album_id = album_id;
+        row.genre_id = genre_id;
+        row.label_id = label_id;
+        row.key_id = key_id;
+        row.color_id = color_id;
+        row.artwork_id = artwork_id;
+        row.duration_seconds = duration_seconds;
+        row.bpm_100x = bpm_100x;
+        row.rating = rating;
+        row.file_path = std::string(file_path);
+        row.comment = std::string(comment);
+        row.bitrate = bitrate;
+        row.sample_rate = sample_rate;
+        row.year = year;
+        row.file_size = file_size;
+        row.track_number = track_number;
+        row.disc_number = disc_number;
+        row.play_count = play_count;
+        row.sample_depth = sample_depth;
+        row.isrc = std::string(isrc);
+        row.texter = std::string(texter);
+        row.message = std::string(message);
+        row.kuvo_public = std::string(kuvo_public);
+        row.autoload_hot_cues = std::string(autoload_hot_cues);
+        row.date_added = std::string(date_added);
+        row.release_date = std::string(release_date);
+        row.mix_name = std::string(mix_name);
+        row.analyze_path = std::string(analyze_path);
+        row.analyze_date = std::string(analyze_date);
+        row.filename = std::string(filename);
+        return row;
+    }
+};
+
+/// Artist row whose name points into the Database
+struct ArtistRowView {
+    ArtistId id;
+    std::string_view name;
+
+    [[nodiscard]] ArtistRow to_row() const { return {id, std::string(name)}; }
+};
+
+/// Album row whose name points into the Database
+struct AlbumRowView {
+    AlbumId id;
+    std::string_view name;
+    ArtistId artist_id;
+
+    [[nodiscard]] AlbumRow to_row() const { return {id, std::string(name), artist_id}; }
+};
+
+/// Genre row whose name points into the Database
+struct GenreRowView {
+    GenreId id;
+    std::string_view name;
+
+    [[nodiscard]] GenreRow to_row() const { return {id, std::string(name)}; }
+};
+
+/// Label row whose name points into the Database
+struct LabelRowView {
+    LabelId id;
+    std::string_view name;
+
+    [[nodiscard]] LabelRow to_row() const { return {id, std::string(name)}; }
+};
+
+/// Color row whose name points into the Database
+struct ColorRowView {
+    ColorId id;
+    std::string_view name;
+
+    [[nodiscard]] ColorRow to_row() const { return {id, std::string(name)}; }
+};
+
+/// Musical key row whose name points into the Database
+struct KeyRowView {
+    KeyId id;
+    std::string_view name;
+
+    [[nodiscard]] KeyRow to_row() const { return {id, std::string(name)}; }
+};
+
+/// Artwork row whose path points into the Database
+struct ArtworkRowView {
+    ArtworkId id;
+    std::string_view path;
+
+    [[nodiscard]] ArtworkRow to_row() const { return {id, std::string(path)}; }
+};
+
 /// Playlist folder entry
 struct PlaylistFolderEntry {
     std::string name;
@@ -650,6 +859,30 @@ struct DatabaseConfig {
     static constexpr uint32_t EXPECTED_PAGE_SIZE = 4096;
 };
 
+/// How file contents are brought into memory for parsing
+enum class IoMode : uint8_t {
+    Buffered = 0,      // Read the whole file into a heap buffer
+    MemoryMapped = 1   // Map the file read-only (zero-copy, pages loaded on demand)
+};
+
+/**
+ * @brief Progress and cancellation hooks for a long load
+ *
+ * Loaders report units (tables, files) as they finish, possibly from several
+ * worker threads at once, and poll cancelled() between units. A cancelled
+ * load stops early and keeps none of its partial results.
+ */
+struct LoadObserver {
+    std::function<void(size_t done, size_t total)> on_progress;  // Must be thread-safe
+    const std::atomic<bool>* cancel{nullptr};                    // Set to request a stop
+
+    [[nodiscard]] bool cancelled() const { return cancel != nullptr && cancel->load(std::memory_order_relaxed); }
+
+    void report(size_t done, size_t total) const {
+        if (on_progress) on_progress(done, total);
+    }
+};
+
 // ============================================================================
 // Safety Curtain (Hardware Control Limits)
 // ============================================================================
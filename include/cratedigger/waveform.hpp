@@ -0,0 +1,91 @@
+#pragma once
+/**
+ * @file waveform.hpp
+ * @brief Waveforms decoded once into planar arrays, with mip levels for rendering
+ *
+ * WaveformData keeps the raw ANLZ bytes and decodes one entry per accessor
+ * call. DecodedWaveform decodes every entry up front into one array per
+ * channel and builds a pyramid of 2:1 reductions, so rendering any range at
+ * any pixel width touches O(width * log(entries / width)) cached values
+ * instead of every entry. Reductions run on 16-byte vectors (SSE2 / NEON)
+ * with a scalar fallback.
+ *
+ *   DecodedWaveform wave(*waveforms->detail);
+ *   auto columns = wave.render(first_entry, last_entry, canvas_width);
+ *   // columns.min_height[x] .. columns.max_height[x] is the bar at pixel x
+ */
+
+#include "types.hpp"
+#include <vector>
+
+namespace cratedigger {
+
+/**
+ * @brief Waveform channels (struct-of-arrays)
+ *
+ * Every present channel has size() entries. Height is kept as a min/max
+ * pair so reduced columns can draw the full envelope; the colour and band
+ * channels hold the peak of the entries a column covers.
+ */
+struct WaveformColumns {
+    WaveformStyle style{WaveformStyle::Blue};
+    std::vector<uint8_t> min_height;  // 0-31
+    std::vector<uint8_t> max_height;  // 0-31
+    std::vector<uint8_t> red;         // RGB only (0-255)
+    std::vector<uint8_t> green;
+    std::vector<uint8_t> blue;
+    std::vector<uint8_t> low;         // ThreeBand only (0-31)
+    std::vector<uint8_t> mid;
+    std::vector<uint8_t> high;
+
+    /// Number of entries (or rendered columns)
+    [[nodiscard]] size_t size() const { return max_height.size(); }
+};
+
+/**
+ * @brief A waveform decoded into planar channels plus mip levels
+ *
+ * Entries are decoded with the same interpretation as WaveformData's
+ * height_at(), color_at() and bands_at(). Level k holds one value per 2^k
+ * entries; level 0 is the decoded entries themselves.
+ */
+class DecodedWaveform {
+public:
+    DecodedWaveform() = default;
+
+    /// Decode every entry and build the mip levels
+    explicit DecodedWaveform(const WaveformData& waveform);
+
+    [[nodiscard]] WaveformStyle style() const { return levels_[0].style; }
+    [[nodiscard]] size_t size() const { return levels_[0].size(); }
+    [[nodiscard]] bool empty() const { return size() == 0; }
+
+    /// Decoded entries (min_height and max_height are equal)
+    [[nodiscard]] const WaveformColumns& entries() const { return levels_[0]; }
+
+    /// Number of mip levels (at least 1)
+    [[nodiscard]] size_t level_count() const { return levels_.size(); }
+
+    /// Mip level k: value j reduces entries [j * 2^k, (j + 1) * 2^k)
+    [[nodiscard]] const WaveformColumns& level(size_t k) const { return levels_.at(k); }
+
+    /**
+     * @brief Reduce entries [first, last) to width columns
+     *
+     * Column x covers entries [first + x * n / width, first + (x + 1) * n / width)
+     * with n = last - first (at least one entry, so widths above n repeat
+     * entries). last is clamped to size(); an empty range yields no columns.
+     */
+    [[nodiscard]] WaveformColumns render(size_t first, size_t last, size_t width) const;
+
+    /// Reduce the whole waveform to width columns
+    [[nodiscard]] WaveformColumns render(size_t width) const { return render(0, size(), width); }
+
+    /// render() into existing columns, reusing their storage
+    void render_into(size_t first, size_t last, size_t width, WaveformColumns& out) const;
+
+private:
+    std::vector<WaveformColumns> levels_ = std::vector<WaveformColumns>(1);  // Level 0 first
+};
+
+} // namespace cratedigger
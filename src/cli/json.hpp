@@ -0,0 +1,552 @@
+#pragma once
+/**
+ * @file json.hpp
+ * @brief Minimal JSON reader and buffered writer for the JSONL CLI
+ *
+ * The reader parses one line in a single pass into a flat node array that
+ * is reused between lines, so steady-state parsing does not allocate.
+ * Strings are kept as views into the line and only unescaped on request.
+ * The writer appends into one buffer and hands it to the output stream in
+ * large writes.
+ */
+
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+namespace cratedigger::cli {
+
+// ============================================================================
+// Reader
+// ============================================================================
+
+enum class JsonType : uint8_t {
+    Null,
+    Bool,
+    Number,
+    String,
+    Array,
+    Object
+};
+
+/// One parsed value; containers are followed by their descendants
+struct JsonNode {
+    JsonType type{JsonType::Null};
+    bool escaped{false};    // String contains backslash escapes
+    uint32_t end{0};        // Index one past the last descendant
+    std::string_view key;   // Member name (raw, inside an object)
+    std::string_view text;  // Raw value text (strings without quotes)
+};
+
+class JsonDocument;
+
+/// Handle to a node of a JsonDocument (valid while the document is unchanged)
+class JsonValue {
+public:
+    JsonValue() = default;
+    JsonValue(const JsonDocument* doc, uint32_t index) : doc_(doc), index_(index) {}
+
+    [[nodiscard]] bool valid() const { return doc_ != nullptr; }
+    [[nodiscard]] JsonType type() const;
+    [[nodiscard]] bool is_object() const { return valid() && type() == JsonType::Object; }
+    [[nodiscard]] bool is_array() const { return valid() && type() == JsonType::Array; }
+
+    /// Raw JSON text of the value (for echoing it back unchanged)
+    [[nodiscard]] std::string_view raw() const;
+
+    /// Member of an object (invalid if missing or not an object)
+    [[nodiscard]] JsonValue find(std::string_view key) const;
+
+    /// Visit the elements of an array or the members of an object in order
+    template<typename Visitor>
+    void for_each(Visitor&& visitor) const;
+
+    /// Number as an integer (fallback if missing, not a number or fractional)
+    [[nodiscard]] int64_t as_int(int64_t fallback = 0) const;
+
+    /// Number as a double (fallback if missing or not a number)
+    [[nodiscard]] double as_double(double fallback = 0.0) const;
+
+    /// Boolean value (fallback if missing or not a bool)
+    [[nodiscard]] bool as_bool(bool fallback = false) const;
+
+    /// String value, unescaped into scratch only if it contains escapes (lone surrogates become U+FFFD)
+    [[nodiscard]] std::string_view as_string(std::string& scratch) const;
+
+private:
+    const JsonNode& node() const;
+
+    const JsonDocument* doc_{nullptr};
+    uint32_t index_{0};
+};
+
+/**
+ * @brief Single-pass parser for one JSON text
+ *
+ * The text must outlive the document; nodes view it. Nesting is limited to
+ * kMaxDepth so hostile input cannot exhaust the stack.
+ */
+class JsonDocument {
+public:
+    static constexpr int kMaxDepth = 64;
+
+    /// Parse text, replacing the previous contents (false on a syntax error)
+    bool parse(std::string_view text) {
+        nodes_.clear();
+        text_ = text;
+        pos_ = 0;
+        error_.clear();
+        skip_space();
+        if (!parse_value({}, 0)) return false;
+        skip_space();
+        if (pos_ != text_.size()) return fail("trailing characters");
+        return true;
+    }
+
+    [[nodiscard]] JsonValue root() const {
+        return nodes_.empty() ? JsonValue{} : JsonValue{this, 0};
+    }
+
+    /// Syntax error of the last parse(), with its byte offset
+    [[nodiscard]] const std::string& error() const { return error_; }
+
+    [[nodiscard]] const std::vector<JsonNode>& nodes() const { return nodes_; }
+
+private:
+    bool fail(const char* what) {
+        error_ = std::string(what) + " at offset " + std::to_string(pos_);
+        return false;
+    }
+
+    void skip_space() {
+        while (pos_ < text_.size() &&
+               (text_[pos_] == ' ' || text_[pos_] == '\t' || text_[pos_] == '\n' || text_[pos_] == '\r')) {
+            ++pos_;
+        }
+    }
+
+    bool literal(std::string_view word) {
+        if (text_.compare(pos_, word.size(), word) != 0) return fail("invalid literal");
+        pos_ += word.size();
+        return true;
+    }
+
+    /// Scan a string body after its opening quote; sets text and escaped
+    bool scan_string(std::string_view& out, bool& escaped) {
+        size_t start = pos_;
+        escaped = false;
+        while (pos_ < text_.size()) {
+            char c = text_[pos_];
+            if (c == '"') {
+                out = text_.substr(start, pos_ - start);
+                ++pos_;
+                return true;
+            }
+            if (c == '\\') {
+                escaped = true;
+                if (++pos_ >= text_.size()) break;
+            } else if (static_cast<unsigned char>(c) < 0x20) {
+                return fail("control character in string");
+            }
+            ++pos_;
+        }
+        return fail("unterminated string");
+    }
+
+    bool scan_number() {
+        size_t start = pos_;
+        if (text_[pos_] == '-') ++pos_;
+        auto digits = [this] {
+            size_t first = pos_;
+            while (pos_ < text_.size() && text_[pos_] >= '0' && text_[pos_] <= '9') ++pos_;
+            return pos_ > first;
+        };
+        if (!digits()) return fail("invalid number");
+        if (pos_ < text_.size() && text_[pos_] == '.') {
+            ++pos_;
+            if (!digits()) return fail("invalid number");
+        }
+        if (pos_ < text_.size() && (text_[pos_] == 'e' || text_[pos_] == 'E')) {
+            ++pos_;
+            if (pos_ < text_.size() && (text_[pos_] == '+' || text_[pos_] == '-')) ++pos_;
+            if (!digits()) return fail("invalid number");
+        }
+        nodes_.back().text = text_.substr(start, pos_ - start);
+        return true;
+    }
+
+    bool parse_value(std::string_view key, int depth) {
+        if (pos_ >= text_.size()) return fail("unexpected end");
+        if (depth > kMaxDepth) return fail("nesting too deep");
+
+        auto index = static_cast<uint32_t>(nodes_.size());
+        nodes_.push_back(JsonNode{});
+        nodes_[index].key = key;
+        size_t start = pos_;
+
+        char c = text_[pos_];
+        bool ok = true;
+        if (c == '{' || c == '[') {
+            bool object = c == '{';
+            nodes_[index].type = object ? JsonType::Object : JsonType::Array;
+            ++pos_;
+            skip_space();
+            char close = object ? '}' : ']';
+            if (pos_ < text_.size() && text_[pos_] == close) {
+                ++pos_;
+            } else {
+                while (true) {
+                    std::string_view member;
+                    if (object) {
+                        bool escaped = false;
+                        if (pos_ >= text_.size() || text_[pos_] != '"') return fail("expected member name");
+                        ++pos_;
+                        if (!scan_string(member, escaped)) return false;
+                        skip_space();
+                        if (pos_ >= text_.size() || text_[pos_] != ':') return fail("expected ':'");
+                        ++pos_;
+                        skip_space();
+                    }
+                    if (!parse_value(member, depth + 1)) return false;
+                    skip_space();
+                    if (pos_ < text_.size() && text_[pos_] == ',') {
+                        ++pos_;
+                        skip_space();
+                        continue;
+                    }
+                    if (pos_ < text_.size() && text_[pos_] == close) {
+                        ++pos_;
+                        break;
+                    }
+                    return fail(object ? "expected ',' or '}'" : "expected ',' or ']'");
+                }
+            }
+            nodes_[index].text = text_.substr(start, pos_ - start);
+        } else if (c == '"') {
+            nodes_[index].type = JsonType::String;
+            ++pos_;
+            std::string_view body;
+            bool escaped = false;
+            ok = scan_string(body, escaped);
+            nodes_[index].text = body;
+            nodes_[index].escaped = escaped;
+        } else if (c == '-' || (c >= '0' && c <= '9')) {
+            nodes_[index].type = JsonType::Number;
+            ok = scan_number();
+        } else if (c == 't' || c == 'f') {
+            nodes_[index].type = JsonType::Bool;
+            ok = literal(c == 't' ? "true" : "false");
+            nodes_[index].text = text_.substr(start, pos_ - start);
+        } else if (c == 'n') {
+            ok = literal("null");
+            nodes_[index].text = text_.substr(start, pos_ - start);
+        } else {
+            return fail("unexpected character");
+        }
+
+        nodes_[index].end = static_cast<uint32_t>(nodes_.size());
+        return ok;
+    }
+
+    std::vector<JsonNode> nodes_;  // Pre-order; capacity is kept between parses
+    std::string_view text_;
+    size_t pos_{0};
+    std::string error_;
+};
+
+inline const JsonNode& JsonValue::node() const { return doc_->nodes()[index_]; }
+
+inline JsonType JsonValue::type() const { return node().type; }
+
+inline std::string_view JsonValue::raw() const {
+    if (!valid()) return "null";
+    const auto& n = node();
+    // String text excludes the quotes, which sit right around it in the source
+    return n.type == JsonType::String ? std::string_view(n.text.data() - 1, n.text.size() + 2) : n.text;
+}
+
+template<typename Visitor>
+void JsonValue::for_each(Visitor&& visitor) const {
+    if (!valid()) return;
+    const auto& nodes = doc_->nodes();
+    const auto& n = nodes[index_];
+    if (n.type != JsonType::Array && n.type != JsonType::Object) return;
+    for (uint32_t child = index_ + 1; child < n.end; child = nodes[child].end) {
+        visitor(JsonValue{doc_, child});
+    }
+}
+
+inline JsonValue JsonValue::find(std::string_view key) const {
+    if (!is_object()) return {};
+    const auto& nodes = doc_->nodes();
+    for (uint32_t child = index_ + 1; child < node().end; child = nodes[child].end) {
+        // Member names used by the CLI never need unescaping
+        if (nodes[child].key == key) return JsonValue{doc_, child};
+    }
+    return {};
+}
+
+inline int64_t JsonValue::as_int(int64_t fallback) const {
+    if (!valid() || type() != JsonType::Number) return fallback;
+    auto text = node().text;
+    int64_t value = 0;
+    auto [end, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
+    if (ec == std::errc() && end == text.data() + text.size()) return value;
+    double d = as_double(static_cast<double>(fallback));
+    // Doubles outside int64_t's range (and NaN) have no conversion; casting them is undefined
+    if (!(d >= -9223372036854775808.0 && d < 9223372036854775808.0)) return fallback;
+    return static_cast<double>(static_cast<int64_t>(d)) == d ? static_cast<int64_t>(d) : fallback;
+}
+
+inline double JsonValue::as_double(double fallback) const {
+    if (!valid() || type() != JsonType::Number) return fallback;
+    // strtod needs a terminator; numbers are short
+    char buffer[64];
+    auto text = node().text;
+    if (text.size() >= sizeof(buffer)) return fallback;
+    text.copy(buffer, text.size());
+    buffer[text.size()] = '\0';
+    return std::strtod(buffer, nullptr);
+}
+
+inline bool JsonValue::as_bool(bool fallback) const {
+    if (!valid() || type() != JsonType::Bool) return fallback;
+    return node().text == "true";
+}
+
+inline std::string_view JsonValue::as_string(std::string& scratch) const {
+    if (!valid() || type() != JsonType::String) return {};
+    const auto& n = node();
+    if (!n.escaped) return n.text;
+
+    auto hex4 = [](std::string_view s, size_t at, uint32_t& out) {
+        if (at + 4 > s.size()) return false;
+        out = 0;
+        for (size_t i = at; i < at + 4; ++i) {
+            char c = s[i];
+            out <<= 4;
+            if (c >= '0' && c <= '9') out |= static_cast<uint32_t>(c - '0');
+            else if (c >= 'a' && c <= 'f') out |= static_cast<uint32_t>(c - 'a' + 10);
+            else if (c >= 'A' && c <= 'F') out |= static_cast<uint32_t>(c - 'A' + 10);
+            else return false;
+        }
+        return true;
+    };
+    auto put_utf8 = [&scratch](uint32_t cp) {
+        if (cp < 0x80) {
+            scratch += static_cast<char>(cp);
+        } else if (cp < 0x800) {
+            scratch += static_cast<char>(0xC0 | (cp >> 6));
+            scratch += static_cast<char>(0x80 | (cp & 0x3F));
+        } else if (cp < 0x10000) {
+            scratch += static_cast<char>(0xE0 | (cp >> 12));
+            scratch += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+            scratch += static_cast<char>(0x80 | (cp & 0x3F));
+        } else {
+            scratch += static_cast<char>(0xF0 | (cp >> 18));
+            scratch += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+            scratch += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+            scratch += static_cast<char>(0x80 | (cp & 0x3F));
+        }
+    };
+
+    std::string_view s = n.text;
+    scratch.clear();
+    for (size_t i = 0; i < s.size(); ++i) {
+        if (s[i] != '\\' || i + 1 >= s.size()) {
+            scratch += s[i];
+            continue;
+        }
+        char e = s[++i];
+        switch (e) {
+            case 'b': scratch += '\b'; break;
+            case 'f': scratch += '\f'; break;
+            case 'n': scratch += '\n'; break;
+            case 'r': scratch += '\r'; break;
+            case 't': scratch += '\t'; break;
+            case 'u': {
+                uint32_t cp = 0;
+                if (!hex4(s, i + 1, cp)) {
+                    scratch += "\\u";
+                    break;
+                }
+                i += 4;
+                uint32_t low = 0;
+                if (cp >= 0xD800 && cp < 0xDC00 && i + 2 < s.size() && s[i + 1] == '\\' && s[i + 2] == 'u' &&
+                    hex4(s, i + 3, low) && low >= 0xDC00 && low < 0xE000) {
+                    cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+                    i += 6;
+                } else if (cp >= 0xD800 && cp < 0xE000) {
+                    cp = 0xFFFD;  // Unpaired surrogate: not encodable as UTF-8
+                }
+                put_utf8(cp);
+                break;
+            }
+            default: scratch += e; break;  // \" \\ \/
+        }
+    }
+    return scratch;
+}
+
+// ============================================================================
+// Writer
+// ============================================================================
+
+/**
+ * @brief Appends JSON to one buffer and writes it out in large blocks
+ *
+ * Commas between members and elements are inserted automatically. The
+ * buffer is handed to the stream once it passes flush_threshold, and by
+ * flush() whenever the caller is about to wait for more input.
+ */
+class JsonWriter {
+public:
+    explicit JsonWriter(std::FILE* out, size_t flush_threshold = 64 * 1024)
+        : out_(out), threshold_(flush_threshold) {
+        buffer_.reserve(flush_threshold * 2);
+    }
+
+    ~JsonWriter() { flush(); }
+
+    JsonWriter(const JsonWriter&) = delete;
+    JsonWriter& operator=(const JsonWriter&) = delete;
+
+    JsonWriter& begin_object() { separate(); buffer_ += '{'; first_.push_back(true); return *this; }
+    JsonWriter& end_object() { buffer_ += '}'; first_.pop_back(); return *this; }
+    JsonWriter& begin_array() { separate(); buffer_ += '['; first_.push_back(true); return *this; }
+    JsonWriter& end_array() { buffer_ += ']'; first_.pop_back(); return *this; }
+
+    /// Member name; the next value belongs to it
+    JsonWriter& key(std::string_view name) {
+        separate();
+        buffer_ += '"';
+        buffer_ += name;
+        buffer_ += "\":";
+        after_key_ = true;
+        return *this;
+    }
+
+    JsonWriter& value(std::string_view s) {
+        separate();
+        buffer_ += '"';
+        escape(s);
+        buffer_ += '"';
+        return *this;
+    }
+
+    JsonWriter& value(const char* s) { return value(std::string_view(s)); }
+
+    JsonWriter& value(bool b) {
+        separate();
+        buffer_ += b ? "true" : "false";
+        return *this;
+    }
+
+    template<typename Int, typename = std::enable_if_t<std::is_integral_v<Int>>>
+    JsonWriter& value(Int v) {
+        separate();
+        char digits[24];
+        auto result = std::to_chars(digits, digits + sizeof(digits), v);
+        buffer_.append(digits, static_cast<size_t>(result.ptr - digits));
+        return *this;
+    }
+
+    JsonWriter& value(double v) { return number(v, "%.10g"); }
+
+    /// Floats print with float precision, so 0.9f stays 0.9
+    JsonWriter& value(float v) { return number(static_cast<double>(v), "%.7g"); }
+
+    JsonWriter& null() {
+        separate();
+        buffer_ += "null";
+        return *this;
+    }
+
+    /// Already-encoded JSON value
+    JsonWriter& raw(std::string_view json) {
+        separate();
+        buffer_ += json;
+        return *this;
+    }
+
+    /// Members of an already-encoded JSON object, spliced into the current object
+    JsonWriter& members(std::string_view object_json) {
+        if (object_json.size() < 2 || object_json.front() != '{' || object_json.back() != '}') return *this;
+        auto inner = object_json.substr(1, object_json.size() - 2);
+        if (inner.empty()) return *this;
+        separate();
+        buffer_ += inner;
+        return *this;
+    }
+
+    /// End the current top-level value; flushes if the buffer is large
+    void end_line() {
+        buffer_ += '\n';
+        first_.clear();
+        if (buffer_.size() >= threshold_) flush();
+    }
+
+    void flush() {
+        if (buffer_.empty()) return;
+        std::fwrite(buffer_.data(), 1, buffer_.size(), out_);
+        std::fflush(out_);
+        buffer_.clear();
+    }
+
+private:
+    /// Non-finite values have no JSON spelling and are written as null
+    JsonWriter& number(double v, const char* format) {
+        if (!std::isfinite(v)) return null();
+        separate();
+        char digits[32];
+        int n = std::snprintf(digits, sizeof(digits), format, v);
+        buffer_.append(digits, n > 0 ? static_cast<size_t>(n) : 0);
+        return *this;
+    }
+
+    void separate() {
+        if (after_key_) {
+            after_key_ = false;
+            return;
+        }
+        if (first_.empty()) return;
+        if (!first_.back()) buffer_ += ',';
+        first_.back() = false;
+    }
+
+    void escape(std::string_view s) {
+        for (char c : s) {
+            switch (c) {
+                case '"': buffer_ += "\\\""; break;
+                case '\\': buffer_ += "\\\\"; break;
+                case '\b': buffer_ += "\\b"; break;
+                case '\f': buffer_ += "\\f"; break;
+                case '\n': buffer_ += "\\n"; break;
+                case '\r': buffer_ += "\\r"; break;
+                case '\t': buffer_ += "\\t"; break;
+                default:
+                    if (static_cast<unsigned char>(c) < 0x20) {
+                        char hex[8];
+                        std::snprintf(hex, sizeof(hex), "\\u%04x", static_cast<unsigned char>(c));
+                        buffer_ += hex;
+                    } else {
+                        buffer_ += c;
+                    }
+            }
+        }
+    }
+
+    std::FILE* out_;
+    size_t threshold_;
+    std::string buffer_;
+    std::vector<bool> first_;  // Per open container: no element written yet
+    bool after_key_{false};
+};
+
+} // namespace cratedigger::cli
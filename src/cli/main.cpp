@@ -5,17 +5,25 @@
  * Per INTRODUCTION_JAVA_TO_CPP.md:
  * - MUST: CLI (JSONL for Agents/Pipe)
  * - MUST: --schema support for describe_api()
+ *
+ * Each input line is one command object, or an array of command objects
+ * answered by one array line in the same order. A "request_id" member of
+ * any JSON type is echoed back first in its response so callers can
+ * pipeline requests. Output is buffered and only flushed when no further
+ * input is waiting.
  */
 
 #include "cratedigger/cratedigger.hpp"
+#include "session.hpp"
+#include <cstring>
 #include <iostream>
-#include <fstream>
-#include <sstream>
 #include <string>
-#include <cstring>
 
 namespace {
 
+using cratedigger::cli::JsonWriter;
+using cratedigger::cli::Session;
+
 void print_usage(const char* program_name) {
     std::cerr << "Usage: " << program_name << " [OPTIONS] [FILE]\n"
               << "\n"
@@ -23,24 +31,41 @@ void print_usage(const char* program_name) {
               << "\n"
               << "Options:\n"
               << "  --schema          Output API schema as JSON (for AI agents)\n"
+              << "  --anlz DIR        Load ANLZ files from DIR after opening\n"
+              << "  --lazy-anlz       Load ANLZ files on demand per track\n"
+              << "  --export-arrow F  Write all tracks to Arrow IPC file F (\"-\" streams to stdout) and exit\n"
+              << "  --metrics         Print open/load metrics as one JSON line to stderr after loading\n"
               << "  --help            Show this help message\n"
               << "  --version         Show version information\n"
               << "\n"
               << "Interactive mode:\n"
               << "  When FILE is provided, opens the database and accepts JSONL commands on stdin.\n"
+              << "  A line may also hold an array of commands; the answer is one array line.\n"
+              << "  Any \"request_id\" is echoed back in the matching response.\n"
               << "\n"
               << "JSONL Commands:\n"
               << "  {\"cmd\": \"describe_api\"}              Get API schema\n"
               << "  {\"cmd\": \"get_track\", \"id\": 123}      Get track by ID\n"
+              << "  {\"cmd\": \"get_artist\", \"id\": 1}       Also get_album, get_genre, get_playlist\n"
               << "  {\"cmd\": \"find_tracks_by_title\", \"title\": \"...\"}\n"
+              << "  {\"cmd\": \"find_tracks_by_bpm_range\", \"min_bpm\": 120, \"max_bpm\": 130}\n"
+              << "  {\"cmd\": \"find_tracks\", \"min_bpm\": 120, \"genre_id\": 3}\n"
+              << "  {\"cmd\": \"search_tracks\", \"query\": \"...\", \"limit\": 10}\n"
+              << "  {\"cmd\": \"load_cue_points\", \"dir\": \"PIONEER/USBANLZ\"}\n"
+              << "  {\"cmd\": \"get_cue_points\", \"id\": 123}\n"
+              << "  {\"cmd\": \"get_beat_grid\", \"id\": 123}\n"
+              << "  {\"cmd\": \"get_waveform\", \"id\": 123, \"kind\": \"preview\", \"max_points\": 400}\n"
               << "  {\"cmd\": \"all_track_ids\"}             Get all track IDs\n"
               << "  {\"cmd\": \"track_count\"}               Get track count\n"
+              << "  {\"cmd\": \"get_metrics\"}               Open/load timings and counters\n"
               << "  {\"cmd\": \"exit\"}                      Exit the program\n"
               << "\n"
               << "Example:\n"
               << "  " << program_name << " --schema\n"
               << "  " << program_name << " export.pdb\n"
-              << "  echo '{\"cmd\":\"track_count\"}' | " << program_name << " export.pdb\n";
+              << "  echo '{\"cmd\":\"track_count\"}' | " << program_name << " export.pdb\n"
+              << "  echo '[{\"cmd\":\"get_track\",\"id\":1,\"request_id\":7},{\"cmd\":\"track_count\"}]' | "
+              << program_name << " export.pdb\n";
 }
 
 void print_version() {
@@ -53,167 +78,17 @@ void print_schema() {
     std::cout << cratedigger::to_json(schema) << '\n';
 }
 
-/// Escape a string for JSON output
-std::string json_escape(std::string_view str) {
-    std::string result;
-    result.reserve(str.size());
-    for (char c : str) {
-        switch (c) {
-            case '"': result += "\\\""; break;
-            case '\\': result += "\\\\"; break;
-            case '\b': result += "\\b"; break;
-            case '\f': result += "\\f"; break;
-            case '\n': result += "\\n"; break;
-            case '\r': result += "\\r"; break;
-            case '\t': result += "\\t"; break;
-            default:
-                if (c >= 0 && c < 32) {
-                    char buf[8];
-                    std::snprintf(buf, sizeof(buf), "\\u%04x", static_cast<unsigned char>(c));
-                    result += buf;
-                } else {
-                    result += c;
-                }
-        }
-    }
-    return result;
-}
-
-/// Parse a simple JSON string value
-std::string parse_json_string(std::string_view json, std::string_view key) {
-    auto key_pos = json.find(std::string("\"") + std::string(key) + "\"");
-    if (key_pos == std::string_view::npos) return "";
-
-    auto colon_pos = json.find(':', key_pos);
-    if (colon_pos == std::string_view::npos) return "";
-
-    auto quote_start = json.find('"', colon_pos + 1);
-    if (quote_start == std::string_view::npos) return "";
-
-    auto quote_end = json.find('"', quote_start + 1);
-    if (quote_end == std::string_view::npos) return "";
-
-    return std::string(json.substr(quote_start + 1, quote_end - quote_start - 1));
-}
-
-/// Parse a simple JSON integer value
-int64_t parse_json_int(std::string_view json, std::string_view key) {
-    auto key_pos = json.find(std::string("\"") + std::string(key) + "\"");
-    if (key_pos == std::string_view::npos) return 0;
-
-    auto colon_pos = json.find(':', key_pos);
-    if (colon_pos == std::string_view::npos) return 0;
-
-    // Skip whitespace
-    size_t num_start = colon_pos + 1;
-    while (num_start < json.size() && (json[num_start] == ' ' || json[num_start] == '\t')) {
-        ++num_start;
-    }
-
-    // Find end of number
-    size_t num_end = num_start;
-    while (num_end < json.size() && (std::isdigit(json[num_end]) || json[num_end] == '-')) {
-        ++num_end;
-    }
-
-    if (num_end == num_start) return 0;
-
-    return std::stoll(std::string(json.substr(num_start, num_end - num_start)));
-}
-
-/// Output track as JSON
-void output_track(const cratedigger::TrackRow& track) {
-    std::cout << "{"
-              << "\"id\":" << track.id.value
-              << ",\"title\":\"" << json_escape(track.title) << "\""
-              << ",\"artist_id\":" << track.artist_id.value
-              << ",\"album_id\":" << track.album_id.value
-              << ",\"genre_id\":" << track.genre_id.value
-              << ",\"bpm\":" << (track.bpm_100x / 100.0)
-              << ",\"duration\":" << track.duration_seconds
-              << ",\"rating\":" << track.rating
-              << ",\"year\":" << track.year
-              << ",\"file_path\":\"" << json_escape(track.file_path) << "\""
-              << "}\n";
-}
-
-/// Output error as JSON
-void output_error(std::string_view message) {
-    std::cout << "{\"error\":\"" << json_escape(message) << "\"}\n";
-}
-
-/// Process a single JSONL command
-bool process_command(const cratedigger::Database& db, std::string_view line) {
-    auto cmd = parse_json_string(line, "cmd");
-
-    if (cmd == "exit" || cmd == "quit") {
-        return false;
-    }
-    else if (cmd == "describe_api") {
-        print_schema();
-    }
-    else if (cmd == "get_track") {
-        int64_t id = parse_json_int(line, "id");
-        auto track = db.get_track(cratedigger::TrackId{id});
-        if (track) {
-            output_track(*track);
-        } else {
-            output_error("Track not found");
-        }
-    }
-    else if (cmd == "find_tracks_by_title") {
-        auto title = parse_json_string(line, "title");
-        auto ids = db.find_tracks_by_title(title);
-        std::cout << "{\"track_ids\":[";
-        bool first = true;
-        for (const auto& id : ids) {
-            if (!first) std::cout << ",";
-            first = false;
-            std::cout << id.value;
-        }
-        std::cout << "]}\n";
-    }
-    else if (cmd == "all_track_ids") {
-        auto ids = db.all_track_ids();
-        std::cout << "{\"track_ids\":[";
-        bool first = true;
-        for (const auto& id : ids) {
-            if (!first) std::cout << ",";
-            first = false;
-            std::cout << id.value;
-        }
-        std::cout << "]}\n";
-    }
-    else if (cmd == "track_count") {
-        std::cout << "{\"count\":" << db.track_count() << "}\n";
-    }
-    else if (cmd == "artist_count") {
-        std::cout << "{\"count\":" << db.artist_count() << "}\n";
-    }
-    else if (cmd == "album_count") {
-        std::cout << "{\"count\":" << db.album_count() << "}\n";
-    }
-    else if (cmd == "genre_count") {
-        std::cout << "{\"count\":" << db.genre_count() << "}\n";
-    }
-    else if (cmd == "playlist_count") {
-        std::cout << "{\"count\":" << db.playlist_count() << "}\n";
-    }
-    else if (cmd.empty()) {
-        // Ignore empty commands
-    }
-    else {
-        output_error("Unknown command: " + std::string(cmd));
-    }
-
-    return true;
-}
-
 } // anonymous namespace
 
 int main(int argc, char* argv[]) {
+    std::ios::sync_with_stdio(false);
+
     // Parse command line arguments
     std::string db_path;
+    std::string anlz_dir;
+    std::string arrow_path;
+    bool lazy_anlz = false;
+    bool show_metrics = false;
     bool show_schema = false;
     bool show_help = false;
     bool show_version = false;
@@ -222,6 +97,18 @@ int main(int argc, char* argv[]) {
         if (std::strcmp(argv[i], "--schema") == 0) {
             show_schema = true;
         }
+        else if (std::strcmp(argv[i], "--anlz") == 0 && i + 1 < argc) {
+            anlz_dir = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--export-arrow") == 0 && i + 1 < argc) {
+            arrow_path = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--lazy-anlz") == 0) {
+            lazy_anlz = true;
+        }
+        else if (std::strcmp(argv[i], "--metrics") == 0) {
+            show_metrics = true;
+        }
         else if (std::strcmp(argv[i], "--help") == 0 || std::strcmp(argv[i], "-h") == 0) {
             show_help = true;
         }
@@ -258,28 +145,69 @@ int main(int argc, char* argv[]) {
         return 1;
     }
 
+    JsonWriter out(stdout);
+
     // Open database
     auto db_result = cratedigger::Database::open(db_path);
     if (!db_result) {
-        output_error(db_result.error().message);
+        out.begin_object().key("error").value(db_result.error().message).end_object();
+        out.end_line();
         return 1;
     }
 
     auto& db = *db_result;
+    if (lazy_anlz) {
+        db.enable_lazy_anlz_loading();
+    }
+    if (!anlz_dir.empty()) {
+        db.load_cue_points(anlz_dir);
+    }
+    if (show_metrics) {
+        // stderr keeps stdout a clean response stream
+        std::cerr << cratedigger::to_json(db.metrics()) << '\n';
+    }
+
+#ifdef CRATE_DIGGER_ARROW_EXPORT
+    if (!arrow_path.empty()) {
+        bool to_stdout = arrow_path == "-";
+        cratedigger::ArrowExportOptions options;
+        options.format = to_stdout ? cratedigger::ArrowFormat::Stream : cratedigger::ArrowFormat::File;
+        auto exported = to_stdout ? cratedigger::export_tracks_arrow(db, std::cout, options)
+                                  : cratedigger::export_tracks_arrow(db, arrow_path, options);
+        if (!exported) {
+            std::cerr << exported.error().message << "\n";
+            return 1;
+        }
+        return 0;
+    }
+#else
+    if (!arrow_path.empty()) {
+        std::cerr << "Arrow export is not built (CRATE_DIGGER_BUILD_ARROW_EXPORT=OFF)\n";
+        return 1;
+    }
+#endif
 
     // Output database info
-    std::cout << "{\"status\":\"opened\""
-              << ",\"tracks\":" << db.track_count()
-              << ",\"artists\":" << db.artist_count()
-              << ",\"albums\":" << db.album_count()
-              << ",\"genres\":" << db.genre_count()
-              << ",\"playlists\":" << db.playlist_count()
-              << "}\n";
+    out.begin_object()
+        .key("status").value("opened")
+        .key("tracks").value(db.track_count())
+        .key("artists").value(db.artist_count())
+        .key("albums").value(db.album_count())
+        .key("genres").value(db.genre_count())
+        .key("playlists").value(db.playlist_count())
+        .end_object();
+    out.end_line();
+    out.flush();
 
     // Interactive mode: read JSONL commands from stdin
+    Session session(db, out);
     std::string line;
-    while (std::getline(std::cin, line)) {
-        if (!process_command(db, line)) {
+    while (true) {
+        // Only pay for a write when the caller has to wait for the answers
+        if (std::cin.rdbuf()->in_avail() <= 0) {
+            out.flush();
+        }
+        if (!std::getline(std::cin, line) || !session.process_line(line)) {
             break;
         }
     }
@@ -0,0 +1,477 @@
+#pragma once
+/**
+ * @file session.hpp
+ * @brief Command dispatch of the JSONL CLI
+ *
+ * Each input line is one command object, or an array of command objects
+ * answered by one array line in the same order. A "request_id" member of
+ * any JSON type is echoed back first in its response so callers can
+ * pipeline requests.
+ */
+
+#include "cratedigger/cratedigger.hpp"
+#include "json.hpp"
+#include <algorithm>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace cratedigger::cli {
+
+inline std::string_view text_field_to_string(cratedigger::TextField field) {
+    switch (field) {
+        case cratedigger::TextField::Title: return "title";
+        case cratedigger::TextField::Artist: return "artist";
+        case cratedigger::TextField::Album: return "album";
+        case cratedigger::TextField::FileName: return "filename";
+        case cratedigger::TextField::FilePath: return "file_path";
+    }
+    return "unknown";
+}
+
+// ============================================================================
+// Session
+// ============================================================================
+
+/// Per-process command state; scratch buffers are reused between requests
+class Session {
+public:
+    Session(cratedigger::Database& db, JsonWriter& out) : db_(db), out_(out) {}
+
+    /// Answer one input line (false once an exit command was seen)
+    bool process_line(std::string_view line);
+
+    /// Write the response object for one command
+    void respond(JsonValue request);
+
+    /// Write an error response
+    void output_error(std::string_view message) {
+        out_.begin_object().key("error").value(message).end_object();
+    }
+
+private:
+    using Handler = void (Session::*)(JsonValue args);
+
+    static const std::unordered_map<std::string_view, Handler>& handlers();
+
+    // Arguments -------------------------------------------------------------
+
+    /// First present member among the accepted names
+    static JsonValue arg(JsonValue args, std::string_view name, std::string_view alias = {}) {
+        JsonValue value = args.find(name);
+        if (!value.valid() && !alias.empty()) value = args.find(alias);
+        return value;
+    }
+
+    /// Required numeric argument (writes an error and returns false if missing)
+    bool require_number(JsonValue value, std::string_view name) {
+        if (value.valid() && value.type() == JsonType::Number) return true;
+        out_.key("error").value("Missing numeric parameter: " + std::string(name));
+        return false;
+    }
+
+    bool require_string(JsonValue value, std::string_view name) {
+        if (value.valid() && value.type() == JsonType::String) return true;
+        out_.key("error").value("Missing string parameter: " + std::string(name));
+        return false;
+    }
+
+    // Output ------------------------------------------------------------------
+
+    template<typename Range>
+    void write_track_ids(const Range& ids) {
+        out_.key("track_ids").begin_array();
+        for (const auto& id : ids) out_.value(id.value);
+        out_.end_array();
+    }
+
+    void write_track(const cratedigger::TrackRow& track) {
+        out_.key("id").value(track.id.value)
+            .key("title").value(track.title)
+            .key("artist_id").value(track.artist_id.value)
+            .key("album_id").value(track.album_id.value)
+            .key("genre_id").value(track.genre_id.value)
+            .key("bpm").value(track.bpm_100x / 100.0)
+            .key("duration").value(track.duration_seconds)
+            .key("rating").value(track.rating)
+            .key("year").value(track.year)
+            .key("file_path").value(track.file_path);
+    }
+
+    // Commands ----------------------------------------------------------------
+
+    void cmd_describe_api(JsonValue) {
+        if (schema_json_.empty()) schema_json_ = cratedigger::to_json(cratedigger::describe_api());
+        out_.members(schema_json_);
+    }
+
+    void cmd_get_track(JsonValue args) {
+        auto id = arg(args, "track_id", "id");
+        if (!require_number(id, "track_id")) return;
+        if (auto track = db_.get_track(cratedigger::TrackId{id.as_int()})) {
+            write_track(*track);
+        } else {
+            out_.key("error").value("Track not found");
+        }
+    }
+
+    void cmd_get_artist(JsonValue args) {
+        auto id = arg(args, "artist_id", "id");
+        if (!require_number(id, "artist_id")) return;
+        if (const auto* artist = db_.get_artist_view(cratedigger::ArtistId{id.as_int()})) {
+            out_.key("id").value(artist->id.value).key("name").value(artist->name);
+        } else {
+            out_.key("error").value("Artist not found");
+        }
+    }
+
+    void cmd_get_album(JsonValue args) {
+        auto id = arg(args, "album_id", "id");
+        if (!require_number(id, "album_id")) return;
+        if (const auto* album = db_.get_album_view(cratedigger::AlbumId{id.as_int()})) {
+            out_.key("id").value(album->id.value)
+                .key("name").value(album->name)
+                .key("artist_id").value(album->artist_id.value);
+        } else {
+            out_.key("error").value("Album not found");
+        }
+    }
+
+    void cmd_get_genre(JsonValue args) {
+        auto id = arg(args, "genre_id", "id");
+        if (!require_number(id, "genre_id")) return;
+        if (const auto* genre = db_.get_genre_view(cratedigger::GenreId{id.as_int()})) {
+            out_.key("id").value(genre->id.value).key("name").value(genre->name);
+        } else {
+            out_.key("error").value("Genre not found");
+        }
+    }
+
+    void cmd_get_playlist(JsonValue args) {
+        auto id = arg(args, "playlist_id", "id");
+        if (!require_number(id, "playlist_id")) return;
+        if (auto tracks = db_.get_playlist(cratedigger::PlaylistId{id.as_int()})) {
+            write_track_ids(*tracks);
+        } else {
+            out_.key("error").value("Playlist not found");
+        }
+    }
+
+    void cmd_find_tracks_by_title(JsonValue args) {
+        auto title = arg(args, "title");
+        if (!require_string(title, "title")) return;
+        write_track_ids(db_.find_tracks_by_title_view(title.as_string(scratch_)));
+    }
+
+    void cmd_find_tracks_by_filename(JsonValue args) {
+        auto filename = arg(args, "filename");
+        if (!require_string(filename, "filename")) return;
+        write_track_ids(db_.find_tracks_by_filename_view(filename.as_string(scratch_)));
+    }
+
+    void cmd_find_tracks_by_artist(JsonValue args) {
+        auto id = arg(args, "artist_id", "id");
+        if (!require_number(id, "artist_id")) return;
+        write_track_ids(db_.find_tracks_by_artist_view(cratedigger::ArtistId{id.as_int()}));
+    }
+
+    void cmd_find_tracks_by_album(JsonValue args) {
+        auto id = arg(args, "album_id", "id");
+        if (!require_number(id, "album_id")) return;
+        write_track_ids(db_.find_tracks_by_album_view(cratedigger::AlbumId{id.as_int()}));
+    }
+
+    void cmd_find_tracks_by_genre(JsonValue args) {
+        auto id = arg(args, "genre_id", "id");
+        if (!require_number(id, "genre_id")) return;
+        write_track_ids(db_.find_tracks_by_genre_view(cratedigger::GenreId{id.as_int()}));
+    }
+
+    void cmd_find_tracks_by_bpm_range(JsonValue args) {
+        auto lo = arg(args, "min_bpm");
+        auto hi = arg(args, "max_bpm");
+        if (!require_number(lo, "min_bpm") || !require_number(hi, "max_bpm")) return;
+        write_track_ids(db_.find_tracks_by_bpm_range(static_cast<float>(lo.as_double()),
+                                                     static_cast<float>(hi.as_double())));
+    }
+
+    void cmd_find_tracks_by_duration_range(JsonValue args) {
+        auto lo = arg(args, "min_seconds");
+        auto hi = arg(args, "max_seconds");
+        if (!require_number(lo, "min_seconds") || !require_number(hi, "max_seconds")) return;
+        write_track_ids(db_.find_tracks_by_duration_range(static_cast<uint32_t>(lo.as_int()),
+                                                          static_cast<uint32_t>(hi.as_int())));
+    }
+
+    void cmd_find_tracks_by_year_range(JsonValue args) {
+        auto lo = arg(args, "min_year");
+        auto hi = arg(args, "max_year");
+        if (!require_number(lo, "min_year") || !require_number(hi, "max_year")) return;
+        write_track_ids(db_.find_tracks_by_year_range(static_cast<uint16_t>(lo.as_int()),
+                                                      static_cast<uint16_t>(hi.as_int())));
+    }
+
+    void cmd_find_tracks_by_rating_range(JsonValue args) {
+        auto lo = arg(args, "min_rating");
+        auto hi = arg(args, "max_rating");
+        if (!require_number(lo, "min_rating") || !require_number(hi, "max_rating")) return;
+        write_track_ids(db_.find_tracks_by_rating_range(static_cast<uint16_t>(lo.as_int()),
+                                                        static_cast<uint16_t>(hi.as_int())));
+    }
+
+    void cmd_find_tracks_by_rating(JsonValue args) {
+        auto rating = arg(args, "rating");
+        if (!require_number(rating, "rating")) return;
+        write_track_ids(db_.find_tracks_by_rating(static_cast<uint16_t>(rating.as_int())));
+    }
+
+    void cmd_find_tracks(JsonValue args) {
+        cratedigger::TrackQuery query;
+        auto number = [&args](std::string_view name) { return arg(args, name); };
+        auto is_set = [](JsonValue v) { return v.valid() && v.type() == JsonType::Number; };
+
+        if (auto v = number("min_bpm"); is_set(v)) query.min_bpm = static_cast<float>(v.as_double());
+        if (auto v = number("max_bpm"); is_set(v)) query.max_bpm = static_cast<float>(v.as_double());
+        if (auto v = number("key_id"); is_set(v)) query.key = cratedigger::KeyId{v.as_int()};
+        if (auto v = number("genre_id"); is_set(v)) query.genre = cratedigger::GenreId{v.as_int()};
+        if (auto v = number("artist_id"); is_set(v)) query.artist = cratedigger::ArtistId{v.as_int()};
+        if (auto v = number("min_rating"); is_set(v)) query.min_rating = static_cast<uint16_t>(v.as_int());
+        if (auto v = number("max_rating"); is_set(v)) query.max_rating = static_cast<uint16_t>(v.as_int());
+        if (auto v = number("min_year"); is_set(v)) query.min_year = static_cast<uint16_t>(v.as_int());
+        if (auto v = number("max_year"); is_set(v)) query.max_year = static_cast<uint16_t>(v.as_int());
+        if (auto v = number("min_seconds"); is_set(v)) query.min_duration = static_cast<uint32_t>(v.as_int());
+        if (auto v = number("max_seconds"); is_set(v)) query.max_duration = static_cast<uint32_t>(v.as_int());
+        write_track_ids(db_.find_tracks(query));
+    }
+
+    void cmd_search_tracks(JsonValue args) {
+        auto query = arg(args, "query");
+        if (!require_string(query, "query")) return;
+
+        cratedigger::TextSearchOptions options;
+        options.limit = static_cast<size_t>(std::max<int64_t>(0, arg(args, "limit").as_int(50)));
+        options.fields = static_cast<uint8_t>(arg(args, "fields").as_int(options.fields));
+        options.prefix_only = arg(args, "prefix_only").as_bool(false);
+        options.fuzzy = arg(args, "fuzzy").as_bool(false);
+
+        out_.key("hits").begin_array();
+        for (const auto& hit : db_.search_tracks(query.as_string(scratch_), options)) {
+            out_.begin_object()
+                .key("track_id").value(hit.track_id.value)
+                .key("field").value(text_field_to_string(hit.field))
+                .key("score").value(hit.score)
+                .end_object();
+        }
+        out_.end_array();
+    }
+
+    void cmd_all_track_ids(JsonValue) { write_track_ids(db_.all_track_ids()); }
+    void cmd_track_count(JsonValue) { out_.key("count").value(db_.track_count()); }
+    void cmd_artist_count(JsonValue) { out_.key("count").value(db_.artist_count()); }
+    void cmd_album_count(JsonValue) { out_.key("count").value(db_.album_count()); }
+    void cmd_genre_count(JsonValue) { out_.key("count").value(db_.genre_count()); }
+    void cmd_playlist_count(JsonValue) { out_.key("count").value(db_.playlist_count()); }
+    void cmd_get_metrics(JsonValue) { out_.key("metrics").raw(cratedigger::to_json(db_.metrics())); }
+
+    void cmd_load_cue_points(JsonValue args) {
+        auto dir = arg(args, "dir", "path");
+        if (!require_string(dir, "dir")) return;
+        db_.load_cue_points(std::string(dir.as_string(scratch_)));
+        out_.key("status").value("loaded");
+    }
+
+    void cmd_get_cue_points(JsonValue args) {
+        auto id = arg(args, "track_id", "id");
+        if (!require_number(id, "track_id")) return;
+        auto analysis = db_.get_analysis_for_track(cratedigger::TrackId{id.as_int()});
+        out_.key("cue_points").begin_array();
+        if (analysis) {
+            for (const auto& cue : analysis->cue_points) {
+                out_.begin_object()
+                    .key("type").value(cratedigger::cue_point_type_to_string(cue.type))
+                    .key("time_ms").value(cue.time_ms)
+                    .key("loop_time_ms").value(cue.loop_time_ms)
+                    .key("hot_cue_number").value(cue.hot_cue_number)
+                    .key("color_id").value(cue.color_id)
+                    .key("comment").value(cue.comment)
+                    .end_object();
+            }
+        }
+        out_.end_array();
+    }
+
+    /// Beat grid as parallel columns (one array per field)
+    void cmd_get_beat_grid(JsonValue args) {
+        auto id = arg(args, "track_id", "id");
+        if (!require_number(id, "track_id")) return;
+        auto analysis = db_.get_analysis_for_track(cratedigger::TrackId{id.as_int()});
+        if (!analysis || analysis->beat_grid.empty()) {
+            out_.key("error").value("Beat grid not found");
+            return;
+        }
+        const auto* grid = &analysis->beat_grid;
+        out_.key("count").value(grid->beats.size());
+        out_.key("beat_numbers").begin_array();
+        for (const auto& beat : grid->beats) out_.value(beat.beat_number);
+        out_.end_array().key("tempo_100x").begin_array();
+        for (const auto& beat : grid->beats) out_.value(beat.tempo_100x);
+        out_.end_array().key("times_ms").begin_array();
+        for (const auto& beat : grid->beats) out_.value(beat.time_ms);
+        out_.end_array();
+    }
+
+    /**
+     * Waveform heights (and RGB colors or three bands where present),
+     * reduced to at most max_points entries by taking each bucket's peak
+     * (per channel for colors).
+     */
+    void cmd_get_waveform(JsonValue args) {
+        auto id = arg(args, "track_id", "id");
+        if (!require_number(id, "track_id")) return;
+        auto analysis = db_.get_analysis_for_track(cratedigger::TrackId{id.as_int()});
+        const auto* waveforms = analysis && analysis->waveforms.has_any() ? &analysis->waveforms : nullptr;
+
+        std::string_view kind = arg(args, "kind").as_string(scratch_);
+        if (kind.empty()) kind = "preview";
+        const cratedigger::WaveformData* wave = nullptr;
+        if (waveforms) {
+            if (kind == "preview" && waveforms->preview) wave = &*waveforms->preview;
+            else if (kind == "detail" && waveforms->detail) wave = &*waveforms->detail;
+            else if (kind == "color_preview" && waveforms->color_preview) wave = &*waveforms->color_preview;
+        }
+        if (!wave) {
+            out_.key("error").value("Waveform not found: " + std::string(kind));
+            return;
+        }
+
+        size_t entries = wave->entry_count;
+        int64_t requested = arg(args, "max_points").as_int(0);
+        size_t points = requested > 0 ? std::min(entries, static_cast<size_t>(requested)) : entries;
+
+        out_.key("kind").value(kind)
+            .key("style").value(cratedigger::waveform_style_to_string(wave->style))
+            .key("entry_count").value(entries)
+            .key("points").value(points);
+
+        // Bucket [i * entries / points, (i + 1) * entries / points) folds into point i
+        cratedigger::DecodedWaveform decoded(*wave);
+        decoded.render_into(0, entries, points, columns_);
+        auto write_channel = [&](const char* key, const std::vector<uint8_t>& values) {
+            out_.key(key).begin_array();
+            for (uint8_t v : values) out_.value(v);
+            out_.end_array();
+        };
+        write_channel("heights", columns_.max_height);
+
+        if (wave->style == cratedigger::WaveformStyle::RGB) {
+            out_.key("colors").begin_array();
+            for (size_t i = 0; i < columns_.size(); ++i) {
+                out_.value((uint32_t{columns_.red[i]} << 16) | (uint32_t{columns_.green[i]} << 8) | columns_.blue[i]);
+            }
+            out_.end_array();
+        } else if (wave->style == cratedigger::WaveformStyle::ThreeBand) {
+            write_channel("low", columns_.low);
+            write_channel("mid", columns_.mid);
+            write_channel("high", columns_.high);
+        }
+    }
+
+    cratedigger::Database& db_;
+    JsonWriter& out_;
+    JsonDocument doc_;
+    std::string scratch_;      // Unescaped string arguments
+    cratedigger::WaveformColumns columns_;  // get_waveform output, reused between requests
+    std::string schema_json_;  // describe_api() output, built on first use
+    bool exiting_{false};
+};
+
+inline const std::unordered_map<std::string_view, Session::Handler>& Session::handlers() {
+    static const std::unordered_map<std::string_view, Handler> table = {
+        {"describe_api", &Session::cmd_describe_api},
+        {"get_track", &Session::cmd_get_track},
+        {"get_artist", &Session::cmd_get_artist},
+        {"get_album", &Session::cmd_get_album},
+        {"get_genre", &Session::cmd_get_genre},
+        {"get_playlist", &Session::cmd_get_playlist},
+        {"find_tracks_by_title", &Session::cmd_find_tracks_by_title},
+        {"find_tracks_by_filename", &Session::cmd_find_tracks_by_filename},
+        {"find_tracks_by_artist", &Session::cmd_find_tracks_by_artist},
+        {"find_tracks_by_album", &Session::cmd_find_tracks_by_album},
+        {"find_tracks_by_genre", &Session::cmd_find_tracks_by_genre},
+        {"find_tracks_by_bpm_range", &Session::cmd_find_tracks_by_bpm_range},
+        {"find_tracks_by_duration_range", &Session::cmd_find_tracks_by_duration_range},
+        {"find_tracks_by_year_range", &Session::cmd_find_tracks_by_year_range},
+        {"find_tracks_by_rating_range", &Session::cmd_find_tracks_by_rating_range},
+        {"find_tracks_by_rating", &Session::cmd_find_tracks_by_rating},
+        {"find_tracks", &Session::cmd_find_tracks},
+        {"search_tracks", &Session::cmd_search_tracks},
+        {"all_track_ids", &Session::cmd_all_track_ids},
+        {"track_count", &Session::cmd_track_count},
+        {"artist_count", &Session::cmd_artist_count},
+        {"album_count", &Session::cmd_album_count},
+        {"genre_count", &Session::cmd_genre_count},
+        {"playlist_count", &Session::cmd_playlist_count},
+        {"get_metrics", &Session::cmd_get_metrics},
+        {"load_cue_points", &Session::cmd_load_cue_points},
+        {"get_cue_points", &Session::cmd_get_cue_points},
+        {"get_beat_grid", &Session::cmd_get_beat_grid},
+        {"get_waveform", &Session::cmd_get_waveform},
+    };
+    return table;
+}
+
+inline void Session::respond(JsonValue request) {
+    out_.begin_object();
+    if (!request.is_object()) {
+        out_.key("error").value("Command must be a JSON object").end_object();
+        return;
+    }
+    if (auto id = request.find("request_id"); id.valid()) {
+        out_.key("request_id").raw(id.raw());
+    }
+
+    std::string_view cmd = request.find("cmd").as_string(scratch_);
+    std::string name(cmd);  // scratch_ is reused by the handler
+    if (name == "exit" || name == "quit") {
+        exiting_ = true;
+    } else if (name.empty()) {
+        out_.key("error").value("Missing cmd");
+    } else if (auto it = handlers().find(name); it != handlers().end()) {
+        (this->*(it->second))(request);
+    } else {
+        out_.key("error").value("Unknown command: " + name);
+    }
+    out_.end_object();
+}
+
+inline bool Session::process_line(std::string_view line) {
+    if (line.find_first_not_of(" \t\r") == std::string_view::npos) {
+        return true;  // Ignore empty lines
+    }
+    if (!doc_.parse(line)) {
+        output_error("Invalid JSON: " + doc_.error());
+        out_.end_line();
+        return true;
+    }
+
+    JsonValue root = doc_.root();
+    if (root.is_array()) {
+        // Commands after an exit in the same batch are skipped
+        out_.begin_array();
+        root.for_each([this](JsonValue request) {
+            if (!exiting_) respond(request);
+        });
+        out_.end_array();
+        out_.end_line();
+        return !exiting_;
+    }
+
+    if (auto cmd = root.find("cmd"); cmd.valid() && (cmd.raw() == "\"exit\"" || cmd.raw() == "\"quit\"")) {
+        return false;
+    }
+    respond(root);
+    out_.end_line();
+    return !exiting_;
+}
+
+} // namespace cratedigger::cli
@@ -226,6 +226,13 @@ ApiSchema describe_api() {
         "Integer count"
     ));
 
+    schema.commands.push_back(make_command(
+        "get_metrics",
+        "Get open and ANLZ load metrics: phase times, per-table pages/rows/bytes/parse time, ANLZ files per second and cache hit rates",
+        {},
+        "Metrics JSON object"
+    ));
+
     // Describe API (self-referential)
     schema.commands.push_back(make_command(
         "describe_api",
@@ -0,0 +1,284 @@
+#include "cratedigger/arrow_export.hpp"
+#include "cratedigger/logging.hpp"
+#include "cratedigger/rekordbox_anlz.hpp"
+#include "arrow_ipc.hpp"
+#include <fstream>
+#include <ostream>
+
+namespace cratedigger {
+
+namespace {
+
+using detail::ArrowBlock;
+using detail::ArrowBuffer;
+using detail::ArrowField;
+using detail::ArrowFieldNode;
+using detail::ArrowType;
+
+constexpr ArrowField int_field(std::string_view name, uint8_t bits, bool is_signed) {
+    return {name, ArrowType::Int, bits, is_signed};
+}
+
+constexpr ArrowField utf8_field(std::string_view name) {
+    return {name, ArrowType::Utf8, 0, false};
+}
+
+/// Track columns, in the order BatchBuilder::append_track() fills them
+std::vector<ArrowField> track_fields(bool include_analysis) {
+    std::vector<ArrowField> fields = {
+        int_field("track_id", 64, true),
+        utf8_field("title"),
+        int_field("artist_id", 64, true),
+        utf8_field("artist"),
+        int_field("album_id", 64, true),
+        utf8_field("album"),
+        int_field("genre_id", 64, true),
+        utf8_field("genre"),
+        int_field("key_id", 64, true),
+        utf8_field("key"),
+        int_field("label_id", 64, true),
+        utf8_field("label"),
+        int_field("bpm_100x", 32, false),
+        int_field("duration", 32, false),
+        int_field("year", 16, false),
+        int_field("rating", 16, false),
+        int_field("bitrate", 32, false),
+        int_field("sample_rate", 32, false),
+        int_field("play_count", 16, false),
+        int_field("track_number", 32, false),
+        int_field("file_size", 32, false),
+        utf8_field("isrc"),
+        utf8_field("comment"),
+        utf8_field("date_added"),
+        utf8_field("file_path"),
+        utf8_field("filename"),
+    };
+    if (include_analysis) {
+        fields.push_back(int_field("beat_count", 32, false));
+        fields.push_back(int_field("first_beat_ms", 32, false));
+        fields.push_back(int_field("cue_count", 32, false));
+        fields.push_back(int_field("hot_cue_count", 32, false));
+        fields.push_back(int_field("loop_count", 32, false));
+    }
+    return fields;
+}
+
+/// Arrow bodies keep every buffer 8-byte aligned
+constexpr size_t body_padded(size_t size) {
+    return (size + 7) & ~size_t{7};
+}
+
+/// Column buffers for one record batch (reused between batches)
+class BatchBuilder {
+public:
+    BatchBuilder(const Database& db, const std::vector<ArrowField>& fields, bool include_analysis)
+        : db_(db), fields_(fields), columns_(fields.size()), include_analysis_(include_analysis) {}
+
+    [[nodiscard]] size_t rows() const { return rows_; }
+
+    void append_track(const TrackRowView& track) {
+        next_ = 0;
+        add(track.id.value);
+        add(track.title);
+        add(track.artist_id.value);
+        add(name_of(db_.get_artist_view(track.artist_id)));
+        add(track.album_id.value);
+        add(name_of(db_.get_album_view(track.album_id)));
+        add(track.genre_id.value);
+        add(name_of(db_.get_genre_view(track.genre_id)));
+        add(track.key_id.value);
+        add(name_of(db_.get_key_view(track.key_id)));
+        add(track.label_id.value);
+        add(name_of(db_.get_label_view(track.label_id)));
+        add(track.bpm_100x);
+        add(track.duration_seconds);
+        add(track.year);
+        add(track.rating);
+        add(track.bitrate);
+        add(track.sample_rate);
+        add(track.play_count);
+        add(track.track_number);
+        add(track.file_size);
+        add(track.isrc);
+        add(track.comment);
+        add(track.date_added);
+        add(track.file_path);
+        add(track.filename);
+
+        if (include_analysis_) {
+            // Held for the whole row, so lazy cache evictions cannot free it underneath
+            auto analysis = db_.get_analysis_for_track(track.id);
+            uint32_t beats = analysis ? static_cast<uint32_t>(analysis->beat_grid.beats.size()) : 0;
+            add(beats);
+            add(beats != 0 ? analysis->beat_grid.beats.front().time_ms : uint32_t{0});
+
+            uint32_t cues = 0;
+            uint32_t hot_cues = 0;
+            uint32_t loops = 0;
+            if (analysis) {
+                for (const auto& cue : analysis->cue_points) {
+                    ++cues;
+                    if (cue.hot_cue_number != 0) ++hot_cues;
+                    if (cue.type == CuePointType::Loop) ++loops;
+                }
+            }
+            add(cues);
+            add(hot_cues);
+            add(loops);
+        }
+        ++rows_;
+    }
+
+    /// Write the batch as one encapsulated message and reset for the next
+    [[nodiscard]] ArrowBlock write(std::ostream& out, uint64_t offset, uint64_t& written) {
+        std::vector<ArrowFieldNode> nodes;
+        std::vector<ArrowBuffer> buffers;
+        nodes.reserve(fields_.size());
+        int64_t body = 0;
+        auto place = [&](size_t bytes) {
+            buffers.push_back({body, static_cast<int64_t>(bytes)});
+            body += static_cast<int64_t>(body_padded(bytes));
+        };
+        for (size_t i = 0; i < fields_.size(); ++i) {
+            nodes.push_back({static_cast<int64_t>(rows_), 0});
+            place(0);  // No validity bitmap: null_count is 0
+            if (fields_[i].type == ArrowType::Utf8) {
+                place((rows_ + 1) * sizeof(int32_t));
+            }
+            place(columns_[i].values.size());
+        }
+
+        auto metadata = detail::encode_arrow_record_batch_message(static_cast<int64_t>(rows_), nodes, buffers, body);
+        ArrowBlock block{static_cast<int64_t>(offset), 0, 0, body};
+        block.metadata_length = static_cast<int32_t>(write_message_prefix(out, metadata));
+
+        static constexpr char kZeros[8] = {};
+        auto write_padded = [&](const void* data, size_t bytes) {
+            out.write(static_cast<const char*>(data), static_cast<std::streamsize>(bytes));
+            out.write(kZeros, static_cast<std::streamsize>(body_padded(bytes) - bytes));
+        };
+        for (size_t i = 0; i < fields_.size(); ++i) {
+            auto& column = columns_[i];
+            if (fields_[i].type == ArrowType::Utf8) {
+                write_padded(column.offsets.data(), column.offsets.size() * sizeof(int32_t));
+            }
+            write_padded(column.values.data(), column.values.size());
+            column.values.clear();
+            column.offsets.assign(1, 0);
+        }
+        written += static_cast<uint64_t>(block.metadata_length) + static_cast<uint64_t>(body);
+        rows_ = 0;
+        return block;
+    }
+
+    /// Continuation marker, length and padded metadata; returns the bytes written
+    static size_t write_message_prefix(std::ostream& out, const std::vector<uint8_t>& metadata) {
+        // Prefix plus metadata must end on an 8-byte boundary
+        auto length = static_cast<uint32_t>(body_padded(metadata.size() + 8) - 8);
+        uint32_t prefix[2] = {detail::kArrowContinuation, length};
+        static constexpr char kZeros[8] = {};
+        out.write(reinterpret_cast<const char*>(prefix), sizeof(prefix));
+        out.write(reinterpret_cast<const char*>(metadata.data()), static_cast<std::streamsize>(metadata.size()));
+        out.write(kZeros, static_cast<std::streamsize>(length - metadata.size()));
+        return sizeof(prefix) + length;
+    }
+
+private:
+    struct Column {
+        std::vector<uint8_t> values;
+        std::vector<int32_t> offsets{0};  // Utf8 only
+    };
+
+    template<typename Row>
+    static std::string_view name_of(const Row* row) {
+        return row ? row->name : std::string_view{};
+    }
+
+    template<typename T>
+    void add(T value) {
+        auto& values = columns_[next_++].values;
+        size_t at = values.size();
+        values.resize(at + sizeof(T));
+        std::memcpy(values.data() + at, &value, sizeof(T));
+    }
+
+    void add(std::string_view s) {
+        auto& column = columns_[next_++];
+        column.values.insert(column.values.end(), s.begin(), s.end());
+        column.offsets.push_back(static_cast<int32_t>(column.values.size()));
+    }
+
+    const Database& db_;
+    const std::vector<ArrowField>& fields_;
+    std::vector<Column> columns_;
+    bool include_analysis_;
+    size_t rows_{0};
+    size_t next_{0};
+};
+
+} // anonymous namespace
+
+Result<ArrowExportStats> export_tracks_arrow(const Database& db, std::ostream& out,
+                                             const ArrowExportOptions& options) {
+    const bool file_format = options.format == ArrowFormat::File;
+    const size_t batch_rows = std::max<size_t>(1, options.batch_rows);
+    const auto fields = track_fields(options.include_analysis);
+
+    ArrowExportStats stats;
+    if (file_format) {
+        static constexpr char kMagic[8] = {'A', 'R', 'R', 'O', 'W', '1', '\0', '\0'};
+        out.write(kMagic, sizeof(kMagic));
+        stats.bytes += sizeof(kMagic);
+    }
+    stats.bytes += BatchBuilder::write_message_prefix(out, detail::encode_arrow_schema_message(fields));
+
+    BatchBuilder batch(db, fields, options.include_analysis);
+    std::vector<ArrowBlock> blocks;
+    auto flush = [&] {
+        blocks.push_back(batch.write(out, stats.bytes, stats.bytes));
+        ++stats.batches;
+    };
+    db.for_each_track([&](const TrackRowView& track) {
+        batch.append_track(track);
+        ++stats.rows;
+        if (batch.rows() == batch_rows) flush();
+    });
+    if (batch.rows() != 0) flush();
+
+    // End-of-stream marker
+    uint32_t end_marker[2] = {detail::kArrowContinuation, 0};
+    out.write(reinterpret_cast<const char*>(end_marker), sizeof(end_marker));
+    stats.bytes += sizeof(end_marker);
+
+    if (file_format) {
+        auto footer = detail::encode_arrow_footer(fields, blocks);
+        auto footer_size = static_cast<int32_t>(footer.size());
+        out.write(reinterpret_cast<const char*>(footer.data()), static_cast<std::streamsize>(footer.size()));
+        out.write(reinterpret_cast<const char*>(&footer_size), sizeof(footer_size));
+        out.write(detail::kArrowFileMagic, sizeof(detail::kArrowFileMagic));
+        stats.bytes += footer.size() + sizeof(footer_size) + sizeof(detail::kArrowFileMagic);
+    }
+
+    out.flush();
+    if (!out) {
+        return make_error(ErrorCode::IoError, "Failed to write Arrow export");
+    }
+    LOG_INFO("Exported " + std::to_string(stats.rows) + " tracks in " + std::to_string(stats.batches) +
+             " Arrow record batches");
+    return stats;
+}
+
+Result<ArrowExportStats> export_tracks_arrow(const Database& db, const std::filesystem::path& path,
+                                             const ArrowExportOptions& options) {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        return make_error(ErrorCode::IoError, "Cannot create " + path.string());
+    }
+    auto result = export_tracks_arrow(db, file, options);
+    if (!result) {
+        return make_error(ErrorCode::IoError, result.error().message + ": " + path.string());
+    }
+    return result;
+}
+
+} // namespace cratedigger
@@ -0,0 +1,286 @@
+#pragma once
+/**
+ * @file arrow_ipc.hpp
+ * @brief Internal encoder for Arrow IPC metadata (no Arrow dependency)
+ *
+ * Arrow IPC messages carry FlatBuffers metadata followed by a body of raw
+ * column buffers. Only the handful of tables the exporter needs are encoded
+ * here: Schema/Field with Int and Utf8 types, RecordBatch, Message and the
+ * file Footer (see Arrow's Schema.fbs, Message.fbs and File.fbs).
+ *
+ * FlatBufferBuilder builds back to front like the reference implementation:
+ * children are written before their parents and referenced by their
+ * distance from the end of the buffer. Every field is written explicitly,
+ * defaults included.
+ */
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+namespace cratedigger::detail {
+
+// ============================================================================
+// FlatBuffers
+// ============================================================================
+
+/// Minimal FlatBuffers writer (little-endian host)
+class FlatBufferBuilder {
+public:
+    /// Reference to a written object (its distance from the end of the buffer)
+    using Ref = uint32_t;
+
+    FlatBufferBuilder() : buffer_(256), head_(buffer_.size()) {}
+
+    [[nodiscard]] Ref size() const { return static_cast<Ref>(buffer_.size() - head_); }
+
+    /// Pad so that after writing `additional` bytes the size is a multiple of align
+    void prep(size_t align, size_t additional) {
+        max_align_ = std::max(max_align_, align);
+        size_t pad = (~(size() + additional) + 1) & (align - 1);
+        reserve(pad + additional);
+        for (size_t i = 0; i < pad; ++i) buffer_[--head_] = 0;
+    }
+
+    template<typename T>
+    void push(T value) {
+        static_assert(std::is_arithmetic_v<T>, "scalars only");
+        prep(sizeof(T), 0);
+        push_bytes(&value, sizeof(T));
+    }
+
+    [[nodiscard]] Ref create_string(std::string_view s) {
+        prep(sizeof(uint32_t), s.size() + 1);
+        buffer_[--head_] = 0;
+        push_bytes(s.data(), s.size());
+        push(static_cast<uint32_t>(s.size()));
+        return size();
+    }
+
+    /// Vector of fixed-layout structs, 8-byte aligned
+    template<typename Struct>
+    [[nodiscard]] Ref create_struct_vector(const std::vector<Struct>& items) {
+        static_assert(std::is_trivially_copyable_v<Struct> && alignof(Struct) <= 8, "plain structs only");
+        size_t bytes = items.size() * sizeof(Struct);
+        prep(sizeof(uint32_t), bytes);
+        prep(8, bytes);
+        push_bytes(items.data(), bytes);
+        push(static_cast<uint32_t>(items.size()));
+        return size();
+    }
+
+    /// Vector of references to tables
+    [[nodiscard]] Ref create_ref_vector(const std::vector<Ref>& refs) {
+        prep(sizeof(uint32_t), refs.size() * sizeof(uint32_t));
+        for (size_t i = refs.size(); i-- > 0;) {
+            push(static_cast<uint32_t>(size() + sizeof(uint32_t) - refs[i]));
+        }
+        push(static_cast<uint32_t>(refs.size()));
+        return size();
+    }
+
+    void start_table() {
+        fields_.clear();
+        table_start_ = size();
+    }
+
+    template<typename T>
+    void add_scalar(uint16_t slot, T value) {
+        push(value);
+        fields_.push_back({slot, size()});
+    }
+
+    void add_ref(uint16_t slot, Ref ref) {
+        prep(sizeof(uint32_t), 0);
+        push(static_cast<uint32_t>(size() + sizeof(uint32_t) - ref));
+        fields_.push_back({slot, size()});
+    }
+
+    /// Write the table's vtable (not shared between tables)
+    [[nodiscard]] Ref end_table() {
+        push(int32_t{0});  // Patched below with the distance to the vtable
+        Ref table = size();
+
+        uint16_t slots = 0;
+        for (const auto& field : fields_) slots = std::max<uint16_t>(slots, static_cast<uint16_t>(field.slot + 1));
+        for (uint16_t slot = slots; slot-- > 0;) {
+            uint16_t offset = 0;
+            for (const auto& field : fields_) {
+                if (field.slot == slot) offset = static_cast<uint16_t>(table - field.position);
+            }
+            push(offset);
+        }
+        push(static_cast<uint16_t>(table - table_start_));
+        push(static_cast<uint16_t>(sizeof(uint16_t) * (2 + slots)));
+
+        // The vtable sits just below the table: soffset = table address - vtable address
+        auto soffset = static_cast<int32_t>(size() - table);
+        std::memcpy(&buffer_[buffer_.size() - table], &soffset, sizeof(soffset));
+        return table;
+    }
+
+    /// Write the root reference and return the finished buffer
+    [[nodiscard]] std::vector<uint8_t> finish(Ref root) {
+        prep(max_align_, sizeof(uint32_t));
+        push(static_cast<uint32_t>(size() + sizeof(uint32_t) - root));
+        return std::vector<uint8_t>(buffer_.begin() + static_cast<std::ptrdiff_t>(head_), buffer_.end());
+    }
+
+private:
+    struct FieldLocation {
+        uint16_t slot;
+        Ref position;
+    };
+
+    void reserve(size_t bytes) {
+        if (head_ >= bytes) return;
+        size_t used = size();
+        size_t capacity = std::max(buffer_.size() * 2, used + bytes);
+        std::vector<uint8_t> grown(capacity);
+        std::memcpy(grown.data() + capacity - used, buffer_.data() + head_, used);
+        buffer_.swap(grown);
+        head_ = capacity - used;
+    }
+
+    void push_bytes(const void* data, size_t n) {
+        reserve(n);
+        head_ -= n;
+        if (n != 0) std::memcpy(&buffer_[head_], data, n);
+    }
+
+    std::vector<uint8_t> buffer_;  // Filled from the back; live bytes are [head_, end)
+    size_t head_;
+    size_t max_align_{1};
+    Ref table_start_{0};
+    std::vector<FieldLocation> fields_;
+};
+
+// ============================================================================
+// Arrow Metadata
+// ============================================================================
+
+/// Column types the exporter writes (values of the Arrow Type union)
+enum class ArrowType : uint8_t {
+    Int = 2,
+    Utf8 = 5
+};
+
+/// One column of the exported schema
+struct ArrowField {
+    std::string_view name;
+    ArrowType type{ArrowType::Int};
+    uint8_t bit_width{64};   // Int only
+    bool is_signed{true};    // Int only
+};
+
+/// Arrow FieldNode struct (per column of a record batch)
+struct ArrowFieldNode {
+    int64_t length;
+    int64_t null_count;
+};
+
+/// Arrow Buffer struct (location of a buffer within the message body)
+struct ArrowBuffer {
+    int64_t offset;
+    int64_t length;
+};
+
+/// Arrow Block struct (location of a message within the file)
+struct ArrowBlock {
+    int64_t offset;
+    int32_t metadata_length;
+    int32_t padding;
+    int64_t body_length;
+};
+
+static_assert(sizeof(ArrowFieldNode) == 16 && sizeof(ArrowBuffer) == 16 && sizeof(ArrowBlock) == 24,
+              "Arrow structs must match the FlatBuffers layout");
+
+constexpr int16_t kArrowMetadataV5 = 4;
+constexpr uint8_t kArrowHeaderSchema = 1;
+constexpr uint8_t kArrowHeaderRecordBatch = 3;
+constexpr char kArrowFileMagic[6] = {'A', 'R', 'R', 'O', 'W', '1'};
+constexpr uint32_t kArrowContinuation = 0xFFFFFFFFu;
+
+/// Schema table (children of every field are empty vectors; readers require them)
+inline FlatBufferBuilder::Ref encode_arrow_schema(FlatBufferBuilder& b, const std::vector<ArrowField>& fields) {
+    std::vector<FlatBufferBuilder::Ref> field_refs;
+    field_refs.reserve(fields.size());
+    for (const auto& field : fields) {
+        auto name = b.create_string(field.name);
+        auto children = b.create_ref_vector({});
+
+        b.start_table();
+        if (field.type == ArrowType::Int) {
+            b.add_scalar(0, static_cast<int32_t>(field.bit_width));
+            b.add_scalar(1, static_cast<uint8_t>(field.is_signed));
+        }
+        auto type = b.end_table();
+
+        b.start_table();
+        b.add_ref(0, name);
+        b.add_scalar(1, uint8_t{0});  // nullable: columns never hold nulls
+        b.add_scalar(2, static_cast<uint8_t>(field.type));
+        b.add_ref(3, type);
+        b.add_ref(5, children);
+        field_refs.push_back(b.end_table());
+    }
+    auto field_vector = b.create_ref_vector(field_refs);
+
+    b.start_table();
+    b.add_scalar(0, int16_t{0});  // Little-endian
+    b.add_ref(1, field_vector);
+    return b.end_table();
+}
+
+/// Message table around an already written header
+inline std::vector<uint8_t> finish_arrow_message(FlatBufferBuilder& b, uint8_t header_type,
+                                                 FlatBufferBuilder::Ref header, int64_t body_length) {
+    b.start_table();
+    b.add_scalar(0, kArrowMetadataV5);
+    b.add_scalar(1, header_type);
+    b.add_ref(2, header);
+    b.add_scalar(3, body_length);
+    return b.finish(b.end_table());
+}
+
+inline std::vector<uint8_t> encode_arrow_schema_message(const std::vector<ArrowField>& fields) {
+    FlatBufferBuilder b;
+    auto schema = encode_arrow_schema(b, fields);
+    return finish_arrow_message(b, kArrowHeaderSchema, schema, 0);
+}
+
+inline std::vector<uint8_t> encode_arrow_record_batch_message(int64_t rows, const std::vector<ArrowFieldNode>& nodes,
+                                                              const std::vector<ArrowBuffer>& buffers,
+                                                              int64_t body_length) {
+    FlatBufferBuilder b;
+    auto node_vector = b.create_struct_vector(nodes);
+    auto buffer_vector = b.create_struct_vector(buffers);
+
+    b.start_table();
+    b.add_scalar(0, rows);
+    b.add_ref(1, node_vector);
+    b.add_ref(2, buffer_vector);
+    auto batch = b.end_table();
+    return finish_arrow_message(b, kArrowHeaderRecordBatch, batch, body_length);
+}
+
+inline std::vector<uint8_t> encode_arrow_footer(const std::vector<ArrowField>& fields,
+                                                const std::vector<ArrowBlock>& record_batches) {
+    FlatBufferBuilder b;
+    auto schema = encode_arrow_schema(b, fields);
+    auto dictionaries = b.create_struct_vector(std::vector<ArrowBlock>{});
+    auto batches = b.create_struct_vector(record_batches);
+
+    b.start_table();
+    b.add_scalar(0, kArrowMetadataV5);
+    b.add_ref(1, schema);
+    b.add_ref(2, dictionaries);
+    b.add_ref(3, batches);
+    return b.finish(b.end_table());
+}
+
+} // namespace cratedigger::detail
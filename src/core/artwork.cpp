@@ -0,0 +1,271 @@
+#include "cratedigger/artwork.hpp"
+#include "cratedigger/database.hpp"
+#include "cratedigger/logging.hpp"
+#include "parallel.hpp"
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <list>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace cratedigger {
+
+namespace {
+
+/// Cache key of an artwork file: ID and variant
+uint64_t artwork_key(ArtworkId id, ArtworkVariant variant) {
+    return (static_cast<uint64_t>(id.value) << 1) | static_cast<uint64_t>(variant);
+}
+
+ArtworkId key_id(uint64_t key) {
+    return ArtworkId{static_cast<int64_t>(key >> 1)};
+}
+
+ArtworkVariant key_variant(uint64_t key) {
+    return static_cast<ArtworkVariant>(key & 1);
+}
+
+/// Whole file contents (null if it cannot be read)
+ArtworkBytes read_file(const std::filesystem::path& path) {
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    if (!in) return nullptr;
+    auto size = in.tellg();
+    if (size < 0) return nullptr;
+    auto bytes = std::make_shared<std::vector<uint8_t>>(static_cast<size_t>(size));
+    in.seekg(0);
+    if (!in.read(reinterpret_cast<char*>(bytes->data()), size)) return nullptr;
+    return bytes;
+}
+
+} // anonymous namespace
+
+struct ArtworkCache::State {
+    std::shared_ptr<const Database> db;
+    std::filesystem::path root;
+    size_t capacity{0};
+    std::function<void(ArtworkId, ArtworkVariant)> on_loaded;
+
+    mutable std::mutex mutex;
+    std::condition_variable work;          // Workers: queue filled or stop
+    mutable std::condition_variable done;  // get() / wait_idle(): a read finished or the queue emptied
+    bool stop{false};
+
+    std::deque<uint64_t> queue;             // Prefetches in request order
+    std::unordered_set<uint64_t> queued;    // Keys in queue
+    std::unordered_set<uint64_t> reading;   // Keys being read by a worker or get()
+
+    struct Item {
+        uint64_t key;
+        ArtworkBytes bytes;
+    };
+    std::list<Item> items;  // Most recently used first
+    std::unordered_map<uint64_t, std::list<Item>::iterator> lookup;
+    size_t cached_bytes{0};
+    ArtworkCacheStats counters;
+
+    std::vector<std::thread> workers;
+
+    std::filesystem::path resolve(ArtworkId id, ArtworkVariant variant) const {
+        const ArtworkRowView* row = db->get_artwork_view(id);
+        if (!row || row->path.empty()) return {};
+        // Stored paths are absolute within the export ("/PIONEER/Artwork/00001/a1.jpg")
+        auto path = root / std::filesystem::path(std::string(row->path)).relative_path();
+        if (variant == ArtworkVariant::HighRes) {
+            auto name = path.stem().string() + "_m" + path.extension().string();
+            path.replace_filename(name);
+        }
+        return path;
+    }
+
+    /// Read a file (no lock held); HighRes falls back to the original
+    ArtworkBytes load(uint64_t key) const {
+        auto id = key_id(key);
+        auto path = resolve(id, key_variant(key));
+        if (path.empty()) return nullptr;
+        auto bytes = read_file(path);
+        if (!bytes && key_variant(key) == ArtworkVariant::HighRes) {
+            bytes = read_file(resolve(id, ArtworkVariant::Original));
+        }
+        return bytes;
+    }
+
+    /// Look up and mark as most recently used (mutex held)
+    ArtworkBytes find_locked(uint64_t key) {
+        auto it = lookup.find(key);
+        if (it == lookup.end()) return nullptr;
+        items.splice(items.begin(), items, it->second);
+        return it->second->bytes;
+    }
+
+    /// Record a finished read and cache its bytes, evicting from the back (mutex held)
+    void finish_locked(uint64_t key, const ArtworkBytes& bytes) {
+        reading.erase(key);
+        done.notify_all();
+        if (!bytes) {
+            ++counters.files_missing;
+            return;
+        }
+        ++counters.files_read;
+        counters.bytes_read += bytes->size();
+        items.push_front({key, bytes});
+        lookup[key] = items.begin();
+        cached_bytes += bytes->size();
+        while (cached_bytes > capacity && !items.empty()) {
+            cached_bytes -= items.back().bytes->size();
+            lookup.erase(items.back().key);
+            items.pop_back();
+            ++counters.evictions;
+        }
+    }
+};
+
+ArtworkCache::ArtworkCache(const Database& db, ArtworkCacheOptions options) : state_(std::make_unique<State>()) {
+    state_->db = db.snapshot();
+    state_->root = options.export_root.empty() ? db.export_root() : options.export_root;
+    state_->capacity = options.capacity_bytes;
+    state_->on_loaded = std::move(options.on_loaded);
+
+    size_t threads = detail::resolve_thread_count(options.thread_count, SIZE_MAX);
+    for (size_t i = 0; i < threads; ++i) {
+        state_->workers.emplace_back(&ArtworkCache::run_worker, std::ref(*state_));
+    }
+}
+
+ArtworkCache::~ArtworkCache() {
+    {
+        std::lock_guard<std::mutex> lock(state_->mutex);
+        state_->stop = true;
+        state_->queue.clear();
+        state_->queued.clear();
+    }
+    state_->work.notify_all();
+    for (auto& worker : state_->workers) worker.join();
+}
+
+void ArtworkCache::run_worker(State& state) {
+    std::unique_lock<std::mutex> lock(state.mutex);
+    while (true) {
+        state.work.wait(lock, [&state] { return state.stop || !state.queue.empty(); });
+        if (state.stop) return;
+
+        uint64_t key = state.queue.front();
+        state.queue.pop_front();
+        state.queued.erase(key);
+        if (state.lookup.count(key) != 0 || !state.reading.insert(key).second) {
+            state.done.notify_all();  // wait_idle() may be waiting for the queue to drain
+            continue;
+        }
+
+        lock.unlock();
+        auto bytes = state.load(key);
+        lock.lock();
+        state.finish_locked(key, bytes);
+
+        if (bytes && state.on_loaded) {
+            lock.unlock();
+            state.on_loaded(key_id(key), key_variant(key));
+            lock.lock();
+        }
+    }
+}
+
+std::filesystem::path ArtworkCache::path(ArtworkId id, ArtworkVariant variant) const {
+    return state_->resolve(id, variant);
+}
+
+ArtworkBytes ArtworkCache::get(ArtworkId id, ArtworkVariant variant) {
+    State& state = *state_;
+    uint64_t key = artwork_key(id, variant);
+    std::unique_lock<std::mutex> lock(state.mutex);
+    if (auto bytes = state.find_locked(key)) {
+        ++state.counters.hits;
+        return bytes;
+    }
+    ++state.counters.misses;
+
+    // A worker may be reading the same file; wait for it instead of reading twice
+    state.done.wait(lock, [&] { return state.reading.count(key) == 0; });
+    if (auto bytes = state.find_locked(key)) return bytes;
+
+    state.reading.insert(key);
+    lock.unlock();
+    auto bytes = state.load(key);
+    lock.lock();
+    state.finish_locked(key, bytes);
+    return bytes;
+}
+
+ArtworkBytes ArtworkCache::peek(ArtworkId id, ArtworkVariant variant) const {
+    std::lock_guard<std::mutex> lock(state_->mutex);
+    auto bytes = state_->find_locked(artwork_key(id, variant));
+    if (bytes) {
+        ++state_->counters.hits;
+    } else {
+        ++state_->counters.misses;
+    }
+    return bytes;
+}
+
+void ArtworkCache::prefetch(Span<const ArtworkId> ids, ArtworkVariant variant) {
+    State& state = *state_;
+    {
+        std::lock_guard<std::mutex> lock(state.mutex);
+        state.queue.clear();
+        state.queued.clear();
+        for (ArtworkId id : ids) {
+            if (id.value <= 0) continue;  // Tracks without artwork
+            uint64_t key = artwork_key(id, variant);
+            if (state.lookup.count(key) != 0 || state.reading.count(key) != 0) continue;
+            if (!state.queued.insert(key).second) continue;
+            state.queue.push_back(key);
+        }
+        LOG_DEBUG("Queued " + std::to_string(state.queue.size()) + " artwork prefetches");
+    }
+    state.work.notify_all();
+    state.done.notify_all();
+}
+
+void ArtworkCache::prefetch_tracks(Span<const TrackId> tracks, ArtworkVariant variant) {
+    std::vector<ArtworkId> ids;
+    ids.reserve(tracks.size());
+    for (TrackId id : tracks) {
+        if (const TrackRowView* track = state_->db->get_track_view(id)) ids.push_back(track->artwork_id);
+    }
+    prefetch(ids, variant);
+}
+
+void ArtworkCache::cancel_prefetch() {
+    {
+        std::lock_guard<std::mutex> lock(state_->mutex);
+        state_->queue.clear();
+        state_->queued.clear();
+    }
+    state_->done.notify_all();
+}
+
+void ArtworkCache::wait_idle() const {
+    State& state = *state_;
+    std::unique_lock<std::mutex> lock(state.mutex);
+    state.done.wait(lock, [&state] { return state.queue.empty() && state.reading.empty(); });
+}
+
+ArtworkCacheStats ArtworkCache::stats() const {
+    std::lock_guard<std::mutex> lock(state_->mutex);
+    ArtworkCacheStats stats = state_->counters;
+    stats.cached_items = state_->items.size();
+    stats.cached_bytes = state_->cached_bytes;
+    stats.pending = state_->queue.size() + state_->reading.size();
+    return stats;
+}
+
+void ArtworkCache::clear() {
+    std::lock_guard<std::mutex> lock(state_->mutex);
+    state_->items.clear();
+    state_->lookup.clear();
+    state_->cached_bytes = 0;
+}
+
+} // namespace cratedigger
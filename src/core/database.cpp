@@ -1,41 +1,218 @@
 #include "database_impl.hpp"
+#include "stopwatch.hpp"
 
 namespace cratedigger {
 
+namespace {
+
+/// Convert parsed ANLZ cue points to the public CuePoint type
+std::vector<CuePoint> to_cue_points(const std::vector<CuePointData>& cue_data) {
+    std::vector<CuePoint> result;
+    result.reserve(cue_data.size());
+
+    for (const auto& data : cue_data) {
+        CuePoint cue;
+        cue.type = data.type;
+        cue.time_ms = data.time_ms;
+        cue.loop_time_ms = data.loop_time_ms;
+        cue.hot_cue_number = static_cast<uint8_t>(data.hot_cue_number);
+        cue.color_id = data.color_id;
+        cue.comment = data.comment;
+        result.push_back(std::move(cue));
+    }
+    return result;
+}
+
+/// Widen a column into the int32 vector the bulk getters return
+template<typename T>
+std::vector<int32_t> widen_column(const std::vector<T>& column) {
+    return std::vector<int32_t>(column.begin(), column.end());
+}
+
+/// Rank weight of each TextField, in bit order
+constexpr float kTextFieldWeight[DatabaseImpl::kTextFieldCount] = {1.0f, 0.95f, 0.9f, 0.85f, 0.75f};
+
+/// Rank weight of a substring match kind
+float text_match_weight(TextMatchKind kind) {
+    switch (kind) {
+        case TextMatchKind::Exact: return 1.0f;
+        case TextMatchKind::Prefix: return 0.9f;
+        case TextMatchKind::WordPrefix: return 0.8f;
+        case TextMatchKind::Substring: return 0.6f;
+        case TextMatchKind::None: break;
+    }
+    return 0.0f;
+}
+
+/// View a frozen posting list
+template<typename IdType>
+Span<const IdType> as_span(PostingList<IdType> postings) {
+    return {postings.begin(), postings.size()};
+}
+
+/// Convert a BPM value to the bpm_100x units stored in track rows
+uint32_t to_bpm_100x(float bpm) {
+    return static_cast<uint32_t>(bpm * 100.0f);
+}
+
+/// last_write_time ticks of a file (0 if it cannot be read)
+int64_t mtime_ticks(const std::filesystem::path& path) {
+    std::error_code ec;
+    auto mtime = std::filesystem::last_write_time(path, ec);
+    return ec ? 0 : static_cast<int64_t>(mtime.time_since_epoch().count());
+}
+
+} // anonymous namespace
+
 // ============================================================================
 // Database Implementation
 // ============================================================================
 
-Database::Database(std::unique_ptr<DatabaseImpl> impl)
-    : impl_(std::move(impl))
+Database::Database(std::shared_ptr<const DatabaseGeneration> state)
+    : state_(std::move(state))
 {}
 
 Database::Database(Database&& other) noexcept = default;
 Database& Database::operator=(Database&& other) noexcept = default;
 Database::~Database() = default;
 
-Result<Database> Database::open(const std::filesystem::path& path) {
-    auto pdb_result = RekordboxPdb::open(path, false);
+const DatabaseImpl& Database::impl() const {
+    return *state_->index;
+}
+
+const CuePointManager& Database::anlz() const {
+    return *state_->anlz;
+}
+
+void Database::publish(std::shared_ptr<const DatabaseGeneration> next) {
+    std::atomic_store(&state_, std::move(next));
+}
+
+template<typename Change>
+void Database::change_anlz(Change&& change) {
+    // Loaded analyses are shared with the copy; only changed tracks are duplicated
+    auto anlz = std::make_shared<CuePointManager>(*state_->anlz);
+    change(*anlz);
+    publish(std::make_shared<DatabaseGeneration>(state_->index, std::move(anlz), state_->number + 1));
+}
+
+std::shared_ptr<const Database> Database::snapshot() const {
+    return std::shared_ptr<const Database>(new Database(std::atomic_load(&state_)));
+}
+
+namespace {
+
+/// Error returned by loads stopped through their LoadObserver
+Error cancelled_error(const std::filesystem::path& path) {
+    return make_error(ErrorCode::Cancelled, "Open of " + path.string() + " cancelled");
+}
+
+} // anonymous namespace
+
+std::shared_ptr<CuePointManager> Database::make_anlz(const DatabaseOptions& options) {
+    auto anlz = std::make_shared<CuePointManager>();
+    anlz->set_io_mode(options.io_mode);
+    anlz->set_thread_count(options.thread_count);
+    anlz->set_snapshot_dir(options.snapshot_dir);
+    return anlz;
+}
+
+void Database::adopt_anlz(std::shared_ptr<const CuePointManager> anlz) {
+    publish(std::make_shared<DatabaseGeneration>(state_->index, std::move(anlz), state_->number + 1));
+}
+
+Result<Database> Database::open(const std::filesystem::path& path, const DatabaseOptions& options) {
+    return open_pooled(path, false, options, nullptr);
+}
+
+Result<Database> Database::open_ext(const std::filesystem::path& path, const DatabaseOptions& options) {
+    return open_pooled(path, true, options, nullptr);
+}
+
+Result<Database> Database::open_pooled(const std::filesystem::path& path, bool is_ext, const DatabaseOptions& options,
+                                       std::shared_ptr<StringPool> strings, const LoadObserver* observer) {
+    // Stat before reading, so a write that lands in between is seen by refresh()
+    int64_t mtime = mtime_ticks(path);
+    detail::Stopwatch watch;
+    auto pdb_result = RekordboxPdb::open(path, is_ext, options.io_mode);
     if (!pdb_result) {
         return pdb_result.error();
     }
+    uint64_t read_ns = watch.elapsed_ns();
+    if (observer != nullptr && observer->cancelled()) {
+        return cancelled_error(path);
+    }
 
-    auto impl = std::make_unique<DatabaseImpl>(std::move(*pdb_result), path);
-    impl->build_indices();
+    watch.restart();
+    auto impl = std::make_shared<DatabaseImpl>(std::move(*pdb_result), path, options, std::move(strings));
+    impl->source_mtime_ = mtime;
+    impl->observer_ = observer;
+    impl->open_indices();
+    impl->observer_ = nullptr;
+    impl->read_ns_ = read_ns;
+    impl->index_ns_ = watch.elapsed_ns();
+    if (observer != nullptr && observer->cancelled()) {
+        return cancelled_error(path);
+    }
 
-    return Database(std::move(impl));
+    return Database(std::make_shared<DatabaseGeneration>(std::move(impl), make_anlz(options), 0));
 }
 
-Result<Database> Database::open_ext(const std::filesystem::path& path) {
-    auto pdb_result = RekordboxPdb::open(path, true);
-    if (!pdb_result) {
-        return pdb_result.error();
+// ============================================================================
+// Incremental Refresh
+// ============================================================================
+
+Result<RefreshStats> Database::refresh() {
+    RefreshStats stats;
+    const DatabaseImpl& current = impl();
+    const auto& path = current.source_file_;
+
+    std::error_code ec;
+    auto size = std::filesystem::file_size(path, ec);
+    if (ec) {
+        return make_error(ErrorCode::FileNotFound, "Cannot stat " + path.string() + ": " + ec.message());
+    }
+    int64_t mtime = mtime_ticks(path);
+
+    std::shared_ptr<const DatabaseImpl> index = state_->index;
+    if (size != current.pdb_.file_size() || mtime != current.source_mtime_) {
+        detail::Stopwatch watch;
+        auto pdb_result = RekordboxPdb::open(path, current.pdb_.is_ext(), current.options_.io_mode);
+        if (!pdb_result) {
+            return pdb_result.error();
+        }
+        uint64_t read_ns = watch.elapsed_ns();
+
+        // Build the next generation aside; readers keep using the current one
+        watch.restart();
+        auto next = std::make_shared<DatabaseImpl>(std::move(*pdb_result), path, current.options_,
+                                                   current.shared_strings_ ? current.strings_ : nullptr);
+        next->source_mtime_ = mtime;
+        next->refresh_indices(current, stats);
+        next->read_ns_ = read_ns;
+        next->index_ns_ = watch.elapsed_ns();
+        index = std::move(next);
+        stats.pdb_changed = true;
     }
 
-    auto impl = std::make_unique<DatabaseImpl>(std::move(*pdb_result), path);
-    impl->build_indices();
+    std::shared_ptr<const CuePointManager> anlz = state_->anlz;
+    if (anlz->needs_refresh()) {
+        auto next = std::make_shared<CuePointManager>(*anlz);
+        auto anlz_stats = next->refresh();
+        stats.anlz_files_changed = anlz_stats.files_changed;
+        stats.anlz_tracks_reloaded = anlz_stats.tracks_reloaded;
+        anlz = std::move(next);
+    }
+    if (!stats.changed()) {
+        return stats;
+    }
+
+    publish(std::make_shared<DatabaseGeneration>(std::move(index), std::move(anlz), state_->number + 1));
+    return stats;
+}
 
-    return Database(std::move(impl));
+uint64_t Database::generation() const {
+    return state_->number;
 }
 
 // ============================================================================
@@ -43,153 +220,346 @@ Result<Database> Database::open_ext(const std::filesystem::path& path) {
 // ============================================================================
 
 std::optional<TrackRow> Database::get_track(TrackId id) const {
-    auto it = impl_->track_index.find(id);
-    if (it != impl_->track_index.end()) {
-        return it->second;
+    auto it = impl().track_index.find(id);
+    if (it != impl().track_index.end()) {
+        return it->second.to_row();
     }
     return std::nullopt;
 }
 
 std::optional<ArtistRow> Database::get_artist(ArtistId id) const {
-    auto it = impl_->artist_index.find(id);
-    if (it != impl_->artist_index.end()) {
-        return it->second;
+    auto it = impl().artist_index.find(id);
+    if (it != impl().artist_index.end()) {
+        return it->second.to_row();
     }
     return std::nullopt;
 }
 
 std::optional<AlbumRow> Database::get_album(AlbumId id) const {
-    auto it = impl_->album_index.find(id);
-    if (it != impl_->album_index.end()) {
-        return it->second;
+    auto it = impl().album_index.find(id);
+    if (it != impl().album_index.end()) {
+        return it->second.to_row();
     }
     return std::nullopt;
 }
 
 std::optional<GenreRow> Database::get_genre(GenreId id) const {
-    auto it = impl_->genre_index.find(id);
-    if (it != impl_->genre_index.end()) {
-        return it->second;
+    auto it = impl().genre_index.find(id);
+    if (it != impl().genre_index.end()) {
+        return it->second.to_row();
     }
     return std::nullopt;
 }
 
 std::optional<LabelRow> Database::get_label(LabelId id) const {
-    auto it = impl_->label_index.find(id);
-    if (it != impl_->label_index.end()) {
-        return it->second;
+    auto it = impl().label_index.find(id);
+    if (it != impl().label_index.end()) {
+        return it->second.to_row();
     }
     return std::nullopt;
 }
 
 std::optional<ColorRow> Database::get_color(ColorId id) const {
-    auto it = impl_->color_index.find(id);
-    if (it != impl_->color_index.end()) {
-        return it->second;
+    auto it = impl().color_index.find(id);
+    if (it != impl().color_index.end()) {
+        return it->second.to_row();
     }
     return std::nullopt;
 }
 
 std::optional<KeyRow> Database::get_key(KeyId id) const {
-    auto it = impl_->key_index.find(id);
-    if (it != impl_->key_index.end()) {
-        return it->second;
+    auto it = impl().key_index.find(id);
+    if (it != impl().key_index.end()) {
+        return it->second.to_row();
     }
     return std::nullopt;
 }
 
 std::optional<ArtworkRow> Database::get_artwork(ArtworkId id) const {
-    auto it = impl_->artwork_index.find(id);
-    if (it != impl_->artwork_index.end()) {
-        return it->second;
+    auto it = impl().artwork_index.find(id);
+    if (it != impl().artwork_index.end()) {
+        return it->second.to_row();
     }
     return std::nullopt;
 }
 
+const TrackRowView* Database::get_track_view(TrackId id) const {
+    return impl().track_index.get(id);
+}
+
+const ArtistRowView* Database::get_artist_view(ArtistId id) const {
+    return impl().artist_index.get(id);
+}
+
+const AlbumRowView* Database::get_album_view(AlbumId id) const {
+    return impl().album_index.get(id);
+}
+
+const GenreRowView* Database::get_genre_view(GenreId id) const {
+    return impl().genre_index.get(id);
+}
+
+const LabelRowView* Database::get_label_view(LabelId id) const {
+    return impl().label_index.get(id);
+}
+
+const ColorRowView* Database::get_color_view(ColorId id) const {
+    return impl().color_index.get(id);
+}
+
+const KeyRowView* Database::get_key_view(KeyId id) const {
+    return impl().key_index.get(id);
+}
+
+const ArtworkRowView* Database::get_artwork_view(ArtworkId id) const {
+    return impl().artwork_index.get(id);
+}
+
+const TrackRowView& Database::track_view_at(size_t position) const {
+    return (impl().track_index.begin() + static_cast<std::ptrdiff_t>(position))->second;
+}
+
+// ============================================================================
+// Posting Views
+// ============================================================================
+
+Span<const TrackId> Database::find_tracks_by_title_view(std::string_view title) const {
+    return as_span(impl().track_title_index.find(title));
+}
+
+Span<const TrackId> Database::find_tracks_by_filename_view(std::string_view filename) const {
+    auto slash = filename.find_last_of("/\\");
+    if (slash != std::string_view::npos) {
+        filename.remove_prefix(slash + 1);
+    }
+    return as_span(impl().track_filename_index.find(filename));
+}
+
+Span<const TrackId> Database::find_tracks_by_artist_view(ArtistId artist_id) const {
+    return as_span(impl().track_artist_index.find(artist_id));
+}
+
+Span<const TrackId> Database::find_tracks_by_album_view(AlbumId album_id) const {
+    return as_span(impl().track_album_index.find(album_id));
+}
+
+Span<const TrackId> Database::find_tracks_by_genre_view(GenreId genre_id) const {
+    return as_span(impl().track_genre_index.find(genre_id));
+}
+
+Span<const TrackId> Database::find_tracks_by_tag_view(TagId tag_id) const {
+    return as_span(impl().tag_track_index.find(tag_id));
+}
+
+Span<const TagId> Database::find_tags_by_track_view(TrackId track_id) const {
+    return as_span(impl().track_tag_index.find(track_id));
+}
+
+Span<const TrackId> Database::get_playlist_view(PlaylistId id) const {
+    auto it = impl().playlist_index.find(id);
+    if (it == impl().playlist_index.end()) {
+        return {};
+    }
+    return it->second;
+}
+
 // ============================================================================
 // Secondary Index Access
 // ============================================================================
 
 std::vector<TrackId> Database::find_tracks_by_title(std::string_view title) const {
-    std::vector<TrackId> result;
-    auto it = impl_->track_title_index.find(std::string(title));
-    if (it != impl_->track_title_index.end()) {
-        result.assign(it->second.begin(), it->second.end());
-    }
-    return result;
+    return impl().track_title_index.find(title).to_vector();
+}
+
+std::vector<TrackId> Database::find_tracks_by_filename(std::string_view filename) const {
+    return find_tracks_by_filename_view(filename).to_vector();
 }
 
 std::vector<TrackId> Database::find_tracks_by_artist(ArtistId artist_id) const {
-    std::vector<TrackId> result;
-    auto it = impl_->track_artist_index.find(artist_id);
-    if (it != impl_->track_artist_index.end()) {
-        result.assign(it->second.begin(), it->second.end());
-    }
-    return result;
+    return impl().track_artist_index.find(artist_id).to_vector();
 }
 
 std::vector<TrackId> Database::find_tracks_by_album(AlbumId album_id) const {
-    std::vector<TrackId> result;
-    auto it = impl_->track_album_index.find(album_id);
-    if (it != impl_->track_album_index.end()) {
-        result.assign(it->second.begin(), it->second.end());
-    }
-    return result;
+    return impl().track_album_index.find(album_id).to_vector();
 }
 
 std::vector<TrackId> Database::find_tracks_by_genre(GenreId genre_id) const {
-    std::vector<TrackId> result;
-    auto it = impl_->track_genre_index.find(genre_id);
-    if (it != impl_->track_genre_index.end()) {
-        result.assign(it->second.begin(), it->second.end());
-    }
-    return result;
+    return impl().track_genre_index.find(genre_id).to_vector();
 }
 
 // ============================================================================
-// Range Search
+// Text Search
 // ============================================================================
 
-std::vector<TrackId> Database::find_tracks_by_bpm_range(float min_bpm, float max_bpm) const {
-    std::vector<TrackId> result;
-    uint32_t min_bpm_100x = static_cast<uint32_t>(min_bpm * 100.0f);
-    uint32_t max_bpm_100x = static_cast<uint32_t>(max_bpm * 100.0f);
+std::vector<TextSearchHit> Database::search_tracks(std::string_view query, const TextSearchOptions& options) const {
+    using Index = DatabaseImpl::TrackTextIndex;
+    const Index& index = impl().track_text_index();
+    const std::string folded = Index::fold(query);
+
+    std::vector<TextSearchHit> hits;
+    if (folded.empty()) {
+        return hits;
+    }
 
-    for (const auto& [id, track] : impl_->track_index) {
-        if (track.bpm_100x >= min_bpm_100x && track.bpm_100x <= max_bpm_100x) {
-            result.push_back(id);
+    auto field_enabled = [&](size_t f) { return (options.fields & (1u << f)) != 0; };
+
+    std::vector<uint32_t> docs = index.candidates(folded, options.prefix_only);
+    std::vector<uint32_t> matched_docs;
+    for (uint32_t doc : docs) {
+        const auto& fields = index.fields_at(doc);
+        TextSearchHit hit;
+        for (size_t f = 0; f < fields.size(); ++f) {
+            if (!field_enabled(f)) continue;
+            TextMatchKind kind = Index::match(fields[f], folded);
+            if (kind == TextMatchKind::None) continue;
+            if (options.prefix_only && kind == TextMatchKind::Substring) continue;
+
+            // Shorter fields rank higher for the same kind of match
+            float coverage = static_cast<float>(folded.size()) / static_cast<float>(fields[f].size());
+            float score = text_match_weight(kind) * kTextFieldWeight[f] + 0.05f * coverage;
+            if (score > hit.score) {
+                hit.field = static_cast<TextField>(1u << f);
+                hit.score = score;
+            }
+        }
+        if (hit.score > 0.0f) {
+            hit.track_id = index.id_at(doc);
+            hits.push_back(hit);
+            matched_docs.push_back(doc);
         }
     }
-    return result;
-}
 
-std::vector<TrackId> Database::find_tracks_by_duration_range(uint32_t min_seconds, uint32_t max_seconds) const {
-    std::vector<TrackId> result;
-    for (const auto& [id, track] : impl_->track_index) {
-        if (track.duration_seconds >= min_seconds && track.duration_seconds <= max_seconds) {
-            result.push_back(id);
+    if (options.fuzzy && (options.limit == 0 || hits.size() < options.limit)) {
+        constexpr float kMinSimilarity = 0.4f;
+        auto grams = Index::trigrams(folded);
+        uint32_t min_shared = std::max<uint32_t>(1, static_cast<uint32_t>(grams.size() / 3));
+        for (uint32_t doc : index.overlapping(grams, min_shared)) {
+            if (std::binary_search(matched_docs.begin(), matched_docs.end(), doc)) continue;
+            const auto& fields = index.fields_at(doc);
+            TextSearchHit hit;
+            for (size_t f = 0; f < fields.size(); ++f) {
+                if (!field_enabled(f)) continue;
+                float similarity = Index::similarity(grams, fields[f]);
+                float score = 0.5f * similarity * kTextFieldWeight[f];
+                if (similarity >= kMinSimilarity && score > hit.score) {
+                    hit.field = static_cast<TextField>(1u << f);
+                    hit.score = score;
+                }
+            }
+            if (hit.score > 0.0f) {
+                hit.track_id = index.id_at(doc);
+                hits.push_back(hit);
+            }
         }
     }
-    return result;
+
+    auto ranked = [](const TextSearchHit& a, const TextSearchHit& b) {
+        return a.score != b.score ? a.score > b.score : a.track_id < b.track_id;
+    };
+    if (options.limit != 0 && hits.size() > options.limit) {
+        std::partial_sort(hits.begin(), hits.begin() + static_cast<std::ptrdiff_t>(options.limit), hits.end(), ranked);
+        hits.resize(options.limit);
+    } else {
+        std::sort(hits.begin(), hits.end(), ranked);
+    }
+    return hits;
+}
+
+// ============================================================================
+// Range Search
+// ============================================================================
+
+std::vector<TrackId> Database::find_tracks_by_bpm_range(float min_bpm, float max_bpm) const {
+    return impl().track_bpm_index.ids_in(to_bpm_100x(min_bpm), to_bpm_100x(max_bpm));
+}
+
+std::vector<TrackId> Database::find_tracks_by_duration_range(uint32_t min_seconds, uint32_t max_seconds) const {
+    return impl().track_duration_index.ids_in(min_seconds, max_seconds);
 }
 
 std::vector<TrackId> Database::find_tracks_by_year_range(uint16_t min_year, uint16_t max_year) const {
-    std::vector<TrackId> result;
-    for (const auto& [id, track] : impl_->track_index) {
-        if (track.year >= min_year && track.year <= max_year) {
-            result.push_back(id);
-        }
-    }
-    return result;
+    return impl().track_year_index.ids_in(min_year, max_year);
 }
 
 std::vector<TrackId> Database::find_tracks_by_rating_range(uint16_t min_rating, uint16_t max_rating) const {
+    return impl().track_rating_index.ids_in(min_rating, max_rating);
+}
+
+std::vector<TrackId> Database::find_tracks(const TrackQuery& query) const {
+    const auto& impl = this->impl();
+
+    uint32_t min_bpm = query.min_bpm ? to_bpm_100x(*query.min_bpm) : 0;
+    uint32_t max_bpm = query.max_bpm ? to_bpm_100x(*query.max_bpm) : UINT32_MAX;
+    uint32_t min_duration = query.min_duration.value_or(0);
+    uint32_t max_duration = query.max_duration.value_or(UINT32_MAX);
+    uint16_t min_year = query.min_year.value_or(0);
+    uint16_t max_year = query.max_year.value_or(UINT16_MAX);
+    uint16_t min_rating = query.min_rating.value_or(0);
+    uint16_t max_rating = query.max_rating.value_or(UINT16_MAX);
+
+    // Equality predicates are sorted postings; intersect them smallest first
+    std::vector<PostingList<TrackId>> postings;
+    if (query.key) postings.push_back(impl.track_key_index.find(*query.key));
+    if (query.genre) postings.push_back(impl.track_genre_index.find(*query.genre));
+    if (query.artist) postings.push_back(impl.track_artist_index.find(*query.artist));
+    std::sort(postings.begin(), postings.end(),
+        [](const auto& a, const auto& b) { return a.size() < b.size(); });
+
+    // Seed from the most selective predicate (range counts are two binary searches)
+    size_t best = postings.empty() ? impl.track_index.size() : postings.front().size();
+    const FlatRangeIndex<uint32_t, TrackId>* seed_range32 = nullptr;
+    const FlatRangeIndex<uint16_t, TrackId>* seed_range16 = nullptr;
+    uint32_t seed_lo = 0, seed_hi = 0;
+    auto consider32 = [&](bool set, const FlatRangeIndex<uint32_t, TrackId>& index, uint32_t lo, uint32_t hi) {
+        if (!set) return;
+        size_t n = index.count(lo, hi);
+        if (n < best) { best = n; seed_range32 = &index; seed_range16 = nullptr; seed_lo = lo; seed_hi = hi; }
+    };
+    auto consider16 = [&](bool set, const FlatRangeIndex<uint16_t, TrackId>& index, uint16_t lo, uint16_t hi) {
+        if (!set) return;
+        size_t n = index.count(lo, hi);
+        if (n < best) { best = n; seed_range16 = &index; seed_range32 = nullptr; seed_lo = lo; seed_hi = hi; }
+    };
+    consider32(query.min_bpm || query.max_bpm, impl.track_bpm_index, min_bpm, max_bpm);
+    consider32(query.min_duration || query.max_duration, impl.track_duration_index, min_duration, max_duration);
+    consider16(query.min_year || query.max_year, impl.track_year_index, min_year, max_year);
+    consider16(query.min_rating || query.max_rating, impl.track_rating_index, min_rating, max_rating);
+
     std::vector<TrackId> result;
-    for (const auto& [id, track] : impl_->track_index) {
-        if (track.rating >= min_rating && track.rating <= max_rating) {
-            result.push_back(id);
+    size_t first_posting = 0;
+    if (seed_range32) {
+        result = seed_range32->ids_in(seed_lo, seed_hi);
+    } else if (seed_range16) {
+        result = seed_range16->ids_in(static_cast<uint16_t>(seed_lo), static_cast<uint16_t>(seed_hi));
+    } else if (!postings.empty()) {
+        result = postings.front().to_vector();
+        first_posting = 1;
+    } else {
+        result.reserve(impl.track_index.size());
+        for (const auto& entry : impl.track_index) result.push_back(entry.first);
+    }
+
+    for (size_t p = first_posting; p < postings.size() && !result.empty(); ++p) {
+        auto out = result.begin();
+        auto it = postings[p].begin();
+        auto last = postings[p].end();
+        for (TrackId id : result) {
+            it = std::lower_bound(it, last, id);
+            if (it == last) break;
+            if (*it == id) *out++ = id;
         }
+        result.erase(out, result.end());
     }
+
+    // Remaining range predicates are checked against the dense primary index
+    result.erase(std::remove_if(result.begin(), result.end(), [&](TrackId id) {
+        const TrackRowView* track = impl.track_index.get(id);
+        return track == nullptr ||
+               track->bpm_100x < min_bpm || track->bpm_100x > max_bpm ||
+               track->duration_seconds < min_duration || track->duration_seconds > max_duration ||
+               track->year < min_year || track->year > max_year ||
+               track->rating < min_rating || track->rating > max_rating;
+    }), result.end());
     return result;
 }
 
@@ -202,66 +572,31 @@ std::vector<TrackId> Database::find_tracks_by_rating(uint16_t rating) const {
 }
 
 std::vector<ArtistId> Database::find_artists_by_name(std::string_view name) const {
-    std::vector<ArtistId> result;
-    auto it = impl_->artist_name_index.find(std::string(name));
-    if (it != impl_->artist_name_index.end()) {
-        result.assign(it->second.begin(), it->second.end());
-    }
-    return result;
+    return impl().artist_name_index.find(name).to_vector();
 }
 
 std::vector<AlbumId> Database::find_albums_by_name(std::string_view name) const {
-    std::vector<AlbumId> result;
-    auto it = impl_->album_name_index.find(std::string(name));
-    if (it != impl_->album_name_index.end()) {
-        result.assign(it->second.begin(), it->second.end());
-    }
-    return result;
+    return impl().album_name_index.find(name).to_vector();
 }
 
 std::vector<AlbumId> Database::find_albums_by_artist(ArtistId artist_id) const {
-    std::vector<AlbumId> result;
-    auto it = impl_->album_artist_index.find(artist_id);
-    if (it != impl_->album_artist_index.end()) {
-        result.assign(it->second.begin(), it->second.end());
-    }
-    return result;
+    return impl().album_artist_index.find(artist_id).to_vector();
 }
 
 std::vector<GenreId> Database::find_genres_by_name(std::string_view name) const {
-    std::vector<GenreId> result;
-    auto it = impl_->genre_name_index.find(std::string(name));
-    if (it != impl_->genre_name_index.end()) {
-        result.assign(it->second.begin(), it->second.end());
-    }
-    return result;
+    return impl().genre_name_index.find(name).to_vector();
 }
 
 std::vector<LabelId> Database::find_labels_by_name(std::string_view name) const {
-    std::vector<LabelId> result;
-    auto it = impl_->label_name_index.find(std::string(name));
-    if (it != impl_->label_name_index.end()) {
-        result.assign(it->second.begin(), it->second.end());
-    }
-    return result;
+    return impl().label_name_index.find(name).to_vector();
 }
 
 std::vector<ColorId> Database::find_colors_by_name(std::string_view name) const {
-    std::vector<ColorId> result;
-    auto it = impl_->color_name_index.find(std::string(name));
-    if (it != impl_->color_name_index.end()) {
-        result.assign(it->second.begin(), it->second.end());
-    }
-    return result;
+    return impl().color_name_index.find(name).to_vector();
 }
 
 std::vector<KeyId> Database::find_keys_by_name(std::string_view name) const {
-    std::vector<KeyId> result;
-    auto it = impl_->key_name_index.find(std::string(name));
-    if (it != impl_->key_name_index.end()) {
-        result.assign(it->second.begin(), it->second.end());
-    }
-    return result;
+    return impl().key_name_index.find(name).to_vector();
 }
 
 // ============================================================================
@@ -269,87 +604,193 @@ std::vector<KeyId> Database::find_keys_by_name(std::string_view name) const {
 // ============================================================================
 
 std::optional<std::vector<TrackId>> Database::get_playlist(PlaylistId id) const {
-    auto it = impl_->playlist_index.find(id);
-    if (it != impl_->playlist_index.end()) {
+    auto it = impl().playlist_index.find(id);
+    if (it != impl().playlist_index.end()) {
         return it->second;
     }
     return std::nullopt;
 }
 
 std::optional<std::vector<PlaylistFolderEntry>> Database::get_playlist_folder(PlaylistId folder_id) const {
-    auto it = impl_->playlist_folder_index.find(folder_id);
-    if (it != impl_->playlist_folder_index.end()) {
+    auto it = impl().playlist_folder_index.find(folder_id);
+    if (it != impl().playlist_folder_index.end()) {
         return it->second;
     }
     return std::nullopt;
 }
 
 std::optional<std::vector<TrackId>> Database::get_history_playlist(PlaylistId id) const {
-    auto it = impl_->history_playlist_index.find(id);
-    if (it != impl_->history_playlist_index.end()) {
+    auto it = impl().history_playlist_index.find(id);
+    if (it != impl().history_playlist_index.end()) {
         return it->second;
     }
     return std::nullopt;
 }
 
 std::optional<PlaylistId> Database::find_history_playlist_by_name(std::string_view name) const {
-    auto it = impl_->history_playlist_name_index.find(std::string(name));
-    if (it != impl_->history_playlist_name_index.end()) {
+    auto it = impl().history_playlist_name_index.find(std::string(name));
+    if (it != impl().history_playlist_name_index.end()) {
         return it->second;
     }
     return std::nullopt;
 }
 
+const PlaylistTree& Database::playlist_tree() const {
+    return impl().playlist_tree();
+}
+
+size_t Database::materialize_playlist(PlaylistId id, const PlaylistRowBuffers& out, size_t offset) const {
+    const DatabaseImpl& index = impl();
+    Span<const TrackId> entries = get_playlist_view(id);
+    if (offset >= entries.size()) {
+        return 0;
+    }
+    size_t count = std::min(out.capacity, entries.size() - offset);
+
+    auto name_of = [](const auto* row) { return row ? row->name : std::string_view{}; };
+    for (size_t i = 0; i < count; ++i) {
+        const TrackRowView* track = index.track_index.get(entries[offset + i]);
+        if (out.track_id) out.track_id[i] = track ? track->id.value : 0;
+        if (out.track) out.track[i] = track;
+        if (out.bpm_100x) out.bpm_100x[i] = track ? track->bpm_100x : 0;
+        if (out.duration) out.duration[i] = track ? track->duration_seconds : 0;
+        if (out.rating) out.rating[i] = track ? track->rating : 0;
+        if (out.key_id) out.key_id[i] = track ? track->key_id.value : 0;
+        if (out.title) out.title[i] = track ? track->title : std::string_view{};
+        if (!track) {
+            if (out.artist) out.artist[i] = {};
+            if (out.album) out.album[i] = {};
+            if (out.genre) out.genre[i] = {};
+            if (out.key) out.key[i] = {};
+            continue;
+        }
+        if (out.artist) out.artist[i] = name_of(index.artist_index.get(track->artist_id));
+        if (out.album) out.album[i] = name_of(index.album_index.get(track->album_id));
+        if (out.genre) out.genre[i] = name_of(index.genre_index.get(track->genre_id));
+        if (out.key) out.key[i] = name_of(index.key_index.get(track->key_id));
+    }
+    return count;
+}
+
 // ============================================================================
 // Tag Access (exportExt.pdb)
 // ============================================================================
 
 std::optional<TagRow> Database::get_tag(TagId id) const {
-    auto it = impl_->tag_index.find(id);
-    if (it != impl_->tag_index.end()) {
+    auto it = impl().tag_index.find(id);
+    if (it != impl().tag_index.end()) {
         return it->second;
     }
     return std::nullopt;
 }
 
 std::vector<TagId> Database::find_tags_by_name(std::string_view name) const {
-    std::vector<TagId> result;
-    auto it = impl_->tag_name_index.find(std::string(name));
-    if (it != impl_->tag_name_index.end()) {
-        result.assign(it->second.begin(), it->second.end());
-    }
-    return result;
+    return impl().tag_name_index.find(name).to_vector();
 }
 
 std::vector<TrackId> Database::find_tracks_by_tag(TagId tag_id) const {
-    std::vector<TrackId> result;
-    auto it = impl_->tag_track_index.find(tag_id);
-    if (it != impl_->tag_track_index.end()) {
-        result.assign(it->second.begin(), it->second.end());
-    }
-    return result;
+    return impl().tag_track_index.find(tag_id).to_vector();
 }
 
 std::vector<TagId> Database::find_tags_by_track(TrackId track_id) const {
-    std::vector<TagId> result;
-    auto it = impl_->track_tag_index.find(track_id);
-    if (it != impl_->track_tag_index.end()) {
-        result.assign(it->second.begin(), it->second.end());
-    }
-    return result;
+    return impl().track_tag_index.find(track_id).to_vector();
 }
 
 std::vector<TagId> Database::all_tag_ids() const {
     std::vector<TagId> result;
-    result.reserve(impl_->tag_index.size());
-    for (const auto& [id, _] : impl_->tag_index) {
+    result.reserve(impl().tag_index.size());
+    for (const auto& [id, _] : impl().tag_index) {
         result.push_back(id);
     }
     return result;
 }
 
 size_t Database::tag_count() const {
-    return impl_->tag_index.size();
+    return impl().tag_index.size();
+}
+
+TrackBitmap Database::find_tracks_by_tags(const TagQuery& query, const Database* tracks) const {
+    const DatabaseImpl& index = impl();
+    const auto& bitmaps = index.tag_bitmaps();
+    const TrackBitmap& universe = tracks ? tracks->impl().track_bitmap() : bitmaps.tagged;
+
+    auto tag_bitmap = [&](TagId tag) -> const TrackBitmap* {
+        const auto& keys = index.tag_track_index.keys();
+        auto it = std::lower_bound(keys.begin(), keys.end(), tag);
+        if (it == keys.end() || *it != tag) return nullptr;
+        return &bitmaps.by_tag[static_cast<size_t>(it - keys.begin())];
+    };
+
+    // Each operand is a set or, when negated, its complement in universe; NOT
+    // only flips the flag, and AND / OR fold negations in by De Morgan, so
+    // the universe is subtracted from at most once, at the end
+    struct Operand {
+        TrackBitmap set;
+        bool negated{false};
+    };
+    std::vector<Operand> stack;
+    for (const auto& term : query.terms()) {
+        switch (term.op) {
+            case TagQuery::Op::All:
+                stack.push_back({TrackBitmap{}, true});
+                break;
+            case TagQuery::Op::Tag: {
+                const TrackBitmap* bitmap = tag_bitmap(term.id);
+                stack.push_back({bitmap ? *bitmap : TrackBitmap{}, false});
+                break;
+            }
+            case TagQuery::Op::Category: {
+                Operand operand;
+                auto it = index.category_tags.find(term.id);
+                if (it != index.category_tags.end()) {
+                    for (TagId tag : it->second) {
+                        if (const TrackBitmap* bitmap = tag_bitmap(tag)) operand.set = operand.set | *bitmap;
+                    }
+                }
+                stack.push_back(std::move(operand));
+                break;
+            }
+            case TagQuery::Op::Not:
+                stack.back().negated = !stack.back().negated;
+                break;
+            case TagQuery::Op::And:
+            case TagQuery::Op::Or: {
+                Operand right = std::move(stack.back());
+                stack.pop_back();
+                Operand& left = stack.back();
+                // a OR b == NOT (NOT a AND NOT b)
+                bool is_or = term.op == TagQuery::Op::Or;
+                bool a = left.negated != is_or;
+                bool b = right.negated != is_or;
+                if (!a && !b) {
+                    left.set = left.set & right.set;
+                } else if (a && b) {
+                    left.set = left.set | right.set;
+                } else if (a) {
+                    left.set = right.set - left.set;
+                } else {
+                    left.set = left.set - right.set;
+                }
+                left.negated = (a && b) != is_or;
+                break;
+            }
+        }
+    }
+
+    if (stack.empty()) return universe;  // Match-all query
+    Operand& result = stack.back();
+    if (result.negated) return universe - result.set;
+    return tracks ? result.set & universe : std::move(result.set);
+}
+
+std::vector<const TrackRowView*> Database::track_views(const TrackBitmap& ids) const {
+    std::vector<const TrackRowView*> rows;
+    rows.reserve(ids.cardinality());
+    const auto& index = impl().track_index;
+    ids.for_each([&](TrackId id) {
+        if (const TrackRowView* row = index.get(id)) rows.push_back(row);
+    });
+    return rows;
 }
 
 // ============================================================================
@@ -357,29 +798,24 @@ size_t Database::tag_count() const {
 // ============================================================================
 
 std::optional<TagRow> Database::get_category(TagId id) const {
-    auto it = impl_->category_index.find(id);
-    if (it != impl_->category_index.end()) {
+    auto it = impl().category_index.find(id);
+    if (it != impl().category_index.end()) {
         return it->second;
     }
     return std::nullopt;
 }
 
 std::vector<TagId> Database::find_categories_by_name(std::string_view name) const {
-    std::vector<TagId> result;
-    auto it = impl_->category_name_index.find(std::string(name));
-    if (it != impl_->category_name_index.end()) {
-        result.assign(it->second.begin(), it->second.end());
-    }
-    return result;
+    return impl().category_name_index.find(name).to_vector();
 }
 
 const std::vector<TagId>& Database::category_order() const {
-    return impl_->category_order;
+    return impl().category_order;
 }
 
 std::vector<TagId> Database::get_tags_in_category(TagId category_id) const {
-    auto it = impl_->category_tags.find(category_id);
-    if (it != impl_->category_tags.end()) {
+    auto it = impl().category_tags.find(category_id);
+    if (it != impl().category_tags.end()) {
         return it->second;
     }
     return {};
@@ -387,75 +823,94 @@ std::vector<TagId> Database::get_tags_in_category(TagId category_id) const {
 
 std::vector<TagId> Database::all_category_ids() const {
     std::vector<TagId> result;
-    result.reserve(impl_->category_index.size());
-    for (const auto& [id, _] : impl_->category_index) {
+    result.reserve(impl().category_index.size());
+    for (const auto& [id, _] : impl().category_index) {
         result.push_back(id);
     }
     return result;
 }
 
 size_t Database::category_count() const {
-    return impl_->category_index.size();
+    return impl().category_index.size();
 }
 
 // ============================================================================
 // Cue Point Access
 // ============================================================================
 
-void Database::load_cue_points(const std::filesystem::path& anlz_dir) {
-    impl_->cue_point_manager_.scan_directory(anlz_dir);
+void Database::load_cue_points(const std::filesystem::path& anlz_dir, AnlzSections sections) {
+    change_anlz([&anlz_dir, sections](CuePointManager& anlz) { anlz.scan_directory(anlz_dir, sections); });
 }
 
-void Database::load_anlz_file(const std::filesystem::path& path) {
-    impl_->cue_point_manager_.load_anlz_file(path);
+void Database::load_anlz_file(const std::filesystem::path& path, AnlzSections sections) {
+    change_anlz([&path, sections](CuePointManager& anlz) { anlz.load_anlz_file(path, sections); });
 }
 
-std::vector<CuePoint> Database::get_cue_points(const std::string& track_path) const {
-    auto cue_data = impl_->cue_point_manager_.get_cue_points(track_path);
-    std::vector<CuePoint> result;
-    result.reserve(cue_data.size());
+void Database::enable_lazy_anlz_loading(size_t cache_capacity, const std::filesystem::path& export_root) {
+    auto root = export_root.empty() ? this->export_root() : export_root;
+    change_anlz([&](CuePointManager& anlz) { anlz.enable_lazy_loading(root, cache_capacity); });
+}
 
-    for (const auto& data : cue_data) {
-        CuePoint cue;
-        cue.type = data.type;
-        cue.time_ms = data.time_ms;
-        cue.loop_time_ms = data.loop_time_ms;
-        cue.hot_cue_number = static_cast<uint8_t>(data.hot_cue_number);
-        cue.color_id = data.color_id;
-        cue.comment = data.comment;
-        result.push_back(std::move(cue));
+std::shared_ptr<const TrackAnalysis> Database::get_analysis_for_track(TrackId id) const {
+    const auto* track = get_track_view(id);
+    if (!track) {
+        return nullptr;
     }
-    return result;
+
+    const auto& manager = anlz();
+    if (manager.lazy_loading_enabled()) {
+        return manager.load_analysis(std::string(track->analyze_path));
+    }
+
+    // Eager mode: the record lives as long as this generation, which the pointer pins
+    const auto* loaded = state_->loaded_analysis(id);
+    if (!loaded || loaded->empty()) {
+        return nullptr;
+    }
+    return std::shared_ptr<const TrackAnalysis>(state_, loaded);
+}
+
+size_t Database::cached_analysis_count() const {
+    return anlz().cached_analysis_count();
+}
+
+std::vector<CuePoint> Database::get_cue_points(const std::string& track_path) const {
+    auto cue_data = anlz().get_cue_points(track_path);
+    return to_cue_points(cue_data);
 }
 
 std::vector<CuePoint> Database::get_cue_points_for_track(TrackId id) const {
-    auto track = get_track(id);
-    if (!track || track->file_path.empty()) {
+    const auto* track = get_track_view(id);
+    if (!track) {
         return {};
     }
-    return get_cue_points(track->file_path);
+    if (anlz().lazy_loading_enabled()) {
+        auto analysis = anlz().load_analysis(std::string(track->analyze_path));
+        if (!analysis) {
+            return {};
+        }
+        return to_cue_points(analysis->cue_points);
+    }
+    const auto* analysis = state_->loaded_analysis(id);
+    return analysis ? to_cue_points(analysis->cue_points) : std::vector<CuePoint>{};
 }
 
-std::vector<CuePoint> Database::find_cue_points_by_filename(const std::string& filename) const {
-    auto cue_data = impl_->cue_point_manager_.find_cue_points_by_filename(filename);
-    std::vector<CuePoint> result;
-    result.reserve(cue_data.size());
-
-    for (const auto& data : cue_data) {
-        CuePoint cue;
-        cue.type = data.type;
-        cue.time_ms = data.time_ms;
-        cue.loop_time_ms = data.loop_time_ms;
-        cue.hot_cue_number = static_cast<uint8_t>(data.hot_cue_number);
-        cue.color_id = data.color_id;
-        cue.comment = data.comment;
-        result.push_back(std::move(cue));
+PinnedSpan<const CuePointData> Database::get_cue_points_view(TrackId id) const {
+    auto analysis = get_analysis_for_track(id);
+    if (!analysis) {
+        return {};
     }
-    return result;
+    Span<const CuePointData> cues(analysis->cue_points);
+    return {std::move(analysis), cues};
+}
+
+std::vector<CuePoint> Database::find_cue_points_by_filename(const std::string& filename) const {
+    auto cue_data = anlz().find_cue_points_by_filename(filename);
+    return to_cue_points(cue_data);
 }
 
 size_t Database::cue_point_track_count() const {
-    return impl_->cue_point_manager_.track_count();
+    return anlz().track_count();
 }
 
 // ============================================================================
@@ -463,23 +918,24 @@ size_t Database::cue_point_track_count() const {
 // ============================================================================
 
 const BeatGrid* Database::get_beat_grid(const std::string& track_path) const {
-    return impl_->cue_point_manager_.get_beat_grid(track_path);
+    return anlz().get_beat_grid(track_path);
 }
 
-const BeatGrid* Database::get_beat_grid_for_track(TrackId id) const {
-    auto track = get_track(id);
-    if (!track || track->file_path.empty()) {
+std::shared_ptr<const BeatGrid> Database::get_beat_grid_for_track(TrackId id) const {
+    // Aliases the analysis, which pins a lazy cache entry or the current generation
+    auto analysis = get_analysis_for_track(id);
+    if (!analysis || analysis->beat_grid.empty()) {
         return nullptr;
     }
-    return get_beat_grid(track->file_path);
+    return {analysis, &analysis->beat_grid};
 }
 
 const BeatGrid* Database::find_beat_grid_by_filename(const std::string& filename) const {
-    return impl_->cue_point_manager_.find_beat_grid_by_filename(filename);
+    return anlz().find_beat_grid_by_filename(filename);
 }
 
 size_t Database::beat_grid_track_count() const {
-    return impl_->cue_point_manager_.beat_grid_count();
+    return anlz().beat_grid_count();
 }
 
 // ============================================================================
@@ -487,23 +943,24 @@ size_t Database::beat_grid_track_count() const {
 // ============================================================================
 
 const TrackWaveforms* Database::get_waveforms(const std::string& track_path) const {
-    return impl_->cue_point_manager_.get_waveforms(track_path);
+    return anlz().get_waveforms(track_path);
 }
 
-const TrackWaveforms* Database::get_waveforms_for_track(TrackId id) const {
-    auto track = get_track(id);
-    if (!track || track->file_path.empty()) {
+std::shared_ptr<const TrackWaveforms> Database::get_waveforms_for_track(TrackId id) const {
+    // Aliases the analysis, which pins a lazy cache entry or the current generation
+    auto analysis = get_analysis_for_track(id);
+    if (!analysis || !analysis->waveforms.has_any()) {
         return nullptr;
     }
-    return get_waveforms(track->file_path);
+    return {analysis, &analysis->waveforms};
 }
 
 const TrackWaveforms* Database::find_waveforms_by_filename(const std::string& filename) const {
-    return impl_->cue_point_manager_.find_waveforms_by_filename(filename);
+    return anlz().find_waveforms_by_filename(filename);
 }
 
 size_t Database::waveform_track_count() const {
-    return impl_->cue_point_manager_.waveform_count();
+    return anlz().waveform_count();
 }
 
 // ============================================================================
@@ -511,23 +968,24 @@ size_t Database::waveform_track_count() const {
 // ============================================================================
 
 const SongStructure* Database::get_song_structure(const std::string& track_path) const {
-    return impl_->cue_point_manager_.get_song_structure(track_path);
+    return anlz().get_song_structure(track_path);
 }
 
-const SongStructure* Database::get_song_structure_for_track(TrackId id) const {
-    auto track = get_track(id);
-    if (!track || track->file_path.empty()) {
+std::shared_ptr<const SongStructure> Database::get_song_structure_for_track(TrackId id) const {
+    // Aliases the analysis, which pins a lazy cache entry or the current generation
+    auto analysis = get_analysis_for_track(id);
+    if (!analysis || analysis->song_structure.empty()) {
         return nullptr;
     }
-    return get_song_structure(track->file_path);
+    return {analysis, &analysis->song_structure};
 }
 
 const SongStructure* Database::find_song_structure_by_filename(const std::string& filename) const {
-    return impl_->cue_point_manager_.find_song_structure_by_filename(filename);
+    return anlz().find_song_structure_by_filename(filename);
 }
 
 size_t Database::song_structure_track_count() const {
-    return impl_->cue_point_manager_.song_structure_count();
+    return anlz().song_structure_count();
 }
 
 // ============================================================================
@@ -536,8 +994,8 @@ size_t Database::song_structure_track_count() const {
 
 std::vector<TrackId> Database::all_track_ids() const {
     std::vector<TrackId> result;
-    result.reserve(impl_->track_index.size());
-    for (const auto& [id, _] : impl_->track_index) {
+    result.reserve(impl().track_index.size());
+    for (const auto& [id, _] : impl().track_index) {
         result.push_back(id);
     }
     return result;
@@ -545,8 +1003,8 @@ std::vector<TrackId> Database::all_track_ids() const {
 
 std::vector<ArtistId> Database::all_artist_ids() const {
     std::vector<ArtistId> result;
-    result.reserve(impl_->artist_index.size());
-    for (const auto& [id, _] : impl_->artist_index) {
+    result.reserve(impl().artist_index.size());
+    for (const auto& [id, _] : impl().artist_index) {
         result.push_back(id);
     }
     return result;
@@ -554,8 +1012,8 @@ std::vector<ArtistId> Database::all_artist_ids() const {
 
 std::vector<AlbumId> Database::all_album_ids() const {
     std::vector<AlbumId> result;
-    result.reserve(impl_->album_index.size());
-    for (const auto& [id, _] : impl_->album_index) {
+    result.reserve(impl().album_index.size());
+    for (const auto& [id, _] : impl().album_index) {
         result.push_back(id);
     }
     return result;
@@ -563,8 +1021,8 @@ std::vector<AlbumId> Database::all_album_ids() const {
 
 std::vector<GenreId> Database::all_genre_ids() const {
     std::vector<GenreId> result;
-    result.reserve(impl_->genre_index.size());
-    for (const auto& [id, _] : impl_->genre_index) {
+    result.reserve(impl().genre_index.size());
+    for (const auto& [id, _] : impl().genre_index) {
         result.push_back(id);
     }
     return result;
@@ -572,8 +1030,8 @@ std::vector<GenreId> Database::all_genre_ids() const {
 
 std::vector<PlaylistId> Database::all_playlist_ids() const {
     std::vector<PlaylistId> result;
-    result.reserve(impl_->playlist_index.size());
-    for (const auto& [id, _] : impl_->playlist_index) {
+    result.reserve(impl().playlist_index.size());
+    for (const auto& [id, _] : impl().playlist_index) {
         result.push_back(id);
     }
     return result;
@@ -583,58 +1041,37 @@ std::vector<PlaylistId> Database::all_playlist_ids() const {
 // Bulk Data Extraction (for NumPy/AI)
 // ============================================================================
 
+const TrackColumns& Database::track_columns() const {
+    return impl().track_columns;
+}
+
 std::vector<float> Database::get_all_bpms() const {
-    std::vector<float> result;
-    result.reserve(impl_->track_index.size());
-    for (const auto& [id, track] : impl_->track_index) {
-        result.push_back(track.bpm_100x / 100.0f);
+    const auto& bpm_100x = impl().track_columns.bpm_100x;
+    std::vector<float> result(bpm_100x.size());
+    for (size_t i = 0; i < bpm_100x.size(); ++i) {
+        result[i] = bpm_100x[i] / 100.0f;
     }
     return result;
 }
 
 std::vector<int32_t> Database::get_all_durations() const {
-    std::vector<int32_t> result;
-    result.reserve(impl_->track_index.size());
-    for (const auto& [id, track] : impl_->track_index) {
-        result.push_back(static_cast<int32_t>(track.duration_seconds));
-    }
-    return result;
+    return widen_column(impl().track_columns.duration);
 }
 
 std::vector<int32_t> Database::get_all_years() const {
-    std::vector<int32_t> result;
-    result.reserve(impl_->track_index.size());
-    for (const auto& [id, track] : impl_->track_index) {
-        result.push_back(static_cast<int32_t>(track.year));
-    }
-    return result;
+    return widen_column(impl().track_columns.year);
 }
 
 std::vector<int32_t> Database::get_all_ratings() const {
-    std::vector<int32_t> result;
-    result.reserve(impl_->track_index.size());
-    for (const auto& [id, track] : impl_->track_index) {
-        result.push_back(static_cast<int32_t>(track.rating));
-    }
-    return result;
+    return widen_column(impl().track_columns.rating);
 }
 
 std::vector<int32_t> Database::get_all_bitrates() const {
-    std::vector<int32_t> result;
-    result.reserve(impl_->track_index.size());
-    for (const auto& [id, track] : impl_->track_index) {
-        result.push_back(static_cast<int32_t>(track.bitrate));
-    }
-    return result;
+    return widen_column(impl().track_columns.bitrate);
 }
 
 std::vector<int32_t> Database::get_all_sample_rates() const {
-    std::vector<int32_t> result;
-    result.reserve(impl_->track_index.size());
-    for (const auto& [id, track] : impl_->track_index) {
-        result.push_back(static_cast<int32_t>(track.sample_rate));
-    }
-    return result;
+    return widen_column(impl().track_columns.sample_rate);
 }
 
 // ============================================================================
@@ -642,27 +1079,42 @@ std::vector<int32_t> Database::get_all_sample_rates() const {
 // ============================================================================
 
 size_t Database::track_count() const {
-    return impl_->track_index.size();
+    return impl().track_index.size();
 }
 
 size_t Database::artist_count() const {
-    return impl_->artist_index.size();
+    return impl().artist_index.size();
 }
 
 size_t Database::album_count() const {
-    return impl_->album_index.size();
+    return impl().album_index.size();
 }
 
 size_t Database::genre_count() const {
-    return impl_->genre_index.size();
+    return impl().genre_index.size();
 }
 
 size_t Database::playlist_count() const {
-    return impl_->playlist_index.size();
+    return impl().playlist_index.size();
+}
+
+DatabaseMetrics Database::metrics() const {
+    auto metrics = impl().metrics();
+    metrics.anlz = anlz().metrics();
+    return metrics;
 }
 
 const std::filesystem::path& Database::source_file() const {
-    return impl_->source_file_;
+    return impl().source_file_;
+}
+
+std::filesystem::path Database::export_root() const {
+    // <root>/PIONEER/rekordbox/export.pdb
+    return impl().source_file_.parent_path().parent_path().parent_path();
+}
+
+const DatabaseOptions& Database::options() const {
+    return impl().options_;
 }
 
 } // namespace cratedigger
@@ -10,6 +10,11 @@
 #include "cratedigger/rekordbox_pdb.hpp"
 #include "cratedigger/rekordbox_anlz.hpp"
 #include "cratedigger/logging.hpp"
+#include "flat_index.hpp"
+#include "snapshot.hpp"
+#include "string_pool.hpp"
+#include "text_index.hpp"
+#include <mutex>
 
 namespace cratedigger {
 
@@ -20,36 +25,79 @@ namespace cratedigger {
  */
 class DatabaseImpl {
 public:
-    explicit DatabaseImpl(RekordboxPdb&& pdb, const std::filesystem::path& path)
+    /// Fields of the track text index, in TextField bit order
+    static constexpr size_t kTextFieldCount = 5;
+    using TrackTextIndex = TextIndex<TrackId, kTextFieldCount>;
+
+    /// strings is a pool shared with other databases, or null for a private one
+    DatabaseImpl(RekordboxPdb&& pdb, const std::filesystem::path& path, const DatabaseOptions& options,
+                 std::shared_ptr<StringPool> strings = nullptr)
         : pdb_(std::move(pdb))
+        , strings_(strings ? strings : std::make_shared<StringPool>())
+        , shared_strings_(strings != nullptr)
         , source_file_(path)
+        , options_(options)
     {}
 
     void build_indices();
 
+    /// Load indices from a matching snapshot in options_.snapshot_dir, else build_indices() and save one
+    void open_indices();
+
+    /// Build indices for a changed file, reusing what previous parsed from identical pages
+    void refresh_indices(const DatabaseImpl& previous, RefreshStats& stats);
+
+    /// Title/artist/album/filename/path search index (built on first use, thread-safe)
+    const TrackTextIndex& track_text_index() const;
+
+    /// Flattened playlist_folder_index (built on first use, thread-safe)
+    const PlaylistTree& playlist_tree() const;
+
+    /// Track bitmaps of tag_track_index, in keys() order, and their union
+    struct TagBitmaps {
+        std::vector<TrackBitmap> by_tag;
+        TrackBitmap tagged;
+    };
+
+    /// Per-tag track bitmaps (built on first use, thread-safe)
+    const TagBitmaps& tag_bitmaps() const;
+
+    /// Bitmap of every track_index ID (built on first use, thread-safe)
+    const TrackBitmap& track_bitmap() const;
+
+    /// Open-time counters (anlz is left empty)
+    [[nodiscard]] DatabaseMetrics metrics() const;
+
     // Primary indices
-    PrimaryIndex<TrackId, TrackRow> track_index;
-    PrimaryIndex<ArtistId, ArtistRow> artist_index;
-    PrimaryIndex<AlbumId, AlbumRow> album_index;
-    PrimaryIndex<GenreId, GenreRow> genre_index;
-    PrimaryIndex<LabelId, LabelRow> label_index;
-    PrimaryIndex<ColorId, ColorRow> color_index;
-    PrimaryIndex<KeyId, KeyRow> key_index;
-    PrimaryIndex<ArtworkId, ArtworkRow> artwork_index;
+    FlatPrimaryIndex<TrackId, TrackRowView> track_index;
+    FlatPrimaryIndex<ArtistId, ArtistRowView> artist_index;
+    FlatPrimaryIndex<AlbumId, AlbumRowView> album_index;
+    FlatPrimaryIndex<GenreId, GenreRowView> genre_index;
+    FlatPrimaryIndex<LabelId, LabelRowView> label_index;
+    FlatPrimaryIndex<ColorId, ColorRowView> color_index;
+    FlatPrimaryIndex<KeyId, KeyRowView> key_index;
+    FlatPrimaryIndex<ArtworkId, ArtworkRowView> artwork_index;
 
     // Secondary indices
-    NameIndex<TrackId> track_title_index;
-    SecondaryIndex<ArtistId, TrackId> track_artist_index;
-    SecondaryIndex<AlbumId, TrackId> track_album_index;
-    SecondaryIndex<GenreId, TrackId> track_genre_index;
-
-    NameIndex<ArtistId> artist_name_index;
-    NameIndex<AlbumId> album_name_index;
-    SecondaryIndex<ArtistId, AlbumId> album_artist_index;
-    NameIndex<GenreId> genre_name_index;
-    NameIndex<LabelId> label_name_index;
-    NameIndex<ColorId> color_name_index;
-    NameIndex<KeyId> key_name_index;
+    FlatNameIndex<TrackId> track_title_index;
+    FlatNameIndex<TrackId> track_filename_index;
+    FlatSecondaryIndex<ArtistId, TrackId> track_artist_index;
+    FlatSecondaryIndex<AlbumId, TrackId> track_album_index;
+    FlatSecondaryIndex<GenreId, TrackId> track_genre_index;
+    FlatSecondaryIndex<KeyId, TrackId> track_key_index;
+    FlatRangeIndex<uint32_t, TrackId> track_bpm_index;       // bpm_100x
+    FlatRangeIndex<uint32_t, TrackId> track_duration_index;  // Seconds
+    FlatRangeIndex<uint16_t, TrackId> track_year_index;
+    FlatRangeIndex<uint16_t, TrackId> track_rating_index;
+    TrackColumns track_columns;  // Numeric columns in track_index order
+
+    FlatNameIndex<ArtistId> artist_name_index;
+    FlatNameIndex<AlbumId> album_name_index;
+    FlatSecondaryIndex<ArtistId, AlbumId> album_artist_index;
+    FlatNameIndex<GenreId> genre_name_index;
+    FlatNameIndex<LabelId> label_name_index;
+    FlatNameIndex<ColorId> color_name_index;
+    FlatNameIndex<KeyId> key_name_index;
 
     // Playlist indices
     PlaylistIndex playlist_index;
@@ -58,25 +106,80 @@ public:
     std::map<std::string, PlaylistId, CaseInsensitiveCompare> history_playlist_name_index;
 
     // Tag indices (exportExt.pdb)
-    PrimaryIndex<TagId, TagRow> tag_index;               // Tags only (not categories)
-    NameIndex<TagId> tag_name_index;                     // Tag name lookup
-    SecondaryIndex<TagId, TrackId> tag_track_index;      // Tag -> Tracks
-    SecondaryIndex<TrackId, TagId> track_tag_index;      // Track -> Tags
+    FlatPrimaryIndex<TagId, TagRow> tag_index;               // Tags only (not categories)
+    FlatNameIndex<TagId> tag_name_index;                     // Tag name lookup
+    FlatSecondaryIndex<TagId, TrackId> tag_track_index;      // Tag -> Tracks
+    FlatSecondaryIndex<TrackId, TagId> track_tag_index;      // Track -> Tags
 
     // Tag category indices (exportExt.pdb)
-    PrimaryIndex<TagId, TagRow> category_index;          // Categories only
-    NameIndex<TagId> category_name_index;                // Category name lookup
-    std::vector<TagId> category_order;                   // Categories in display order
-    std::map<TagId, std::vector<TagId>> category_tags;   // Category -> Tags in order
+    FlatPrimaryIndex<TagId, TagRow> category_index;          // Categories only
+    FlatNameIndex<TagId> category_name_index;                // Category name lookup
+    std::vector<TagId> category_order;                       // Categories in display order
+    std::map<TagId, std::vector<TagId>> category_tags;       // Category -> Tags in order
 
     RekordboxPdb pdb_;
+    std::shared_ptr<StringPool> strings_;  // Decoded UTF-16 strings (ASCII rows borrow pdb_ bytes)
+    bool shared_strings_{false};            // strings_ belongs to a DatabaseSet and outlives refreshes
     std::filesystem::path source_file_;
+    int64_t source_mtime_{0};  // last_write_time ticks of source_file_ before it was read
+    DatabaseOptions options_;
+
+    // Set by Database::open / refresh around reading and indexing
+    uint64_t read_ns_{0};
+    uint64_t index_ns_{0};
 
-    // Cue point manager (loaded separately from ANLZ files)
-    CuePointManager cue_point_manager_;
+    /// Told each table as it is indexed, and polled between tables (open_async only)
+    const LoadObserver* observer_{nullptr};
+
+    /// Check whether the observer asked the build to stop
+    [[nodiscard]] bool build_cancelled() const { return observer_ != nullptr && observer_->cancelled(); }
 
 private:
+    SnapshotFile snapshot_;  // Backs pooled strings of indices loaded from a snapshot
+
+    mutable std::once_flag track_text_once_;
+    mutable TrackTextIndex track_text_index_;
+
+    mutable std::once_flag playlist_tree_once_;
+    mutable PlaylistTree playlist_tree_;
+
+    mutable std::once_flag tag_bitmaps_once_;
+    mutable TagBitmaps tag_bitmaps_;
+
+    mutable std::once_flag track_bitmap_once_;
+    mutable TrackBitmap track_bitmap_;
+
+    bool snapshot_restored_{false};
+    mutable std::mutex metrics_mutex_;  // Table indexers record from several workers
+    mutable std::vector<TableMetrics> table_metrics_;
+
+    /// Add one scan of a table (merged with earlier scans of the same table)
+    void record_table(std::string_view table, uint64_t pages, uint64_t rows, uint64_t parse_ns) const;
+
+    using TableIndexer = void (DatabaseImpl::*)();
+
+    /// Indexers of the file's tables in serial build order (tracks first)
+    [[nodiscard]] std::vector<TableIndexer> table_indexers() const;
+
+    void build_indices_serial();
+    void build_indices_parallel();
+
+    bool load_snapshot(const std::filesystem::path& path, const SnapshotKey& key);
+    void save_snapshot(const std::filesystem::path& path, const SnapshotKey& key) const;
+    void clear_indices();
+
+    /// Save a snapshot of the current indices if options_.snapshot_dir is set
+    void store_snapshot() const;
+
+    void refresh_tracks(const DatabaseImpl& previous, RefreshStats& stats);
+    [[nodiscard]] std::string_view rebase_string(std::string_view s, const DatabaseImpl& previous) const;
+
     void index_tracks();
+    bool parse_track_row(size_t row_base, TrackRowView& row) const;
+    void parse_track_pages(const uint32_t* first, const uint32_t* last, std::vector<TrackRowView>& rows) const;
+    void add_track(const TrackRowView& row);
+    void finish_track_indices();
+    void build_track_columns();
     void index_artists();
     void index_albums();
     void index_genres();
@@ -91,10 +194,54 @@ private:
     void index_tags();
     void index_tag_tracks();
 
+    /// Pass every row of a table (PageType or PageTypeExt) to handler and record the scan
+    template<typename Type, typename RowHandler>
+    void scan_table(Type type, RowHandler handler);
+
     template<typename RowHandler>
-    void scan_table(PageType type, RowHandler handler);
+    bool scan_page(uint32_t page_index, RowHandler& handler) const;
+
+    /// String reader for detail::RowFormat decoders (views are pooled, std::string members copied)
+    struct RowStrings;
+
+    /// Pass every row of a table that decodes with its detail::RowFormat to handler
+    template<auto Type, typename RowHandler>
+    void decode_table(RowHandler handler);
+
+    std::vector<uint32_t> table_pages(PageType type) const;
+
+    std::string_view string_at(size_t offset) const;
+};
 
-    std::string read_string_at_row(size_t row_base, uint16_t offset) const;
+// ============================================================================
+// Published Generation
+// ============================================================================
+
+/**
+ * @brief Everything a Database reads: PDB indices plus loaded ANLZ data
+ *
+ * Immutable once published. Readers pin a generation through a shared_ptr;
+ * refresh() and the ANLZ loaders build a successor next to it and swap the
+ * pointer, so a pinned generation never changes underneath its readers.
+ * Unchanged parts are shared between generations.
+ */
+class DatabaseGeneration {
+public:
+    DatabaseGeneration(std::shared_ptr<const DatabaseImpl> index, std::shared_ptr<const CuePointManager> anlz,
+                       uint64_t number)
+        : index(std::move(index)), anlz(std::move(anlz)), number(number) {}
+
+    /// Loaded ANLZ analysis for a track (nullptr if none; O(1), thread-safe)
+    const TrackAnalysis* loaded_analysis(TrackId id) const;
+
+    const std::shared_ptr<const DatabaseImpl> index;
+    const std::shared_ptr<const CuePointManager> anlz;
+    const uint64_t number;  // Database::generation()
+
+private:
+    // anlz record of each track, in index->track_index order
+    mutable std::once_flag analysis_once_;
+    mutable std::vector<const TrackAnalysis*> analysis_by_track_;
 };
 
 } // namespace cratedigger
@@ -0,0 +1,250 @@
+#include "cratedigger/database_set.hpp"
+#include "database_impl.hpp"
+#include "parallel.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <optional>
+
+namespace cratedigger {
+
+namespace {
+
+/// Merge per-member CSR indices into one whose postings are (source, ID) pairs
+template<typename Key, typename Index, typename KeysOf>
+void merge_member_indices(const std::vector<const Index*>& parts, KeysOf keys_of, std::vector<Key>& keys,
+                          std::vector<uint32_t>& offsets, std::vector<SourcedTrack>& ids) {
+    struct Entry {
+        const Key* key;
+        uint32_t source;
+        uint32_t index;
+    };
+    std::vector<Entry> entries;
+    size_t posting_count = 0;
+    for (uint32_t source = 0; source < parts.size(); ++source) {
+        const auto& part_keys = keys_of(*parts[source]);
+        for (uint32_t i = 0; i < part_keys.size(); ++i) entries.push_back({&part_keys[i], source, i});
+        posting_count += parts[source]->ids().size();
+    }
+    // Each member's keys are already sorted, so this mostly interleaves runs
+    std::stable_sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return *a.key < *b.key; });
+
+    keys.clear();
+    offsets.clear();
+    ids.clear();
+    ids.reserve(posting_count);
+    for (const auto& entry : entries) {
+        if (keys.empty() || !(keys.back() == *entry.key)) {
+            keys.push_back(*entry.key);
+            offsets.push_back(static_cast<uint32_t>(ids.size()));
+        }
+        for (TrackId id : parts[entry.source]->postings_at(entry.index)) ids.push_back({entry.source, id});
+    }
+    offsets.push_back(static_cast<uint32_t>(ids.size()));
+}
+
+} // anonymous namespace
+
+// ============================================================================
+// Implementation
+// ============================================================================
+
+struct DatabaseSet::Impl {
+    std::shared_ptr<StringPool> strings = std::make_shared<StringPool>();
+    std::vector<Database> members;
+    std::vector<std::filesystem::path> paths;
+    std::vector<DatabaseSetFailure> failures;
+
+    // Global indices over all members
+    FlatNameIndex<SourcedTrack> isrc_index;
+    FlatNameIndex<SourcedTrack> title_index;
+    FlatSecondaryIndex<uint64_t, SourcedTrack> file_hash_index;
+};
+
+DatabaseSet::DatabaseSet(std::unique_ptr<Impl> impl) : impl_(std::move(impl)) {}
+DatabaseSet::DatabaseSet(DatabaseSet&& other) noexcept = default;
+DatabaseSet& DatabaseSet::operator=(DatabaseSet&& other) noexcept = default;
+DatabaseSet::~DatabaseSet() = default;
+
+Result<DatabaseSet> DatabaseSet::open(const std::vector<std::filesystem::path>& paths,
+                                      const DatabaseSetOptions& options) {
+    auto impl = std::make_unique<Impl>();
+
+    // Split the thread budget: one worker per export, the rest go to each member's own loading
+    size_t budget = detail::resolve_thread_count(options.thread_count, SIZE_MAX);
+    size_t workers = detail::resolve_thread_count(budget, paths.size());
+    DatabaseOptions member_options = options.database;
+    member_options.thread_count = std::max<size_t>(1, budget / workers);
+
+    struct Opened {
+        std::optional<Database> db;
+        std::optional<Error> error;
+        FlatNameIndex<TrackId> isrc_index;
+        FlatSecondaryIndex<uint64_t, TrackId> file_hash_index;
+    };
+    std::vector<Opened> opened(paths.size());
+    detail::run_work_stealing(paths.size(), workers, [&](size_t i) {
+        auto& slot = opened[i];
+        auto db = Database::open_pooled(paths[i], false, member_options, impl->strings);
+        if (!db) {
+            slot.error = db.error();
+            return;
+        }
+        if (options.load_anlz) {
+            // <root>/PIONEER/rekordbox/export.pdb -> <root>/PIONEER/USBANLZ
+            auto anlz_dir = paths[i].parent_path().parent_path() / "USBANLZ";
+            std::error_code ec;
+            if (std::filesystem::is_directory(anlz_dir, ec)) db->load_cue_points(anlz_dir);
+        }
+
+        // Per-member parts of the global indices (the title index already exists)
+        db->for_each_track([&slot](const TrackRowView& track) {
+            if (!track.isrc.empty()) slot.isrc_index.insert(track.isrc, track.id);
+            if (uint64_t hash = file_hash(track)) slot.file_hash_index.insert(hash, track.id);
+        });
+        slot.isrc_index.freeze();
+        slot.file_hash_index.freeze();
+        slot.db = std::move(*db);
+    });
+
+    std::vector<const FlatNameIndex<TrackId>*> isrc_parts;
+    std::vector<const FlatNameIndex<TrackId>*> title_parts;
+    std::vector<const FlatSecondaryIndex<uint64_t, TrackId>*> hash_parts;
+    for (size_t i = 0; i < paths.size(); ++i) {
+        auto& slot = opened[i];
+        if (!slot.db) {
+            LOG_WARN("Skipping " + paths[i].string() + ": " + slot.error->message);
+            impl->failures.push_back({paths[i], std::move(*slot.error)});
+            continue;
+        }
+        // Indices live in the shared DatabaseImpl, so they stay put when the Database moves
+        title_parts.push_back(&slot.db->impl().track_title_index);
+        isrc_parts.push_back(&slot.isrc_index);
+        hash_parts.push_back(&slot.file_hash_index);
+        impl->members.push_back(std::move(*slot.db));
+        impl->paths.push_back(paths[i]);
+    }
+    if (impl->members.empty()) {
+        return make_error(ErrorCode::FileNotFound, paths.empty() ? std::string("No exports given")
+                                                                 : "No export could be opened: " +
+                                                                       impl->failures.front().error.message);
+    }
+    auto names_of = [](const FlatNameIndex<TrackId>& index) -> const std::vector<std::string>& { return index.names(); };
+    auto keys_of = [](const FlatSecondaryIndex<uint64_t, TrackId>& index) -> const std::vector<uint64_t>& {
+        return index.keys();
+    };
+    std::vector<std::string> names;
+    std::vector<uint64_t> hashes;
+    std::vector<uint32_t> offsets;
+    std::vector<SourcedTrack> ids;
+    merge_member_indices(isrc_parts, names_of, names, offsets, ids);
+    impl->isrc_index.restore(std::move(names), std::move(offsets), std::move(ids));
+    merge_member_indices(title_parts, names_of, names, offsets, ids);
+    impl->title_index.restore(std::move(names), std::move(offsets), std::move(ids));
+    merge_member_indices(hash_parts, keys_of, hashes, offsets, ids);
+    impl->file_hash_index.restore(std::move(hashes), std::move(offsets), std::move(ids));
+
+    LOG_INFO("Opened " + std::to_string(impl->members.size()) + " of " + std::to_string(paths.size()) +
+             " exports (" + std::to_string(impl->strings->size()) + " shared strings)");
+    return DatabaseSet(std::move(impl));
+}
+
+// ============================================================================
+// Members
+// ============================================================================
+
+size_t DatabaseSet::size() const {
+    return impl_->members.size();
+}
+
+const Database& DatabaseSet::member(uint32_t source) const {
+    return impl_->members.at(source);
+}
+
+Database& DatabaseSet::member(uint32_t source) {
+    return impl_->members.at(source);
+}
+
+const std::filesystem::path& DatabaseSet::source_path(uint32_t source) const {
+    return impl_->paths.at(source);
+}
+
+const std::vector<DatabaseSetFailure>& DatabaseSet::failures() const {
+    return impl_->failures;
+}
+
+size_t DatabaseSet::track_count() const {
+    size_t count = 0;
+    for (const auto& member : impl_->members) count += member.track_count();
+    return count;
+}
+
+size_t DatabaseSet::shared_string_count() const {
+    return impl_->strings->size();
+}
+
+// ============================================================================
+// Global Indices
+// ============================================================================
+
+std::vector<SourcedTrack> DatabaseSet::find_tracks_by_isrc(std::string_view isrc) const {
+    return impl_->isrc_index.find(isrc).to_vector();
+}
+
+std::vector<SourcedTrack> DatabaseSet::find_tracks_by_title(std::string_view title) const {
+    return impl_->title_index.find(title).to_vector();
+}
+
+std::vector<SourcedTrack> DatabaseSet::find_tracks_by_file_hash(uint64_t hash) const {
+    return impl_->file_hash_index.find(hash).to_vector();
+}
+
+std::vector<SourcedTrack> DatabaseSet::find_copies(SourcedTrack track) const {
+    const auto* view = get_track_view(track);
+    if (!view) {
+        return {};
+    }
+    uint64_t hash = file_hash(*view);
+    return hash != 0 ? find_tracks_by_file_hash(hash) : std::vector<SourcedTrack>{track};
+}
+
+uint64_t DatabaseSet::file_hash(const TrackRowView& track) {
+    if (track.filename.empty()) {
+        return 0;
+    }
+    thread_local std::string folded;
+    folded.assign(track.filename);
+    for (auto& c : folded) c = FlatNameIndex<TrackId>::fold_char(c);
+    uint64_t hash = hash_bytes(folded.data(), folded.size(), track.file_size);
+    return hash != 0 ? hash : 1;
+}
+
+// ============================================================================
+// Merged Queries
+// ============================================================================
+
+const TrackRowView* DatabaseSet::get_track_view(SourcedTrack track) const {
+    if (track.source >= impl_->members.size()) {
+        return nullptr;
+    }
+    return impl_->members[track.source].get_track_view(track.track_id);
+}
+
+std::vector<SourcedTrack> DatabaseSet::find_tracks(const TrackQuery& query) const {
+    std::vector<SourcedTrack> result;
+    for (uint32_t source = 0; source < impl_->members.size(); ++source) {
+        for (TrackId id : impl_->members[source].find_tracks(query)) result.push_back({source, id});
+    }
+    return result;
+}
+
+std::vector<SourcedTrack> DatabaseSet::find_tracks_by_bpm_range(float min_bpm, float max_bpm) const {
+    std::vector<SourcedTrack> result;
+    for (uint32_t source = 0; source < impl_->members.size(); ++source) {
+        for (TrackId id : impl_->members[source].find_tracks_by_bpm_range(min_bpm, max_bpm)) {
+            result.push_back({source, id});
+        }
+    }
+    return result;
+}
+
+} // namespace cratedigger
@@ -0,0 +1,500 @@
+#include "database_impl.hpp"
+#include "row_strings.hpp"
+#include <cstddef>
+#include <cstring>
+
+namespace cratedigger {
+
+// ============================================================================
+// Index Snapshots
+// ============================================================================
+
+namespace {
+
+/**
+ * Size and member offsets of every struct stored by memcpy; a build that
+ * changes one rejects old snapshots. Swapping two members of the same type
+ * keeps the offsets, so such changes still need a kSnapshotVersion bump.
+ */
+uint64_t index_snapshot_layout() {
+    const uint64_t layout[] = {
+        sizeof(TrackRowView),
+        offsetof(TrackRowView, id), offsetof(TrackRowView, title), offsetof(TrackRowView, artist_id),
+        offsetof(TrackRowView, composer_id), offsetof(TrackRowView, original_artist_id),
+        offsetof(TrackRowView, remixer_id), offsetof(TrackRowView, album_id), offsetof(TrackRowView, genre_id),
+        offsetof(TrackRowView, label_id), offsetof(TrackRowView, key_id), offsetof(TrackRowView, color_id),
+        offsetof(TrackRowView, artwork_id), offsetof(TrackRowView, duration_seconds),
+        offsetof(TrackRowView, bpm_100x), offsetof(TrackRowView, rating), offsetof(TrackRowView, file_path),
+        offsetof(TrackRowView, comment), offsetof(TrackRowView, bitrate), offsetof(TrackRowView, sample_rate),
+        offsetof(TrackRowView, year), offsetof(TrackRowView, file_size), offsetof(TrackRowView, track_number),
+        offsetof(TrackRowView, disc_number), offsetof(TrackRowView, play_count),
+        offsetof(TrackRowView, sample_depth), offsetof(TrackRowView, isrc), offsetof(TrackRowView, texter),
+        offsetof(TrackRowView, message), offsetof(TrackRowView, kuvo_public),
+        offsetof(TrackRowView, autoload_hot_cues), offsetof(TrackRowView, date_added),
+        offsetof(TrackRowView, release_date), offsetof(TrackRowView, mix_name),
+        offsetof(TrackRowView, analyze_path), offsetof(TrackRowView, analyze_date),
+        offsetof(TrackRowView, filename),
+        sizeof(ArtistRowView), offsetof(ArtistRowView, id), offsetof(ArtistRowView, name),
+        sizeof(AlbumRowView), offsetof(AlbumRowView, id), offsetof(AlbumRowView, name),
+        offsetof(AlbumRowView, artist_id),
+        sizeof(GenreRowView), offsetof(GenreRowView, id), offsetof(GenreRowView, name),
+        sizeof(LabelRowView), offsetof(LabelRowView, id), offsetof(LabelRowView, name),
+        sizeof(ColorRowView), offsetof(ColorRowView, id), offsetof(ColorRowView, name),
+        sizeof(KeyRowView), offsetof(KeyRowView, id), offsetof(KeyRowView, name),
+        sizeof(ArtworkRowView), offsetof(ArtworkRowView, id), offsetof(ArtworkRowView, path),
+        sizeof(TrackId), sizeof(PlaylistId), sizeof(TagId),
+        sizeof(SnapshotStringRef), offsetof(SnapshotStringRef, offset), offsetof(SnapshotStringRef, size),
+    };
+    return hash_bytes(layout, sizeof(layout), kSnapshotVersion);
+}
+
+// Primary indices of row views: rows with their strings cleared, then one
+// reference per string. Entry IDs are the rows' own IDs.
+
+template<typename IdType, typename Row>
+void save_rows(SnapshotWriter& out, const FlatPrimaryIndex<IdType, Row>& index) {
+    std::vector<SnapshotStringRef> refs;
+    refs.reserve(index.size() * strings_per_row<Row>());
+    out.array(index.entries(), [&](const std::pair<IdType, Row>& entry) {
+        Row row = entry.second;
+        visit_strings(row, [&](std::string_view& s) {
+            refs.push_back(out.ref(s));
+            s = {};
+        });
+        return row;
+    });
+    out.array(refs);
+}
+
+template<typename IdType, typename Row>
+void load_rows(SnapshotReader& in, FlatPrimaryIndex<IdType, Row>& index) {
+    // Rows are copied straight from the mapping into the index entries
+    size_t count = 0;
+    const uint8_t* rows = in.array_bytes<Row>(count);
+    std::vector<SnapshotStringRef> refs;
+    in.array(refs);
+    if (refs.size() != count * strings_per_row<Row>()) {
+        in.fail();
+        return;
+    }
+
+    std::vector<std::pair<IdType, Row>> entries;
+    entries.reserve(count);
+    size_t next = 0;
+    for (size_t i = 0; i < count; ++i) {
+        Row row;
+        std::memcpy(&row, rows + i * sizeof(Row), sizeof(Row));
+        visit_strings(row, [&](std::string_view& s) { s = in.resolve(refs[next++]); });
+        entries.emplace_back(row.id, row);
+    }
+    index.assign(std::move(entries));
+}
+
+// Tag rows own their names
+
+void save_tags(SnapshotWriter& out, const FlatPrimaryIndex<TagId, TagRow>& index) {
+    out.value(static_cast<uint64_t>(index.size()));
+    for (const auto& [id, tag] : index) {
+        out.value(id);
+        out.string(tag.name);
+        out.value(tag.category_id);
+        out.value(tag.category_pos);
+        out.value(tag.is_category);
+    }
+}
+
+void load_tags(SnapshotReader& in, FlatPrimaryIndex<TagId, TagRow>& index) {
+    std::vector<std::pair<TagId, TagRow>> entries(in.count(sizeof(TagId)));
+    for (auto& [id, tag] : entries) {
+        in.value(tag.id);
+        in.string(tag.name);
+        in.value(tag.category_id);
+        in.value(tag.category_pos);
+        in.value(tag.is_category);
+        id = tag.id;
+    }
+    index.assign(std::move(entries));
+}
+
+// CSR indices
+
+template<typename KeyType, typename IdType>
+void save_postings(SnapshotWriter& out, const FlatSecondaryIndex<KeyType, IdType>& index) {
+    out.array(index.keys());
+    out.array(index.offsets());
+    out.array(index.ids());
+}
+
+template<typename KeyType, typename IdType>
+void load_postings(SnapshotReader& in, FlatSecondaryIndex<KeyType, IdType>& index) {
+    std::vector<KeyType> keys;
+    std::vector<uint32_t> offsets;
+    std::vector<IdType> ids;
+    in.array(keys);
+    in.array(offsets);
+    in.array(ids);
+    if (in.ok() && !index.restore(std::move(keys), std::move(offsets), std::move(ids))) in.fail();
+}
+
+template<typename IdType>
+void save_postings(SnapshotWriter& out, const FlatNameIndex<IdType>& index) {
+    out.value(static_cast<uint64_t>(index.names().size()));
+    for (const auto& name : index.names()) out.string(name);
+    out.array(index.offsets());
+    out.array(index.ids());
+}
+
+template<typename IdType>
+void load_postings(SnapshotReader& in, FlatNameIndex<IdType>& index) {
+    std::vector<std::string> names(in.count(sizeof(uint64_t)));
+    for (auto& name : names) in.string(name);
+    std::vector<uint32_t> offsets;
+    std::vector<IdType> ids;
+    in.array(offsets);
+    in.array(ids);
+    if (in.ok() && !index.restore(std::move(names), std::move(offsets), std::move(ids))) in.fail();
+}
+
+// Range indices, stored as parallel value and ID arrays
+
+template<typename ValueType, typename IdType>
+void save_range(SnapshotWriter& out, const FlatRangeIndex<ValueType, IdType>& index) {
+    out.array(index.entries(), [](const std::pair<ValueType, IdType>& e) { return e.first; });
+    out.array(index.entries(), [](const std::pair<ValueType, IdType>& e) { return e.second; });
+}
+
+template<typename ValueType, typename IdType>
+void load_range(SnapshotReader& in, FlatRangeIndex<ValueType, IdType>& index) {
+    std::vector<ValueType> values;
+    std::vector<IdType> ids;
+    in.array(values);
+    in.array(ids);
+    if (values.size() != ids.size()) {
+        in.fail();
+        return;
+    }
+    std::vector<std::pair<ValueType, IdType>> entries;
+    entries.reserve(values.size());
+    for (size_t i = 0; i < values.size(); ++i) entries.emplace_back(values[i], ids[i]);
+    index.assign(std::move(entries));
+}
+
+// Maps of ID lists (playlists, category tags), stored as CSR
+
+template<typename KeyType, typename IdType, typename Compare>
+void save_lists(SnapshotWriter& out, const std::map<KeyType, std::vector<IdType>, Compare>& lists) {
+    std::vector<KeyType> keys;
+    std::vector<uint32_t> offsets{0};
+    std::vector<IdType> ids;
+    for (const auto& [key, list] : lists) {
+        keys.push_back(key);
+        ids.insert(ids.end(), list.begin(), list.end());
+        offsets.push_back(static_cast<uint32_t>(ids.size()));
+    }
+    out.array(keys);
+    out.array(offsets);
+    out.array(ids);
+}
+
+template<typename KeyType, typename IdType, typename Compare>
+void load_lists(SnapshotReader& in, std::map<KeyType, std::vector<IdType>, Compare>& lists) {
+    std::vector<KeyType> keys;
+    std::vector<uint32_t> offsets;
+    std::vector<IdType> ids;
+    in.array(keys);
+    in.array(offsets);
+    in.array(ids);
+    if (offsets.size() != keys.size() + 1 || offsets.back() != ids.size() ||
+        !std::is_sorted(offsets.begin(), offsets.end())) {
+        in.fail();
+        return;
+    }
+    lists.clear();
+    for (size_t k = 0; k < keys.size(); ++k) {
+        lists.emplace_hint(lists.end(), keys[k],
+                           std::vector<IdType>(ids.begin() + offsets[k], ids.begin() + offsets[k + 1]));
+    }
+}
+
+void save_folders(SnapshotWriter& out, const PlaylistFolderIndex& folders) {
+    out.value(static_cast<uint64_t>(folders.size()));
+    for (const auto& [parent, entries] : folders) {
+        out.value(parent);
+        out.value(static_cast<uint64_t>(entries.size()));
+        for (const auto& entry : entries) {
+            out.string(entry.name);
+            out.value(entry.is_folder);
+            out.value(entry.id);
+        }
+    }
+}
+
+void load_folders(SnapshotReader& in, PlaylistFolderIndex& folders) {
+    folders.clear();
+    for (size_t f = in.count(sizeof(PlaylistId)); f > 0 && in.ok(); --f) {
+        PlaylistId parent;
+        in.value(parent);
+        auto& entries = folders[parent];
+        entries.resize(in.count(sizeof(PlaylistId)));
+        for (auto& entry : entries) {
+            in.string(entry.name);
+            in.value(entry.is_folder);
+            in.value(entry.id);
+        }
+    }
+}
+
+template<typename Compare>
+void save_names(SnapshotWriter& out, const std::map<std::string, PlaylistId, Compare>& names) {
+    out.value(static_cast<uint64_t>(names.size()));
+    for (const auto& [name, id] : names) {
+        out.string(name);
+        out.value(id);
+    }
+}
+
+template<typename Compare>
+void load_names(SnapshotReader& in, std::map<std::string, PlaylistId, Compare>& names) {
+    names.clear();
+    for (size_t n = in.count(sizeof(PlaylistId)); n > 0 && in.ok(); --n) {
+        std::string name;
+        PlaylistId id;
+        in.string(name);
+        in.value(id);
+        names.emplace_hint(names.end(), std::move(name), id);
+    }
+}
+
+} // anonymous namespace
+
+void DatabaseImpl::open_indices() {
+    if (options_.snapshot_dir.empty()) {
+        build_indices();
+        return;
+    }
+
+    auto bytes = pdb_.data_at(0, pdb_.file_size());
+    auto key = snapshot_key(source_file_, bytes.first, bytes.second);
+    if (!key) {
+        LOG_WARN(key.error().message);
+        build_indices();
+        return;
+    }
+
+    auto path = snapshot_path(options_.snapshot_dir, source_file_,
+                              pdb_.is_ext() ? SnapshotKind::PdbExt : SnapshotKind::Pdb);
+    if (load_snapshot(path, *key)) {
+        snapshot_restored_ = true;
+        size_t tables = table_indexers().size();
+        if (observer_ != nullptr) observer_->report(tables, tables);
+        return;
+    }
+
+    build_indices();
+    if (build_cancelled()) return;  // Partial indices must not become a snapshot
+    save_snapshot(path, *key);
+}
+
+void DatabaseImpl::store_snapshot() const {
+    if (options_.snapshot_dir.empty()) return;
+
+    auto bytes = pdb_.data_at(0, pdb_.file_size());
+    auto key = snapshot_key(source_file_, bytes.first, bytes.second);
+    if (!key) {
+        LOG_WARN(key.error().message);
+        return;
+    }
+    save_snapshot(snapshot_path(options_.snapshot_dir, source_file_,
+                                pdb_.is_ext() ? SnapshotKind::PdbExt : SnapshotKind::Pdb), *key);
+}
+
+void DatabaseImpl::save_snapshot(const std::filesystem::path& path, const SnapshotKey& key) const {
+    auto bytes = pdb_.data_at(0, pdb_.file_size());
+    SnapshotWriter out(bytes.first, bytes.second);
+
+    save_rows(out, track_index);
+    save_rows(out, artist_index);
+    save_rows(out, album_index);
+    save_rows(out, genre_index);
+    save_rows(out, label_index);
+    save_rows(out, color_index);
+    save_rows(out, key_index);
+    save_rows(out, artwork_index);
+
+    save_postings(out, track_title_index);
+    save_postings(out, track_filename_index);
+    save_postings(out, track_artist_index);
+    save_postings(out, track_album_index);
+    save_postings(out, track_genre_index);
+    save_postings(out, track_key_index);
+    save_range(out, track_bpm_index);
+    save_range(out, track_duration_index);
+    save_range(out, track_year_index);
+    save_range(out, track_rating_index);
+    out.array(track_columns.track_id);
+    out.array(track_columns.bpm_100x);
+    out.array(track_columns.duration);
+    out.array(track_columns.year);
+    out.array(track_columns.rating);
+    out.array(track_columns.bitrate);
+    out.array(track_columns.sample_rate);
+    out.array(track_columns.key_id);
+    out.array(track_columns.genre_id);
+    out.array(track_columns.artist_id);
+    out.array(track_columns.play_count);
+
+    save_postings(out, artist_name_index);
+    save_postings(out, album_name_index);
+    save_postings(out, album_artist_index);
+    save_postings(out, genre_name_index);
+    save_postings(out, label_name_index);
+    save_postings(out, color_name_index);
+    save_postings(out, key_name_index);
+
+    save_lists(out, playlist_index);
+    save_folders(out, playlist_folder_index);
+    save_lists(out, history_playlist_index);
+    save_names(out, history_playlist_name_index);
+
+    save_tags(out, tag_index);
+    save_postings(out, tag_name_index);
+    save_postings(out, tag_track_index);
+    save_postings(out, track_tag_index);
+    save_tags(out, category_index);
+    save_postings(out, category_name_index);
+    out.array(category_order);
+    save_lists(out, category_tags);
+
+    if (out.commit(path, pdb_.is_ext() ? SnapshotKind::PdbExt : SnapshotKind::Pdb, key, index_snapshot_layout())) {
+        LOG_INFO("Saved index snapshot " + path.string());
+    }
+}
+
+void DatabaseImpl::clear_indices() {
+    track_index = {};
+    artist_index = {};
+    album_index = {};
+    genre_index = {};
+    label_index = {};
+    color_index = {};
+    key_index = {};
+    artwork_index = {};
+    track_title_index = {};
+    track_filename_index = {};
+    track_artist_index = {};
+    track_album_index = {};
+    track_genre_index = {};
+    track_key_index = {};
+    track_bpm_index = {};
+    track_duration_index = {};
+    track_year_index = {};
+    track_rating_index = {};
+    track_columns = {};
+    artist_name_index = {};
+    album_name_index = {};
+    album_artist_index = {};
+    genre_name_index = {};
+    label_name_index = {};
+    color_name_index = {};
+    key_name_index = {};
+    playlist_index.clear();
+    playlist_folder_index.clear();
+    history_playlist_index.clear();
+    history_playlist_name_index.clear();
+    tag_index = {};
+    tag_name_index = {};
+    tag_track_index = {};
+    track_tag_index = {};
+    category_index = {};
+    category_name_index = {};
+    category_order.clear();
+    category_tags.clear();
+}
+
+bool DatabaseImpl::load_snapshot(const std::filesystem::path& path, const SnapshotKey& key) {
+    if (!std::filesystem::exists(path)) return false;
+
+    auto file = SnapshotFile::open(path, pdb_.is_ext() ? SnapshotKind::PdbExt : SnapshotKind::Pdb,
+                                   key, index_snapshot_layout());
+    if (!file) {
+        LOG_INFO("Ignoring index snapshot: " + file.error().message);
+        return false;
+    }
+
+    auto bytes = pdb_.data_at(0, pdb_.file_size());
+    SnapshotReader in = file->reader(bytes.first, bytes.second);
+
+    load_rows(in, track_index);
+    load_rows(in, artist_index);
+    load_rows(in, album_index);
+    load_rows(in, genre_index);
+    load_rows(in, label_index);
+    load_rows(in, color_index);
+    load_rows(in, key_index);
+    load_rows(in, artwork_index);
+
+    load_postings(in, track_title_index);
+    load_postings(in, track_filename_index);
+    load_postings(in, track_artist_index);
+    load_postings(in, track_album_index);
+    load_postings(in, track_genre_index);
+    load_postings(in, track_key_index);
+    load_range(in, track_bpm_index);
+    load_range(in, track_duration_index);
+    load_range(in, track_year_index);
+    load_range(in, track_rating_index);
+    in.array(track_columns.track_id);
+    in.array(track_columns.bpm_100x);
+    in.array(track_columns.duration);
+    in.array(track_columns.year);
+    in.array(track_columns.rating);
+    in.array(track_columns.bitrate);
+    in.array(track_columns.sample_rate);
+    in.array(track_columns.key_id);
+    in.array(track_columns.genre_id);
+    in.array(track_columns.artist_id);
+    in.array(track_columns.play_count);
+
+    load_postings(in, artist_name_index);
+    load_postings(in, album_name_index);
+    load_postings(in, album_artist_index);
+    load_postings(in, genre_name_index);
+    load_postings(in, label_name_index);
+    load_postings(in, color_name_index);
+    load_postings(in, key_name_index);
+
+    load_lists(in, playlist_index);
+    load_folders(in, playlist_folder_index);
+    load_lists(in, history_playlist_index);
+    load_names(in, history_playlist_name_index);
+
+    load_tags(in, tag_index);
+    load_postings(in, tag_name_index);
+    load_postings(in, tag_track_index);
+    load_postings(in, track_tag_index);
+    load_tags(in, category_index);
+    load_postings(in, category_name_index);
+    in.array(category_order);
+    load_lists(in, category_tags);
+
+    const auto& columns = track_columns;
+    for (size_t size : {columns.track_id.size(), columns.bpm_100x.size(), columns.duration.size(),
+                        columns.year.size(), columns.rating.size(), columns.bitrate.size(),
+                        columns.sample_rate.size(), columns.key_id.size(), columns.genre_id.size(),
+                        columns.artist_id.size(), columns.play_count.size()}) {
+        if (size != track_index.size()) in.fail();
+    }
+
+    if (!in.finished()) {
+        // Discard whatever was read; the caller rebuilds from the PDB
+        LOG_WARN("Corrupt index snapshot: " + path.string());
+        clear_indices();
+        return false;
+    }
+
+    snapshot_ = std::move(*file);
+    LOG_INFO("Loaded " + std::to_string(track_index.size()) + " tracks from index snapshot");
+    return true;
+}
+
+} // namespace cratedigger
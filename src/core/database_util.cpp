@@ -1,6 +1,13 @@
 #include "database_impl.hpp"
+#include "parallel.hpp"
+#include "row_decoders.hpp"
+#include "row_strings.hpp"
+#include "stopwatch.hpp"
 #include <algorithm>
+#include <atomic>
 #include <cctype>
+#include <cstring>
+#include <functional>
 
 namespace cratedigger {
 
@@ -22,100 +29,261 @@ bool CaseInsensitiveCompare::operator()(const std::string& a, const std::string&
 // Table Scanning
 // ============================================================================
 
-template<typename RowHandler>
-void DatabaseImpl::scan_table(PageType type, RowHandler handler) {
-    // Find the table with matching type
-    for (const auto& table : pdb_.tables()) {
-        if (table.type != type) continue;
+namespace {
+
+/**
+ * @brief Visit each page of a table's chain with a row cursor
+ *
+ * Stops after file_size / page_size pages so a cyclic chain cannot spin.
+ * Returns false if a page in the chain is out of range.
+ */
+template<typename PageVisitor>
+bool walk_page_chain(const RekordboxPdb& pdb, const PdbTable& table, PageVisitor&& visit) {
+    size_t max_pages = pdb.page_size() == 0 ? 0 : pdb.file_size() / pdb.page_size();
+    uint32_t current_page_idx = table.first_page_index;
+
+    for (size_t visited = 0; visited < max_pages; ++visited) {
+        PageRowCursor cursor = pdb.page_rows(current_page_idx);
+        if (!cursor.valid()) {
+            LOG_ERROR("Failed to read page " + std::to_string(current_page_idx));
+            return false;
+        }
 
-        uint32_t current_page_idx = table.first_page_index;
-        uint32_t last_page_idx = table.last_page_index;
-        bool more_pages = true;
+        visit(current_page_idx, cursor);
 
-        while (more_pages) {
-            auto page_result = pdb_.read_page(current_page_idx);
-            if (!page_result) {
-                LOG_ERROR("Failed to read page " + std::to_string(current_page_idx));
-                break;
-            }
+        if (current_page_idx == table.last_page_index) break;
+        current_page_idx = cursor.next_page_index();
+    }
+    return true;
+}
 
-            const auto& page = *page_result;
+/// Pass every present row of a page to the handler (returns the number of rows)
+template<typename RowHandler>
+size_t scan_rows(PageRowCursor& cursor, RowHandler& handler) {
+    size_t row_base = 0;
+    size_t rows = 0;
+    while (cursor.next(row_base)) {
+        handler(row_base);
+        ++rows;
+    }
+    return rows;
+}
 
-            if (page.is_data_page) {
-                for (const auto& row_group : page.row_groups) {
-                    for (size_t row_idx = 0; row_idx < row_group.row_offsets.size(); ++row_idx) {
-                        // Check if row is present
-                        bool present = ((row_group.row_present_flags >> row_idx) & 1) != 0;
-                        if (!present) continue;
+const PdbTable* find_table(const RekordboxPdb& pdb, PageType type) {
+    for (const auto& table : pdb.tables()) {
+        if (table.type == type) return &table;
+    }
+    return nullptr;
+}
 
-                        uint16_t row_offset = row_group.row_offsets[row_idx];
-                        size_t row_base = row_group.heap_pos + row_offset;
+const PdbTable* find_table(const RekordboxPdb& pdb, PageTypeExt type) {
+    for (const auto& table : pdb.tables()) {
+        if (table.type_ext == type) return &table;
+    }
+    return nullptr;
+}
 
-                        handler(row_base);
-                    }
-                }
-            }
+/// Table name used in metrics
+std::string table_name(PageType type) {
+    switch (type) {
+        case PageType::Tracks: return "tracks";
+        case PageType::Genres: return "genres";
+        case PageType::Artists: return "artists";
+        case PageType::Albums: return "albums";
+        case PageType::Labels: return "labels";
+        case PageType::Keys: return "keys";
+        case PageType::Colors: return "colors";
+        case PageType::PlaylistTree: return "playlist_tree";
+        case PageType::PlaylistEntries: return "playlist_entries";
+        case PageType::HistoryPlaylists: return "history_playlists";
+        case PageType::HistoryEntries: return "history_entries";
+        case PageType::Artwork: return "artwork";
+        case PageType::Columns: return "columns";
+        case PageType::History: return "history";
+        default: return "table_" + std::to_string(static_cast<uint32_t>(type));
+    }
+}
 
-            if (current_page_idx == last_page_idx) {
-                more_pages = false;
-            } else {
-                current_page_idx = page.next_page_index;
-            }
-        }
+std::string table_name(PageTypeExt type) {
+    switch (type) {
+        case PageTypeExt::Tags: return "tags";
+        case PageTypeExt::TagTracks: return "tag_tracks";
+        default: return "ext_table_" + std::to_string(static_cast<uint32_t>(type));
+    }
+}
 
-        return;  // Found and processed the table
+/// A table's lists hold at most this many slots per row, plus kPositionAllowance in all
+constexpr size_t kPositionSlack = 4;
+constexpr size_t kPositionAllowance = 1024;
+
+/// A row stored at a position of a per-key list (playlist entries, folder children)
+template<typename Key, typename Value>
+struct PlacedRow {
+    Key key;
+    uint32_t position{0};
+    Value value;
+};
+
+/**
+ * @brief Store rows at their positions in per-key lists
+ *
+ * Lists are sized by their largest position, so a corrupt position
+ * (0xFFFFFFFF) would wrap or allocate gigabytes. While the table's lists
+ * fit the budget of kPositionSlack slots per row plus kPositionAllowance,
+ * rows keep their exact positions, gaps included. Beyond it the sparsest
+ * lists are compacted (their rows kept in position order, without gaps)
+ * until the rest fit, so no row is lost. Returns the lists compacted.
+ */
+template<typename Lists, typename Key, typename Value>
+size_t place_rows(Lists& lists, std::vector<PlacedRow<Key, Value>>& rows) {
+    struct Extent {
+        size_t rows{0};
+        size_t slots{0};
+        bool compact{false};
+    };
+    std::map<Key, Extent> extents;
+    size_t total = 0;
+    for (const auto& row : rows) {
+        auto& extent = extents[row.key];
+        ++extent.rows;
+        size_t slots = std::max<size_t>(extent.slots, size_t{row.position} + 1);
+        total += slots - extent.slots;
+        extent.slots = slots;
     }
 
-    LOG_WARN("Table type " + std::to_string(static_cast<int>(type)) + " not found");
-}
+    size_t compacted = 0;
+    size_t budget = rows.size() * kPositionSlack + kPositionAllowance;
+    if (total > budget) {
+        std::vector<Extent*> sparsest;
+        for (auto& [key, extent] : extents) sparsest.push_back(&extent);
+        std::sort(sparsest.begin(), sparsest.end(), [](const Extent* a, const Extent* b) {
+            return a->slots - a->rows > b->slots - b->rows;
+        });
+        for (Extent* extent : sparsest) {
+            if (total <= budget) break;
+            total -= extent->slots - extent->rows;
+            extent->compact = true;
+            ++compacted;
+        }
+    }
 
-template<typename RowHandler>
-void scan_table_ext(RekordboxPdb& pdb, PageTypeExt type, RowHandler handler) {
-    for (const auto& table : pdb.tables()) {
-        if (table.type_ext != type) continue;
+    // Position order places compacted rows; ties keep table order, so the last row stored wins
+    std::stable_sort(rows.begin(), rows.end(), [](const auto& a, const auto& b) { return a.position < b.position; });
+    for (auto& row : rows) {
+        auto& list = lists[row.key];
+        if (extents[row.key].compact) {
+            list.push_back(std::move(row.value));
+            continue;
+        }
+        size_t position = row.position;
+        if (list.size() <= position) {
+            list.resize(position + 1);
+        }
+        list[position] = std::move(row.value);
+    }
+    return compacted;
+}
 
-        uint32_t current_page_idx = table.first_page_index;
-        uint32_t last_page_idx = table.last_page_index;
-        bool more_pages = true;
+} // anonymous namespace
 
-        while (more_pages) {
-            auto page_result = pdb.read_page(current_page_idx);
-            if (!page_result) {
-                LOG_ERROR("Failed to read page " + std::to_string(current_page_idx));
-                break;
-            }
+template<typename Type, typename RowHandler>
+void DatabaseImpl::scan_table(Type type, RowHandler handler) {
+    const PdbTable* table = find_table(pdb_, type);
+    if (table == nullptr) {
+        LOG_WARN("Table type " + std::to_string(static_cast<int>(type)) + " not found");
+        return;
+    }
 
-            const auto& page = *page_result;
+    detail::Stopwatch watch;
+    uint64_t pages = 0;
+    uint64_t rows = 0;
+    walk_page_chain(pdb_, *table, [&](uint32_t, PageRowCursor& cursor) {
+        ++pages;
+        rows += scan_rows(cursor, handler);
+    });
+    record_table(table_name(type), pages, rows, watch.elapsed_ns());
+}
 
-            if (page.is_data_page) {
-                for (const auto& row_group : page.row_groups) {
-                    for (size_t row_idx = 0; row_idx < row_group.row_offsets.size(); ++row_idx) {
-                        bool present = ((row_group.row_present_flags >> row_idx) & 1) != 0;
-                        if (!present) continue;
+void DatabaseImpl::record_table(std::string_view table, uint64_t pages, uint64_t rows, uint64_t parse_ns) const {
+    std::lock_guard<std::mutex> lock(metrics_mutex_);
+    auto it = std::find_if(table_metrics_.begin(), table_metrics_.end(),
+                           [table](const TableMetrics& m) { return m.table == table; });
+    if (it == table_metrics_.end()) {
+        it = table_metrics_.insert(table_metrics_.end(), TableMetrics{std::string(table), 0, 0, 0, 0});
+    }
+    it->pages += pages;
+    it->rows += rows;
+    it->bytes += pages * pdb_.page_size();
+    it->parse_ns += parse_ns;
+}
 
-                        uint16_t row_offset = row_group.row_offsets[row_idx];
-                        size_t row_base = row_group.heap_pos + row_offset;
+DatabaseMetrics DatabaseImpl::metrics() const {
+    DatabaseMetrics metrics;
+    metrics.read_ns = read_ns_;
+    metrics.index_ns = index_ns_;
+    metrics.open_ns = read_ns_ + index_ns_;
+    metrics.file_bytes = pdb_.file_size();
+    metrics.page_size = pdb_.page_size();
+    metrics.snapshot_restored = snapshot_restored_;
+    {
+        std::lock_guard<std::mutex> lock(metrics_mutex_);
+        metrics.tables = table_metrics_;
+    }
+    metrics.pooled_strings = strings_->size();
+    metrics.pooled_string_bytes = strings_->bytes();
+    return metrics;
+}
 
-                        handler(row_base);
-                    }
-                }
-            }
+template<typename RowHandler>
+bool DatabaseImpl::scan_page(uint32_t page_index, RowHandler& handler) const {
+    PageRowCursor cursor = pdb_.page_rows(page_index);
+    if (!cursor.valid()) {
+        LOG_ERROR("Failed to read page " + std::to_string(page_index));
+        return false;
+    }
+    scan_rows(cursor, handler);
+    return true;
+}
 
-            if (current_page_idx == last_page_idx) {
-                more_pages = false;
-            } else {
-                current_page_idx = page.next_page_index;
-            }
-        }
+std::vector<uint32_t> DatabaseImpl::table_pages(PageType type) const {
+    std::vector<uint32_t> pages;
+    for (const auto& table : pdb_.tables()) {
+        if (table.type != type) continue;
 
-        return;
+        walk_page_chain(pdb_, table, [&pages](uint32_t page_index, PageRowCursor&) {
+            pages.push_back(page_index);
+        });
+        return pages;
     }
 
     LOG_WARN("Table type " + std::to_string(static_cast<int>(type)) + " not found");
+    return pages;
 }
 
-std::string DatabaseImpl::read_string_at_row(size_t row_base, uint16_t offset) const {
-    return pdb_.read_string(row_base + offset);
+std::string_view DatabaseImpl::string_at(size_t offset) const {
+    // ASCII strings borrow the file bytes; only decoded UTF-16 is pooled
+    thread_local std::string scratch;
+    std::string_view view = pdb_.read_string_view(offset, scratch);
+    if (!view.empty() && view.data() == scratch.data()) {
+        return strings_->intern(view);
+    }
+    return view;
+}
+
+struct DatabaseImpl::RowStrings {
+    const DatabaseImpl& db;
+
+    void read(size_t offset, std::string_view& out) const { out = db.string_at(offset); }
+    void read(size_t offset, std::string& out) const { out = db.pdb_.read_string(offset); }
+};
+
+template<auto Type, typename RowHandler>
+void DatabaseImpl::decode_table(RowHandler handler) {
+    RowStrings strings{*this};
+    scan_table(Type, [this, &strings, &handler](size_t row_base) {
+        typename detail::RowFormat<Type>::Row row{};
+        if (detail::decode_row<Type>(detail::row_bytes(pdb_, row_base), row, strings)) handler(row);
+    });
 }
 
 // ============================================================================
@@ -123,353 +291,455 @@ std::string DatabaseImpl::read_string_at_row(size_t row_base, uint16_t offset) c
 // ============================================================================
 
 void DatabaseImpl::build_indices() {
+    if (options_.parallel_indexing && options_.thread_count != 1) {
+        build_indices_parallel();
+    } else {
+        build_indices_serial();
+    }
+}
+
+std::vector<DatabaseImpl::TableIndexer> DatabaseImpl::table_indexers() const {
     if (pdb_.is_ext()) {
         // exportExt.pdb tables
-        index_tags();
-        index_tag_tracks();
-    } else {
-        // export.pdb tables
-        index_tracks();
-        index_artists();
-        index_albums();
-        index_genres();
-        index_labels();
-        index_colors();
-        index_keys();
-        index_artwork();
-        index_playlists();
-        index_playlist_folders();
-        index_history_playlists();
-        index_history_entries();
+        return {&DatabaseImpl::index_tags, &DatabaseImpl::index_tag_tracks};
     }
+    // export.pdb tables
+    return {
+        &DatabaseImpl::index_tracks,
+        &DatabaseImpl::index_artists,
+        &DatabaseImpl::index_albums,
+        &DatabaseImpl::index_genres,
+        &DatabaseImpl::index_labels,
+        &DatabaseImpl::index_colors,
+        &DatabaseImpl::index_keys,
+        &DatabaseImpl::index_artwork,
+        &DatabaseImpl::index_playlists,
+        &DatabaseImpl::index_playlist_folders,
+        &DatabaseImpl::index_history_playlists,
+        &DatabaseImpl::index_history_entries,
+    };
 }
 
-void DatabaseImpl::index_tracks() {
-    scan_table(PageType::Tracks, [this](size_t row_base) {
-        auto data = pdb_.data_at(row_base, sizeof(RawTrackRow));
-        if (data.second < sizeof(RawTrackRow)) return;
-
-        const auto* raw = reinterpret_cast<const RawTrackRow*>(data.first);
-
-        TrackRow row;
-        row.id = TrackId{static_cast<int64_t>(raw->id)};
-        row.artist_id = ArtistId{static_cast<int64_t>(raw->artist_id)};
-        row.composer_id = ArtistId{static_cast<int64_t>(raw->composer_id)};
-        row.original_artist_id = ArtistId{static_cast<int64_t>(raw->original_artist_id)};
-        row.remixer_id = ArtistId{static_cast<int64_t>(raw->remixer_id)};
-        row.album_id = AlbumId{static_cast<int64_t>(raw->album_id)};
-        row.genre_id = GenreId{static_cast<int64_t>(raw->genre_id)};
-        row.label_id = LabelId{static_cast<int64_t>(raw->label_id)};
-        row.key_id = KeyId{static_cast<int64_t>(raw->key_id)};
-        row.color_id = ColorId{static_cast<int64_t>(raw->color_id)};
-        row.artwork_id = ArtworkId{static_cast<int64_t>(raw->artwork_id)};
-        row.duration_seconds = raw->duration;
-        row.bpm_100x = raw->tempo;
-        row.rating = raw->rating;
-        row.bitrate = raw->bitrate;
-        row.sample_rate = raw->sample_rate;
-        row.year = raw->year;
-        // Additional numeric fields
-        row.file_size = raw->file_size;
-        row.track_number = raw->track_number;
-        row.disc_number = raw->disc_number;
-        row.play_count = raw->play_count;
-        row.sample_depth = raw->sample_depth;
-
-        // Read strings (per IR_SCHEMA.md string offset indices)
-        row.isrc = read_string_at_row(row_base, raw->ofs_strings[0]);
-        row.texter = read_string_at_row(row_base, raw->ofs_strings[1]);
-        row.message = read_string_at_row(row_base, raw->ofs_strings[5]);
-        row.kuvo_public = read_string_at_row(row_base, raw->ofs_strings[6]);
-        row.autoload_hot_cues = read_string_at_row(row_base, raw->ofs_strings[7]);
-        row.date_added = read_string_at_row(row_base, raw->ofs_strings[10]);
-        row.release_date = read_string_at_row(row_base, raw->ofs_strings[11]);
-        row.mix_name = read_string_at_row(row_base, raw->ofs_strings[12]);
-        row.analyze_path = read_string_at_row(row_base, raw->ofs_strings[14]);
-        row.analyze_date = read_string_at_row(row_base, raw->ofs_strings[15]);
-        row.comment = read_string_at_row(row_base, raw->ofs_strings[16]);
-        row.title = read_string_at_row(row_base, raw->ofs_strings[17]);
-        row.filename = read_string_at_row(row_base, raw->ofs_strings[19]);
-        row.file_path = read_string_at_row(row_base, raw->ofs_strings[20]);
-
-        // Add to primary index
-        track_index[row.id] = row;
-
-        // Add to secondary indices
-        if (!row.title.empty()) {
-            track_title_index[row.title].insert(row.id);
-        }
-        if (row.artist_id.value > 0) {
-            track_artist_index[row.artist_id].insert(row.id);
-        }
-        if (row.composer_id.value > 0) {
-            track_artist_index[row.composer_id].insert(row.id);
-        }
-        if (row.original_artist_id.value > 0) {
-            track_artist_index[row.original_artist_id].insert(row.id);
+void DatabaseImpl::build_indices_serial() {
+    auto indexers = table_indexers();
+    if (observer_ != nullptr) observer_->report(0, indexers.size());
+    for (size_t i = 0; i < indexers.size(); ++i) {
+        if (build_cancelled()) return;
+        (this->*indexers[i])();
+        if (observer_ != nullptr) observer_->report(i + 1, indexers.size());
+    }
+}
+
+void DatabaseImpl::build_indices_parallel() {
+    // Each table indexer writes only its own members, and the track table is
+    // parsed in page-chain segments that are merged back in chain order, so
+    // the result matches build_indices_serial().
+    constexpr size_t kTrackPagesPerSegment = 8;
+
+    auto indexers = table_indexers();
+    std::atomic<size_t> tables_done{0};
+    auto table_done = [&] {
+        if (observer_ != nullptr) {
+            observer_->report(tables_done.fetch_add(1, std::memory_order_relaxed) + 1, indexers.size());
         }
-        if (row.remixer_id.value > 0) {
-            track_artist_index[row.remixer_id].insert(row.id);
+    };
+    if (observer_ != nullptr) observer_->report(0, indexers.size());
+
+    std::vector<std::function<void()>> tasks;
+    std::vector<uint32_t> track_pages;
+    std::vector<std::vector<TrackRowView>> track_segments;
+
+    bool ext = pdb_.is_ext();
+    if (!ext) {
+        track_pages = table_pages(PageType::Tracks);
+        track_segments.resize((track_pages.size() + kTrackPagesPerSegment - 1) / kTrackPagesPerSegment);
+        for (size_t s = 0; s < track_segments.size(); ++s) {
+            tasks.emplace_back([this, s, &track_pages, &track_segments] {
+                if (build_cancelled()) return;
+                size_t begin = s * kTrackPagesPerSegment;
+                size_t end = std::min(begin + kTrackPagesPerSegment, track_pages.size());
+                parse_track_pages(track_pages.data() + begin, track_pages.data() + end, track_segments[s]);
+            });
         }
-        if (row.album_id.value > 0) {
-            track_album_index[row.album_id].insert(row.id);
+    }
+    // The track table is parsed by the segment tasks above and merged below
+    for (size_t i = ext ? 0 : 1; i < indexers.size(); ++i) {
+        tasks.emplace_back([this, indexer = indexers[i], &table_done] {
+            if (build_cancelled()) return;
+            (this->*indexer)();
+            table_done();
+        });
+    }
+
+    detail::run_work_stealing(tasks.size(), options_.thread_count, [&tasks](size_t i) { tasks[i](); });
+
+    if (!ext && !build_cancelled()) {
+        detail::Stopwatch watch;
+        for (auto& segment : track_segments) {
+            for (const auto& row : segment) add_track(row);
+            std::vector<TrackRowView>().swap(segment);
         }
-        if (row.genre_id.value > 0) {
-            track_genre_index[row.genre_id].insert(row.id);
+        record_table(table_name(PageType::Tracks), 0, 0, watch.elapsed_ns());
+        finish_track_indices();
+        table_done();
+    }
+}
+
+void DatabaseImpl::index_tracks() {
+    scan_table(PageType::Tracks, [this](size_t row_base) {
+        TrackRowView row;
+        if (parse_track_row(row_base, row)) {
+            add_track(row);
         }
     });
 
+    finish_track_indices();
+}
+
+bool DatabaseImpl::parse_track_row(size_t row_base, TrackRowView& row) const {
+    RowStrings strings{*this};
+    return detail::decode_row<PageType::Tracks>(detail::row_bytes(pdb_, row_base), row, strings);
+}
+
+void DatabaseImpl::parse_track_pages(const uint32_t* first, const uint32_t* last,
+                                     std::vector<TrackRowView>& rows) const {
+    detail::Stopwatch watch;
+    uint64_t seen = 0;
+    auto handler = [this, &rows, &seen](size_t row_base) {
+        ++seen;
+        TrackRowView row;
+        if (parse_track_row(row_base, row)) {
+            rows.push_back(row);
+        }
+    };
+    const uint32_t* page = first;
+    for (; page != last; ++page) {
+        if (!scan_page(*page, handler)) break;
+    }
+    record_table(table_name(PageType::Tracks), static_cast<uint64_t>(page - first), seen, watch.elapsed_ns());
+}
+
+void DatabaseImpl::add_track(const TrackRowView& row) {
+    // Add to secondary indices
+    if (!row.title.empty()) {
+        track_title_index.insert(row.title, row.id);
+    }
+    if (!row.filename.empty()) {
+        track_filename_index.insert(row.filename, row.id);
+    }
+    if (row.artist_id.value > 0) {
+        track_artist_index.insert(row.artist_id, row.id);
+    }
+    if (row.composer_id.value > 0) {
+        track_artist_index.insert(row.composer_id, row.id);
+    }
+    if (row.original_artist_id.value > 0) {
+        track_artist_index.insert(row.original_artist_id, row.id);
+    }
+    if (row.remixer_id.value > 0) {
+        track_artist_index.insert(row.remixer_id, row.id);
+    }
+    if (row.album_id.value > 0) {
+        track_album_index.insert(row.album_id, row.id);
+    }
+    if (row.genre_id.value > 0) {
+        track_genre_index.insert(row.genre_id, row.id);
+    }
+    if (row.key_id.value > 0) {
+        track_key_index.insert(row.key_id, row.id);
+    }
+    track_bpm_index.insert(row.bpm_100x, row.id);
+    track_duration_index.insert(row.duration_seconds, row.id);
+    track_year_index.insert(row.year, row.id);
+    track_rating_index.insert(row.rating, row.id);
+
+    track_index.insert(row.id, row);
+}
+
+void DatabaseImpl::finish_track_indices() {
+    detail::Stopwatch watch;
+    track_index.freeze();
+    track_title_index.freeze();
+    track_filename_index.freeze();
+    track_artist_index.freeze();
+    track_album_index.freeze();
+    track_genre_index.freeze();
+    track_key_index.freeze();
+    track_bpm_index.freeze();
+    track_duration_index.freeze();
+    track_year_index.freeze();
+    track_rating_index.freeze();
+
+    build_track_columns();
+    record_table(table_name(PageType::Tracks), 0, 0, watch.elapsed_ns());  // Index building counts as parsing
+
     LOG_INFO("Indexed " + std::to_string(track_index.size()) + " tracks");
 }
 
-void DatabaseImpl::index_artists() {
-    scan_table(PageType::Artists, [this](size_t row_base) {
-        auto data = pdb_.data_at(row_base, sizeof(RawArtistRow));
-        if (data.second < sizeof(RawArtistRow)) return;
-
-        const auto* raw = reinterpret_cast<const RawArtistRow*>(data.first);
-
-        ArtistRow row;
-        row.id = ArtistId{static_cast<int64_t>(raw->id)};
-
-        // Determine name offset (near or far)
-        uint16_t name_offset = raw->ofs_name_near;
-        if ((raw->subtype & 0x04) == 0x04) {
-            auto far_data = pdb_.data_at(row_base + 0x0a, 2);
-            if (far_data.second >= 2) {
-                name_offset = static_cast<uint16_t>(far_data.first[0]) |
-                              (static_cast<uint16_t>(far_data.first[1]) << 8);
-            }
+const DatabaseImpl::TrackTextIndex& DatabaseImpl::track_text_index() const {
+    std::call_once(track_text_once_, [this] {
+        for (const auto& [id, track] : track_index) {
+            const auto* artist = artist_index.get(track.artist_id);
+            const auto* album = album_index.get(track.album_id);
+            track_text_index_.insert(id, {
+                track.title,
+                artist ? artist->name : std::string_view{},
+                album ? album->name : std::string_view{},
+                track.filename,
+                track.file_path,
+            });
         }
+        track_text_index_.freeze();
+        LOG_DEBUG("Built text search index over " + std::to_string(track_text_index_.size()) + " tracks");
+    });
+    return track_text_index_;
+}
 
-        row.name = read_string_at_row(row_base, name_offset);
+const PlaylistTree& DatabaseImpl::playlist_tree() const {
+    std::call_once(playlist_tree_once_, [this] {
+        auto& tree = playlist_tree_;
+        auto add_children = [&](PlaylistId folder, uint32_t parent, uint32_t depth) {
+            auto it = playlist_folder_index.find(folder);
+            if (it == playlist_folder_index.end()) return;
+            for (const auto& entry : it->second) {
+                if (entry.id.value == 0) continue;  // Gap in the sort order
+                auto playlist = playlist_index.find(entry.id);
+                tree.id.push_back(entry.id.value);
+                tree.parent.push_back(parent);
+                tree.first_child.push_back(0);
+                tree.child_count.push_back(0);
+                tree.depth.push_back(depth);
+                tree.is_folder.push_back(entry.is_folder ? 1 : 0);
+                tree.track_count.push_back(entry.is_folder || playlist == playlist_index.end()
+                                               ? 0 : static_cast<uint32_t>(playlist->second.size()));
+                tree.name.push_back(entry.name);
+            }
+        };
+
+        // Breadth-first, so each folder's children are appended as one run
+        std::set<int64_t> expanded{0};
+        add_children(PlaylistId{0}, PlaylistTree::kNoParent, 0);
+        tree.root_count = static_cast<uint32_t>(tree.size());
+        for (uint32_t node = 0; node < tree.size(); ++node) {
+            // A folder listed twice (or a cycle) is expanded only at its first position
+            if (!tree.is_folder[node] || !expanded.insert(tree.id[node]).second) continue;
+            tree.first_child[node] = static_cast<uint32_t>(tree.size());
+            add_children(PlaylistId{tree.id[node]}, node, tree.depth[node] + 1);
+            tree.child_count[node] = static_cast<uint32_t>(tree.size()) - tree.first_child[node];
+        }
 
-        artist_index[row.id] = row;
+        tree.by_id.resize(tree.size());
+        for (uint32_t node = 0; node < tree.size(); ++node) tree.by_id[node] = node;
+        std::stable_sort(tree.by_id.begin(), tree.by_id.end(),
+                         [&tree](uint32_t a, uint32_t b) { return tree.id[a] < tree.id[b]; });
+        LOG_DEBUG("Flattened playlist tree: " + std::to_string(tree.size()) + " nodes");
+    });
+    return playlist_tree_;
+}
 
-        if (!row.name.empty()) {
-            artist_name_index[row.name].insert(row.id);
+const DatabaseImpl::TagBitmaps& DatabaseImpl::tag_bitmaps() const {
+    std::call_once(tag_bitmaps_once_, [this] {
+        const auto& keys = tag_track_index.keys();
+        tag_bitmaps_.by_tag.reserve(keys.size());
+        for (size_t i = 0; i < keys.size(); ++i) {
+            PostingList<TrackId> tracks = tag_track_index.postings_at(i);
+            tag_bitmaps_.by_tag.push_back(TrackBitmap::from_ids({tracks.begin(), tracks.size()}));
         }
+        tag_bitmaps_.tagged = TrackBitmap::from_ids(track_tag_index.keys());
+        LOG_DEBUG("Built track bitmaps for " + std::to_string(keys.size()) + " tags");
     });
+    return tag_bitmaps_;
+}
 
-    LOG_INFO("Indexed " + std::to_string(artist_index.size()) + " artists");
+const TrackBitmap& DatabaseImpl::track_bitmap() const {
+    std::call_once(track_bitmap_once_, [this] {
+        std::vector<TrackId> ids;
+        ids.reserve(track_index.size());
+        for (const auto& [id, _] : track_index) ids.push_back(id);
+        track_bitmap_ = TrackBitmap::from_ids(ids);
+    });
+    return track_bitmap_;
 }
 
-void DatabaseImpl::index_albums() {
-    scan_table(PageType::Albums, [this](size_t row_base) {
-        auto data = pdb_.data_at(row_base, sizeof(RawAlbumRow));
-        if (data.second < sizeof(RawAlbumRow)) return;
-
-        const auto* raw = reinterpret_cast<const RawAlbumRow*>(data.first);
-
-        AlbumRow row;
-        row.id = AlbumId{static_cast<int64_t>(raw->id)};
-        row.artist_id = ArtistId{static_cast<int64_t>(raw->artist_id)};
-
-        // Determine name offset
-        uint16_t name_offset = raw->ofs_name_near;
-        if ((raw->subtype & 0x04) == 0x04) {
-            auto far_data = pdb_.data_at(row_base + 0x16, 2);
-            if (far_data.second >= 2) {
-                name_offset = static_cast<uint16_t>(far_data.first[0]) |
-                              (static_cast<uint16_t>(far_data.first[1]) << 8);
-            }
+void DatabaseImpl::build_track_columns() {
+    auto& c = track_columns;
+    c = TrackColumns{};
+    size_t n = track_index.size();
+    c.track_id.reserve(n);
+    c.bpm_100x.reserve(n);
+    c.duration.reserve(n);
+    c.year.reserve(n);
+    c.rating.reserve(n);
+    c.bitrate.reserve(n);
+    c.sample_rate.reserve(n);
+    c.key_id.reserve(n);
+    c.genre_id.reserve(n);
+    c.artist_id.reserve(n);
+    c.play_count.reserve(n);
+
+    for (const auto& [id, track] : track_index) {
+        c.track_id.push_back(id.value);
+        c.bpm_100x.push_back(track.bpm_100x);
+        c.duration.push_back(track.duration_seconds);
+        c.year.push_back(track.year);
+        c.rating.push_back(track.rating);
+        c.bitrate.push_back(track.bitrate);
+        c.sample_rate.push_back(track.sample_rate);
+        c.key_id.push_back(track.key_id.value);
+        c.genre_id.push_back(track.genre_id.value);
+        c.artist_id.push_back(track.artist_id.value);
+        c.play_count.push_back(track.play_count);
+    }
+}
+
+void DatabaseImpl::index_artists() {
+    decode_table<PageType::Artists>([this](const ArtistRowView& row) {
+        if (!row.name.empty()) {
+            artist_name_index.insert(row.name, row.id);
         }
 
-        row.name = read_string_at_row(row_base, name_offset);
+        artist_index.insert(row.id, row);
+    });
 
-        album_index[row.id] = row;
+    artist_index.freeze();
+    artist_name_index.freeze();
 
+    LOG_INFO("Indexed " + std::to_string(artist_index.size()) + " artists");
+}
+
+void DatabaseImpl::index_albums() {
+    decode_table<PageType::Albums>([this](const AlbumRowView& row) {
         if (!row.name.empty()) {
-            album_name_index[row.name].insert(row.id);
+            album_name_index.insert(row.name, row.id);
         }
         if (row.artist_id.value > 0) {
-            album_artist_index[row.artist_id].insert(row.id);
+            album_artist_index.insert(row.artist_id, row.id);
         }
+
+        album_index.insert(row.id, row);
     });
 
+    album_index.freeze();
+    album_name_index.freeze();
+    album_artist_index.freeze();
+
     LOG_INFO("Indexed " + std::to_string(album_index.size()) + " albums");
 }
 
 void DatabaseImpl::index_genres() {
-    scan_table(PageType::Genres, [this](size_t row_base) {
-        auto data = pdb_.data_at(row_base, sizeof(RawGenreRow));
-        if (data.second < sizeof(RawGenreRow)) return;
-
-        const auto* raw = reinterpret_cast<const RawGenreRow*>(data.first);
-
-        GenreRow row;
-        row.id = GenreId{static_cast<int64_t>(raw->id)};
-        row.name = pdb_.read_string(row_base + sizeof(RawGenreRow));
-
-        genre_index[row.id] = row;
-
+    decode_table<PageType::Genres>([this](const GenreRowView& row) {
         if (!row.name.empty()) {
-            genre_name_index[row.name].insert(row.id);
+            genre_name_index.insert(row.name, row.id);
         }
+
+        genre_index.insert(row.id, row);
     });
 
+    genre_index.freeze();
+    genre_name_index.freeze();
+
     LOG_INFO("Indexed " + std::to_string(genre_index.size()) + " genres");
 }
 
 void DatabaseImpl::index_labels() {
-    scan_table(PageType::Labels, [this](size_t row_base) {
-        auto data = pdb_.data_at(row_base, sizeof(RawLabelRow));
-        if (data.second < sizeof(RawLabelRow)) return;
-
-        const auto* raw = reinterpret_cast<const RawLabelRow*>(data.first);
-
-        LabelRow row;
-        row.id = LabelId{static_cast<int64_t>(raw->id)};
-        row.name = pdb_.read_string(row_base + sizeof(RawLabelRow));
-
-        label_index[row.id] = row;
-
+    decode_table<PageType::Labels>([this](const LabelRowView& row) {
         if (!row.name.empty()) {
-            label_name_index[row.name].insert(row.id);
+            label_name_index.insert(row.name, row.id);
         }
+
+        label_index.insert(row.id, row);
     });
 
+    label_index.freeze();
+    label_name_index.freeze();
+
     LOG_INFO("Indexed " + std::to_string(label_index.size()) + " labels");
 }
 
 void DatabaseImpl::index_colors() {
-    scan_table(PageType::Colors, [this](size_t row_base) {
-        auto data = pdb_.data_at(row_base, sizeof(RawColorRow));
-        if (data.second < sizeof(RawColorRow)) return;
-
-        const auto* raw = reinterpret_cast<const RawColorRow*>(data.first);
-
-        ColorRow row;
-        row.id = ColorId{static_cast<int64_t>(raw->id)};
-        row.name = pdb_.read_string(row_base + sizeof(RawColorRow));
-
-        color_index[row.id] = row;
-
+    decode_table<PageType::Colors>([this](const ColorRowView& row) {
         if (!row.name.empty()) {
-            color_name_index[row.name].insert(row.id);
+            color_name_index.insert(row.name, row.id);
         }
+
+        color_index.insert(row.id, row);
     });
 
+    color_index.freeze();
+    color_name_index.freeze();
+
     LOG_INFO("Indexed " + std::to_string(color_index.size()) + " colors");
 }
 
 void DatabaseImpl::index_keys() {
-    scan_table(PageType::Keys, [this](size_t row_base) {
-        auto data = pdb_.data_at(row_base, sizeof(RawKeyRow));
-        if (data.second < sizeof(RawKeyRow)) return;
-
-        const auto* raw = reinterpret_cast<const RawKeyRow*>(data.first);
-
-        KeyRow row;
-        row.id = KeyId{static_cast<int64_t>(raw->id)};
-        row.name = pdb_.read_string(row_base + sizeof(RawKeyRow));
-
-        key_index[row.id] = row;
-
+    decode_table<PageType::Keys>([this](const KeyRowView& row) {
         if (!row.name.empty()) {
-            key_name_index[row.name].insert(row.id);
+            key_name_index.insert(row.name, row.id);
         }
+
+        key_index.insert(row.id, row);
     });
 
+    key_index.freeze();
+    key_name_index.freeze();
+
     LOG_INFO("Indexed " + std::to_string(key_index.size()) + " musical keys");
 }
 
 void DatabaseImpl::index_artwork() {
-    scan_table(PageType::Artwork, [this](size_t row_base) {
-        auto data = pdb_.data_at(row_base, sizeof(RawArtworkRow));
-        if (data.second < sizeof(RawArtworkRow)) return;
-
-        const auto* raw = reinterpret_cast<const RawArtworkRow*>(data.first);
-
-        ArtworkRow row;
-        row.id = ArtworkId{static_cast<int64_t>(raw->id)};
-        row.path = pdb_.read_string(row_base + sizeof(RawArtworkRow));
-
-        artwork_index[row.id] = row;
+    decode_table<PageType::Artwork>([this](const ArtworkRowView& row) {
+        artwork_index.insert(row.id, row);
     });
 
+    artwork_index.freeze();
+
     LOG_INFO("Indexed " + std::to_string(artwork_index.size()) + " artwork paths");
 }
 
 void DatabaseImpl::index_playlists() {
-    scan_table(PageType::PlaylistEntries, [this](size_t row_base) {
-        auto data = pdb_.data_at(row_base, sizeof(RawPlaylistEntryRow));
-        if (data.second < sizeof(RawPlaylistEntryRow)) return;
-
-        const auto* raw = reinterpret_cast<const RawPlaylistEntryRow*>(data.first);
-
-        PlaylistId playlist_id{static_cast<int64_t>(raw->playlist_id)};
-        TrackId track_id{static_cast<int64_t>(raw->track_id)};
-        uint32_t entry_index = raw->entry_index;
-
-        auto& playlist = playlist_index[playlist_id];
-        if (playlist.size() <= entry_index) {
-            playlist.resize(entry_index + 1);
-        }
-        playlist[entry_index] = track_id;
+    std::vector<PlacedRow<PlaylistId, TrackId>> entries;
+    decode_table<PageType::PlaylistEntries>([&entries](const detail::PlaylistEntryFields& row) {
+        entries.push_back({row.playlist_id, row.entry_index, row.track_id});
     });
+    if (size_t compacted = place_rows(playlist_index, entries)) {
+        LOG_WARN("Compacted " + std::to_string(compacted) + " playlists with corrupt entry positions");
+    }
 
     LOG_INFO("Indexed " + std::to_string(playlist_index.size()) + " playlists");
 }
 
 void DatabaseImpl::index_playlist_folders() {
-    scan_table(PageType::PlaylistTree, [this](size_t row_base) {
-        auto data = pdb_.data_at(row_base, sizeof(RawPlaylistTreeRow));
-        if (data.second < sizeof(RawPlaylistTreeRow)) return;
-
-        const auto* raw = reinterpret_cast<const RawPlaylistTreeRow*>(data.first);
-
+    std::vector<PlacedRow<PlaylistId, PlaylistFolderEntry>> entries;
+    decode_table<PageType::PlaylistTree>([&entries](detail::PlaylistNodeFields& row) {
         PlaylistFolderEntry entry;
-        entry.id = PlaylistId{static_cast<int64_t>(raw->id)};
-        entry.is_folder = raw->raw_is_folder != 0;
-        entry.name = pdb_.read_string(row_base + sizeof(RawPlaylistTreeRow));
-
-        PlaylistId parent_id{static_cast<int64_t>(raw->parent_id)};
-        uint32_t sort_order = raw->sort_order;
-
-        auto& folder = playlist_folder_index[parent_id];
-        if (folder.size() <= sort_order) {
-            folder.resize(sort_order + 1);
-        }
-        folder[sort_order] = entry;
+        entry.id = row.id;
+        entry.is_folder = row.is_folder;
+        entry.name = std::move(row.name);
+        entries.push_back({row.parent_id, row.sort_order, std::move(entry)});
     });
+    if (size_t compacted = place_rows(playlist_folder_index, entries)) {
+        LOG_WARN("Compacted " + std::to_string(compacted) + " playlist folders with corrupt sort orders");
+    }
 
     LOG_INFO("Indexed " + std::to_string(playlist_folder_index.size()) + " playlist folders");
 }
 
 void DatabaseImpl::index_history_playlists() {
-    scan_table(PageType::HistoryPlaylists, [this](size_t row_base) {
-        auto data = pdb_.data_at(row_base, sizeof(RawHistoryPlaylistRow));
-        if (data.second < sizeof(RawHistoryPlaylistRow)) return;
-
-        const auto* raw = reinterpret_cast<const RawHistoryPlaylistRow*>(data.first);
-
-        PlaylistId id{static_cast<int64_t>(raw->id)};
-        std::string name = pdb_.read_string(row_base + sizeof(RawHistoryPlaylistRow));
-
-        history_playlist_name_index[name] = id;
+    decode_table<PageType::HistoryPlaylists>([this](const detail::HistoryPlaylistFields& row) {
+        history_playlist_name_index[row.name] = row.id;
     });
 
     LOG_INFO("Indexed " + std::to_string(history_playlist_name_index.size()) + " history playlist names");
 }
 
 void DatabaseImpl::index_history_entries() {
-    scan_table(PageType::HistoryEntries, [this](size_t row_base) {
-        auto data = pdb_.data_at(row_base, sizeof(RawHistoryEntryRow));
-        if (data.second < sizeof(RawHistoryEntryRow)) return;
-
-        const auto* raw = reinterpret_cast<const RawHistoryEntryRow*>(data.first);
-
-        PlaylistId playlist_id{static_cast<int64_t>(raw->playlist_id)};
-        TrackId track_id{static_cast<int64_t>(raw->track_id)};
-        uint32_t entry_index = raw->entry_index;
-
-        auto& playlist = history_playlist_index[playlist_id];
-        if (playlist.size() <= entry_index) {
-            playlist.resize(entry_index + 1);
-        }
-        playlist[entry_index] = track_id;
+    std::vector<PlacedRow<PlaylistId, TrackId>> entries;
+    decode_table<PageType::HistoryEntries>([&entries](const detail::PlaylistEntryFields& row) {
+        entries.push_back({row.playlist_id, row.entry_index, row.track_id});
     });
+    if (size_t compacted = place_rows(history_playlist_index, entries)) {
+        LOG_WARN("Compacted " + std::to_string(compacted) + " history playlists with corrupt entry positions");
+    }
 
     LOG_INFO("Indexed " + std::to_string(history_playlist_index.size()) + " history playlists");
 }
@@ -479,43 +749,19 @@ void DatabaseImpl::index_tags() {
     std::vector<std::pair<uint32_t, TagId>> category_positions;  // (pos, id)
     std::map<TagId, std::vector<std::pair<uint32_t, TagId>>> tag_positions;  // category -> [(pos, tag)]
 
-    scan_table_ext(pdb_, PageTypeExt::Tags, [this, &category_positions, &tag_positions](size_t row_base) {
-        auto data = pdb_.data_at(row_base, sizeof(RawTagRow));
-        if (data.second < sizeof(RawTagRow)) return;
-
-        const auto* raw = reinterpret_cast<const RawTagRow*>(data.first);
-
-        TagRow row;
-        row.id = TagId{static_cast<int64_t>(raw->id)};
-        row.category_id = TagId{static_cast<int64_t>(raw->category)};
-        row.category_pos = raw->category_pos;
-        row.is_category = raw->raw_is_category != 0;
-
-        // Read name string using offset
-        // Name is at row_base + ofs_name_near for near offsets, or further for far
-        size_t name_offset = row_base + raw->ofs_name_near;
-        if (raw->subtype == 0x0684) {
-            // Long name offset - read additional offset
-            auto far_offset_data = pdb_.data_at(row_base + raw->ofs_name_near, 4);
-            if (far_offset_data.second >= 4) {
-                uint32_t far_offset = *reinterpret_cast<const uint32_t*>(far_offset_data.first);
-                name_offset = row_base + far_offset;
-            }
-        }
-        row.name = pdb_.read_string(name_offset);
-
+    decode_table<PageTypeExt::Tags>([this, &category_positions, &tag_positions](const TagRow& row) {
         if (row.is_category) {
             // This is a category
-            category_index[row.id] = row;
+            category_index.insert(row.id, row);
             if (!row.name.empty()) {
-                category_name_index[row.name].insert(row.id);
+                category_name_index.insert(row.name, row.id);
             }
             category_positions.emplace_back(row.category_pos, row.id);
         } else {
             // This is a tag
-            tag_index[row.id] = row;
+            tag_index.insert(row.id, row);
             if (!row.name.empty()) {
-                tag_name_index[row.name].insert(row.id);
+                tag_name_index.insert(row.name, row.id);
             }
             // Group by category for ordering
             tag_positions[row.category_id].emplace_back(row.category_pos, row.id);
@@ -536,24 +782,294 @@ void DatabaseImpl::index_tags() {
         }
     }
 
+    tag_index.freeze();
+    tag_name_index.freeze();
+    category_index.freeze();
+    category_name_index.freeze();
+
     LOG_INFO("Indexed " + std::to_string(tag_index.size()) + " tags, " + std::to_string(category_index.size()) + " categories");
 }
 
 void DatabaseImpl::index_tag_tracks() {
-    scan_table_ext(pdb_, PageTypeExt::TagTracks, [this](size_t row_base) {
-        auto data = pdb_.data_at(row_base, sizeof(RawTagTrackRow));
-        if (data.second < sizeof(RawTagTrackRow)) return;
+    decode_table<PageTypeExt::TagTracks>([this](const detail::TagTrackFields& row) {
+        tag_track_index.insert(row.tag_id, row.track_id);
+        track_tag_index.insert(row.track_id, row.tag_id);
+    });
 
-        const auto* raw = reinterpret_cast<const RawTagTrackRow*>(data.first);
+    tag_track_index.freeze();
+    track_tag_index.freeze();
 
-        TagId tag_id{static_cast<int64_t>(raw->tag_id)};
-        TrackId track_id{static_cast<int64_t>(raw->track_id)};
+    LOG_INFO("Indexed tag-track associations");
+}
+
+// ============================================================================
+// Incremental Refresh
+// ============================================================================
 
-        tag_track_index[tag_id].insert(track_id);
-        track_tag_index[track_id].insert(tag_id);
+namespace {
+
+/// Page header bytes up to and including free_size and used_size
+constexpr size_t kPageHeaderCompareSize = 28;
+
+/**
+ * @brief Check whether a page has the same bytes in two files
+ *
+ * A rewritten page nearly always differs in its header (page index, next
+ * page, row counts, free/used size) or in the present flags of its first
+ * row group, so those few bytes are compared first. The full compare then
+ * catches rows edited in place without any size changing.
+ */
+bool same_page(const RekordboxPdb& a, const RekordboxPdb& b, uint32_t page_index) {
+    uint32_t page_size = a.page_size();
+    if (page_size != b.page_size() || page_size < kPageHeaderCompareSize + 4) return false;
+
+    size_t offset = static_cast<size_t>(page_index) * page_size;
+    auto x = a.data_at(offset, page_size);
+    auto y = b.data_at(offset, page_size);
+    if (x.second < page_size || y.second < page_size) return false;
+
+    return std::memcmp(x.first, y.first, kPageHeaderCompareSize) == 0 &&
+           std::memcmp(x.first + page_size - 4, y.first + page_size - 4, 4) == 0 &&
+           std::memcmp(x.first, y.first, page_size) == 0;
+}
+
+/// Check whether a table has the same page chain with identical pages in both files
+template<typename Type>
+bool same_table(const RekordboxPdb& previous, const RekordboxPdb& current, Type type) {
+    const PdbTable* before = find_table(previous, type);
+    const PdbTable* after = find_table(current, type);
+    if (before == nullptr || after == nullptr) return before == after;
+
+    std::vector<uint32_t> pages;
+    std::vector<uint32_t> previous_pages;
+    walk_page_chain(current, *after, [&pages](uint32_t page, PageRowCursor&) { pages.push_back(page); });
+    walk_page_chain(previous, *before, [&previous_pages](uint32_t page, PageRowCursor&) {
+        previous_pages.push_back(page);
     });
+    if (pages != previous_pages) return false;
 
-    LOG_INFO("Indexed tag-track associations");
+    for (uint32_t page : pages) {
+        if (!same_page(previous, current, page)) return false;
+    }
+    return true;
+}
+
+/// Copy a primary index of row views, moving each string to the new backing
+template<typename IdType, typename Row, typename Rebase>
+void copy_rows(const FlatPrimaryIndex<IdType, Row>& from, FlatPrimaryIndex<IdType, Row>& to, Rebase rebase) {
+    auto entries = from.entries();
+    for (auto& entry : entries) {
+        visit_strings(entry.second, [&rebase](std::string_view& s) { s = rebase(s); });
+    }
+    to.assign(std::move(entries));
+}
+
+} // anonymous namespace
+
+std::string_view DatabaseImpl::rebase_string(std::string_view s, const DatabaseImpl& previous) const {
+    if (s.empty()) return s;
+
+    // Strings on an identical page sit at the same offset in the new file
+    auto before = previous.pdb_.data_at(0, previous.pdb_.file_size());
+    const auto* bytes = reinterpret_cast<const uint8_t*>(s.data());
+    if (bytes >= before.first && bytes + s.size() <= before.first + before.second) {
+        auto after = pdb_.data_at(static_cast<size_t>(bytes - before.first), s.size());
+        return std::string_view(reinterpret_cast<const char*>(after.first), s.size());
+    }
+
+    // Decoded UTF-16 lives in the previous pool (or its snapshot): copy it over
+    return strings_->intern(s);
+}
+
+void DatabaseImpl::refresh_indices(const DatabaseImpl& previous, RefreshStats& stats) {
+    if (pdb_.is_mapped() || previous.pdb_.is_mapped() || pdb_.is_ext() != previous.pdb_.is_ext()) {
+        // A mapping shows the new bytes through the old file too, so nothing can be compared
+        build_indices();
+        stats.tracks_reparsed = track_index.size();
+        if (!pdb_.is_ext()) stats.pages_changed = table_pages(PageType::Tracks).size();
+        stats.tables_reindexed = pdb_.tables().size();
+        store_snapshot();
+        return;
+    }
+
+    auto rebase = [this, &previous](std::string_view s) { return rebase_string(s, previous); };
+    auto refresh_table = [&](auto type, auto copy, auto rebuild) {
+        if (same_table(previous.pdb_, pdb_, type)) {
+            copy();
+        } else {
+            rebuild();
+            ++stats.tables_reindexed;
+        }
+    };
+
+    if (pdb_.is_ext()) {
+        refresh_table(PageTypeExt::Tags, [&] {
+            tag_index = previous.tag_index;
+            tag_name_index = previous.tag_name_index;
+            category_index = previous.category_index;
+            category_name_index = previous.category_name_index;
+            category_order = previous.category_order;
+            category_tags = previous.category_tags;
+        }, [&] { index_tags(); });
+        refresh_table(PageTypeExt::TagTracks, [&] {
+            tag_track_index = previous.tag_track_index;
+            track_tag_index = previous.track_tag_index;
+        }, [&] { index_tag_tracks(); });
+    } else {
+        refresh_tracks(previous, stats);
+        refresh_table(PageType::Artists, [&] {
+            copy_rows(previous.artist_index, artist_index, rebase);
+            artist_name_index = previous.artist_name_index;
+        }, [&] { index_artists(); });
+        refresh_table(PageType::Albums, [&] {
+            copy_rows(previous.album_index, album_index, rebase);
+            album_name_index = previous.album_name_index;
+            album_artist_index = previous.album_artist_index;
+        }, [&] { index_albums(); });
+        refresh_table(PageType::Genres, [&] {
+            copy_rows(previous.genre_index, genre_index, rebase);
+            genre_name_index = previous.genre_name_index;
+        }, [&] { index_genres(); });
+        refresh_table(PageType::Labels, [&] {
+            copy_rows(previous.label_index, label_index, rebase);
+            label_name_index = previous.label_name_index;
+        }, [&] { index_labels(); });
+        refresh_table(PageType::Colors, [&] {
+            copy_rows(previous.color_index, color_index, rebase);
+            color_name_index = previous.color_name_index;
+        }, [&] { index_colors(); });
+        refresh_table(PageType::Keys, [&] {
+            copy_rows(previous.key_index, key_index, rebase);
+            key_name_index = previous.key_name_index;
+        }, [&] { index_keys(); });
+        refresh_table(PageType::Artwork, [&] {
+            copy_rows(previous.artwork_index, artwork_index, rebase);
+        }, [&] { index_artwork(); });
+        refresh_table(PageType::PlaylistEntries, [&] {
+            playlist_index = previous.playlist_index;
+        }, [&] { index_playlists(); });
+        refresh_table(PageType::PlaylistTree, [&] {
+            playlist_folder_index = previous.playlist_folder_index;
+        }, [&] { index_playlist_folders(); });
+        refresh_table(PageType::HistoryPlaylists, [&] {
+            history_playlist_name_index = previous.history_playlist_name_index;
+        }, [&] { index_history_playlists(); });
+        refresh_table(PageType::HistoryEntries, [&] {
+            history_playlist_index = previous.history_playlist_index;
+        }, [&] { index_history_entries(); });
+    }
+
+    LOG_INFO("Refreshed " + source_file_.string() + ": " + std::to_string(stats.pages_changed) +
+             " track pages changed, " + std::to_string(stats.tables_reindexed) + " other tables rebuilt");
+    store_snapshot();
+}
+
+void DatabaseImpl::refresh_tracks(const DatabaseImpl& previous, RefreshStats& stats) {
+    std::vector<uint32_t> pages = table_pages(PageType::Tracks);
+    std::vector<bool> in_chain;   // Indexed by page index
+    std::vector<bool> unchanged;  // In both chains with identical bytes
+    for (uint32_t page : pages) {
+        if (page >= in_chain.size()) in_chain.resize(static_cast<size_t>(page) + 1, false);
+        in_chain[page] = true;
+    }
+    unchanged.resize(in_chain.size(), false);
+
+    // Rows of every previous page that did not survive intact leave the indices
+    std::vector<TrackId> dropped;
+    auto drop_row = [&](size_t row_base) {
+        using Format = detail::RowFormat<PageType::Tracks>;
+        auto bytes = detail::row_bytes(previous.pdb_, row_base);
+        if (bytes.size < Format::Decoder::kSize) return;
+        RowStrings strings{previous};
+        TrackRowView row;
+        Format::Id::decode(bytes, row, strings);
+        dropped.push_back(row.id);
+    };
+    for (uint32_t page : previous.table_pages(PageType::Tracks)) {
+        if (page < in_chain.size() && in_chain[page] && same_page(previous.pdb_, pdb_, page)) {
+            unchanged[page] = true;
+        } else {
+            previous.scan_page(page, drop_row);
+        }
+    }
+    std::sort(dropped.begin(), dropped.end());
+    dropped.erase(std::unique(dropped.begin(), dropped.end()), dropped.end());
+
+    // Only rows on changed or new pages are parsed
+    std::vector<TrackRowView> rows;
+    auto parse_row = [&](size_t row_base) {
+        TrackRowView row;
+        if (parse_track_row(row_base, row)) rows.push_back(row);
+    };
+    for (uint32_t page : pages) {
+        if (unchanged[page]) continue;
+        ++stats.pages_changed;
+        if (!scan_page(page, parse_row)) break;
+    }
+
+    for (const auto& row : rows) {
+        if (previous.track_index.get(row.id) != nullptr &&
+            !std::binary_search(dropped.begin(), dropped.end(), row.id)) {
+            // The ID is also on an unchanged page; only chain order says which row wins
+            index_tracks();
+            stats.tracks_reparsed = track_index.size();
+            return;
+        }
+    }
+
+    for (const auto& row : rows) add_track(row);
+    auto rebase_row = [this, &previous](const TrackRowView& old) {
+        TrackRowView row = old;
+        visit_strings(row, [&](std::string_view& s) { s = rebase_string(s, previous); });
+        return row;
+    };
+    track_index.freeze_over(previous.track_index, dropped, rebase_row);
+    track_title_index.freeze_over(previous.track_title_index, dropped);
+    track_filename_index.freeze_over(previous.track_filename_index, dropped);
+    track_artist_index.freeze_over(previous.track_artist_index, dropped);
+    track_album_index.freeze_over(previous.track_album_index, dropped);
+    track_genre_index.freeze_over(previous.track_genre_index, dropped);
+    track_key_index.freeze_over(previous.track_key_index, dropped);
+    track_bpm_index.freeze_over(previous.track_bpm_index, dropped);
+    track_duration_index.freeze_over(previous.track_duration_index, dropped);
+    track_year_index.freeze_over(previous.track_year_index, dropped);
+    track_rating_index.freeze_over(previous.track_rating_index, dropped);
+    build_track_columns();
+
+    std::vector<TrackId> parsed;
+    parsed.reserve(rows.size());
+    for (const auto& row : rows) parsed.push_back(row.id);
+    std::sort(parsed.begin(), parsed.end());
+    parsed.erase(std::unique(parsed.begin(), parsed.end()), parsed.end());
+    stats.tracks_reparsed = parsed.size();
+    stats.tracks_reused = track_index.size() - parsed.size();
+
+    LOG_INFO("Indexed " + std::to_string(track_index.size()) + " tracks (" +
+             std::to_string(parsed.size()) + " reparsed)");
+}
+
+// ============================================================================
+// Published Generation
+// ============================================================================
+
+const TrackAnalysis* DatabaseGeneration::loaded_analysis(TrackId id) const {
+    const auto& tracks = index->track_index;
+    std::call_once(analysis_once_, [&] {
+        // Resolve every track's file_path once, not on each access
+        analysis_by_track_.assign(tracks.size(), nullptr);
+        size_t position = 0;
+        for (const auto& entry : tracks) {
+            const auto& track = entry.second;
+            if (!track.file_path.empty()) {
+                analysis_by_track_[position] = anlz->get_analysis(track.file_path);
+            }
+            ++position;
+        }
+    });
+
+    auto it = tracks.find(id);
+    if (it == tracks.end()) return nullptr;
+    return analysis_by_track_[static_cast<size_t>(it - tracks.begin())];
 }
 
 } // namespace cratedigger
@@ -0,0 +1,207 @@
+#include "cratedigger/file_buffer.hpp"
+#include "cratedigger/logging.hpp"
+#include <fstream>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace cratedigger {
+
+namespace {
+
+/// Read the whole file into a vector
+Result<std::vector<uint8_t>> read_whole_file(const std::filesystem::path& path) {
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file) {
+        return make_error(
+            ErrorCode::FileNotFound,
+            "Cannot open file: " + path.string()
+        );
+    }
+
+    auto file_size = file.tellg();
+    if (file_size < 0) {
+        return make_error(
+            ErrorCode::IoError,
+            "Cannot determine file size: " + path.string()
+        );
+    }
+
+    std::vector<uint8_t> bytes(static_cast<size_t>(file_size));
+    file.seekg(0);
+    file.read(reinterpret_cast<char*>(bytes.data()), file_size);
+
+    if (!file) {
+        return make_error(
+            ErrorCode::IoError,
+            "Failed to read file contents: " + path.string()
+        );
+    }
+    return bytes;
+}
+
+#ifdef _WIN32
+
+/// Map a file read-only (Windows file mapping)
+Result<std::pair<const uint8_t*, size_t>> map_file(const std::filesystem::path& path) {
+    HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ,
+                              nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return make_error(ErrorCode::FileNotFound, "Cannot open file: " + path.string());
+    }
+
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(file, &file_size)) {
+        CloseHandle(file);
+        return make_error(ErrorCode::IoError, "Cannot determine file size: " + path.string());
+    }
+    if (file_size.QuadPart == 0) {
+        CloseHandle(file);
+        return std::pair<const uint8_t*, size_t>{nullptr, 0};
+    }
+
+    HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(file);
+    if (mapping == nullptr) {
+        return make_error(ErrorCode::IoError, "Cannot create file mapping: " + path.string());
+    }
+
+    // The view keeps the mapping object alive after its handle is closed
+    void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping);
+    if (view == nullptr) {
+        return make_error(ErrorCode::IoError, "Cannot map file: " + path.string());
+    }
+
+    return std::pair<const uint8_t*, size_t>{
+        static_cast<const uint8_t*>(view), static_cast<size_t>(file_size.QuadPart)};
+}
+
+void unmap_file(const uint8_t* data, size_t /*size*/) {
+    UnmapViewOfFile(data);
+}
+
+#else
+
+/// Map a file read-only (POSIX mmap)
+Result<std::pair<const uint8_t*, size_t>> map_file(const std::filesystem::path& path) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return make_error(ErrorCode::FileNotFound, "Cannot open file: " + path.string());
+    }
+
+    struct stat st {};
+    if (::fstat(fd, &st) != 0) {
+        ::close(fd);
+        return make_error(ErrorCode::IoError, "Cannot determine file size: " + path.string());
+    }
+    if (st.st_size == 0) {
+        ::close(fd);
+        return std::pair<const uint8_t*, size_t>{nullptr, 0};
+    }
+
+    auto size = static_cast<size_t>(st.st_size);
+    void* addr = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    // The mapping stays valid after the descriptor is closed
+    ::close(fd);
+    if (addr == MAP_FAILED) {
+        return make_error(ErrorCode::IoError, "Cannot map file: " + path.string());
+    }
+
+    return std::pair<const uint8_t*, size_t>{static_cast<const uint8_t*>(addr), size};
+}
+
+void unmap_file(const uint8_t* data, size_t size) {
+    ::munmap(const_cast<uint8_t*>(data), size);
+}
+
+#endif
+
+} // anonymous namespace
+
+// ============================================================================
+// FileBuffer Implementation
+// ============================================================================
+
+Result<FileBuffer> FileBuffer::open(const std::filesystem::path& path, IoMode mode) {
+    FileBuffer buffer;
+
+    if (mode == IoMode::MemoryMapped) {
+        auto mapped = map_file(path);
+        if (!mapped) {
+            return mapped.error();
+        }
+        buffer.data_ = mapped->first;
+        buffer.size_ = mapped->second;
+        buffer.mapped_ = buffer.data_ != nullptr;
+        return buffer;
+    }
+
+    auto bytes = read_whole_file(path);
+    if (!bytes) {
+        return bytes.error();
+    }
+    return from_bytes(std::move(*bytes));
+}
+
+FileBuffer FileBuffer::from_bytes(std::vector<uint8_t> bytes) {
+    FileBuffer buffer;
+    buffer.owned_ = std::move(bytes);
+    buffer.data_ = buffer.owned_.empty() ? nullptr : buffer.owned_.data();
+    buffer.size_ = buffer.owned_.size();
+    return buffer;
+}
+
+FileBuffer::FileBuffer(FileBuffer&& other) noexcept
+    : owned_(std::move(other.owned_))
+    , data_(other.data_)
+    , size_(other.size_)
+    , mapped_(other.mapped_)
+{
+    other.data_ = nullptr;
+    other.size_ = 0;
+    other.mapped_ = false;
+}
+
+FileBuffer& FileBuffer::operator=(FileBuffer&& other) noexcept {
+    if (this != &other) {
+        reset();
+        owned_ = std::move(other.owned_);
+        data_ = other.data_;
+        size_ = other.size_;
+        mapped_ = other.mapped_;
+        other.data_ = nullptr;
+        other.size_ = 0;
+        other.mapped_ = false;
+    }
+    return *this;
+}
+
+FileBuffer::~FileBuffer() {
+    reset();
+}
+
+void FileBuffer::reset() {
+    if (mapped_ && data_ != nullptr) {
+        unmap_file(data_, size_);
+    }
+    owned_.clear();
+    owned_.shrink_to_fit();
+    data_ = nullptr;
+    size_ = 0;
+    mapped_ = false;
+}
+
+} // namespace cratedigger
@@ -0,0 +1,518 @@
+#pragma once
+/**
+ * @file flat_index.hpp
+ * @brief Internal frozen index containers for DatabaseImpl
+ *
+ * The database is immutable once build_indices() returns, so indices are
+ * built by appending to contiguous staging arrays and then frozen into
+ * sorted arrays: binary search (or a dense slot table when IDs are compact)
+ * for primary lookups, and CSR-style offset + ID arrays for postings.
+ */
+
+#include "cratedigger/types.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cstddef>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace cratedigger {
+
+/// Contiguous, sorted, duplicate-free run of IDs from a frozen index
+template<typename IdType>
+struct PostingList {
+    const IdType* first{nullptr};
+    const IdType* last{nullptr};
+
+    [[nodiscard]] const IdType* begin() const { return first; }
+    [[nodiscard]] const IdType* end() const { return last; }
+    [[nodiscard]] size_t size() const { return static_cast<size_t>(last - first); }
+    [[nodiscard]] bool empty() const { return first == last; }
+
+    /// Copy out as a vector (the public API returns owned vectors)
+    [[nodiscard]] std::vector<IdType> to_vector() const { return std::vector<IdType>(first, last); }
+};
+
+/// Merge the sorted runs ids[start, middle) and ids[middle, end) into one sorted, duplicate-free run
+template<typename IdType>
+void merge_postings(std::vector<IdType>& ids, size_t start, size_t middle) {
+    if (middle == start || middle == ids.size()) return;
+    auto first = ids.begin() + static_cast<std::ptrdiff_t>(start);
+    std::inplace_merge(first, ids.begin() + static_cast<std::ptrdiff_t>(middle), ids.end());
+    ids.erase(std::unique(first, ids.end()), ids.end());
+}
+
+// ============================================================================
+// Primary Index (ID -> Row)
+// ============================================================================
+
+/**
+ * @brief Sorted (ID, row) array with an optional dense slot table
+ *
+ * insert() appends; freeze() sorts by ID and keeps the last row inserted for
+ * a duplicated ID (matching map assignment semantics). Iteration yields
+ * (id, row) pairs in ascending ID order.
+ */
+template<typename IdType, typename RowType>
+class FlatPrimaryIndex {
+public:
+    using value_type = std::pair<IdType, RowType>;
+    using const_iterator = typename std::vector<value_type>::const_iterator;
+
+    /// Stage a row (before freeze)
+    void insert(IdType id, RowType row) {
+        entries_.emplace_back(id, std::move(row));
+    }
+
+    /// Sort, drop superseded duplicates and build the slot table
+    void freeze() {
+        sort_staged();
+        entries_.shrink_to_fit();
+        build_slots();
+    }
+
+    /**
+     * @brief Freeze staged rows merged over a frozen index
+     *
+     * Rows of base whose ID is in dropped (sorted) are left out, the rest are
+     * copied through transform. A staged row replaces a base row with the same ID.
+     */
+    template<typename Transform>
+    void freeze_over(const FlatPrimaryIndex& base, const std::vector<IdType>& dropped, Transform transform) {
+        sort_staged();
+
+        std::vector<value_type> merged;
+        merged.reserve(base.entries_.size() + entries_.size());
+        auto staged = entries_.begin();
+        for (const auto& entry : base.entries_) {
+            while (staged != entries_.end() && staged->first < entry.first) merged.push_back(std::move(*staged++));
+            if (staged != entries_.end() && staged->first == entry.first) continue;
+            if (std::binary_search(dropped.begin(), dropped.end(), entry.first)) continue;
+            merged.emplace_back(entry.first, transform(entry.second));
+        }
+        for (; staged != entries_.end(); ++staged) merged.push_back(std::move(*staged));
+
+        entries_ = std::move(merged);
+        build_slots();
+    }
+
+    /// Find a row by ID (end() if missing)
+    [[nodiscard]] const_iterator find(IdType id) const {
+        if (!slots_.empty()) {
+            if (id.value < 0 || static_cast<size_t>(id.value) >= slots_.size()) return entries_.end();
+            uint32_t slot = slots_[static_cast<size_t>(id.value)];
+            return slot == 0 ? entries_.end() : entries_.begin() + (slot - 1);
+        }
+        auto it = std::lower_bound(entries_.begin(), entries_.end(), id,
+            [](const value_type& entry, IdType key) { return entry.first < key; });
+        return (it != entries_.end() && it->first == id) ? it : entries_.end();
+    }
+
+    /// Find a row by ID (nullptr if missing)
+    [[nodiscard]] const RowType* get(IdType id) const {
+        auto it = find(id);
+        return it == entries_.end() ? nullptr : &it->second;
+    }
+
+    [[nodiscard]] const_iterator begin() const { return entries_.begin(); }
+    [[nodiscard]] const_iterator end() const { return entries_.end(); }
+    [[nodiscard]] size_t size() const { return entries_.size(); }
+    [[nodiscard]] bool empty() const { return entries_.empty(); }
+
+    /// Frozen (id, row) pairs in ascending ID order
+    [[nodiscard]] const std::vector<value_type>& entries() const { return entries_; }
+
+    /// Replace the contents with frozen entries (e.g. from a snapshot) and refreeze
+    void assign(std::vector<value_type> entries) {
+        entries_ = std::move(entries);
+        freeze();
+    }
+
+    void clear() {
+        entries_.clear();
+        slots_.clear();
+    }
+
+private:
+    /// Sort staged rows by ID, keeping the last of each run of equal IDs
+    void sort_staged() {
+        auto by_id = [](const value_type& a, const value_type& b) { return a.first < b.first; };
+        if (!std::is_sorted(entries_.begin(), entries_.end(), by_id)) {
+            std::stable_sort(entries_.begin(), entries_.end(), by_id);
+        }
+
+        size_t out = 0;
+        for (size_t i = 0; i < entries_.size(); ++i) {
+            if (i + 1 < entries_.size() && entries_[i + 1].first == entries_[i].first) continue;
+            if (out != i) entries_[out] = std::move(entries_[i]);
+            ++out;
+        }
+        entries_.resize(out);
+    }
+
+    /// Dense lookup when IDs are compact (rekordbox IDs usually are)
+    void build_slots() {
+        slots_.clear();
+        if (!entries_.empty() && entries_.front().first.value >= 0) {
+            auto max_id = static_cast<size_t>(entries_.back().first.value);
+            if (max_id <= entries_.size() * 2 + 1024) {
+                slots_.assign(max_id + 1, 0);
+                for (size_t i = 0; i < entries_.size(); ++i) {
+                    slots_[static_cast<size_t>(entries_[i].first.value)] = static_cast<uint32_t>(i + 1);
+                }
+            }
+        }
+    }
+
+    std::vector<value_type> entries_;
+    std::vector<uint32_t> slots_;  // ID -> position + 1 (0 = absent)
+};
+
+// ============================================================================
+// Secondary Index (Key -> IDs, CSR)
+// ============================================================================
+
+/**
+ * @brief Key -> sorted unique IDs, stored as keys + offsets + one ID array
+ */
+template<typename KeyType, typename IdType>
+class FlatSecondaryIndex {
+public:
+    /// Stage a posting (before freeze)
+    void insert(KeyType key, IdType id) {
+        staging_.emplace_back(key, id);
+    }
+
+    /// Sort and compact staged postings into CSR form
+    void freeze() {
+        std::sort(staging_.begin(), staging_.end());
+        staging_.erase(std::unique(staging_.begin(), staging_.end()), staging_.end());
+
+        keys_.clear();
+        offsets_.clear();
+        ids_.clear();
+        ids_.reserve(staging_.size());
+        for (const auto& [key, id] : staging_) {
+            if (keys_.empty() || !(keys_.back() == key)) {
+                keys_.push_back(key);
+                offsets_.push_back(static_cast<uint32_t>(ids_.size()));
+            }
+            ids_.push_back(id);
+        }
+        offsets_.push_back(static_cast<uint32_t>(ids_.size()));
+
+        std::vector<std::pair<KeyType, IdType>>().swap(staging_);
+        keys_.shrink_to_fit();
+        offsets_.shrink_to_fit();
+    }
+
+    /// Freeze staged postings merged into a frozen index, leaving out IDs in dropped (sorted)
+    void freeze_over(const FlatSecondaryIndex& base, const std::vector<IdType>& dropped) {
+        std::sort(staging_.begin(), staging_.end());
+        staging_.erase(std::unique(staging_.begin(), staging_.end()), staging_.end());
+
+        std::vector<KeyType> keys;
+        std::vector<uint32_t> offsets;
+        std::vector<IdType> ids;
+        ids.reserve(base.ids_.size() + staging_.size());
+        size_t b = 0;
+        size_t s = 0;
+        while (b < base.keys_.size() || s < staging_.size()) {
+            bool in_base = b < base.keys_.size() && (s == staging_.size() || !(staging_[s].first < base.keys_[b]));
+            KeyType key = in_base ? base.keys_[b] : staging_[s].first;
+            size_t start = ids.size();
+            if (in_base) {
+                for (IdType id : base.postings_at(b++)) {
+                    if (!std::binary_search(dropped.begin(), dropped.end(), id)) ids.push_back(id);
+                }
+            }
+            size_t middle = ids.size();
+            for (; s < staging_.size() && staging_[s].first == key; ++s) ids.push_back(staging_[s].second);
+            merge_postings(ids, start, middle);
+            if (ids.size() == start) continue;
+            keys.push_back(key);
+            offsets.push_back(static_cast<uint32_t>(start));
+        }
+        offsets.push_back(static_cast<uint32_t>(ids.size()));
+
+        std::vector<std::pair<KeyType, IdType>>().swap(staging_);
+        keys_ = std::move(keys);
+        offsets_ = std::move(offsets);
+        ids_ = std::move(ids);
+    }
+
+    /// IDs for a key (empty if missing)
+    [[nodiscard]] PostingList<IdType> find(KeyType key) const {
+        auto it = std::lower_bound(keys_.begin(), keys_.end(), key);
+        if (it == keys_.end() || !(*it == key)) return {};
+        return postings_at(static_cast<size_t>(it - keys_.begin()));
+    }
+
+    /// Number of distinct keys
+    [[nodiscard]] size_t size() const { return keys_.size(); }
+
+    /// Distinct keys in ascending order
+    [[nodiscard]] const std::vector<KeyType>& keys() const { return keys_; }
+
+    /// Postings for the key at a position in keys()
+    [[nodiscard]] PostingList<IdType> postings_at(size_t index) const {
+        return {ids_.data() + offsets_[index], ids_.data() + offsets_[index + 1]};
+    }
+
+    /// Frozen CSR arrays: keys()[i] owns ids()[offsets()[i], offsets()[i + 1])
+    [[nodiscard]] const std::vector<uint32_t>& offsets() const { return offsets_; }
+    [[nodiscard]] const std::vector<IdType>& ids() const { return ids_; }
+
+    /// Replace the contents with frozen CSR arrays (e.g. from a snapshot); false if inconsistent
+    bool restore(std::vector<KeyType> keys, std::vector<uint32_t> offsets, std::vector<IdType> ids) {
+        auto not_ascending = [](const auto& a, const auto& b) { return !(a < b); };
+        bool never_frozen = keys.empty() && offsets.empty() && ids.empty();
+        bool consistent = offsets.size() == keys.size() + 1 && offsets.front() == 0 &&
+                          offsets.back() == ids.size() && std::is_sorted(offsets.begin(), offsets.end()) &&
+                          std::adjacent_find(keys.begin(), keys.end(), not_ascending) == keys.end();
+        if (!never_frozen && !consistent) return false;
+        keys_ = std::move(keys);
+        offsets_ = std::move(offsets);
+        ids_ = std::move(ids);
+        return true;
+    }
+
+private:
+    std::vector<std::pair<KeyType, IdType>> staging_;
+    std::vector<KeyType> keys_;
+    std::vector<uint32_t> offsets_;  // keys_.size() + 1 entries once frozen
+    std::vector<IdType> ids_;
+};
+
+// ============================================================================
+// Range Index (sorted (value, ID) pairs)
+// ============================================================================
+
+/**
+ * @brief Numeric value -> IDs, sorted by (value, ID) for range lookups
+ */
+template<typename ValueType, typename IdType>
+class FlatRangeIndex {
+public:
+    using value_type = std::pair<ValueType, IdType>;
+    using const_iterator = typename std::vector<value_type>::const_iterator;
+
+    /// Stage an entry (before freeze)
+    void insert(ValueType value, IdType id) {
+        entries_.emplace_back(value, id);
+    }
+
+    /// Sort staged entries
+    void freeze() {
+        if (!std::is_sorted(entries_.begin(), entries_.end())) {
+            std::sort(entries_.begin(), entries_.end());
+        }
+        entries_.shrink_to_fit();
+    }
+
+    /// Freeze staged entries merged into a frozen index, leaving out IDs in dropped (sorted)
+    void freeze_over(const FlatRangeIndex& base, const std::vector<IdType>& dropped) {
+        std::sort(entries_.begin(), entries_.end());
+        std::vector<value_type> kept;
+        kept.reserve(base.entries_.size());
+        for (const auto& entry : base.entries_) {
+            if (!std::binary_search(dropped.begin(), dropped.end(), entry.second)) kept.push_back(entry);
+        }
+
+        std::vector<value_type> merged;
+        merged.reserve(kept.size() + entries_.size());
+        std::merge(kept.begin(), kept.end(), entries_.begin(), entries_.end(), std::back_inserter(merged));
+        entries_ = std::move(merged);
+    }
+
+    /// Entries with min <= value <= max, in (value, ID) order
+    [[nodiscard]] std::pair<const_iterator, const_iterator> equal_range(ValueType min, ValueType max) const {
+        if (max < min) return {entries_.end(), entries_.end()};
+        auto first = std::lower_bound(entries_.begin(), entries_.end(), min,
+            [](const value_type& entry, ValueType v) { return entry.first < v; });
+        auto last = std::upper_bound(first, entries_.end(), max,
+            [](ValueType v, const value_type& entry) { return v < entry.first; });
+        return {first, last};
+    }
+
+    /// Number of entries with min <= value <= max
+    [[nodiscard]] size_t count(ValueType min, ValueType max) const {
+        auto [first, last] = equal_range(min, max);
+        return static_cast<size_t>(last - first);
+    }
+
+    /// IDs with min <= value <= max, sorted by ID
+    [[nodiscard]] std::vector<IdType> ids_in(ValueType min, ValueType max) const {
+        auto [first, last] = equal_range(min, max);
+        std::vector<IdType> ids;
+        ids.reserve(static_cast<size_t>(last - first));
+        for (auto it = first; it != last; ++it) ids.push_back(it->second);
+        std::sort(ids.begin(), ids.end());
+        return ids;
+    }
+
+    [[nodiscard]] size_t size() const { return entries_.size(); }
+
+    /// Frozen (value, ID) pairs in ascending order
+    [[nodiscard]] const std::vector<value_type>& entries() const { return entries_; }
+
+    /// Replace the contents with frozen entries (e.g. from a snapshot) and refreeze
+    void assign(std::vector<value_type> entries) {
+        entries_ = std::move(entries);
+        freeze();
+    }
+
+private:
+    std::vector<value_type> entries_;
+};
+
+// ============================================================================
+// Name Index (case-insensitive name -> IDs, CSR)
+// ============================================================================
+
+/**
+ * @brief Case-insensitive name -> sorted unique IDs
+ *
+ * Names are folded with std::tolower, the same folding CaseInsensitiveCompare
+ * applies, and stored once per distinct folded name.
+ */
+template<typename IdType>
+class FlatNameIndex {
+public:
+    /// Stage a posting (before freeze)
+    void insert(std::string_view name, IdType id) {
+        staging_.emplace_back(fold(name), id);
+    }
+
+    /// Sort and compact staged postings into CSR form
+    void freeze() {
+        std::sort(staging_.begin(), staging_.end());
+        staging_.erase(std::unique(staging_.begin(), staging_.end()), staging_.end());
+
+        names_.clear();
+        offsets_.clear();
+        ids_.clear();
+        ids_.reserve(staging_.size());
+        for (auto& [name, id] : staging_) {
+            if (names_.empty() || names_.back() != name) {
+                names_.push_back(std::move(name));
+                offsets_.push_back(static_cast<uint32_t>(ids_.size()));
+            }
+            ids_.push_back(id);
+        }
+        offsets_.push_back(static_cast<uint32_t>(ids_.size()));
+
+        std::vector<std::pair<std::string, IdType>>().swap(staging_);
+        names_.shrink_to_fit();
+        offsets_.shrink_to_fit();
+    }
+
+    /// Freeze staged postings merged into a frozen index, leaving out IDs in dropped (sorted)
+    void freeze_over(const FlatNameIndex& base, const std::vector<IdType>& dropped) {
+        std::sort(staging_.begin(), staging_.end());
+        staging_.erase(std::unique(staging_.begin(), staging_.end()), staging_.end());
+
+        std::vector<std::string> names;
+        std::vector<uint32_t> offsets;
+        std::vector<IdType> ids;
+        names.reserve(base.names_.size() + staging_.size());
+        ids.reserve(base.ids_.size() + staging_.size());
+        size_t b = 0;
+        size_t s = 0;
+        while (b < base.names_.size() || s < staging_.size()) {
+            bool in_base = b < base.names_.size() && (s == staging_.size() || !(staging_[s].first < base.names_[b]));
+            std::string name = in_base ? base.names_[b] : staging_[s].first;
+            size_t start = ids.size();
+            if (in_base) {
+                for (IdType id : base.postings_at(b++)) {
+                    if (!std::binary_search(dropped.begin(), dropped.end(), id)) ids.push_back(id);
+                }
+            }
+            size_t middle = ids.size();
+            for (; s < staging_.size() && staging_[s].first == name; ++s) ids.push_back(staging_[s].second);
+            merge_postings(ids, start, middle);
+            if (ids.size() == start) continue;
+            names.push_back(std::move(name));
+            offsets.push_back(static_cast<uint32_t>(start));
+        }
+        offsets.push_back(static_cast<uint32_t>(ids.size()));
+
+        std::vector<std::pair<std::string, IdType>>().swap(staging_);
+        names_ = std::move(names);
+        offsets_ = std::move(offsets);
+        ids_ = std::move(ids);
+    }
+
+    /// IDs for a name, compared case-insensitively (empty if missing)
+    [[nodiscard]] PostingList<IdType> find(std::string_view name) const {
+        // Fold while comparing so lookups never allocate
+        auto folded_less = [](const std::string& key, std::string_view query) {
+            size_t n = std::min(key.size(), query.size());
+            for (size_t i = 0; i < n; ++i) {
+                auto a = static_cast<unsigned char>(key[i]);
+                auto b = static_cast<unsigned char>(fold_char(query[i]));
+                if (a != b) return a < b;
+            }
+            return key.size() < query.size();
+        };
+        auto it = std::lower_bound(names_.begin(), names_.end(), name, folded_less);
+        if (it == names_.end() || it->size() != name.size()) return {};
+        for (size_t i = 0; i < name.size(); ++i) {
+            if ((*it)[i] != fold_char(name[i])) return {};
+        }
+        return postings_at(static_cast<size_t>(it - names_.begin()));
+    }
+
+    /// Number of distinct names
+    [[nodiscard]] size_t size() const { return names_.size(); }
+
+    /// Distinct folded names in ascending order
+    [[nodiscard]] const std::vector<std::string>& names() const { return names_; }
+
+    /// Postings for the name at a position in names()
+    [[nodiscard]] PostingList<IdType> postings_at(size_t index) const {
+        return {ids_.data() + offsets_[index], ids_.data() + offsets_[index + 1]};
+    }
+
+    /// Frozen CSR arrays: names()[i] owns ids()[offsets()[i], offsets()[i + 1])
+    [[nodiscard]] const std::vector<uint32_t>& offsets() const { return offsets_; }
+    [[nodiscard]] const std::vector<IdType>& ids() const { return ids_; }
+
+    /// Replace the contents with frozen CSR arrays (e.g. from a snapshot); false if inconsistent
+    bool restore(std::vector<std::string> names, std::vector<uint32_t> offsets, std::vector<IdType> ids) {
+        auto not_ascending = [](const auto& a, const auto& b) { return !(a < b); };
+        bool never_frozen = names.empty() && offsets.empty() && ids.empty();
+        bool consistent = offsets.size() == names.size() + 1 && offsets.front() == 0 &&
+                          offsets.back() == ids.size() && std::is_sorted(offsets.begin(), offsets.end()) &&
+                          std::adjacent_find(names.begin(), names.end(), not_ascending) == names.end();
+        if (!never_frozen && !consistent) return false;
+        names_ = std::move(names);
+        offsets_ = std::move(offsets);
+        ids_ = std::move(ids);
+        return true;
+    }
+
+    /// Case folding used for keys
+    static char fold_char(char c) {
+        return static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    }
+
+    static std::string fold(std::string_view name) {
+        std::string folded(name);
+        for (auto& c : folded) {
+            c = fold_char(c);
+        }
+        return folded;
+    }
+
+private:
+    std::vector<std::pair<std::string, IdType>> staging_;
+    std::vector<std::string> names_;
+    std::vector<uint32_t> offsets_;
+    std::vector<IdType> ids_;
+};
+
+} // namespace cratedigger
@@ -1,7 +1,7 @@
 #include "cratedigger/logging.hpp"
 #include <chrono>
-#include <iomanip>
-#include <sstream>
+#include <cstdio>
+#include <ctime>
 
 namespace cratedigger {
 
@@ -17,53 +17,62 @@ std::string_view level_to_string(LogLevel level) {
     return "unknown";
 }
 
-std::string escape_json_string(std::string_view str) {
-    std::string result;
-    result.reserve(str.size());
+/// Append str to out as the body of a JSON string
+void append_json_escaped(std::string& out, std::string_view str) {
     for (char c : str) {
         switch (c) {
-            case '"': result += "\\\""; break;
-            case '\\': result += "\\\\"; break;
-            case '\b': result += "\\b"; break;
-            case '\f': result += "\\f"; break;
-            case '\n': result += "\\n"; break;
-            case '\r': result += "\\r"; break;
-            case '\t': result += "\\t"; break;
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\b': out += "\\b"; break;
+            case '\f': out += "\\f"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
             default:
                 if (c >= 0 && c < 32) {
                     char buf[8];
                     std::snprintf(buf, sizeof(buf), "\\u%04x", static_cast<unsigned char>(c));
-                    result += buf;
+                    out += buf;
                 } else {
-                    result += c;
+                    out += c;
                 }
         }
     }
-    return result;
 }
 
 } // anonymous namespace
 
 void Logger::log(LogLevel level, const SourceLocation& loc, const std::string& message) {
-    if (level < min_level_) {
+    if (!enabled(level)) {
         return;
     }
 
-    // Get current timestamp in ISO 8601 format
+    // Get current timestamp in ISO 8601 format (std::gmtime is not thread-safe)
     auto now = std::chrono::system_clock::now();
     auto time = std::chrono::system_clock::to_time_t(now);
-    std::ostringstream timestamp_stream;
-    timestamp_stream << std::put_time(std::gmtime(&time), "%FT%TZ");
+    std::tm utc{};
+#ifdef _WIN32
+    gmtime_s(&utc, &time);
+#else
+    gmtime_r(&time, &utc);
+#endif
+    char timestamp[32];
+    size_t timestamp_len = std::strftime(timestamp, sizeof(timestamp), "%Y-%m-%dT%H:%M:%SZ", &utc);
 
-    // Build JSON Lines output (C++17)
-    std::ostringstream json_stream;
-    json_stream << R"({"timestamp":")" << timestamp_stream.str()
-                << R"(","level":")" << level_to_string(level)
-                << R"(","message":")" << escape_json_string(message)
-                << R"(","source":")" << loc.file_name() << ":" << loc.line
-                << R"("})";
-
-    std::string json_line = json_stream.str();
+    // Build JSON Lines output in one buffer
+    std::string json_line;
+    json_line.reserve(96 + message.size());
+    json_line += R"({"timestamp":")";
+    json_line.append(timestamp, timestamp_len);
+    json_line += R"(","level":")";
+    json_line += level_to_string(level);
+    json_line += R"(","message":")";
+    append_json_escaped(json_line, message);
+    json_line += R"(","source":")";
+    json_line += loc.file_name();
+    json_line += ':';
+    json_line += std::to_string(loc.line);
+    json_line += R"("})";
 
     std::lock_guard<std::mutex> lock(mutex_);
     if (callback_) {
@@ -0,0 +1,104 @@
+#include "cratedigger/metrics.hpp"
+#include <cstdio>
+
+namespace cratedigger {
+
+namespace {
+
+/// Appends "key":value members; the first member of an object goes without a comma
+class MemberWriter {
+public:
+    explicit MemberWriter(std::string& out) : out_(out) {}
+
+    MemberWriter& add(const char* key, uint64_t value) {
+        start(key);
+        out_ += std::to_string(value);
+        return *this;
+    }
+
+    MemberWriter& add(const char* key, double value) {
+        char buf[32];
+        std::snprintf(buf, sizeof(buf), "%.6g", value);
+        start(key);
+        out_ += buf;
+        return *this;
+    }
+
+    MemberWriter& add(const char* key, bool value) {
+        start(key);
+        out_ += value ? "true" : "false";
+        return *this;
+    }
+
+    /// Table names are fixed identifiers, so they need no escaping
+    MemberWriter& add(const char* key, const std::string& value) {
+        start(key);
+        out_ += '"';
+        out_ += value;
+        out_ += '"';
+        return *this;
+    }
+
+    /// Start a member whose value the caller appends
+    MemberWriter& start(const char* key) {
+        if (!first_) out_ += ',';
+        first_ = false;
+        out_ += '"';
+        out_ += key;
+        out_ += "\":";
+        return *this;
+    }
+
+private:
+    std::string& out_;
+    bool first_{true};
+};
+
+} // anonymous namespace
+
+std::string to_json(const DatabaseMetrics& metrics) {
+    std::string out = "{";
+    MemberWriter top(out);
+    top.add("open_ns", metrics.open_ns)
+        .add("read_ns", metrics.read_ns)
+        .add("index_ns", metrics.index_ns)
+        .add("file_bytes", metrics.file_bytes)
+        .add("page_size", metrics.page_size)
+        .add("snapshot_restored", metrics.snapshot_restored)
+        .add("pooled_strings", metrics.pooled_strings)
+        .add("pooled_string_bytes", metrics.pooled_string_bytes);
+
+    top.start("tables");
+    out += '[';
+    for (size_t i = 0; i < metrics.tables.size(); ++i) {
+        const auto& table = metrics.tables[i];
+        out += i == 0 ? "{" : ",{";
+        MemberWriter(out)
+            .add("table", table.table)
+            .add("pages", table.pages)
+            .add("rows", table.rows)
+            .add("bytes", table.bytes)
+            .add("parse_ns", table.parse_ns);
+        out += '}';
+    }
+    out += ']';
+
+    const auto& anlz = metrics.anlz;
+    top.start("anlz");
+    out += '{';
+    MemberWriter(out)
+        .add("files_parsed", anlz.files_parsed)
+        .add("files_failed", anlz.files_failed)
+        .add("bytes_read", anlz.bytes_read)
+        .add("load_ns", anlz.load_ns)
+        .add("files_per_second", anlz.files_per_second())
+        .add("snapshot_hits", anlz.snapshot_hits)
+        .add("snapshot_misses", anlz.snapshot_misses)
+        .add("cache_hits", anlz.cache_hits)
+        .add("cache_misses", anlz.cache_misses)
+        .add("cache_hit_rate", anlz.cache_hit_rate());
+    out += "}}";
+    return out;
+}
+
+} // namespace cratedigger
@@ -0,0 +1,195 @@
+#include "cratedigger/open_task.hpp"
+#include "cratedigger/logging.hpp"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <optional>
+#include <thread>
+
+namespace cratedigger {
+
+namespace {
+
+/// State whose on_progress the current thread is running (null outside a report)
+thread_local const void* reporting_state = nullptr;
+
+} // anonymous namespace
+
+struct OpenTask::State {
+    std::atomic<bool> cancel{false};      // Polled by both loaders
+    std::atomic<bool> user_cancel{false}; // cancel() was called (rather than a failed open stopping the scan)
+
+    mutable std::mutex mutex;
+    mutable std::condition_variable changed;
+    OpenProgress progress;
+    std::shared_ptr<const Database> metadata;
+    std::optional<Result<Database>> result;
+    bool taken{false};
+
+    std::mutex report_mutex;  // One on_progress call at a time, in update order
+    std::function<void(const OpenProgress&)> on_progress;
+
+    std::thread loader;
+
+    /// Apply change to the progress, wake waiters and report the new progress
+    template<typename Change>
+    void update(Change&& change) {
+        std::lock_guard<std::mutex> report_lock(report_mutex);
+        OpenProgress current;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            change(progress);
+            current = progress;
+        }
+        changed.notify_all();
+        if (on_progress) {
+            const void* outer = reporting_state;
+            reporting_state = this;
+            on_progress(current);
+            reporting_state = outer;
+        }
+    }
+};
+
+OpenTask::OpenTask(std::shared_ptr<State> state) : state_(std::move(state)) {}
+
+OpenTask::OpenTask(OpenTask&& other) noexcept = default;
+
+OpenTask& OpenTask::operator=(OpenTask&& other) noexcept {
+    if (this != &other) {
+        OpenTask previous(std::move(*this));  // Cancelled and joined on scope exit
+        state_ = std::move(other.state_);
+    }
+    return *this;
+}
+
+OpenTask::~OpenTask() {
+    if (!state_) return;  // Moved-from
+    cancel();
+    if (!state_->loader.joinable()) return;
+    if (reporting_state == state_.get()) {
+        // Destroyed from on_progress: the loader holds the state and finishes on its own
+        state_->loader.detach();
+    } else {
+        state_->loader.join();
+    }
+}
+
+void OpenTask::cancel() {
+    state_->user_cancel.store(true, std::memory_order_relaxed);
+    state_->cancel.store(true, std::memory_order_relaxed);
+}
+
+OpenProgress OpenTask::progress() const {
+    std::lock_guard<std::mutex> lock(state_->mutex);
+    return state_->progress;
+}
+
+bool OpenTask::ready() const {
+    std::lock_guard<std::mutex> lock(state_->mutex);
+    return state_->result.has_value();
+}
+
+bool OpenTask::wait_for(std::chrono::milliseconds timeout) const {
+    std::unique_lock<std::mutex> lock(state_->mutex);
+    return state_->changed.wait_for(lock, timeout, [this] { return state_->result.has_value(); });
+}
+
+void OpenTask::wait() const {
+    std::unique_lock<std::mutex> lock(state_->mutex);
+    state_->changed.wait(lock, [this] { return state_->result.has_value(); });
+}
+
+std::shared_ptr<const Database> OpenTask::metadata() const {
+    std::lock_guard<std::mutex> lock(state_->mutex);
+    return state_->metadata;
+}
+
+std::shared_ptr<const Database> OpenTask::wait_metadata() const {
+    std::unique_lock<std::mutex> lock(state_->mutex);
+    state_->changed.wait(lock, [this] { return state_->metadata || state_->result.has_value(); });
+    return state_->metadata;
+}
+
+Result<Database> OpenTask::get() {
+    wait();
+    {
+        std::lock_guard<std::mutex> lock(state_->mutex);
+        if (state_->taken) {
+            return make_error(ErrorCode::InvalidParameter, "OpenTask::get() was already called");
+        }
+        state_->taken = true;
+    }
+    // The result is set last, so the loader is about to exit
+    if (state_->loader.joinable()) state_->loader.join();
+    return std::move(*state_->result);
+}
+
+void OpenTask::run(State& state, std::filesystem::path path, AsyncOpenOptions options) {
+    // ANLZ scan first, so its file reads overlap the PDB read and index build
+    std::shared_ptr<CuePointManager> anlz;
+    std::thread scanner;
+    LoadObserver file_observer;
+    file_observer.cancel = &state.cancel;
+    file_observer.on_progress = [&state](size_t done, size_t total) {
+        state.update([&](OpenProgress& p) {
+            // Scanner threads report out of order; progress only moves forward
+            p.anlz_files_done = std::max(p.anlz_files_done, done);
+            p.anlz_files_total = std::max(p.anlz_files_total, total);
+        });
+    };
+    if (!options.anlz_dir.empty()) {
+        anlz = Database::make_anlz(options.database);
+        scanner = std::thread([&] { anlz->scan_directory(options.anlz_dir, options.sections, &file_observer); });
+    }
+
+    LoadObserver table_observer;
+    table_observer.cancel = &state.cancel;
+    table_observer.on_progress = [&state](size_t done, size_t total) {
+        state.update([&](OpenProgress& p) {
+            p.phase = OpenPhase::Indexing;
+            p.tables_done = std::max(p.tables_done, done);
+            p.tables_total = std::max(p.tables_total, total);
+        });
+    };
+    auto opened = Database::open_pooled(path, options.ext, options.database, nullptr, &table_observer);
+
+    if (opened) {
+        auto metadata = opened->snapshot();
+        bool scanning = scanner.joinable();
+        state.update([&](OpenProgress& p) {
+            if (scanning) p.phase = OpenPhase::LoadingAnlz;
+            state.metadata = std::move(metadata);
+        });
+    } else {
+        state.cancel.store(true, std::memory_order_relaxed);  // Nothing to attach the scan to
+    }
+    if (scanner.joinable()) scanner.join();
+
+    if (opened && state.user_cancel.load(std::memory_order_relaxed)) {
+        opened = make_error(ErrorCode::Cancelled, "Open of " + path.string() + " cancelled");
+    }
+    if (opened && anlz) {
+        opened->adopt_anlz(std::move(anlz));
+    }
+    if (!opened) {
+        LOG_INFO("Asynchronous open failed: " + opened.error().message);
+    }
+
+    bool ok = static_cast<bool>(opened);
+    state.update([&](OpenProgress& p) {
+        p.phase = ok ? OpenPhase::Done : OpenPhase::Failed;
+        state.result.emplace(std::move(opened));
+    });
+}
+
+OpenTask open_async(const std::filesystem::path& path, const AsyncOpenOptions& options) {
+    auto state = std::make_shared<OpenTask::State>();
+    state->on_progress = options.on_progress;
+    // The loader keeps the state alive, so it can outlive a handle dropped from on_progress
+    state->loader = std::thread([state, path, options] { OpenTask::run(*state, path, options); });
+    return OpenTask(std::move(state));
+}
+
+} // namespace cratedigger
@@ -0,0 +1,116 @@
+#pragma once
+/**
+ * @file parallel.hpp
+ * @brief Internal work-stealing task runner
+ *
+ * Each worker owns a contiguous range of task indices and pops from its
+ * front; a worker whose range runs dry steals the back half of another
+ * worker's range. Ranges stay contiguous, so callers that store one result
+ * per task index can merge them in index order and get the same output as
+ * a serial loop.
+ */
+
+#include <algorithm>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace cratedigger::detail {
+
+/// Resolve a requested worker count (0 = one per hardware thread), capped by the task count
+inline size_t resolve_thread_count(size_t requested, size_t task_count) {
+    size_t threads = requested;
+    if (threads == 0) {
+        threads = std::max<size_t>(1, std::thread::hardware_concurrency());
+    }
+    return std::max<size_t>(1, std::min(threads, task_count));
+}
+
+/**
+ * @brief Run task(task_index) for every index in [0, task_count)
+ *
+ * The calling thread acts as worker 0. With one worker the tasks run inline
+ * in order. The first exception thrown by a task is rethrown after all
+ * workers have joined.
+ */
+template<typename Task>
+void run_work_stealing(size_t task_count, size_t thread_count, Task&& task) {
+    size_t workers = resolve_thread_count(thread_count, task_count);
+    if (task_count == 0) return;
+    if (workers == 1) {
+        for (size_t i = 0; i < task_count; ++i) task(i);
+        return;
+    }
+
+    struct Range {
+        std::mutex mutex;
+        size_t begin{0};
+        size_t end{0};
+    };
+    std::vector<Range> ranges(workers);
+    for (size_t w = 0; w < workers; ++w) {
+        ranges[w].begin = task_count * w / workers;
+        ranges[w].end = task_count * (w + 1) / workers;
+    }
+
+    std::mutex error_mutex;
+    std::exception_ptr error;
+
+    auto pop_own = [&ranges](size_t self, size_t& index) {
+        std::lock_guard<std::mutex> lock(ranges[self].mutex);
+        if (ranges[self].begin == ranges[self].end) return false;
+        index = ranges[self].begin++;
+        return true;
+    };
+
+    auto steal = [&ranges, workers](size_t self) {
+        for (size_t k = 1; k < workers; ++k) {
+            Range& victim = ranges[(self + k) % workers];
+            size_t begin = 0;
+            size_t end = 0;
+            {
+                std::lock_guard<std::mutex> lock(victim.mutex);
+                size_t remaining = victim.end - victim.begin;
+                if (remaining == 0) continue;
+                // Take the back half (or the last task)
+                size_t take = (remaining + 1) / 2;
+                begin = victim.end - take;
+                end = victim.end;
+                victim.end = begin;
+            }
+            std::lock_guard<std::mutex> lock(ranges[self].mutex);
+            ranges[self].begin = begin;
+            ranges[self].end = end;
+            return true;
+        }
+        return false;
+    };
+
+    auto run_worker = [&](size_t self) {
+        size_t index = 0;
+        do {
+            while (pop_own(self, index)) {
+                try {
+                    task(index);
+                } catch (...) {
+                    std::lock_guard<std::mutex> lock(error_mutex);
+                    if (!error) error = std::current_exception();
+                }
+            }
+        } while (steal(self));
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(workers - 1);
+    for (size_t w = 1; w < workers; ++w) {
+        threads.emplace_back(run_worker, w);
+    }
+    run_worker(0);
+    for (auto& t : threads) t.join();
+
+    if (error) std::rethrow_exception(error);
+}
+
+} // namespace cratedigger::detail
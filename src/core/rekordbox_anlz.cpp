@@ -1,10 +1,20 @@
 #include "cratedigger/rekordbox_anlz.hpp"
 #include "cratedigger/logging.hpp"
-#include <fstream>
+#include "parallel.hpp"
+#include "snapshot.hpp"
+#include "stopwatch.hpp"
+#include "utf16.hpp"
+#include <cstddef>
 #include <cstring>
 #include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <array>
 #include <sstream>
 #include <iomanip>
+#include <list>
+#include <mutex>
+#include <unordered_map>
 
 namespace cratedigger {
 
@@ -38,67 +48,134 @@ CuePointType parse_cue_type(uint8_t raw_type) {
 
 /// Parse UTF-16BE string to UTF-8
 std::string parse_utf16be_string(const uint8_t* data, size_t byte_len) {
-    std::string result;
-    size_t char_count = byte_len / 2;
-    result.reserve(char_count);
-
-    for (size_t i = 0; i < char_count; ++i) {
-        uint16_t ch = read_u16_be(data + i * 2);
-        if (ch == 0) break;
-
-        if (ch < 0x80) {
-            result += static_cast<char>(ch);
-        } else if (ch < 0x800) {
-            result += static_cast<char>(0xC0 | (ch >> 6));
-            result += static_cast<char>(0x80 | (ch & 0x3F));
-        } else {
-            result += static_cast<char>(0xE0 | (ch >> 12));
-            result += static_cast<char>(0x80 | ((ch >> 6) & 0x3F));
-            result += static_cast<char>(0x80 | (ch & 0x3F));
-        }
+    return detail::utf16_to_utf8(data, byte_len / 2, detail::Utf16Order::BigEndian);
+}
+
+/// Check if a section's payload is needed for a mask (the path is always read)
+bool section_wanted(uint32_t type, AnlzSections sections) {
+    switch (static_cast<AnlzSectionType>(type)) {
+        case AnlzSectionType::Path:
+            return true;
+        case AnlzSectionType::CuePointList:
+        case AnlzSectionType::CuePointList2:
+        case AnlzSectionType::ExtCuePointList:
+            return has_sections(sections, AnlzSections::CuePoints);
+        case AnlzSectionType::BeatGrid:
+            return has_sections(sections, AnlzSections::BeatGrid);
+        case AnlzSectionType::WaveformPreview:
+        case AnlzSectionType::WaveformTiny:
+        case AnlzSectionType::WaveformColorPreview:
+        case AnlzSectionType::Waveform3BandPreview:
+            return has_sections(sections, AnlzSections::WaveformPreviews);
+        case AnlzSectionType::WaveformScroll:
+        case AnlzSectionType::WaveformColorScroll:
+        case AnlzSectionType::Waveform3BandScroll:
+            return has_sections(sections, AnlzSections::WaveformDetails);
+        case AnlzSectionType::SongStructure:
+            return has_sections(sections, AnlzSections::SongStructure);
+        default:
+            return false;
     }
-    return result;
 }
 
+/**
+ * @brief Byte ranges of an ANLZ file, from a mapping or by positioned reads
+ *
+ * Buffered reads go to the file through a small read-ahead window, so a
+ * run of small sections costs one read while a large skipped section costs
+ * at most the window; memory is bounded by the largest range read.
+ */
+class SectionReader {
+public:
+    static Result<SectionReader> open(const std::filesystem::path& path, IoMode io_mode) {
+        SectionReader reader;
+        if (io_mode == IoMode::MemoryMapped) {
+            auto mapped = FileBuffer::open(path, io_mode);
+            if (!mapped) return mapped.error();
+            reader.mapped_ = std::move(*mapped);
+            reader.size_ = reader.mapped_.size();
+            return reader;
+        }
+        reader.file_ = std::make_unique<std::ifstream>();
+        reader.file_->rdbuf()->pubsetbuf(nullptr, 0);
+        reader.file_->open(path, std::ios::binary | std::ios::ate);
+        if (!*reader.file_) {
+            return make_error(ErrorCode::FileNotFound, "Cannot open file: " + path.string());
+        }
+        auto size = reader.file_->tellg();
+        if (size < 0) {
+            return make_error(ErrorCode::IoError, "Cannot determine file size: " + path.string());
+        }
+        reader.size_ = static_cast<uint64_t>(size);
+        return reader;
+    }
+
+    [[nodiscard]] uint64_t size() const { return size_; }
+    [[nodiscard]] uint64_t bytes_read() const { return bytes_read_; }
+
+    /// Bytes [offset, offset + length), valid until the next read (nullptr past the end or on error)
+    const uint8_t* read(uint64_t offset, size_t length) {
+        if (offset > size_ || length > size_ - offset) return nullptr;
+        if (!file_) {
+            bytes_read_ += length;
+            return mapped_.data() + offset;
+        }
+
+        if (offset >= buffer_offset_ && offset + length <= buffer_offset_ + buffer_.size()) {
+            return buffer_.data() + (offset - buffer_offset_);
+        }
+        // Short ranges read ahead to the window size; longer ones are read exactly
+        size_t count = static_cast<size_t>(std::max<uint64_t>(length, std::min<uint64_t>(kWindow, size_ - offset)));
+        buffer_.resize(count);
+        buffer_offset_ = offset;
+        file_->seekg(static_cast<std::streamoff>(offset));
+        file_->read(reinterpret_cast<char*>(buffer_.data()), static_cast<std::streamsize>(count));
+        if (!*file_) {
+            buffer_.clear();
+            return nullptr;
+        }
+        bytes_read_ += count;
+        return buffer_.data();
+    }
+
+private:
+    static constexpr size_t kWindow = 1024;
+
+    FileBuffer mapped_;                   // MemoryMapped
+    std::unique_ptr<std::ifstream> file_; // Buffered (unique_ptr keeps the unbuffered stream in place)
+    std::vector<uint8_t> buffer_;         // Bytes [buffer_offset_, buffer_offset_ + size) of the file
+    uint64_t buffer_offset_{0};
+    uint64_t size_{0};
+    uint64_t bytes_read_{0};
+};
+
 } // anonymous namespace
 
 // ============================================================================
 // RekordboxAnlz Implementation
 // ============================================================================
 
-Result<RekordboxAnlz> RekordboxAnlz::open(const std::filesystem::path& path) {
+Result<RekordboxAnlz> RekordboxAnlz::open(const std::filesystem::path& path, IoMode io_mode, AnlzSections sections) {
     RekordboxAnlz anlz;
 
-    // Read entire file
-    std::ifstream file(path, std::ios::binary | std::ios::ate);
-    if (!file) {
+    auto reader = SectionReader::open(path, io_mode);
+    if (!reader) {
         return make_error(
-            ErrorCode::FileNotFound,
+            reader.error().code,
             "Cannot open ANLZ file: " + path.string()
         );
     }
 
-    auto file_size = file.tellg();
-    if (file_size < static_cast<std::streamoff>(sizeof(RawAnlzHeader))) {
+    const uint8_t* header = reader->read(0, sizeof(RawAnlzHeader));
+    if (!header) {
         return make_error(
             ErrorCode::InvalidFileFormat,
             "File too small to be a valid ANLZ file"
         );
     }
 
-    anlz.file_data_.resize(static_cast<size_t>(file_size));
-    file.seekg(0);
-    file.read(reinterpret_cast<char*>(anlz.file_data_.data()), file_size);
-
-    if (!file) {
-        return make_error(
-            ErrorCode::IoError,
-            "Failed to read ANLZ file contents"
-        );
-    }
-
     // Verify magic number "PMAI"
-    uint32_t magic = read_u32_be(anlz.file_data_.data());
+    uint32_t magic = read_u32_be(header);
     if (magic != 0x504D4149) {  // "PMAI"
         std::ostringstream oss;
         oss << "Invalid ANLZ magic number: 0x" << std::hex << std::uppercase << std::setfill('0') << std::setw(8) << magic;
@@ -108,8 +185,26 @@ Result<RekordboxAnlz> RekordboxAnlz::open(const std::filesystem::path& path) {
         );
     }
 
-    anlz.parse_sections();
+    // Walk the tag headers; only wanted sections have their payload read
+    uint64_t offset = read_u32_be(header + 4);
+    while (const uint8_t* tag = reader->read(offset, sizeof(RawAnlzSectionHeader))) {
+        uint32_t section_type = read_u32_be(tag);
+        uint32_t section_header_len = read_u32_be(tag + 4);
+        uint32_t section_len = read_u32_be(tag + 8);
+
+        if (section_len == 0 || section_header_len > section_len || offset + section_len > reader->size()) {
+            break;
+        }
+        if (section_wanted(section_type, sections)) {
+            size_t section_data_len = section_len - section_header_len;
+            const uint8_t* section_data = reader->read(offset + section_header_len, section_data_len);
+            if (!section_data) break;
+            anlz.parse_section(section_type, section_data, section_data_len);
+        }
+        offset += section_len;
+    }
     anlz.is_valid_ = true;
+    anlz.bytes_read_ = reader->bytes_read();
 
     LOG_INFO("Parsed ANLZ file: " + std::to_string(anlz.cue_points_.size()) + " cue points, " + std::to_string(anlz.beat_grid_.beats.size()) + " beats");
 
@@ -117,12 +212,12 @@ Result<RekordboxAnlz> RekordboxAnlz::open(const std::filesystem::path& path) {
 }
 
 RekordboxAnlz::RekordboxAnlz(RekordboxAnlz&& other) noexcept
-    : file_data_(std::move(other.file_data_))
-    , cue_points_(std::move(other.cue_points_))
+    : cue_points_(std::move(other.cue_points_))
     , beat_grid_(std::move(other.beat_grid_))
     , waveforms_(std::move(other.waveforms_))
     , song_structure_(std::move(other.song_structure_))
     , track_path_(std::move(other.track_path_))
+    , bytes_read_(other.bytes_read_)
     , is_valid_(other.is_valid_)
 {
     other.is_valid_ = false;
@@ -130,12 +225,12 @@ RekordboxAnlz::RekordboxAnlz(RekordboxAnlz&& other) noexcept
 
 RekordboxAnlz& RekordboxAnlz::operator=(RekordboxAnlz&& other) noexcept {
     if (this != &other) {
-        file_data_ = std::move(other.file_data_);
         cue_points_ = std::move(other.cue_points_);
         beat_grid_ = std::move(other.beat_grid_);
         waveforms_ = std::move(other.waveforms_);
         song_structure_ = std::move(other.song_structure_);
         track_path_ = std::move(other.track_path_);
+        bytes_read_ = other.bytes_read_;
         is_valid_ = other.is_valid_;
         other.is_valid_ = false;
     }
@@ -144,80 +239,70 @@ RekordboxAnlz& RekordboxAnlz::operator=(RekordboxAnlz&& other) noexcept {
 
 RekordboxAnlz::~RekordboxAnlz() = default;
 
-void RekordboxAnlz::parse_sections() {
-    if (file_data_.size() < sizeof(RawAnlzHeader)) {
-        return;
-    }
-
-    const uint8_t* data = file_data_.data();
-    uint32_t header_len = read_u32_be(data + 4);
-    size_t offset = header_len;
-
-    while (offset + sizeof(RawAnlzSectionHeader) <= file_data_.size()) {
-        uint32_t section_type = read_u32_be(data + offset);
-        uint32_t section_header_len = read_u32_be(data + offset + 4);
-        uint32_t section_len = read_u32_be(data + offset + 8);
+TrackAnalysis RekordboxAnlz::release_analysis() {
+    TrackAnalysis analysis;
+    analysis.cue_points = std::move(cue_points_);
+    analysis.beat_grid = std::move(beat_grid_);
+    analysis.waveforms = std::move(waveforms_);
+    analysis.song_structure = std::move(song_structure_);
+    cue_points_.clear();
+    beat_grid_ = BeatGrid{};
+    waveforms_ = TrackWaveforms{};
+    song_structure_ = SongStructure{};
+    return analysis;
+}
 
-        if (section_len == 0 || offset + section_len > file_data_.size()) {
+void RekordboxAnlz::parse_section(uint32_t type, const uint8_t* data, size_t len) {
+    switch (static_cast<AnlzSectionType>(type)) {
+        case AnlzSectionType::CuePointList:
+        case AnlzSectionType::CuePointList2:
+            parse_cue_list(data, len, false);
             break;
-        }
-
-        const uint8_t* section_data = data + offset + section_header_len;
-        size_t section_data_len = section_len - section_header_len;
-
-        switch (static_cast<AnlzSectionType>(section_type)) {
-            case AnlzSectionType::CuePointList:
-            case AnlzSectionType::CuePointList2:
-                parse_cue_list(section_data, section_data_len, false);
-                break;
 
-            case AnlzSectionType::ExtCuePointList:
-                parse_cue_list(section_data, section_data_len, true);
-                break;
-
-            case AnlzSectionType::BeatGrid:
-                parse_beat_grid(section_data, section_data_len);
-                break;
+        case AnlzSectionType::ExtCuePointList:
+            parse_cue_list(data, len, true);
+            break;
 
-            case AnlzSectionType::Path:
-                track_path_ = parse_path_section(section_data, section_data_len);
-                break;
+        case AnlzSectionType::BeatGrid:
+            parse_beat_grid(data, len);
+            break;
 
-            case AnlzSectionType::WaveformPreview:
-            case AnlzSectionType::WaveformTiny:
-                parse_waveform_preview(section_data, section_data_len);
-                break;
+        case AnlzSectionType::Path:
+            track_path_ = parse_path_section(data, len);
+            break;
 
-            case AnlzSectionType::WaveformScroll:
-                parse_waveform_scroll(section_data, section_data_len, WaveformStyle::Blue);
-                break;
+        case AnlzSectionType::WaveformPreview:
+        case AnlzSectionType::WaveformTiny:
+            parse_waveform_preview(data, len);
+            break;
 
-            case AnlzSectionType::WaveformColorPreview:
-                parse_waveform_color_preview(section_data, section_data_len);
-                break;
+        case AnlzSectionType::WaveformScroll:
+            parse_waveform_scroll(data, len, WaveformStyle::Blue);
+            break;
 
-            case AnlzSectionType::WaveformColorScroll:
-                parse_waveform_color_scroll(section_data, section_data_len);
-                break;
+        case AnlzSectionType::WaveformColorPreview:
+            parse_waveform_color_preview(data, len);
+            break;
 
-            case AnlzSectionType::Waveform3BandPreview:
-                parse_waveform_3band(section_data, section_data_len, true);
-                break;
+        case AnlzSectionType::WaveformColorScroll:
+            parse_waveform_color_scroll(data, len);
+            break;
 
-            case AnlzSectionType::Waveform3BandScroll:
-                parse_waveform_3band(section_data, section_data_len, false);
-                break;
+        case AnlzSectionType::Waveform3BandPreview:
+            parse_waveform_3band(data, len, true);
+            break;
 
-            case AnlzSectionType::SongStructure:
-                parse_song_structure(section_data, section_data_len);
-                break;
+        case AnlzSectionType::Waveform3BandScroll:
+            parse_waveform_3band(data, len, false);
+            break;
 
-            default:
-                // Skip unknown sections
-                break;
-        }
+        case AnlzSectionType::SongStructure:
+            parse_song_structure(data, len);
+            break;
 
-        offset += section_len;
+        default:
+            // Skip unknown sections
+            break;
     }
 }
 
@@ -470,7 +555,7 @@ void RekordboxAnlz::parse_song_structure(const uint8_t* data, size_t len) {
     size_t body_offset = 6;
     size_t body_len = len - body_offset;
 
-    if (body_len < 14 + entry_count * 24) return;
+    if (body_len < 14 + static_cast<size_t>(entry_count) * 24) return;
 
     // Copy body data for potential unmasking
     std::vector<uint8_t> body(data + body_offset, data + len);
@@ -541,177 +626,883 @@ void RekordboxAnlz::parse_song_structure(const uint8_t* data, size_t len) {
 // CuePointManager Implementation
 // ============================================================================
 
-void CuePointManager::scan_directory(const std::filesystem::path& anlz_dir) {
-    if (!std::filesystem::exists(anlz_dir)) {
-        LOG_WARN("ANLZ directory does not exist: " + anlz_dir.string());
-        return;
+namespace {
+
+/// Check for an .EXT file (case-insensitive)
+bool is_ext_file(const std::filesystem::path& path) {
+    auto ext = path.extension().string();
+    std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+    return ext == ".ext";
+}
+
+/// Merge waveforms - prefer higher quality versions
+void merge_waveforms(TrackWaveforms& existing, TrackWaveforms&& incoming) {
+    if (incoming.preview && !existing.preview) {
+        existing.preview = std::move(incoming.preview);
+    }
+    if (incoming.detail) {
+        // Prefer colored/3-band detail over blue
+        if (!existing.detail ||
+            (existing.detail->style == WaveformStyle::Blue &&
+             incoming.detail->style != WaveformStyle::Blue)) {
+            existing.detail = std::move(incoming.detail);
+        }
+    }
+    if (incoming.color_preview) {
+        // Prefer 3-band over RGB
+        if (!existing.color_preview ||
+            (existing.color_preview->style == WaveformStyle::RGB &&
+             incoming.color_preview->style == WaveformStyle::ThreeBand)) {
+            existing.color_preview = std::move(incoming.color_preview);
+        }
     }
+}
 
-    size_t loaded = 0;
-    for (const auto& entry : std::filesystem::recursive_directory_iterator(anlz_dir)) {
-        if (entry.is_regular_file()) {
-            auto ext = entry.path().extension().string();
-            // Convert to lowercase for comparison
-            std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+/**
+ * Merge one track's analysis into another.
+ *
+ * Cue points: the first non-empty list wins unless a later one comes from an
+ * .EXT file (extended format has priority). Beat grid and song structure:
+ * first wins. Waveforms: see merge_waveforms.
+ */
+void merge_analysis(TrackAnalysis& existing, TrackAnalysis&& incoming, bool incoming_from_ext) {
+    if (!incoming.cue_points.empty() && (existing.cue_points.empty() || incoming_from_ext)) {
+        existing.cue_points = std::move(incoming.cue_points);
+    }
+    if (existing.beat_grid.empty()) {
+        existing.beat_grid = std::move(incoming.beat_grid);
+    }
+    merge_waveforms(existing.waveforms, std::move(incoming.waveforms));
+    if (existing.song_structure.empty()) {
+        existing.song_structure = std::move(incoming.song_structure);
+    }
+}
 
-            if (ext == ".dat" || ext == ".ext") {
-                load_anlz_file(entry.path());
-                ++loaded;
-            }
+/// Last component of a '/'-separated track path
+std::string path_filename(const std::string& path) {
+    auto slash = path.find_last_of('/');
+    return slash == std::string::npos ? path : path.substr(slash + 1);
+}
+
+} // anonymous namespace
+
+/**
+ * Analysis merged from a contiguous run of ANLZ files.
+ *
+ * Besides the per-path data it remembers which cue lists came from an .EXT
+ * file, so that merging two partials in order gives the same result as
+ * loading all of their files one after another.
+ */
+struct CuePointManager::PartialIndex {
+    struct Entry {
+        TrackAnalysis analysis;
+        bool cues_from_ext{false};
+    };
+    std::map<std::string, Entry> entries;
+
+    /// Merge a parsed file; returns the track path it was merged into
+    const std::string& add(const std::filesystem::path& path, RekordboxAnlz&& anlz) {
+        std::string track_path = anlz.track_path();
+        if (track_path.empty()) {
+            // Use filename as key if no path in ANLZ
+            track_path = path.stem().string();
         }
+
+        bool from_ext = is_ext_file(path);
+        auto it = entries.try_emplace(std::move(track_path)).first;
+        auto& entry = it->second;
+        auto analysis = anlz.release_analysis();
+        entry.cues_from_ext = entry.cues_from_ext || (from_ext && !analysis.cue_points.empty());
+        merge_analysis(entry.analysis, std::move(analysis), from_ext);
+        return it->first;
+    }
+};
+
+/// LRU cache of lazily loaded analysis, keyed by analyze_path
+struct CuePointManager::LazyCache {
+    struct Item {
+        std::string analyze_path;
+        std::shared_ptr<const TrackAnalysis> analysis;
+        uint64_t stamp{0};  // lazy_stamp() of the files it was parsed from
+    };
+
+    std::filesystem::path export_root;
+    size_t capacity{0};
+
+    std::mutex mutex;
+    std::list<Item> items;  // Most recently used first
+    std::unordered_map<std::string, std::list<Item>::iterator> lookup;
+};
+
+/// Counters behind CuePointManager::metrics()
+struct CuePointManager::Counters {
+    std::atomic<uint64_t> files_parsed{0};
+    std::atomic<uint64_t> files_failed{0};
+    std::atomic<uint64_t> bytes_read{0};
+    std::atomic<uint64_t> load_ns{0};
+    std::atomic<uint64_t> snapshot_hits{0};
+    std::atomic<uint64_t> snapshot_misses{0};
+    std::atomic<uint64_t> cache_hits{0};
+    std::atomic<uint64_t> cache_misses{0};
+
+    static void add(std::atomic<uint64_t>& counter, uint64_t n) { counter.fetch_add(n, std::memory_order_relaxed); }
+};
+
+CuePointManager::CuePointManager() : counters_(std::make_shared<Counters>()) {}
+CuePointManager::~CuePointManager() = default;
+CuePointManager::CuePointManager(CuePointManager&& other) noexcept = default;
+
+CuePointManager::CuePointManager(const CuePointManager& other)
+    : records_(other.records_)
+    , filename_index_(other.filename_index_)
+    , cue_point_count_(other.cue_point_count_)
+    , beat_grid_count_(other.beat_grid_count_)
+    , waveform_count_(other.waveform_count_)
+    , song_structure_count_(other.song_structure_count_)
+    , lazy_(other.lazy_)
+    , counters_(other.counters_)
+    , scanned_(other.scanned_)
+    , io_mode_(other.io_mode_)
+    , thread_count_(other.thread_count_)
+    , snapshot_dir_(other.snapshot_dir_)
+{
+    // Keys view the paths of this copy's own records
+    path_index_.reserve(records_.size());
+    for (size_t i = 0; i < records_.size(); ++i) {
+        path_index_.emplace(records_[i].path, i);
     }
+}
+CuePointManager& CuePointManager::operator=(CuePointManager&& other) noexcept = default;
 
-    LOG_INFO("Loaded " + std::to_string(loaded) + " ANLZ files: " +
-             std::to_string(cue_point_index_.size()) + " cues, " +
-             std::to_string(beat_grid_index_.size()) + " beats, " +
-             std::to_string(waveform_index_.size()) + " waves, " +
-             std::to_string(song_structure_index_.size()) + " structures");
+void CuePointManager::count(std::atomic<uint64_t> Counters::*counter, uint64_t n) const {
+    if (counters_) Counters::add((*counters_).*counter, n);
 }
 
-void CuePointManager::load_anlz_file(const std::filesystem::path& path) {
-    auto result = RekordboxAnlz::open(path);
-    if (!result) {
-        // Skip files that fail to parse (e.g., corrupted or incompatible format)
-        return;
+CuePointManager::Record& CuePointManager::record_for(const std::string& track_path) {
+    auto it = path_index_.find(track_path);
+    if (it != path_index_.end()) {
+        return records_[it->second];
     }
+    records_.push_back(Record{track_path, {}});
+    path_index_.emplace(records_.back().path, records_.size() - 1);
+    filename_index_[path_filename(track_path)].insert(track_path);
+    return records_.back();
+}
 
-    auto& anlz = *result;
+TrackAnalysis& CuePointManager::writable(Record& record) {
+    if (!record.analysis) {
+        record.analysis = std::make_shared<TrackAnalysis>();
+    } else if (record.analysis.use_count() > 1) {
+        // Only the writer copies managers, so the count cannot grow behind our back
+        record.analysis = std::make_shared<TrackAnalysis>(*record.analysis);
+    }
+    return *record.analysis;
+}
 
-    std::string track_path = anlz.track_path();
-    if (track_path.empty()) {
-        // Use filename as key if no path in ANLZ
-        track_path = path.stem().string();
+void CuePointManager::merge_partial(PartialIndex&& partial) {
+    for (auto& [track_path, entry] : partial.entries) {
+        merge_entry(track_path, std::move(entry.analysis), entry.cues_from_ext);
     }
+}
 
-    // Merge cue points (newer file overwrites)
-    if (!anlz.cue_points().empty()) {
-        auto& existing_cues = cue_point_index_[track_path];
-        if (existing_cues.empty()) {
-            existing_cues = anlz.cue_points();
-        } else {
-            // Extended format (.EXT) has priority over standard format (.DAT)
-            auto ext = path.extension().string();
-            std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
-            if (ext == ".ext") {
-                existing_cues = anlz.cue_points();
+void CuePointManager::merge_entry(const std::string& track_path, TrackAnalysis&& analysis, bool cues_from_ext) {
+    if (analysis.empty()) return;
+
+    auto& existing = writable(record_for(track_path));
+    if (!analysis.cue_points.empty()) {
+        if (existing.cue_points.empty()) {
+            ++cue_point_count_;
+            existing.cue_points = std::move(analysis.cue_points);
+        } else if (cues_from_ext) {
+            existing.cue_points = std::move(analysis.cue_points);
+        }
+    }
+    if (!analysis.beat_grid.empty() && existing.beat_grid.empty()) {
+        ++beat_grid_count_;
+        existing.beat_grid = std::move(analysis.beat_grid);
+    }
+    if (analysis.waveforms.has_any()) {
+        if (!existing.waveforms.has_any()) ++waveform_count_;
+        merge_waveforms(existing.waveforms, std::move(analysis.waveforms));
+    }
+    if (!analysis.song_structure.empty() && existing.song_structure.empty()) {
+        ++song_structure_count_;
+        existing.song_structure = std::move(analysis.song_structure);
+    }
+}
+
+// ============================================================================
+// Scan Snapshots
+// ============================================================================
+
+namespace {
+
+/// ANLZ files (.DAT and .EXT) under a directory, in directory order, with their sizes and mtimes
+template<typename File>
+std::vector<File> list_anlz_files(const std::filesystem::path& anlz_dir) {
+    std::vector<File> files;
+    std::error_code ec;
+    for (auto it = std::filesystem::recursive_directory_iterator(anlz_dir, ec);
+         !ec && it != std::filesystem::recursive_directory_iterator(); it.increment(ec)) {
+        const auto& entry = *it;
+        if (!entry.is_regular_file(ec)) continue;
+
+        auto ext = entry.path().extension().string();
+        // Convert to lowercase for comparison
+        std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+        if (ext != ".dat" && ext != ".ext") continue;
+
+        // Directory entries may carry cached attributes (e.g. on Windows)
+        File file;
+        file.path = entry.path();
+        file.size = static_cast<uint64_t>(entry.file_size(ec));
+        file.mtime = static_cast<int64_t>(entry.last_write_time(ec).time_since_epoch().count());
+        files.push_back(std::move(file));
+    }
+    return files;
+}
+
+/// Size and member offsets of every struct stored by memcpy (see index_snapshot_layout)
+uint64_t anlz_snapshot_layout() {
+    const uint64_t layout[] = {
+        sizeof(BeatEntry), offsetof(BeatEntry, beat_number), offsetof(BeatEntry, tempo_100x),
+        offsetof(BeatEntry, time_ms),
+        sizeof(PhraseEntry), offsetof(PhraseEntry, index), offsetof(PhraseEntry, beat), offsetof(PhraseEntry, kind),
+        offsetof(PhraseEntry, end_beat), offsetof(PhraseEntry, k1), offsetof(PhraseEntry, k2),
+        offsetof(PhraseEntry, k3), offsetof(PhraseEntry, has_fill), offsetof(PhraseEntry, fill_beat),
+        sizeof(SnapshotStringRef), offsetof(SnapshotStringRef, offset), offsetof(SnapshotStringRef, size),
+    };
+    return hash_bytes(layout, sizeof(layout), kSnapshotVersion);
+}
+
+/**
+ * Key of an ANLZ directory listing. Hashing every file's contents would cost
+ * as much I/O as parsing it, so files are identified by relative path, size
+ * and mtime; the key's size and mtime are the total size and newest mtime.
+ */
+template<typename File>
+SnapshotKey anlz_listing_key(const std::filesystem::path& anlz_dir, const std::vector<File>& files,
+                             AnlzSections sections) {
+    SnapshotKey key;
+    std::string listing;
+    const size_t prefix = anlz_dir.generic_string().size();
+    for (const auto& file : files) {
+        key.size += file.size;
+        key.mtime = std::max(key.mtime, file.mtime);
+
+        // Files come from iterating anlz_dir, so they all start with its path
+        listing.append(file.path.generic_string(), prefix, std::string::npos);
+        listing.push_back('\0');
+        listing.append(reinterpret_cast<const char*>(&file.size), sizeof(file.size));
+        listing.append(reinterpret_cast<const char*>(&file.mtime), sizeof(file.mtime));
+    }
+    // A scan of other sections parsed different data from the same files
+    auto mask = static_cast<uint32_t>(sections);
+    listing.append(reinterpret_cast<const char*>(&mask), sizeof(mask));
+    key.content_hash = hash_bytes(listing.data(), listing.size(), files.size());
+    return key;
+}
+
+void write_waveform(SnapshotWriter& out, const std::optional<WaveformData>& waveform) {
+    out.value(waveform.has_value());
+    if (!waveform) return;
+    out.value(waveform->style);
+    out.array(waveform->data);
+    out.value(waveform->entry_count);
+    out.value(waveform->bytes_per_entry);
+}
+
+void read_waveform(SnapshotReader& in, std::optional<WaveformData>& waveform) {
+    bool present = false;
+    in.value(present);
+    if (!present || !in.ok()) return;
+    waveform.emplace();
+    in.value(waveform->style);
+    in.array(waveform->data);
+    in.value(waveform->entry_count);
+    in.value(waveform->bytes_per_entry);
+}
+
+void write_analysis(SnapshotWriter& out, const TrackAnalysis& analysis) {
+    out.value(static_cast<uint64_t>(analysis.cue_points.size()));
+    for (const auto& cue : analysis.cue_points) {
+        out.value(cue.hot_cue_number);
+        out.value(cue.type);
+        out.value(cue.time_ms);
+        out.value(cue.loop_time_ms);
+        out.value(cue.color_id);
+        out.string(cue.comment);
+        out.value(cue.is_active);
+    }
+    out.array(analysis.beat_grid.beats);
+    write_waveform(out, analysis.waveforms.preview);
+    write_waveform(out, analysis.waveforms.detail);
+    write_waveform(out, analysis.waveforms.color_preview);
+    out.value(analysis.song_structure.mood);
+    out.value(analysis.song_structure.bank);
+    out.value(analysis.song_structure.end_beat);
+    out.array(analysis.song_structure.phrases);
+}
+
+void read_analysis(SnapshotReader& in, TrackAnalysis& analysis) {
+    analysis.cue_points.resize(in.count(sizeof(uint64_t)));
+    for (auto& cue : analysis.cue_points) {
+        in.value(cue.hot_cue_number);
+        in.value(cue.type);
+        in.value(cue.time_ms);
+        in.value(cue.loop_time_ms);
+        in.value(cue.color_id);
+        in.string(cue.comment);
+        in.value(cue.is_active);
+    }
+    in.array(analysis.beat_grid.beats);
+    read_waveform(in, analysis.waveforms.preview);
+    read_waveform(in, analysis.waveforms.detail);
+    read_waveform(in, analysis.waveforms.color_preview);
+    in.value(analysis.song_structure.mood);
+    in.value(analysis.song_structure.bank);
+    in.value(analysis.song_structure.end_beat);
+    in.array(analysis.song_structure.phrases);
+}
+
+} // anonymous namespace
+
+void CuePointManager::save_snapshot(const std::filesystem::path& path, const SnapshotKey& key,
+                                    const std::vector<PartialIndex>& partials,
+                                    const std::vector<ScannedFile>& files) const {
+    SnapshotWriter out(nullptr, 0);
+    size_t count = 0;
+    for (const auto& partial : partials) count += partial.entries.size();
+
+    // Entries in merge order, so loading replays exactly what merge_partial did
+    out.value(static_cast<uint64_t>(count));
+    for (const auto& partial : partials) {
+        for (const auto& [track_path, entry] : partial.entries) {
+            out.string(track_path);
+            out.value(entry.cues_from_ext);
+            write_analysis(out, entry.analysis);
+        }
+    }
+
+    // Which record each file went into, so refresh() works after a restore
+    out.value(static_cast<uint64_t>(files.size()));
+    for (const auto& file : files) out.string(file.track_path);
+
+    if (out.commit(path, SnapshotKind::Anlz, key, anlz_snapshot_layout())) {
+        LOG_INFO("Saved ANLZ snapshot " + path.string());
+    }
+}
+
+bool CuePointManager::load_snapshot(const std::filesystem::path& path, const SnapshotKey& key,
+                                    std::vector<ScannedFile>& files) {
+    if (!std::filesystem::exists(path)) return false;
+
+    auto file = SnapshotFile::open(path, SnapshotKind::Anlz, key, anlz_snapshot_layout());
+    if (!file) {
+        LOG_INFO("Ignoring ANLZ snapshot: " + file.error().message);
+        return false;
+    }
+
+    // Decode everything before merging so a corrupt file changes nothing
+    SnapshotReader in = file->reader(nullptr, 0);
+    struct Entry {
+        std::string track_path;
+        bool cues_from_ext{false};
+        TrackAnalysis analysis;
+    };
+    std::vector<Entry> entries(in.count(sizeof(uint64_t)));
+    for (auto& entry : entries) {
+        in.string(entry.track_path);
+        in.value(entry.cues_from_ext);
+        read_analysis(in, entry.analysis);
+    }
+    std::vector<std::string> track_paths(in.count(sizeof(uint64_t)));
+    for (auto& track_path : track_paths) in.string(track_path);
+    if (track_paths.size() != files.size()) in.fail();
+    if (!in.finished()) {
+        LOG_WARN("Corrupt ANLZ snapshot: " + path.string());
+        return false;
+    }
+
+    for (auto& entry : entries) {
+        merge_entry(entry.track_path, std::move(entry.analysis), entry.cues_from_ext);
+    }
+    for (size_t i = 0; i < files.size(); ++i) files[i].track_path = std::move(track_paths[i]);
+    return true;
+}
+
+void CuePointManager::scan_directory(const std::filesystem::path& anlz_dir, AnlzSections sections,
+                                     const LoadObserver* observer) {
+    if (!std::filesystem::exists(anlz_dir)) {
+        LOG_WARN("ANLZ directory does not exist: " + anlz_dir.string());
+        return;
+    }
+    detail::Stopwatch watch;
+
+    // Collect files first so that the merge order is the directory order
+    auto files = list_anlz_files<ScannedFile>(anlz_dir);
+    if (observer != nullptr) observer->report(0, files.size());
+
+    SnapshotKey snapshot_key;
+    std::filesystem::path snapshot_file;
+    if (!snapshot_dir_.empty()) {
+        snapshot_key = anlz_listing_key(anlz_dir, files, sections);
+        snapshot_file = snapshot_path(snapshot_dir_, anlz_dir, SnapshotKind::Anlz);
+        if (load_snapshot(snapshot_file, snapshot_key, files)) {
+            LOG_INFO("Restored " + std::to_string(files.size()) + " ANLZ files from snapshot");
+            if (observer != nullptr) observer->report(files.size(), files.size());
+            remember_scan(anlz_dir, std::move(files), sections);
+            count(&Counters::snapshot_hits, 1);
+            count(&Counters::load_ns, watch.elapsed_ns());
+            return;
+        }
+        count(&Counters::snapshot_misses, 1);
+    }
+
+    // Small tasks keep the workers balanced; one partial index per task
+    constexpr size_t files_per_task = 32;
+    size_t task_count = (files.size() + files_per_task - 1) / files_per_task;
+    std::vector<PartialIndex> partials(task_count);
+    std::atomic<size_t> files_done{0};
+
+    detail::run_work_stealing(task_count, thread_count_, [&](size_t task) {
+        size_t begin = task * files_per_task;
+        size_t end = std::min(begin + files_per_task, files.size());
+        for (size_t i = begin; i < end; ++i) {
+            if (observer != nullptr && observer->cancelled()) return;
+            auto result = parse_file(files[i].path, sections);
+            // Files that fail to parse (e.g., corrupted or incompatible format) are skipped
+            if (result) {
+                files[i].track_path = partials[task].add(files[i].path, std::move(*result));
+            }
+            if (observer != nullptr) {
+                observer->report(files_done.fetch_add(1, std::memory_order_relaxed) + 1, files.size());
             }
         }
+    });
+
+    if (observer != nullptr && observer->cancelled()) {
+        LOG_INFO("ANLZ scan of " + anlz_dir.string() + " cancelled");
+        count(&Counters::load_ns, watch.elapsed_ns());
+        return;
+    }
+
+    if (!snapshot_file.empty()) {
+        save_snapshot(snapshot_file, snapshot_key, partials, files);
+    }
+
+    for (auto& partial : partials) {
+        merge_partial(std::move(partial));
+    }
+
+    LOG_INFO("Loaded " + std::to_string(files.size()) + " ANLZ files: " +
+             std::to_string(cue_point_count_) + " cues, " +
+             std::to_string(beat_grid_count_) + " beats, " +
+             std::to_string(waveform_count_) + " waves, " +
+             std::to_string(song_structure_count_) + " structures");
+    remember_scan(anlz_dir, std::move(files), sections);
+    count(&Counters::load_ns, watch.elapsed_ns());
+}
+
+void CuePointManager::load_anlz_file(const std::filesystem::path& path, AnlzSections sections) {
+    detail::Stopwatch watch;
+    auto result = parse_file(path, sections);
+    if (result) {
+        PartialIndex partial;
+        partial.add(path, std::move(*result));
+        merge_partial(std::move(partial));
     }
+    // Files that fail to parse (e.g., corrupted or incompatible format) are skipped
+    count(&Counters::load_ns, watch.elapsed_ns());
+}
+
+Result<RekordboxAnlz> CuePointManager::parse_file(const std::filesystem::path& path, AnlzSections sections) const {
+    auto result = RekordboxAnlz::open(path, io_mode_, sections);
+    if (result) {
+        count(&Counters::files_parsed, 1);
+        count(&Counters::bytes_read, result->bytes_read());
+    } else {
+        count(&Counters::files_failed, 1);
+    }
+    return result;
+}
+
+AnlzMetrics CuePointManager::metrics() const {
+    AnlzMetrics metrics;
+    if (!counters_) return metrics;  // Moved-from
+    auto load = [](const std::atomic<uint64_t>& counter) { return counter.load(std::memory_order_relaxed); };
+    metrics.files_parsed = load(counters_->files_parsed);
+    metrics.files_failed = load(counters_->files_failed);
+    metrics.bytes_read = load(counters_->bytes_read);
+    metrics.load_ns = load(counters_->load_ns);
+    metrics.snapshot_hits = load(counters_->snapshot_hits);
+    metrics.snapshot_misses = load(counters_->snapshot_misses);
+    metrics.cache_hits = load(counters_->cache_hits);
+    metrics.cache_misses = load(counters_->cache_misses);
+    return metrics;
+}
+
+// ============================================================================
+// Refresh
+// ============================================================================
 
-    // Store beat grid if present
-    if (anlz.has_beat_grid()) {
-        auto& existing_grid = beat_grid_index_[track_path];
-        if (existing_grid.empty()) {
-            existing_grid = anlz.beat_grid();
+void CuePointManager::remember_scan(const std::filesystem::path& anlz_dir, std::vector<ScannedFile>&& files,
+                                    AnlzSections sections) {
+    for (auto& scanned : scanned_) {
+        if (scanned.dir == anlz_dir) {
+            scanned.files = std::move(files);
+            scanned.sections = sections;
+            return;
         }
     }
+    scanned_.push_back({anlz_dir, std::move(files), sections});
+}
+
+void CuePointManager::reset_record(const std::string& track_path) {
+    auto it = path_index_.find(track_path);
+    if (it == path_index_.end()) return;
+
+    auto& analysis = records_[it->second].analysis;
+    if (!analysis) return;
+    if (!analysis->cue_points.empty()) --cue_point_count_;
+    if (!analysis->beat_grid.empty()) --beat_grid_count_;
+    if (analysis->waveforms.has_any()) --waveform_count_;
+    if (!analysis->song_structure.empty()) --song_structure_count_;
+    // Copies of this manager keep their reference to the old analysis
+    analysis.reset();
+}
+
+AnlzRefreshStats CuePointManager::refresh() {
+    AnlzRefreshStats stats;
+    for (auto& scanned : scanned_) {
+        refresh_directory(scanned, stats);
+    }
+    stats.tracks_reloaded += refresh_lazy_cache();
+    return stats;
+}
 
-    // Store waveforms if present
-    if (anlz.has_waveforms()) {
-        auto& existing_waveforms = waveform_index_[track_path];
-        const auto& new_waveforms = anlz.waveforms();
+bool CuePointManager::needs_refresh() const {
+    for (const auto& scanned : scanned_) {
+        auto files = list_anlz_files<ScannedFile>(scanned.dir);
+        if (files.size() != scanned.files.size()) return true;
 
-        // Merge waveforms - prefer higher quality versions
-        if (new_waveforms.preview && !existing_waveforms.preview) {
-            existing_waveforms.preview = new_waveforms.preview;
+        std::unordered_map<std::string, const ScannedFile*> previous;
+        previous.reserve(scanned.files.size());
+        for (const auto& file : scanned.files) {
+            previous.emplace(file.path.generic_string(), &file);
         }
-        if (new_waveforms.detail) {
-            // Prefer colored/3-band detail over blue
-            if (!existing_waveforms.detail ||
-                (existing_waveforms.detail->style == WaveformStyle::Blue &&
-                 new_waveforms.detail->style != WaveformStyle::Blue)) {
-                existing_waveforms.detail = new_waveforms.detail;
+        for (const auto& file : files) {
+            auto it = previous.find(file.path.generic_string());
+            if (it == previous.end() || it->second->size != file.size || it->second->mtime != file.mtime) {
+                return true;
             }
         }
-        if (new_waveforms.color_preview) {
-            // Prefer 3-band over RGB
-            if (!existing_waveforms.color_preview ||
-                (existing_waveforms.color_preview->style == WaveformStyle::RGB &&
-                 new_waveforms.color_preview->style == WaveformStyle::ThreeBand)) {
-                existing_waveforms.color_preview = new_waveforms.color_preview;
+    }
+    return !stale_lazy_items().empty();
+}
+
+void CuePointManager::refresh_directory(ScannedDirectory& scanned, AnlzRefreshStats& stats) {
+    auto files = list_anlz_files<ScannedFile>(scanned.dir);
+
+    std::unordered_map<std::string, const ScannedFile*> previous;
+    previous.reserve(scanned.files.size());
+    for (const auto& file : scanned.files) {
+        previous.emplace(file.path.generic_string(), &file);
+    }
+
+    // Tracks touched by an added, modified or removed file
+    std::set<std::string> affected;
+    std::vector<size_t> to_parse;
+    size_t changed = 0;
+    for (size_t i = 0; i < files.size(); ++i) {
+        auto it = previous.find(files[i].path.generic_string());
+        if (it != previous.end()) {
+            const ScannedFile& old = *it->second;
+            previous.erase(it);
+            if (old.size == files[i].size && old.mtime == files[i].mtime) {
+                files[i].track_path = old.track_path;
+                continue;
             }
+            affected.insert(old.track_path);
+        }
+        to_parse.push_back(i);
+        ++changed;
+    }
+    for (const auto& [path, old] : previous) {
+        affected.insert(old->track_path);
+        ++changed;
+    }
+    if (changed == 0) return;
+    detail::Stopwatch watch;
+
+    // Changed files may now belong to other tracks; parse them first to find out
+    std::vector<std::optional<RekordboxAnlz>> parsed(files.size());
+    auto parse = [&](const std::vector<size_t>& indices) {
+        detail::run_work_stealing(indices.size(), thread_count_, [&](size_t k) {
+            auto result = parse_file(files[indices[k]].path, scanned.sections);
+            if (result) parsed[indices[k]].emplace(std::move(*result));
+        });
+    };
+    parse(to_parse);
+    for (size_t i : to_parse) {
+        if (!parsed[i]) continue;
+        files[i].track_path = parsed[i]->track_path().empty() ? files[i].path.stem().string()
+                                                              : parsed[i]->track_path();
+        affected.insert(files[i].track_path);
+    }
+    affected.erase(std::string());
+
+    // Unchanged siblings of an affected track are merged again with it
+    std::vector<bool> attempted(files.size(), false);
+    for (size_t i : to_parse) attempted[i] = true;
+    std::vector<size_t> siblings;
+    for (size_t i = 0; i < files.size(); ++i) {
+        if (!attempted[i] && affected.count(files[i].track_path) != 0) {
+            siblings.push_back(i);
         }
     }
+    parse(siblings);
 
-    // Store song structure if present
-    if (anlz.has_song_structure()) {
-        auto& existing = song_structure_index_[track_path];
-        if (existing.empty()) {
-            existing = anlz.song_structure();
+    PartialIndex partial;
+    for (size_t i = 0; i < files.size(); ++i) {
+        if (parsed[i] && affected.count(files[i].track_path) != 0) {
+            partial.add(files[i].path, std::move(*parsed[i]));
         }
     }
+    for (const auto& track_path : affected) {
+        reset_record(track_path);
+    }
+    merge_partial(std::move(partial));
+
+    stats.files_changed += changed;
+    stats.tracks_reloaded += affected.size();
+    scanned.files = std::move(files);
+    count(&Counters::load_ns, watch.elapsed_ns());
+
+    LOG_INFO("Refreshed " + scanned.dir.string() + ": " + std::to_string(changed) + " files changed, " +
+             std::to_string(affected.size()) + " tracks reloaded");
 }
 
-std::vector<CuePointData> CuePointManager::get_cue_points(const std::string& track_path) const {
-    auto it = cue_point_index_.find(track_path);
-    if (it != cue_point_index_.end()) {
-        return it->second;
+namespace {
+
+/// The .DAT an analyze_path names, then its .EXT and .2EX siblings
+std::array<std::filesystem::path, 3> lazy_candidates(const std::filesystem::path& export_root,
+                                                     const std::string& analyze_path) {
+    // analyze_path is absolute within the export ("/PIONEER/USBANLZ/.../ANLZ0000.DAT")
+    std::filesystem::path dat_path = export_root / std::filesystem::path(analyze_path).relative_path();
+    bool lower = dat_path.extension() == ".dat";
+    return {
+        dat_path,
+        std::filesystem::path(dat_path).replace_extension(lower ? ".ext" : ".EXT"),
+        std::filesystem::path(dat_path).replace_extension(lower ? ".2ex" : ".2EX"),
+    };
+}
+
+/// Hash of which candidates exist and their sizes and mtimes
+uint64_t lazy_stamp(const std::array<std::filesystem::path, 3>& candidates) {
+    uint64_t fields[3 * 2] = {};
+    for (size_t i = 0; i < candidates.size(); ++i) {
+        std::error_code ec;
+        auto status = std::filesystem::status(candidates[i], ec);
+        if (ec || !std::filesystem::is_regular_file(status)) continue;
+        fields[2 * i] = static_cast<uint64_t>(std::filesystem::file_size(candidates[i], ec)) + 1;
+        fields[2 * i + 1] = static_cast<uint64_t>(
+            std::filesystem::last_write_time(candidates[i], ec).time_since_epoch().count());
     }
-    return {};
+    return hash_bytes(fields, sizeof(fields));
 }
 
-std::vector<CuePointData> CuePointManager::find_cue_points_by_filename(const std::string& filename) const {
-    // Search for partial match
-    for (const auto& [path, cues] : cue_point_index_) {
-        if (path.find(filename) != std::string::npos) {
-            return cues;
+} // anonymous namespace
+
+void CuePointManager::enable_lazy_loading(const std::filesystem::path& export_root, size_t cache_capacity) {
+    // A fresh cache: copies of this manager keep the one they share
+    lazy_ = std::make_shared<LazyCache>();
+    lazy_->export_root = export_root;
+    lazy_->capacity = std::max<size_t>(1, cache_capacity);
+}
+
+std::shared_ptr<const TrackAnalysis> CuePointManager::load_analysis(const std::string& analyze_path) const {
+    if (!lazy_ || analyze_path.empty()) {
+        return nullptr;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(lazy_->mutex);
+        auto it = lazy_->lookup.find(analyze_path);
+        if (it != lazy_->lookup.end()) {
+            lazy_->items.splice(lazy_->items.begin(), lazy_->items, it->second);
+            count(&Counters::cache_hits, 1);
+            return it->second->analysis;
         }
     }
-    return {};
-}
 
-const BeatGrid* CuePointManager::get_beat_grid(const std::string& track_path) const {
-    auto it = beat_grid_index_.find(track_path);
-    if (it != beat_grid_index_.end()) {
-        return &it->second;
+    // Parse outside the lock
+    detail::Stopwatch watch;
+    count(&Counters::cache_misses, 1);
+    auto candidates = lazy_candidates(lazy_->export_root, analyze_path);
+    uint64_t stamp = lazy_stamp(candidates);
+
+    auto analysis = std::make_shared<TrackAnalysis>();
+    bool found = false;
+    for (const auto& candidate : candidates) {
+        std::error_code ec;
+        if (!std::filesystem::is_regular_file(candidate, ec)) continue;
+        auto result = parse_file(candidate, AnlzSections::All);
+        if (!result) continue;
+        found = true;
+        merge_analysis(*analysis, result->release_analysis(), candidate != candidates[0]);
+    }
+    count(&Counters::load_ns, watch.elapsed_ns());
+    if (!found) {
+        return nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(lazy_->mutex);
+    auto it = lazy_->lookup.find(analyze_path);
+    if (it != lazy_->lookup.end()) {
+        // Another thread loaded it meanwhile; keep the cached copy
+        lazy_->items.splice(lazy_->items.begin(), lazy_->items, it->second);
+        return it->second->analysis;
     }
-    return nullptr;
+    lazy_->items.push_front({analyze_path, std::move(analysis), stamp});
+    lazy_->lookup[analyze_path] = lazy_->items.begin();
+    while (lazy_->items.size() > lazy_->capacity) {
+        lazy_->lookup.erase(lazy_->items.back().analyze_path);
+        lazy_->items.pop_back();
+    }
+    return lazy_->items.front().analysis;
 }
 
-const BeatGrid* CuePointManager::find_beat_grid_by_filename(const std::string& filename) const {
-    // Search for partial match
-    for (const auto& [path, grid] : beat_grid_index_) {
-        if (path.find(filename) != std::string::npos) {
-            return &grid;
+std::vector<std::string> CuePointManager::stale_lazy_items() const {
+    std::vector<std::string> stale;
+    if (!lazy_) return stale;
+
+    // Stat outside the lock; the cache holds at most capacity tracks
+    std::vector<std::pair<std::string, uint64_t>> cached;
+    {
+        std::lock_guard<std::mutex> lock(lazy_->mutex);
+        for (const auto& item : lazy_->items) cached.emplace_back(item.analyze_path, item.stamp);
+    }
+    for (auto& [analyze_path, stamp] : cached) {
+        if (lazy_stamp(lazy_candidates(lazy_->export_root, analyze_path)) != stamp) {
+            stale.push_back(std::move(analyze_path));
         }
     }
-    return nullptr;
+    return stale;
 }
 
-const TrackWaveforms* CuePointManager::get_waveforms(const std::string& track_path) const {
-    auto it = waveform_index_.find(track_path);
-    if (it != waveform_index_.end()) {
-        return &it->second;
+size_t CuePointManager::refresh_lazy_cache() {
+    if (!lazy_) return 0;
+
+    size_t dropped = 0;
+    for (const auto& analyze_path : stale_lazy_items()) {
+        std::lock_guard<std::mutex> lock(lazy_->mutex);
+        auto it = lazy_->lookup.find(analyze_path);
+        if (it == lazy_->lookup.end()) continue;
+        lazy_->items.erase(it->second);
+        lazy_->lookup.erase(it);
+        ++dropped;
     }
-    return nullptr;
+    return dropped;
 }
 
-const TrackWaveforms* CuePointManager::find_waveforms_by_filename(const std::string& filename) const {
-    // Search for partial match
-    for (const auto& [path, waveforms] : waveform_index_) {
-        if (path.find(filename) != std::string::npos) {
-            return &waveforms;
+size_t CuePointManager::cached_analysis_count() const {
+    if (!lazy_) return 0;
+    std::lock_guard<std::mutex> lock(lazy_->mutex);
+    return lazy_->items.size();
+}
+
+void CuePointManager::clear() {
+    scanned_.clear();
+    path_index_.clear();
+    records_.clear();
+    filename_index_.clear();
+    cue_point_count_ = 0;
+    beat_grid_count_ = 0;
+    waveform_count_ = 0;
+    song_structure_count_ = 0;
+    if (lazy_) {
+        // Replace rather than empty the cache, which copies may share
+        auto cache = std::make_shared<LazyCache>();
+        cache->export_root = lazy_->export_root;
+        cache->capacity = lazy_->capacity;
+        lazy_ = std::move(cache);
+    }
+}
+
+const TrackAnalysis* CuePointManager::get_analysis(std::string_view track_path) const {
+    auto it = path_index_.find(track_path);
+    if (it == path_index_.end()) return nullptr;
+    const auto& analysis = records_[it->second].analysis;
+    return analysis && !analysis->empty() ? analysis.get() : nullptr;
+}
+
+/**
+ * Known last path components are resolved through the filename index (first
+ * matching path in path order); anything else falls back to the substring
+ * scan these lookups always did.
+ */
+template<typename Predicate>
+const TrackAnalysis* CuePointManager::find_by_filename(const std::string& filename, Predicate has) const {
+    auto entry = filename_index_.find(path_filename(filename));
+    if (entry != filename_index_.end()) {
+        for (const auto& path : entry->second) {
+            if (path.size() < filename.size() ||
+                path.compare(path.size() - filename.size(), filename.size(), filename) != 0) {
+                continue;
+            }
+            const auto* analysis = get_analysis(path);
+            if (analysis && has(*analysis)) return analysis;
         }
+        return nullptr;
     }
-    return nullptr;
+
+    const Record* best = nullptr;
+    for (const auto& record : records_) {
+        if (record.path.find(filename) == std::string::npos || !record.analysis || !has(*record.analysis)) continue;
+        if (!best || record.path < best->path) best = &record;
+    }
+    return best ? best->analysis.get() : nullptr;
+}
+
+std::vector<CuePointData> CuePointManager::get_cue_points(const std::string& track_path) const {
+    const auto* analysis = get_analysis(track_path);
+    return analysis ? analysis->cue_points : std::vector<CuePointData>{};
+}
+
+std::vector<CuePointData> CuePointManager::find_cue_points_by_filename(const std::string& filename) const {
+    const auto* analysis = find_by_filename(filename, [](const TrackAnalysis& a) { return !a.cue_points.empty(); });
+    return analysis ? analysis->cue_points : std::vector<CuePointData>{};
+}
+
+const BeatGrid* CuePointManager::get_beat_grid(const std::string& track_path) const {
+    const auto* analysis = get_analysis(track_path);
+    return analysis && !analysis->beat_grid.empty() ? &analysis->beat_grid : nullptr;
+}
+
+const BeatGrid* CuePointManager::find_beat_grid_by_filename(const std::string& filename) const {
+    const auto* analysis = find_by_filename(filename, [](const TrackAnalysis& a) { return !a.beat_grid.empty(); });
+    return analysis ? &analysis->beat_grid : nullptr;
+}
+
+const TrackWaveforms* CuePointManager::get_waveforms(const std::string& track_path) const {
+    const auto* analysis = get_analysis(track_path);
+    return analysis && analysis->waveforms.has_any() ? &analysis->waveforms : nullptr;
+}
+
+const TrackWaveforms* CuePointManager::find_waveforms_by_filename(const std::string& filename) const {
+    const auto* analysis = find_by_filename(filename, [](const TrackAnalysis& a) { return a.waveforms.has_any(); });
+    return analysis ? &analysis->waveforms : nullptr;
 }
 
 const SongStructure* CuePointManager::get_song_structure(const std::string& track_path) const {
-    auto it = song_structure_index_.find(track_path);
-    if (it != song_structure_index_.end()) {
-        return &it->second;
-    }
-    return nullptr;
+    const auto* analysis = get_analysis(track_path);
+    return analysis && !analysis->song_structure.empty() ? &analysis->song_structure : nullptr;
 }
 
 const SongStructure* CuePointManager::find_song_structure_by_filename(const std::string& filename) const {
-    // Search for partial match
-    for (const auto& [path, structure] : song_structure_index_) {
-        if (path.find(filename) != std::string::npos) {
-            return &structure;
-        }
-    }
-    return nullptr;
+    const auto* analysis = find_by_filename(filename, [](const TrackAnalysis& a) { return !a.song_structure.empty(); });
+    return analysis ? &analysis->song_structure : nullptr;
 }
 
 // ============================================================================
@@ -1,5 +1,6 @@
 #include "cratedigger/rekordbox_pdb.hpp"
 #include "cratedigger/logging.hpp"
+#include "utf16.hpp"
 #include <cstring>
 #include <algorithm>
 #include <sstream>
@@ -22,93 +23,84 @@ inline uint32_t read_u32_le(const uint8_t* data) {
            (static_cast<uint32_t>(data[3]) << 24);
 }
 
-/// Parse device SQL string at given position
-std::string parse_device_sql_string(const uint8_t* data, size_t max_len) {
-    if (max_len == 0) return "";
+/**
+ * @brief Decode a device SQL string at given position
+ *
+ * ASCII strings are returned as a view into data; UTF-16LE strings are
+ * converted into scratch and the returned view points there.
+ */
+std::string_view decode_device_sql_string(const uint8_t* data, size_t max_len, std::string& scratch) {
+    if (max_len == 0) return {};
 
     uint8_t length_and_kind = data[0];
 
     // Check for special encoding markers
     if (length_and_kind == 0x40) {
         // Long ASCII string
-        if (max_len < 4) return "";
+        if (max_len < 4) return {};
         uint16_t length = read_u16_le(data + 1);
-        if (length < 4 || static_cast<size_t>(length - 4) > max_len - 4) return "";
-        return std::string(reinterpret_cast<const char*>(data + 4), length - 4);
+        if (length < 4 || static_cast<size_t>(length - 4) > max_len - 4) return {};
+        return std::string_view(reinterpret_cast<const char*>(data + 4), length - 4);
     }
     else if (length_and_kind == 0x90) {
         // Long UTF-16LE string
-        if (max_len < 4) return "";
+        if (max_len < 4) return {};
         uint16_t length = read_u16_le(data + 1);
-        if (length < 4) return "";
-
-        size_t char_count = (length - 4) / 2;
-        std::string result;
-        result.reserve(char_count);
-
-        const uint8_t* utf16_data = data + 4;
-        for (size_t i = 0; i < char_count && (i * 2 + 1) < max_len - 4; ++i) {
-            uint16_t ch = read_u16_le(utf16_data + i * 2);
-            if (ch == 0) break;
-            if (ch < 0x80) {
-                result += static_cast<char>(ch);
-            } else if (ch < 0x800) {
-                result += static_cast<char>(0xC0 | (ch >> 6));
-                result += static_cast<char>(0x80 | (ch & 0x3F));
-            } else {
-                result += static_cast<char>(0xE0 | (ch >> 12));
-                result += static_cast<char>(0x80 | ((ch >> 6) & 0x3F));
-                result += static_cast<char>(0x80 | (ch & 0x3F));
-            }
-        }
-        return result;
+        if (length < 4) return {};
+
+        size_t char_count = std::min<size_t>((length - 4) / 2, (max_len - 4) / 2);
+        scratch.clear();
+        detail::append_utf16_as_utf8(data + 4, char_count, detail::Utf16Order::LittleEndian, scratch);
+        return scratch;
     }
     else {
         // Short ASCII string
         size_t length = length_and_kind >> 1;
-        if (length == 0 || length > max_len) return "";
-        return std::string(reinterpret_cast<const char*>(data + 1), length - 1);
+        if (length == 0 || length > max_len) return {};
+        return std::string_view(reinterpret_cast<const char*>(data + 1), length - 1);
     }
 }
 
+/// Parse device SQL string at given position
+std::string parse_device_sql_string(const uint8_t* data, size_t max_len) {
+    std::string scratch;
+    return std::string(decode_device_sql_string(data, max_len, scratch));
+}
+
 } // anonymous namespace
 
 // ============================================================================
 // RekordboxPdb Implementation
 // ============================================================================
 
-Result<RekordboxPdb> RekordboxPdb::open(const std::filesystem::path& path, bool is_ext) {
+Result<RekordboxPdb> RekordboxPdb::open(const std::filesystem::path& path, bool is_ext, IoMode io_mode) {
+    auto buffer = FileBuffer::open(path, io_mode);
+    if (!buffer) {
+        return buffer.error();
+    }
+    auto pdb = parse(std::move(*buffer), is_ext);
+    if (pdb) {
+        LOG_INFO("Opened PDB file: " + std::to_string(pdb->table_count_) + " tables, page size: " + std::to_string(pdb->page_size_));
+    }
+    return pdb;
+}
+
+Result<RekordboxPdb> RekordboxPdb::from_bytes(std::vector<uint8_t> bytes, bool is_ext) {
+    return parse(FileBuffer::from_bytes(std::move(bytes)), is_ext);
+}
+
+Result<RekordboxPdb> RekordboxPdb::parse(FileBuffer buffer, bool is_ext) {
     RekordboxPdb pdb;
     pdb.is_ext_ = is_ext;
+    pdb.file_data_ = std::move(buffer);
 
-    // Read entire file into memory
-    std::ifstream file(path, std::ios::binary | std::ios::ate);
-    if (!file) {
-        return make_error(
-            ErrorCode::FileNotFound,
-            "Cannot open file: " + path.string()
-        );
-    }
-
-    auto file_size = file.tellg();
-    if (file_size < 28) {
+    if (pdb.file_data_.size() < 28) {
         return make_error(
             ErrorCode::InvalidFileFormat,
             "File too small to be a valid PDB file"
         );
     }
 
-    pdb.file_data_.resize(static_cast<size_t>(file_size));
-    file.seekg(0);
-    file.read(reinterpret_cast<char*>(pdb.file_data_.data()), file_size);
-
-    if (!file) {
-        return make_error(
-            ErrorCode::IoError,
-            "Failed to read file contents"
-        );
-    }
-
     const uint8_t* data = pdb.file_data_.data();
 
     // Parse header
@@ -147,8 +139,6 @@ Result<RekordboxPdb> RekordboxPdb::open(const std::filesystem::path& path, bool
         offset += 16;
     }
 
-    LOG_INFO("Opened PDB file: " + std::to_string(pdb.table_count_) + " tables, page size: " + std::to_string(pdb.page_size_));
-
     return pdb;
 }
 
@@ -248,6 +238,14 @@ Result<PdbPage> RekordboxPdb::read_page(uint32_t page_index) const {
     return page;
 }
 
+PageRowCursor RekordboxPdb::page_rows(uint32_t page_index) const {
+    size_t page_offset = static_cast<size_t>(page_size_) * page_index;
+    if (page_size_ < 40 || page_offset + page_size_ > file_data_.size()) {
+        return {};
+    }
+    return PageRowCursor(file_data_.data() + page_offset, page_offset, page_size_);
+}
+
 std::string RekordboxPdb::read_string(size_t offset) const {
     if (offset >= file_data_.size()) {
         return "";
@@ -258,6 +256,17 @@ std::string RekordboxPdb::read_string(size_t offset) const {
     );
 }
 
+std::string_view RekordboxPdb::read_string_view(size_t offset, std::string& scratch) const {
+    if (offset >= file_data_.size()) {
+        return {};
+    }
+    return decode_device_sql_string(
+        file_data_.data() + offset,
+        file_data_.size() - offset,
+        scratch
+    );
+}
+
 std::pair<const uint8_t*, size_t> RekordboxPdb::data_at(size_t offset, size_t size) const {
     if (offset + size > file_data_.size()) {
         return {nullptr, 0};
@@ -0,0 +1,380 @@
+#pragma once
+/**
+ * @file row_decoders.hpp
+ * @brief Internal table-driven decoders for PDB rows
+ *
+ * Each table's fixed row layout is a RowFormat: a constexpr list of field
+ * descriptors (byte offset, stored width, destination member). RowDecoder
+ * folds over that list, so every table gets its own straight-line decode
+ * with a single bounds check against the furthest field instead of one per
+ * field. Fields are read with unaligned little-endian loads, independent
+ * of the host's byte order and of the row's alignment in the file.
+ *
+ * Strings have no fixed size; descriptors hand their file offsets to the
+ * caller's string reader, which bounds each string against the file:
+ *
+ *   struct Strings {
+ *       void read(size_t offset, std::string_view& out);  // Borrowed or pooled
+ *       void read(size_t offset, std::string& out);       // Copied
+ *   };
+ *
+ *   GenreRowView row;
+ *   if (detail::decode_row<PageType::Genres>(detail::row_bytes(pdb, row_base), row, strings)) ...
+ */
+
+#include "cratedigger/rekordbox_pdb.hpp"
+#include "cratedigger/types.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+
+namespace cratedigger::detail {
+
+// ============================================================================
+// Loads
+// ============================================================================
+
+/// Unaligned little-endian load of an unsigned integer
+template<typename T>
+inline T load_le(const uint8_t* data) {
+    static_assert(std::is_unsigned_v<T>, "PDB fields are unsigned");
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    T value = 0;
+    for (size_t i = 0; i < sizeof(T); ++i) {
+        value = static_cast<T>(value | static_cast<T>(static_cast<T>(data[i]) << (8 * i)));
+    }
+    return value;
+#else
+    T value;
+    std::memcpy(&value, data, sizeof(T));
+    return value;
+#endif
+}
+
+/// Bytes from the start of a row to the end of the file
+struct RowBytes {
+    const uint8_t* data{nullptr};
+    size_t size{0};
+    size_t base{0};  // File offset of data[0]
+};
+
+/// The bytes of the row at row_base (empty if it starts past the end of the file)
+inline RowBytes row_bytes(const RekordboxPdb& pdb, size_t row_base) {
+    if (row_base >= pdb.file_size()) return {};
+    auto data = pdb.data_at(row_base, pdb.file_size() - row_base);
+    return {data.first, data.second, row_base};
+}
+
+/// Store a raw field in a plain integer, bool or strong ID member
+template<typename Dest, typename Raw>
+inline void assign_field(Dest& dest, Raw raw) {
+    if constexpr (std::is_integral_v<Dest>) {
+        dest = static_cast<Dest>(raw);
+    } else {
+        dest = Dest{static_cast<int64_t>(raw)};
+    }
+}
+
+// ============================================================================
+// Field Descriptors
+// ============================================================================
+
+/// Integer stored as Raw at Offset, copied into Member
+template<auto Member, typename Raw, size_t Offset>
+struct Column {
+    static constexpr size_t kEnd = Offset + sizeof(Raw);
+
+    template<typename Row, typename Strings>
+    static void decode(const RowBytes& bytes, Row& row, Strings&) {
+        assign_field(row.*Member, load_le<Raw>(bytes.data + Offset));
+    }
+};
+
+/// String whose offset from the row start is stored as Raw at Offset
+template<auto Member, typename Raw, size_t Offset>
+struct StringRef {
+    static constexpr size_t kEnd = Offset + sizeof(Raw);
+
+    template<typename Row, typename Strings>
+    static void decode(const RowBytes& bytes, Row& row, Strings& strings) {
+        strings.read(bytes.base + load_le<Raw>(bytes.data + Offset), row.*Member);
+    }
+};
+
+/// String stored right after the fixed fields, at Offset
+template<auto Member, size_t Offset>
+struct InlineString {
+    static constexpr size_t kEnd = Offset;
+
+    template<typename Row, typename Strings>
+    static void decode(const RowBytes& bytes, Row& row, Strings& strings) {
+        strings.read(bytes.base + Offset, row.*Member);
+    }
+};
+
+// ============================================================================
+// Row Decoders
+// ============================================================================
+
+/// Decoder of a fixed layout: one bounds check, then every field in order
+template<typename... Fields>
+struct RowDecoder {
+    /// Bytes the fixed part of the row occupies
+    static constexpr size_t kSize = std::max({size_t{0}, Fields::kEnd...});
+
+    template<typename Row, typename Strings>
+    static bool decode(const RowBytes& bytes, Row& row, Strings& strings) {
+        if (bytes.size < kSize) return false;
+        decode_unchecked(bytes, row, strings);
+        return true;
+    }
+
+    /// decode() for rows already known to hold kSize bytes
+    template<typename Row, typename Strings>
+    static void decode_unchecked(const RowBytes& bytes, Row& row, Strings& strings) {
+        (Fields::decode(bytes, row, strings), ...);
+    }
+};
+
+/// Rows whose subtype (the first u16) has Flag set use the larger Far layout, others Near
+template<uint16_t Flag, typename Near, typename Far>
+struct SubtypeVariant {
+    static_assert(Near::kSize >= sizeof(uint16_t) && Far::kSize >= Near::kSize,
+                  "Far rows extend near rows");
+    static constexpr size_t kSize = Near::kSize;
+
+    template<typename Row, typename Strings>
+    static bool decode(const RowBytes& bytes, Row& row, Strings& strings) {
+        if (bytes.size < Near::kSize) return false;
+        if ((load_le<uint16_t>(bytes.data) & Flag) != 0) return Far::decode(bytes, row, strings);
+        Near::decode_unchecked(bytes, row, strings);
+        return true;
+    }
+};
+
+// ============================================================================
+// Decode Targets (tables without a row view)
+// ============================================================================
+
+/// Playlist and history entry rows
+struct PlaylistEntryFields {
+    PlaylistId playlist_id;
+    TrackId track_id;
+    uint32_t entry_index{0};
+};
+
+/// Playlist tree rows
+struct PlaylistNodeFields {
+    PlaylistId parent_id;
+    uint32_t sort_order{0};
+    PlaylistId id;
+    bool is_folder{false};
+    std::string name;
+};
+
+/// History playlist rows
+struct HistoryPlaylistFields {
+    PlaylistId id;
+    std::string name;
+};
+
+/// Tag-track association rows (exportExt.pdb)
+struct TagTrackFields {
+    TagId tag_id;
+    TrackId track_id;
+};
+
+/**
+ * @brief Tag and category names
+ *
+ * The u8 at 0x1d is the name's offset from the row start. Subtype 0x0684
+ * rows store a u32 offset at that position instead, which is bounds
+ * checked separately since it can point anywhere in the row.
+ */
+struct TagName {
+    static constexpr size_t kEnd = 0x1e;
+
+    template<typename Strings>
+    static void decode(const RowBytes& bytes, TagRow& row, Strings& strings) {
+        size_t offset = bytes.data[0x1d];
+        if (load_le<uint16_t>(bytes.data) == 0x0684 && offset + sizeof(uint32_t) <= bytes.size) {
+            offset = load_le<uint32_t>(bytes.data + offset);
+        }
+        strings.read(bytes.base + offset, row.name);
+    }
+};
+
+// ============================================================================
+// Row Formats
+// ============================================================================
+
+/// Layout of the rows of a table, keyed by PageType or PageTypeExt
+template<auto Type>
+struct RowFormat;
+
+/// Track row string, by its index in the offset array at 0x5e
+template<auto Member, size_t Index>
+using TrackString = StringRef<Member, uint16_t, 0x5e + 2 * Index>;
+
+template<>
+struct RowFormat<PageType::Tracks> {
+    using Row = TrackRowView;
+    using Id = Column<&TrackRowView::id, uint32_t, 0x48>;
+    using Decoder = RowDecoder<
+        Column<&TrackRowView::sample_rate, uint32_t, 0x08>,
+        Column<&TrackRowView::composer_id, uint32_t, 0x0c>,
+        Column<&TrackRowView::file_size, uint32_t, 0x10>,
+        Column<&TrackRowView::artwork_id, uint32_t, 0x1c>,
+        Column<&TrackRowView::key_id, uint32_t, 0x20>,
+        Column<&TrackRowView::original_artist_id, uint32_t, 0x24>,
+        Column<&TrackRowView::label_id, uint32_t, 0x28>,
+        Column<&TrackRowView::remixer_id, uint32_t, 0x2c>,
+        Column<&TrackRowView::bitrate, uint32_t, 0x30>,
+        Column<&TrackRowView::track_number, uint32_t, 0x34>,
+        Column<&TrackRowView::bpm_100x, uint32_t, 0x38>,
+        Column<&TrackRowView::genre_id, uint32_t, 0x3c>,
+        Column<&TrackRowView::album_id, uint32_t, 0x40>,
+        Column<&TrackRowView::artist_id, uint32_t, 0x44>,
+        Id,
+        Column<&TrackRowView::disc_number, uint16_t, 0x4c>,
+        Column<&TrackRowView::play_count, uint16_t, 0x4e>,
+        Column<&TrackRowView::year, uint16_t, 0x50>,
+        Column<&TrackRowView::sample_depth, uint16_t, 0x52>,
+        Column<&TrackRowView::duration_seconds, uint16_t, 0x54>,
+        Column<&TrackRowView::color_id, uint8_t, 0x58>,
+        Column<&TrackRowView::rating, uint8_t, 0x59>,
+        TrackString<&TrackRowView::isrc, 0>,
+        TrackString<&TrackRowView::texter, 1>,
+        TrackString<&TrackRowView::message, 5>,
+        TrackString<&TrackRowView::kuvo_public, 6>,
+        TrackString<&TrackRowView::autoload_hot_cues, 7>,
+        TrackString<&TrackRowView::date_added, 10>,
+        TrackString<&TrackRowView::release_date, 11>,
+        TrackString<&TrackRowView::mix_name, 12>,
+        TrackString<&TrackRowView::analyze_path, 14>,
+        TrackString<&TrackRowView::analyze_date, 15>,
+        TrackString<&TrackRowView::comment, 16>,
+        TrackString<&TrackRowView::title, 17>,
+        TrackString<&TrackRowView::filename, 19>,
+        TrackString<&TrackRowView::file_path, 20>>;
+    static_assert(Decoder::kSize == sizeof(RawTrackRow), "Track layout covers the offset array");
+};
+
+template<>
+struct RowFormat<PageType::Artists> {
+    using Row = ArtistRowView;
+    using Decoder = SubtypeVariant<0x04,
+        RowDecoder<Column<&ArtistRowView::id, uint32_t, 0x04>,
+                   StringRef<&ArtistRowView::name, uint8_t, 0x09>>,
+        RowDecoder<Column<&ArtistRowView::id, uint32_t, 0x04>,
+                   StringRef<&ArtistRowView::name, uint16_t, 0x0a>>>;
+};
+
+template<>
+struct RowFormat<PageType::Albums> {
+    using Row = AlbumRowView;
+    using Decoder = SubtypeVariant<0x04,
+        RowDecoder<Column<&AlbumRowView::artist_id, uint32_t, 0x08>,
+                   Column<&AlbumRowView::id, uint32_t, 0x0c>,
+                   StringRef<&AlbumRowView::name, uint8_t, 0x15>>,
+        RowDecoder<Column<&AlbumRowView::artist_id, uint32_t, 0x08>,
+                   Column<&AlbumRowView::id, uint32_t, 0x0c>,
+                   StringRef<&AlbumRowView::name, uint16_t, 0x16>>>;
+};
+
+template<>
+struct RowFormat<PageType::Genres> {
+    using Row = GenreRowView;
+    using Decoder = RowDecoder<Column<&GenreRowView::id, uint32_t, 0x00>,
+                               InlineString<&GenreRowView::name, 0x04>>;
+};
+
+template<>
+struct RowFormat<PageType::Labels> {
+    using Row = LabelRowView;
+    using Decoder = RowDecoder<Column<&LabelRowView::id, uint32_t, 0x00>,
+                               InlineString<&LabelRowView::name, 0x04>>;
+};
+
+template<>
+struct RowFormat<PageType::Keys> {
+    using Row = KeyRowView;
+    using Decoder = RowDecoder<Column<&KeyRowView::id, uint32_t, 0x00>,
+                               InlineString<&KeyRowView::name, 0x08>>;
+};
+
+/// Five unknown bytes, then an unaligned u16 ID and one unknown byte
+template<>
+struct RowFormat<PageType::Colors> {
+    using Row = ColorRowView;
+    using Decoder = RowDecoder<Column<&ColorRowView::id, uint16_t, 0x05>,
+                               InlineString<&ColorRowView::name, 0x08>>;
+};
+
+template<>
+struct RowFormat<PageType::Artwork> {
+    using Row = ArtworkRowView;
+    using Decoder = RowDecoder<Column<&ArtworkRowView::id, uint32_t, 0x00>,
+                               InlineString<&ArtworkRowView::path, 0x04>>;
+};
+
+template<>
+struct RowFormat<PageType::PlaylistTree> {
+    using Row = PlaylistNodeFields;
+    using Decoder = RowDecoder<Column<&PlaylistNodeFields::parent_id, uint32_t, 0x00>,
+                               Column<&PlaylistNodeFields::sort_order, uint32_t, 0x08>,
+                               Column<&PlaylistNodeFields::id, uint32_t, 0x0c>,
+                               Column<&PlaylistNodeFields::is_folder, uint32_t, 0x10>,
+                               InlineString<&PlaylistNodeFields::name, 0x14>>;
+};
+
+template<>
+struct RowFormat<PageType::PlaylistEntries> {
+    using Row = PlaylistEntryFields;
+    using Decoder = RowDecoder<Column<&PlaylistEntryFields::entry_index, uint32_t, 0x00>,
+                               Column<&PlaylistEntryFields::track_id, uint32_t, 0x04>,
+                               Column<&PlaylistEntryFields::playlist_id, uint32_t, 0x08>>;
+};
+
+template<>
+struct RowFormat<PageType::HistoryPlaylists> {
+    using Row = HistoryPlaylistFields;
+    using Decoder = RowDecoder<Column<&HistoryPlaylistFields::id, uint32_t, 0x00>,
+                               InlineString<&HistoryPlaylistFields::name, 0x04>>;
+};
+
+template<>
+struct RowFormat<PageType::HistoryEntries> {
+    using Row = PlaylistEntryFields;
+    using Decoder = RowDecoder<Column<&PlaylistEntryFields::track_id, uint32_t, 0x00>,
+                               Column<&PlaylistEntryFields::playlist_id, uint32_t, 0x04>,
+                               Column<&PlaylistEntryFields::entry_index, uint32_t, 0x08>>;
+};
+
+template<>
+struct RowFormat<PageTypeExt::Tags> {
+    using Row = TagRow;
+    using Decoder = RowDecoder<Column<&TagRow::category_id, uint32_t, 0x0c>,
+                               Column<&TagRow::category_pos, uint32_t, 0x10>,
+                               Column<&TagRow::id, uint32_t, 0x14>,
+                               Column<&TagRow::is_category, uint32_t, 0x18>,
+                               TagName>;
+};
+
+template<>
+struct RowFormat<PageTypeExt::TagTracks> {
+    using Row = TagTrackFields;
+    using Decoder = RowDecoder<Column<&TagTrackFields::tag_id, uint32_t, 0x00>,
+                               Column<&TagTrackFields::track_id, uint32_t, 0x04>>;
+};
+
+/// Decode the row at bytes with its table's RowFormat (false if its fixed part is truncated)
+template<auto Type, typename Strings>
+inline bool decode_row(const RowBytes& bytes, typename RowFormat<Type>::Row& row, Strings& strings) {
+    return RowFormat<Type>::Decoder::decode(bytes, row, strings);
+}
+
+} // namespace cratedigger::detail
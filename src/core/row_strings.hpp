@@ -0,0 +1,52 @@
+#pragma once
+/**
+ * @file row_strings.hpp
+ * @brief Internal visitors over the string members of row views
+ *
+ * Row views borrow their strings from the PDB bytes, the string pool or a
+ * snapshot mapping. Code that moves rows between those backings (snapshots,
+ * incremental refresh) visits every string member through these helpers.
+ */
+
+#include "cratedigger/types.hpp"
+#include <cstddef>
+#include <string_view>
+
+namespace cratedigger {
+
+// String members of each row view, in declaration order
+
+template<typename F>
+void visit_strings(TrackRowView& row, F&& f) {
+    f(row.title);
+    f(row.file_path);
+    f(row.comment);
+    f(row.isrc);
+    f(row.texter);
+    f(row.message);
+    f(row.kuvo_public);
+    f(row.autoload_hot_cues);
+    f(row.date_added);
+    f(row.release_date);
+    f(row.mix_name);
+    f(row.analyze_path);
+    f(row.analyze_date);
+    f(row.filename);
+}
+
+template<typename Row, typename F>
+auto visit_strings(Row& row, F&& f) -> decltype(f(row.name)) { f(row.name); }
+
+template<typename F>
+void visit_strings(ArtworkRowView& row, F&& f) { f(row.path); }
+
+/// Number of strings visit_strings() yields per row
+template<typename Row>
+size_t strings_per_row() {
+    Row row{};
+    size_t count = 0;
+    visit_strings(row, [&count](std::string_view&) { ++count; });
+    return count;
+}
+
+} // namespace cratedigger
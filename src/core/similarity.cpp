@@ -0,0 +1,327 @@
+#include "cratedigger/similarity.hpp"
+#include "cratedigger/database.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <limits>
+#include <map>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define CRATEDIGGER_SIMILARITY_SSE2 1
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#define CRATEDIGGER_SIMILARITY_NEON 1
+#endif
+
+namespace cratedigger {
+
+namespace {
+
+constexpr float kInfinity = std::numeric_limits<float>::infinity();
+constexpr float kNaN = std::numeric_limits<float>::quiet_NaN();
+
+/// Unit differences of the weighted features
+const float kBpmUnit = std::log2(1.06f);  // 6% of tempo, in log2 BPM
+constexpr float kYearUnit = 10.0f;
+constexpr float kEnergyUnit = 0.25f;
+constexpr float kMoodUnit = 0.5f;
+
+/// Maximum preview waveform height
+constexpr float kMaxWaveformHeight = 31.0f;
+
+/// Encode a key for the key_ column (0 = unknown)
+uint8_t key_code(CamelotKey key) {
+    return key.valid() ? static_cast<uint8_t>((key.number - 1) * 2 + (key.major ? 1 : 0) + 1) : 0;
+}
+
+CamelotKey decode_key(uint8_t code) {
+    if (code == 0) return {};
+    return {static_cast<uint8_t>((code - 1) / 2 + 1), ((code - 1) % 2) != 0};
+}
+
+/// Parameters of one numeric feature: cost = weight * ((value - seed) / unit)^2, weight if either is NaN
+struct FeatureTerm {
+    const float* values;
+    float seed;
+    float inv_unit;
+    float weight;
+};
+
+/// Numeric pass of a query over [0, n): adds the bpm, year, energy and mood terms to cost
+struct NumericPass {
+    FeatureTerm bpm;
+    FeatureTerm terms[3];
+    bool fold_octaves{false};     // Half/double time: distance to the nearest octave of the seed
+    bool limit_bpm{false};        // Exclude candidates with |log2 BPM delta| > bpm_limit
+    float bpm_limit{kInfinity};
+
+    float scalar_term(const FeatureTerm& t, float d) const {
+        if (std::isnan(d)) return t.weight;
+        float x = d * t.inv_unit;
+        return t.weight * x * x;
+    }
+
+    void scalar(size_t i, float* cost) const {
+        float d = bpm.values[i] - bpm.seed;
+        if (fold_octaves) d -= std::nearbyint(d);
+        float c = cost[i] + scalar_term(bpm, d);
+        for (const auto& t : terms) c += scalar_term(t, t.values[i] - t.seed);
+        if (limit_bpm && !(std::fabs(d) <= bpm_limit)) c = kInfinity;
+        cost[i] = c;
+    }
+
+    void run(size_t n, float* cost) const {
+        size_t i = 0;
+#if defined(CRATEDIGGER_SIMILARITY_SSE2)
+        const __m128 sign = _mm_set1_ps(-0.0f);
+        const __m128 infinity = _mm_set1_ps(kInfinity);
+        const __m128 limit = _mm_set1_ps(bpm_limit);
+        auto term = [](const FeatureTerm& t, __m128 d) {
+            __m128 known = _mm_cmpord_ps(d, d);
+            __m128 x = _mm_mul_ps(d, _mm_set1_ps(t.inv_unit));
+            __m128 w = _mm_set1_ps(t.weight);
+            return _mm_or_ps(_mm_and_ps(known, _mm_mul_ps(w, _mm_mul_ps(x, x))), _mm_andnot_ps(known, w));
+        };
+        for (; i + 4 <= n; i += 4) {
+            __m128 d = _mm_sub_ps(_mm_loadu_ps(bpm.values + i), _mm_set1_ps(bpm.seed));
+            if (fold_octaves) d = _mm_sub_ps(d, _mm_cvtepi32_ps(_mm_cvtps_epi32(d)));  // Round to nearest
+            __m128 c = _mm_add_ps(_mm_loadu_ps(cost + i), term(bpm, d));
+            for (const auto& t : terms) {
+                c = _mm_add_ps(c, term(t, _mm_sub_ps(_mm_loadu_ps(t.values + i), _mm_set1_ps(t.seed))));
+            }
+            if (limit_bpm) {
+                __m128 ok = _mm_cmple_ps(_mm_andnot_ps(sign, d), limit);
+                c = _mm_or_ps(_mm_and_ps(ok, c), _mm_andnot_ps(ok, infinity));
+            }
+            _mm_storeu_ps(cost + i, c);
+        }
+#elif defined(CRATEDIGGER_SIMILARITY_NEON)
+        const float32x4_t infinity = vdupq_n_f32(kInfinity);
+        const float32x4_t limit = vdupq_n_f32(bpm_limit);
+        auto term = [](const FeatureTerm& t, float32x4_t d) {
+            uint32x4_t known = vceqq_f32(d, d);
+            float32x4_t x = vmulq_n_f32(d, t.inv_unit);
+            float32x4_t w = vdupq_n_f32(t.weight);
+            return vbslq_f32(known, vmulq_f32(w, vmulq_f32(x, x)), w);
+        };
+        for (; i + 4 <= n; i += 4) {
+            float32x4_t d = vsubq_f32(vld1q_f32(bpm.values + i), vdupq_n_f32(bpm.seed));
+            if (fold_octaves) d = vsubq_f32(d, vrndnq_f32(d));
+            float32x4_t c = vaddq_f32(vld1q_f32(cost + i), term(bpm, d));
+            for (const auto& t : terms) {
+                c = vaddq_f32(c, term(t, vsubq_f32(vld1q_f32(t.values + i), vdupq_n_f32(t.seed))));
+            }
+            if (limit_bpm) c = vbslq_f32(vcleq_f32(vabsq_f32(d), limit), c, infinity);
+            vst1q_f32(cost + i, c);
+        }
+#endif
+        for (; i < n; ++i) {
+            scalar(i, cost);
+        }
+    }
+};
+
+/// Mean preview height in [0, 1], or NaN without a preview waveform
+float waveform_energy(const TrackWaveforms& waveforms) {
+    const WaveformData* waveform = waveforms.preview ? &*waveforms.preview
+                                 : waveforms.color_preview ? &*waveforms.color_preview : nullptr;
+    if (!waveform || waveform->size() == 0) return kNaN;
+    uint64_t total = 0;
+    for (size_t i = 0; i < waveform->size(); ++i) total += waveform->height_at(i);
+    return static_cast<float>(total) / (static_cast<float>(waveform->size()) * kMaxWaveformHeight);
+}
+
+float mood_level(const SongStructure& structure) {
+    if (structure.empty()) return kNaN;
+    switch (structure.mood) {
+        case TrackMood::High: return 1.0f;
+        case TrackMood::Mid: return 0.5f;
+        case TrackMood::Low: return 0.0f;
+    }
+    return kNaN;
+}
+
+} // anonymous namespace
+
+// ============================================================================
+// Camelot Keys
+// ============================================================================
+
+CamelotKey camelot_key(std::string_view name) {
+    if (name.empty()) return {};
+
+    // Camelot code: 1A-12B
+    if (std::isdigit(static_cast<unsigned char>(name[0]))) {
+        size_t i = 0;
+        unsigned number = 0;
+        while (i < name.size() && i < 2 && std::isdigit(static_cast<unsigned char>(name[i]))) {
+            number = number * 10 + static_cast<unsigned>(name[i++] - '0');
+        }
+        if (number < 1 || number > 12 || i + 1 != name.size()) return {};
+        char letter = static_cast<char>(std::toupper(static_cast<unsigned char>(name[i])));
+        if (letter != 'A' && letter != 'B') return {};
+        return {static_cast<uint8_t>(number), letter == 'B'};
+    }
+
+    // Musical name: root, accidental, then "m"/"min"/"minor" or nothing/"maj"/"major"
+    static constexpr int kPitchClass[7] = {9, 11, 0, 2, 4, 5, 7};  // A-G
+    char root = static_cast<char>(std::toupper(static_cast<unsigned char>(name[0])));
+    if (root < 'A' || root > 'G') return {};
+    int pitch = kPitchClass[root - 'A'];
+    std::string_view rest = name.substr(1);
+    if (!rest.empty() && rest[0] == '#') {
+        ++pitch;
+        rest.remove_prefix(1);
+    } else if (!rest.empty() && rest[0] == 'b') {
+        --pitch;
+        rest.remove_prefix(1);
+    } else if (rest.size() >= 3 && (rest.substr(0, 3) == "\xE2\x99\xAF" || rest.substr(0, 3) == "\xE2\x99\xAD")) {
+        pitch += rest[2] == '\xAF' ? 1 : -1;  // U+266F sharp, U+266D flat
+        rest.remove_prefix(3);
+    }
+    pitch = (pitch + 12) % 12;
+
+    bool major;
+    if (rest.empty() || rest == "maj" || rest == "major") {
+        major = true;
+    } else if (rest == "m" || rest == "min" || rest == "minor") {
+        major = false;
+    } else {
+        return {};
+    }
+    // Fifths around the wheel: C is 8B, A minor 8A
+    int number = (pitch * 7 + (major ? 7 : 4)) % 12 + 1;
+    return {static_cast<uint8_t>(number), major};
+}
+
+uint8_t camelot_distance(CamelotKey a, CamelotKey b) {
+    if (!a.valid() || !b.valid()) return 0xFF;
+    int steps = std::abs(int(a.number) - int(b.number));
+    steps = std::min(steps, 12 - steps);
+    return static_cast<uint8_t>(steps + (a.major != b.major ? 1 : 0));
+}
+
+// ============================================================================
+// SimilarityIndex
+// ============================================================================
+
+SimilarityIndex::SimilarityIndex(const Database& db, bool use_analysis) {
+    size_t n = db.track_count();
+    track_id_.reserve(n);
+    log_bpm_.reserve(n);
+    year_.reserve(n);
+    energy_.reserve(n);
+    mood_.reserve(n);
+    key_.reserve(n);
+    genre_.reserve(n);
+
+    std::map<int64_t, uint8_t> key_codes;  // A library uses a few dozen key rows
+    db.for_each_track([&](const TrackRowView& track) {
+        track_id_.push_back(track.id.value);
+        log_bpm_.push_back(track.bpm_100x != 0 ? std::log2(track.bpm_100x / 100.0f) : kNaN);
+        year_.push_back(track.year != 0 ? static_cast<float>(track.year) : kNaN);
+
+        auto code = key_codes.find(track.key_id.value);
+        if (code == key_codes.end()) {
+            const KeyRowView* key = db.get_key_view(track.key_id);
+            code = key_codes.emplace(track.key_id.value, key ? key_code(camelot_key(key->name)) : 0).first;
+        }
+        key_.push_back(code->second);
+        genre_.push_back(static_cast<int32_t>(track.genre_id.value));
+
+        float energy = kNaN;
+        float mood = kNaN;
+        if (use_analysis) {
+            if (auto analysis = db.get_analysis_for_track(track.id)) {
+                energy = waveform_energy(analysis->waveforms);
+                mood = mood_level(analysis->song_structure);
+            }
+        }
+        energy_.push_back(energy);
+        mood_.push_back(mood);
+    });
+}
+
+size_t SimilarityIndex::position(TrackId id) const {
+    auto it = std::lower_bound(track_id_.begin(), track_id_.end(), id.value);
+    if (it == track_id_.end() || *it != id.value) return size();
+    return static_cast<size_t>(it - track_id_.begin());
+}
+
+TrackFeatures SimilarityIndex::features(TrackId id) const {
+    TrackFeatures f;
+    size_t i = position(id);
+    if (i == size()) return f;
+    f.id = id;
+    f.bpm = std::isnan(log_bpm_[i]) ? 0.0f : std::exp2(log_bpm_[i]);
+    f.key = decode_key(key_[i]);
+    f.genre_id = GenreId{genre_[i]};
+    f.year = std::isnan(year_[i]) ? 0 : static_cast<uint16_t>(year_[i]);
+    f.energy = std::isnan(energy_[i]) ? -1.0f : energy_[i];
+    f.mood = std::isnan(mood_[i]) ? -1.0f : mood_[i];
+    return f;
+}
+
+std::vector<SimilarityHit> SimilarityIndex::nearest(TrackId seed, const SimilarityQuery& query) const {
+    size_t s = position(seed);
+    if (s == size() || query.limit == 0) return {};
+    const auto& w = query.weights;
+    const size_t n = size();
+
+    // Categorical pass: key cost per code, then genre
+    CamelotKey seed_key = decode_key(key_[s]);
+    bool limit_key = query.max_key_distance != SimilarityQuery::kAnyKey && seed_key.valid();
+    float key_cost[25];
+    for (uint8_t code = 0; code < 25; ++code) {
+        uint8_t d = camelot_distance(seed_key, decode_key(code));
+        if (d == 0xFF) {
+            key_cost[code] = limit_key ? kInfinity : w.key;
+        } else {
+            key_cost[code] = limit_key && d > query.max_key_distance ? kInfinity : w.key * float(d) * float(d);
+        }
+    }
+    int32_t seed_genre = genre_[s];
+    float other_genre = query.same_genre ? kInfinity : w.genre;
+    std::vector<float> cost(n);
+    for (size_t i = 0; i < n; ++i) {
+        bool same = genre_[i] == seed_genre;
+        cost[i] = key_cost[key_[i]] + (same ? (seed_genre != 0 ? 0.0f : w.genre) : other_genre);
+    }
+
+    // Numeric pass
+    NumericPass pass;
+    pass.bpm = {log_bpm_.data(), log_bpm_[s], 1.0f / kBpmUnit, w.bpm};
+    pass.terms[0] = {year_.data(), year_[s], 1.0f / kYearUnit, w.year};
+    pass.terms[1] = {energy_.data(), energy_[s], 1.0f / kEnergyUnit, w.energy};
+    pass.terms[2] = {mood_.data(), mood_[s], 1.0f / kMoodUnit, w.mood};
+    pass.fold_octaves = query.half_double_time;
+    pass.limit_bpm = query.bpm_tolerance > 0.0f && !std::isnan(log_bpm_[s]);
+    if (pass.limit_bpm) pass.bpm_limit = std::log2(1.0f + query.bpm_tolerance);
+    pass.run(n, cost.data());
+
+    // Bounded max-heap of the best (cost, position) pairs; positions follow ID order
+    using Entry = std::pair<float, size_t>;
+    std::vector<Entry> heap;
+    heap.reserve(std::min(query.limit, n) + 1);
+    for (size_t i = 0; i < n; ++i) {
+        if (i == s || !(cost[i] < kInfinity)) continue;
+        Entry entry{cost[i], i};
+        if (heap.size() < query.limit) {
+            heap.push_back(entry);
+            std::push_heap(heap.begin(), heap.end());
+        } else if (entry < heap.front()) {
+            std::pop_heap(heap.begin(), heap.end());
+            heap.back() = entry;
+            std::push_heap(heap.begin(), heap.end());
+        }
+    }
+    std::sort_heap(heap.begin(), heap.end());
+
+    std::vector<SimilarityHit> hits;
+    hits.reserve(heap.size());
+    for (const auto& [distance, i] : heap) hits.push_back({TrackId{track_id_[i]}, distance});
+    return hits;
+}
+
+} // namespace cratedigger
@@ -0,0 +1,215 @@
+#include "snapshot.hpp"
+#include "cratedigger/logging.hpp"
+#include <cstdio>
+#include <fstream>
+
+namespace cratedigger {
+
+namespace {
+
+constexpr char kSnapshotMagic[8] = {'C', 'D', 'S', 'N', 'A', 'P', '\0', '\0'};
+
+/// Fixed-size file header (followed by the blob, then the payload)
+struct SnapshotHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t kind;
+    uint64_t layout;
+    SnapshotKey key;
+    uint64_t blob_size;     // Padded to 8 bytes in the file
+    uint64_t payload_size;
+};
+
+constexpr uint64_t kPrime1 = 0x9E3779B185EBCA87ull;
+constexpr uint64_t kPrime2 = 0xC2B2AE3D27D4EB4Full;
+constexpr uint64_t kPrime3 = 0x165667B19E3779F9ull;
+
+inline uint64_t rotl(uint64_t x, int r) {
+    return (x << r) | (x >> (64 - r));
+}
+
+inline uint64_t load_u64(const uint8_t* p) {
+    uint64_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+inline uint64_t mix_lane(uint64_t lane, uint64_t word) {
+    return rotl(lane + word * kPrime2, 31) * kPrime1;
+}
+
+} // anonymous namespace
+
+// ============================================================================
+// Hashing and Keys
+// ============================================================================
+
+uint64_t hash_bytes(const void* data, size_t size, uint64_t seed) {
+    // Four independent lanes over 32-byte blocks keep the multiplier busy
+    const auto* p = static_cast<const uint8_t*>(data);
+    const uint8_t* end = p + size;
+    uint64_t lanes[4] = {seed + kPrime1 + kPrime2, seed + kPrime2, seed, seed - kPrime1};
+
+    for (; end - p >= 32; p += 32) {
+        lanes[0] = mix_lane(lanes[0], load_u64(p));
+        lanes[1] = mix_lane(lanes[1], load_u64(p + 8));
+        lanes[2] = mix_lane(lanes[2], load_u64(p + 16));
+        lanes[3] = mix_lane(lanes[3], load_u64(p + 24));
+    }
+
+    uint64_t h = rotl(lanes[0], 1) + rotl(lanes[1], 7) + rotl(lanes[2], 12) + rotl(lanes[3], 18);
+    h += static_cast<uint64_t>(size);
+    for (; end - p >= 8; p += 8) {
+        h = rotl(h ^ mix_lane(0, load_u64(p)), 27) * kPrime1 + kPrime3;
+    }
+    for (; p < end; ++p) {
+        h = rotl(h ^ (*p * kPrime3), 11) * kPrime1;
+    }
+
+    h ^= h >> 33;
+    h *= kPrime2;
+    h ^= h >> 29;
+    h *= kPrime3;
+    h ^= h >> 32;
+    return h;
+}
+
+Result<SnapshotKey> snapshot_key(const std::filesystem::path& source, const uint8_t* data, size_t size) {
+    std::error_code ec;
+    auto mtime = std::filesystem::last_write_time(source, ec);
+    if (ec) {
+        return make_error(ErrorCode::IoError, "Cannot stat " + source.string() + ": " + ec.message());
+    }
+
+    SnapshotKey key;
+    key.size = size;
+    key.mtime = static_cast<int64_t>(mtime.time_since_epoch().count());
+    key.content_hash = hash_bytes(data, size);
+    return key;
+}
+
+std::filesystem::path snapshot_path(const std::filesystem::path& dir, const std::filesystem::path& source,
+                                    SnapshotKind kind) {
+    std::error_code ec;
+    auto absolute = std::filesystem::weakly_canonical(source, ec);
+    std::string name = (ec ? source : absolute).generic_string();
+
+    char file_name[32];
+    std::snprintf(file_name, sizeof(file_name), "%016llx.%u.snap",
+                  static_cast<unsigned long long>(hash_bytes(name.data(), name.size())),
+                  static_cast<unsigned>(kind));
+    return dir / file_name;
+}
+
+// ============================================================================
+// Writer
+// ============================================================================
+
+void SnapshotWriter::append(const void* data, size_t size) {
+    size_t offset = payload_.size();
+    payload_.resize(offset + snapshot_padded(size), 0);
+    if (size != 0) std::memcpy(payload_.data() + offset, data, size);
+}
+
+SnapshotStringRef SnapshotWriter::ref(std::string_view s) {
+    if (s.empty()) return {};
+
+    const auto* bytes = reinterpret_cast<const uint8_t*>(s.data());
+    if (source_ != nullptr && bytes >= source_ && bytes + s.size() <= source_ + source_size_) {
+        return {static_cast<uint32_t>(bytes - source_), static_cast<uint32_t>(s.size())};
+    }
+
+    // Pooled strings are shared between rows; store each one once
+    auto it = blob_refs_.find(s.data());
+    if (it != blob_refs_.end() && it->second.size == s.size()) return it->second;
+
+    SnapshotStringRef ref{static_cast<uint32_t>(blob_.size()) | SnapshotStringRef::kBlobBit,
+                          static_cast<uint32_t>(s.size())};
+    blob_.append(s);
+    blob_refs_[s.data()] = ref;
+    return ref;
+}
+
+bool SnapshotWriter::commit(const std::filesystem::path& path, SnapshotKind kind,
+                            const SnapshotKey& key, uint64_t layout) const {
+    std::string blob = blob_;
+    blob.resize(snapshot_padded(blob.size()), '\0');
+
+    SnapshotHeader header{};
+    std::memcpy(header.magic, kSnapshotMagic, sizeof(kSnapshotMagic));
+    header.version = kSnapshotVersion;
+    header.kind = static_cast<uint32_t>(kind);
+    header.layout = layout;
+    header.key = key;
+    header.blob_size = blob_.size();
+    header.payload_size = payload_.size();
+
+    std::error_code ec;
+    std::filesystem::create_directories(path.parent_path(), ec);
+
+    // Readers only ever see a complete file: write aside, then rename over
+    auto tmp_path = path;
+    tmp_path += ".tmp";
+    {
+        std::ofstream file(tmp_path, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(blob.data(), static_cast<std::streamsize>(blob.size()));
+        file.write(reinterpret_cast<const char*>(payload_.data()), static_cast<std::streamsize>(payload_.size()));
+        if (!file) {
+            LOG_WARN("Cannot write snapshot: " + tmp_path.string());
+            std::filesystem::remove(tmp_path, ec);
+            return false;
+        }
+    }
+    std::filesystem::rename(tmp_path, path, ec);
+    if (ec) {
+        LOG_WARN("Cannot replace snapshot " + path.string() + ": " + ec.message());
+        std::filesystem::remove(tmp_path, ec);
+        return false;
+    }
+    return true;
+}
+
+// ============================================================================
+// Snapshot File
+// ============================================================================
+
+Result<SnapshotFile> SnapshotFile::open(const std::filesystem::path& path, SnapshotKind kind,
+                                        const SnapshotKey& key, uint64_t layout) {
+    auto buffer = FileBuffer::open(path, IoMode::MemoryMapped);
+    if (!buffer) {
+        return buffer.error();
+    }
+
+    SnapshotHeader header;
+    if (buffer->size() < sizeof(header)) {
+        return make_error(ErrorCode::InvalidFileFormat, "Snapshot too small: " + path.string());
+    }
+    std::memcpy(&header, buffer->data(), sizeof(header));
+
+    if (std::memcmp(header.magic, kSnapshotMagic, sizeof(kSnapshotMagic)) != 0 ||
+        header.version != kSnapshotVersion || header.kind != static_cast<uint32_t>(kind) ||
+        header.layout != layout) {
+        return make_error(ErrorCode::InvalidFileFormat, "Snapshot format mismatch: " + path.string());
+    }
+    if (!(header.key == key)) {
+        return make_error(ErrorCode::InvalidParameter, "Snapshot is stale: " + path.string());
+    }
+
+    size_t available = buffer->size() - sizeof(header);
+    if (header.blob_size > available || header.payload_size > available - snapshot_padded(header.blob_size) ||
+        snapshot_padded(header.blob_size) + header.payload_size != available) {
+        return make_error(ErrorCode::CorruptedData, "Snapshot truncated: " + path.string());
+    }
+
+    SnapshotFile file;
+    file.blob_offset_ = sizeof(header);
+    file.blob_size_ = static_cast<size_t>(header.blob_size);
+    file.payload_offset_ = sizeof(header) + snapshot_padded(file.blob_size_);
+    file.payload_size_ = static_cast<size_t>(header.payload_size);
+
+    file.buffer_ = std::move(*buffer);
+    return file;
+}
+
+} // namespace cratedigger
@@ -0,0 +1,280 @@
+#pragma once
+/**
+ * @file snapshot.hpp
+ * @brief Internal on-disk snapshot format for built indices
+ *
+ * A snapshot file is a fixed header, a string blob and a payload of
+ * 8-byte-aligned records: plain values and length-prefixed arrays of
+ * trivially copyable elements, so loading an array is one bounds check and
+ * one memcpy. Strings that borrow the source file's bytes are stored as
+ * (offset, size) references into that file; other strings go to the blob,
+ * which stays mapped for as long as the SnapshotFile is alive.
+ *
+ * The header records the source's size, mtime and content hash plus a
+ * layout hash of the serialized structs; a snapshot that disagrees with the
+ * current source or build is rejected and the caller parses from scratch.
+ * Files are replaced by rename, so a reader never sees a partial write, and
+ * every read is bounds-checked, so a damaged file fails to load instead of
+ * reading out of range.
+ */
+
+#include "cratedigger/file_buffer.hpp"
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace cratedigger {
+
+/// Bump whenever the payload of any snapshot kind changes
+constexpr uint32_t kSnapshotVersion = 2;
+
+/// What a snapshot was built from
+enum class SnapshotKind : uint32_t {
+    Pdb = 1,     // export.pdb indices
+    PdbExt = 2,  // exportExt.pdb indices
+    Anlz = 3     // Parsed ANLZ directory
+};
+
+/// Identity of the source a snapshot was built from
+struct SnapshotKey {
+    uint64_t size{0};          // Bytes
+    int64_t mtime{0};          // last_write_time ticks
+    uint64_t content_hash{0};
+
+    bool operator==(const SnapshotKey& other) const {
+        return size == other.size && mtime == other.mtime && content_hash == other.content_hash;
+    }
+};
+
+/// A string in the source bytes, or in the blob when kBlobBit is set
+struct SnapshotStringRef {
+    static constexpr uint32_t kBlobBit = 0x80000000u;
+
+    uint32_t offset{0};
+    uint32_t size{0};
+};
+
+/// Records are padded to 8 bytes so every array starts aligned
+constexpr size_t snapshot_padded(size_t size) {
+    return (size + 7) & ~size_t{7};
+}
+
+/// Fast 64-bit hash of a byte range (not cryptographic)
+[[nodiscard]] uint64_t hash_bytes(const void* data, size_t size, uint64_t seed = 0);
+
+/// Key of a source file whose contents are already in memory
+[[nodiscard]] Result<SnapshotKey> snapshot_key(const std::filesystem::path& source,
+                                               const uint8_t* data, size_t size);
+
+/// Snapshot file for a source inside a snapshot directory
+[[nodiscard]] std::filesystem::path snapshot_path(const std::filesystem::path& dir,
+                                                  const std::filesystem::path& source,
+                                                  SnapshotKind kind);
+
+// ============================================================================
+// Writer
+// ============================================================================
+
+/**
+ * @brief Serializes values into a snapshot payload
+ *
+ * Strings passed to ref() that lie inside the source range are written as
+ * offsets; anything else is copied into the blob once per distinct pointer.
+ */
+class SnapshotWriter {
+public:
+    SnapshotWriter(const uint8_t* source, size_t source_size)
+        : source_(source), source_size_(source_size) {}
+
+    template<typename T>
+    void value(const T& v) {
+        static_assert(std::is_trivially_copyable_v<T>, "snapshot values must be trivially copyable");
+        append(&v, sizeof(T));
+    }
+
+    template<typename T>
+    void array(const T* data, size_t count) {
+        static_assert(std::is_trivially_copyable_v<T>, "snapshot arrays must be trivially copyable");
+        value(static_cast<uint64_t>(count));
+        append(data, count * sizeof(T));
+    }
+
+    template<typename T>
+    void array(const std::vector<T>& v) { array(v.data(), v.size()); }
+
+    /// Array of project(element) for each element of v, written in place
+    template<typename T, typename Project>
+    void array(const std::vector<T>& v, Project project) {
+        using U = std::decay_t<decltype(project(std::declval<const T&>()))>;
+        static_assert(std::is_trivially_copyable_v<U>, "snapshot arrays must be trivially copyable");
+        value(static_cast<uint64_t>(v.size()));
+        size_t offset = payload_.size();
+        payload_.resize(offset + snapshot_padded(v.size() * sizeof(U)), 0);
+        for (size_t i = 0; i < v.size(); ++i) {
+            U element = project(v[i]);
+            std::memcpy(payload_.data() + offset + i * sizeof(U), &element, sizeof(U));
+        }
+    }
+
+    /// Owned string (copied into the payload)
+    void string(std::string_view s) { array(s.data(), s.size()); }
+
+    /// Borrowed string (resolved against the source or the blob on load)
+    [[nodiscard]] SnapshotStringRef ref(std::string_view s);
+
+    /// Write header, blob and payload to path via a temporary file and rename
+    [[nodiscard]] bool commit(const std::filesystem::path& path, SnapshotKind kind,
+                              const SnapshotKey& key, uint64_t layout) const;
+
+private:
+    void append(const void* data, size_t size);
+
+    const uint8_t* source_;
+    size_t source_size_;
+    std::vector<uint8_t> payload_;
+    std::string blob_;
+    std::unordered_map<const char*, SnapshotStringRef> blob_refs_;
+};
+
+// ============================================================================
+// Reader
+// ============================================================================
+
+/**
+ * @brief Deserializes a snapshot payload written by SnapshotWriter
+ *
+ * Every read is bounds-checked. After the first failure all reads are
+ * no-ops that leave their outputs empty, so callers read a whole section
+ * and check ok() once.
+ */
+class SnapshotReader {
+public:
+    SnapshotReader(const uint8_t* payload, size_t payload_size, std::string_view blob,
+                   const uint8_t* source, size_t source_size)
+        : cursor_(payload), end_(payload + payload_size), blob_(blob)
+        , source_(source), source_size_(source_size) {}
+
+    template<typename T>
+    void value(T& v) {
+        static_assert(std::is_trivially_copyable_v<T>, "snapshot values must be trivially copyable");
+        if (const uint8_t* bytes = take(sizeof(T))) std::memcpy(&v, bytes, sizeof(T));
+    }
+
+    /// Element count of the next array (0 after a failure or if it cannot fit)
+    [[nodiscard]] size_t count(size_t element_size) {
+        uint64_t n = 0;
+        value(n);
+        if (element_size != 0 && n > static_cast<uint64_t>(end_ - cursor_) / element_size) {
+            fail();
+            return 0;
+        }
+        return static_cast<size_t>(n);
+    }
+
+    template<typename T>
+    void array(std::vector<T>& v) {
+        static_assert(std::is_trivially_copyable_v<T>, "snapshot arrays must be trivially copyable");
+        size_t n = count(sizeof(T));
+        v.resize(n);
+        if (n == 0) return;
+        if (const uint8_t* bytes = take(n * sizeof(T))) std::memcpy(v.data(), bytes, n * sizeof(T));
+    }
+
+    /// Start of the next array of T in place (nullptr if empty or after a failure); copy elements out with memcpy
+    template<typename T>
+    [[nodiscard]] const uint8_t* array_bytes(size_t& n) {
+        static_assert(std::is_trivially_copyable_v<T>, "snapshot arrays must be trivially copyable");
+        n = count(sizeof(T));
+        const uint8_t* bytes = n == 0 ? nullptr : take(n * sizeof(T));
+        if (bytes == nullptr) n = 0;
+        return bytes;
+    }
+
+    void string(std::string& s) {
+        size_t n = count(1);
+        s.clear();
+        if (n == 0) return;
+        if (const uint8_t* bytes = take(n)) s.assign(reinterpret_cast<const char*>(bytes), n);
+    }
+
+    /// Resolve a borrowed string (empty and failed if out of range)
+    [[nodiscard]] std::string_view resolve(SnapshotStringRef ref) {
+        if (ref.size == 0) return {};
+        size_t offset = ref.offset & ~SnapshotStringRef::kBlobBit;
+        std::string_view base = (ref.offset & SnapshotStringRef::kBlobBit) != 0
+            ? blob_ : std::string_view(reinterpret_cast<const char*>(source_), source_size_);
+        if (offset > base.size() || ref.size > base.size() - offset) {
+            fail();
+            return {};
+        }
+        return base.substr(offset, ref.size);
+    }
+
+    /// Mark the payload as corrupt
+    void fail() { failed_ = true; cursor_ = end_; }
+
+    [[nodiscard]] bool ok() const { return !failed_; }
+
+    /// Check that the whole payload was consumed without errors
+    [[nodiscard]] bool finished() const { return !failed_ && cursor_ == end_; }
+
+private:
+    /// Consume size bytes plus padding (nullptr past the end)
+    const uint8_t* take(size_t size) {
+        if (failed_ || snapshot_padded(size) > static_cast<size_t>(end_ - cursor_)) {
+            fail();
+            return nullptr;
+        }
+        const uint8_t* bytes = cursor_;
+        cursor_ += snapshot_padded(size);
+        return bytes;
+    }
+
+    const uint8_t* cursor_;
+    const uint8_t* end_;
+    std::string_view blob_;
+    const uint8_t* source_;
+    size_t source_size_;
+    bool failed_{false};
+};
+
+// ============================================================================
+// Snapshot File
+// ============================================================================
+
+/// A memory-mapped snapshot whose header matched the expected source
+class SnapshotFile {
+public:
+    /// Map a snapshot and check its kind, key and layout
+    [[nodiscard]] static Result<SnapshotFile> open(const std::filesystem::path& path, SnapshotKind kind,
+                                                   const SnapshotKey& key, uint64_t layout);
+
+    SnapshotFile() = default;
+
+    /// Reader over the payload; borrowed strings resolve against source
+    [[nodiscard]] SnapshotReader reader(const uint8_t* source, size_t source_size) const {
+        return SnapshotReader(buffer_.data() + payload_offset_, payload_size_,
+                              std::string_view(reinterpret_cast<const char*>(buffer_.data()) + blob_offset_, blob_size_),
+                              source, source_size);
+    }
+
+    [[nodiscard]] bool empty() const { return buffer_.empty(); }
+
+    /// Drop the mapping (invalidates blob strings)
+    void reset() { buffer_.reset(); }
+
+private:
+    FileBuffer buffer_;
+    size_t blob_offset_{0};
+    size_t blob_size_{0};
+    size_t payload_offset_{0};
+    size_t payload_size_{0};
+};
+
+} // namespace cratedigger
@@ -0,0 +1,28 @@
+#pragma once
+/**
+ * @file stopwatch.hpp
+ * @brief Internal monotonic timer for the metrics counters
+ */
+
+#include <chrono>
+#include <cstdint>
+
+namespace cratedigger::detail {
+
+/// Measures wall time since construction (or the last restart)
+class Stopwatch {
+public:
+    Stopwatch() : start_(std::chrono::steady_clock::now()) {}
+
+    void restart() { start_ = std::chrono::steady_clock::now(); }
+
+    [[nodiscard]] uint64_t elapsed_ns() const {
+        auto elapsed = std::chrono::steady_clock::now() - start_;
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+    }
+
+private:
+    std::chrono::steady_clock::time_point start_;
+};
+
+} // namespace cratedigger::detail
@@ -0,0 +1,99 @@
+#pragma once
+/**
+ * @file string_pool.hpp
+ * @brief Internal arena-backed, deduplicating string pool
+ *
+ * Strings are copied once into large arena chunks and looked up through an
+ * open-addressing hash table, so interning N strings costs a handful of
+ * chunk allocations instead of N heap blocks. Views returned by intern()
+ * stay valid for the lifetime of the pool.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <vector>
+
+namespace cratedigger {
+
+class StringPool {
+public:
+    StringPool() = default;
+    StringPool(const StringPool&) = delete;
+    StringPool& operator=(const StringPool&) = delete;
+
+    /// Return a pooled view equal to s (thread-safe)
+    std::string_view intern(std::string_view s) {
+        if (s.empty()) return {};
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        if ((count_ + 1) * 4 > slots_.size() * 3) grow();
+
+        size_t mask = slots_.size() - 1;
+        for (size_t i = std::hash<std::string_view>{}(s) & mask;; i = (i + 1) & mask) {
+            if (slots_[i].data() == nullptr) {
+                slots_[i] = store(s);
+                ++count_;
+                return slots_[i];
+            }
+            if (slots_[i] == s) return slots_[i];
+        }
+    }
+
+    /// Number of distinct strings
+    [[nodiscard]] size_t size() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return count_;
+    }
+
+    /// Bytes of string data held in the arena
+    [[nodiscard]] size_t bytes() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return bytes_;
+    }
+
+private:
+    static constexpr size_t kChunkSize = 64 * 1024;
+
+    /// Copy s into the arena
+    std::string_view store(std::string_view s) {
+        if (s.size() > chunk_capacity_ - chunk_used_) {
+            size_t capacity = s.size() > kChunkSize ? s.size() : kChunkSize;
+            chunks_.emplace_back(new char[capacity]);
+            chunk_capacity_ = capacity;
+            chunk_used_ = 0;
+        }
+        char* dest = chunks_.back().get() + chunk_used_;
+        std::memcpy(dest, s.data(), s.size());
+        chunk_used_ += s.size();
+        bytes_ += s.size();
+        return std::string_view(dest, s.size());
+    }
+
+    /// Double the hash table (power-of-two size)
+    void grow() {
+        std::vector<std::string_view> old = std::move(slots_);
+        slots_.assign(old.empty() ? 1024 : old.size() * 2, std::string_view{});
+        size_t mask = slots_.size() - 1;
+        for (const auto& s : old) {
+            if (s.data() == nullptr) continue;
+            size_t i = std::hash<std::string_view>{}(s) & mask;
+            while (slots_[i].data() != nullptr) i = (i + 1) & mask;
+            slots_[i] = s;
+        }
+    }
+
+    mutable std::mutex mutex_;
+    std::vector<std::unique_ptr<char[]>> chunks_;
+    size_t chunk_used_{0};
+    size_t chunk_capacity_{0};
+    std::vector<std::string_view> slots_;  // data() == nullptr marks an empty slot
+    size_t count_{0};
+    size_t bytes_{0};
+};
+
+} // namespace cratedigger
@@ -0,0 +1,241 @@
+#include "cratedigger/tag_query.hpp"
+#include "cratedigger/database.hpp"
+#include <cctype>
+
+namespace cratedigger {
+
+TagQuery TagQuery::tag(TagId id) {
+    TagQuery query;
+    query.terms_.push_back({Op::Tag, id});
+    return query;
+}
+
+TagQuery TagQuery::category(TagId id) {
+    TagQuery query;
+    query.terms_.push_back({Op::Category, id});
+    return query;
+}
+
+void TagQuery::append(const TagQuery& other) {
+    if (other.terms_.empty()) {
+        terms_.push_back({Op::All, TagId{}});
+        return;
+    }
+    terms_.insert(terms_.end(), other.terms_.begin(), other.terms_.end());
+}
+
+TagQuery TagQuery::operator&(const TagQuery& other) const {
+    TagQuery query;
+    query.terms_.reserve(terms_.size() + other.terms_.size() + 1);
+    query.append(*this);
+    query.append(other);
+    query.terms_.push_back({Op::And, TagId{}});
+    return query;
+}
+
+TagQuery TagQuery::operator|(const TagQuery& other) const {
+    TagQuery query;
+    query.terms_.reserve(terms_.size() + other.terms_.size() + 1);
+    query.append(*this);
+    query.append(other);
+    query.terms_.push_back({Op::Or, TagId{}});
+    return query;
+}
+
+TagQuery TagQuery::operator!() const {
+    TagQuery query;
+    query.terms_.reserve(terms_.size() + 1);
+    query.append(*this);
+    query.terms_.push_back({Op::Not, TagId{}});
+    return query;
+}
+
+// ============================================================================
+// Parser
+// ============================================================================
+
+namespace {
+
+enum class TokenKind : uint8_t { Name, And, Or, Not, Open, Close, End };
+
+struct Token {
+    TokenKind kind{TokenKind::End};
+    std::string text;  // Name only
+};
+
+/// Recursive descent over: or := and (OR and)*, and := unary (AND unary)*, unary := NOT unary | ( or ) | name
+/// (unary nesting is capped at kMaxDepth)
+class QueryParser {
+public:
+    QueryParser(std::string_view text, const Database& ext) : text_(text), ext_(ext) {}
+
+    Result<TagQuery> parse() {
+        auto error = next();
+        if (!error.empty()) return make_error(ErrorCode::InvalidParameter, error);
+        auto query = parse_or();
+        if (!query) return query;
+        if (token_.kind != TokenKind::End) return unexpected();
+        return query;
+    }
+
+private:
+    /// Nesting limit of parentheses and NOT, so hostile input cannot exhaust the stack
+    static constexpr int kMaxDepth = 256;
+
+    std::string_view text_;
+    const Database& ext_;
+    size_t pos_{0};
+    int depth_{0};
+    Token token_;
+
+    static bool is_operator(char c) { return c == '(' || c == ')' || c == '&' || c == '|' || c == '!' || c == '"'; }
+
+    /// Advance token_; returns an error message for an unterminated quote
+    std::string next() {
+        while (pos_ < text_.size() && std::isspace(static_cast<unsigned char>(text_[pos_]))) ++pos_;
+        token_ = Token{};
+        if (pos_ == text_.size()) return {};
+
+        char c = text_[pos_];
+        switch (c) {
+            case '(': ++pos_; token_.kind = TokenKind::Open; return {};
+            case ')': ++pos_; token_.kind = TokenKind::Close; return {};
+            case '&': ++pos_; token_.kind = TokenKind::And; return {};
+            case '|': ++pos_; token_.kind = TokenKind::Or; return {};
+            case '!': ++pos_; token_.kind = TokenKind::Not; return {};
+            case '"': {
+                size_t close = text_.find('"', pos_ + 1);
+                if (close == std::string_view::npos) return "Unterminated quote in tag query";
+                token_.kind = TokenKind::Name;
+                token_.text = std::string(text_.substr(pos_ + 1, close - pos_ - 1));
+                pos_ = close + 1;
+                return {};
+            }
+            default:
+                break;
+        }
+
+        // Words up to the next keyword or operator form one name
+        token_.kind = TokenKind::Name;
+        while (pos_ < text_.size() && !is_operator(text_[pos_])) {
+            size_t start = pos_;
+            while (pos_ < text_.size() && !is_operator(text_[pos_])
+                   && !std::isspace(static_cast<unsigned char>(text_[pos_]))) {
+                ++pos_;
+            }
+            std::string_view word = text_.substr(start, pos_ - start);
+            TokenKind keyword = word == "AND" ? TokenKind::And
+                              : word == "OR"  ? TokenKind::Or
+                              : word == "NOT" ? TokenKind::Not
+                                              : TokenKind::Name;
+            if (keyword != TokenKind::Name) {
+                if (token_.text.empty()) {
+                    token_.kind = keyword;
+                } else {
+                    pos_ = start;  // Ends the name; read again as the next token
+                }
+                return {};
+            }
+            if (!token_.text.empty()) token_.text += ' ';
+            token_.text += word;
+            while (pos_ < text_.size() && std::isspace(static_cast<unsigned char>(text_[pos_]))) ++pos_;
+        }
+        return {};
+    }
+
+    Result<TagQuery> unexpected() const {
+        if (token_.kind == TokenKind::End) {
+            return make_error(ErrorCode::InvalidParameter, "Unexpected end of tag query");
+        }
+        return make_error(ErrorCode::InvalidParameter,
+                          "Unexpected token at offset " + std::to_string(pos_) + " of tag query");
+    }
+
+    /// Consume the current token and read the next
+    Result<TagQuery> advance_then(Result<TagQuery> (QueryParser::*rule)()) {
+        auto error = next();
+        if (!error.empty()) return make_error(ErrorCode::InvalidParameter, error);
+        return (this->*rule)();
+    }
+
+    Result<TagQuery> parse_or() {
+        auto left = parse_and();
+        while (left && token_.kind == TokenKind::Or) {
+            auto right = advance_then(&QueryParser::parse_and);
+            if (!right) return right;
+            left = *left | *right;
+        }
+        return left;
+    }
+
+    Result<TagQuery> parse_and() {
+        auto left = parse_unary();
+        while (left && token_.kind == TokenKind::And) {
+            auto right = advance_then(&QueryParser::parse_unary);
+            if (!right) return right;
+            left = *left & *right;
+        }
+        return left;
+    }
+
+    Result<TagQuery> parse_unary() {
+        if (depth_ == kMaxDepth) {
+            return make_error(ErrorCode::InvalidParameter, "Tag query nesting too deep");
+        }
+        ++depth_;
+        auto query = parse_primary();
+        --depth_;
+        return query;
+    }
+
+    Result<TagQuery> parse_primary() {
+        switch (token_.kind) {
+            case TokenKind::Not: {
+                auto operand = advance_then(&QueryParser::parse_unary);
+                if (!operand) return operand;
+                return !*operand;
+            }
+            case TokenKind::Open: {
+                auto inner = advance_then(&QueryParser::parse_or);
+                if (!inner) return inner;
+                if (token_.kind != TokenKind::Close) return unexpected();
+                auto error = next();
+                if (!error.empty()) return make_error(ErrorCode::InvalidParameter, error);
+                return inner;
+            }
+            case TokenKind::Name: {
+                auto term = resolve(token_.text);
+                if (!term) return term;
+                auto error = next();
+                if (!error.empty()) return make_error(ErrorCode::InvalidParameter, error);
+                return term;
+            }
+            default:
+                return unexpected();
+        }
+    }
+
+    Result<TagQuery> resolve(const std::string& name) const {
+        auto tags = ext_.find_tags_by_name(name);
+        if (!tags.empty()) {
+            TagQuery query = TagQuery::tag(tags[0]);
+            for (size_t i = 1; i < tags.size(); ++i) query = query | TagQuery::tag(tags[i]);
+            return query;
+        }
+        auto categories = ext_.find_categories_by_name(name);
+        if (!categories.empty()) {
+            TagQuery query = TagQuery::category(categories[0]);
+            for (size_t i = 1; i < categories.size(); ++i) query = query | TagQuery::category(categories[i]);
+            return query;
+        }
+        return make_error(ErrorCode::InvalidParameter, "Unknown tag or category '" + name + "'");
+    }
+};
+
+} // anonymous namespace
+
+Result<TagQuery> TagQuery::parse(std::string_view text, const Database& ext) {
+    return QueryParser(text, ext).parse();
+}
+
+} // namespace cratedigger
@@ -0,0 +1,225 @@
+#include "cratedigger/tempo_map.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define CRATEDIGGER_TEMPO_SSE2 1
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#define CRATEDIGGER_TEMPO_NEON 1
+#endif
+
+namespace cratedigger {
+
+namespace {
+
+/// Upper bound on the time bucket table of a multi-segment grid
+constexpr size_t kMaxTimeBuckets = 1u << 16;
+
+constexpr int64_t kBeatsPerBar = 4;
+
+/// out[i] = (in[i] - offset) * scale + add for i in [0, n); out may alias in
+void affine(const double* in, size_t n, double* out, double offset, double scale, double add) {
+    size_t i = 0;
+#if defined(CRATEDIGGER_TEMPO_SSE2)
+    const __m128d vo = _mm_set1_pd(offset);
+    const __m128d vs = _mm_set1_pd(scale);
+    const __m128d va = _mm_set1_pd(add);
+    for (; i + 2 <= n; i += 2) {
+        __m128d v = _mm_loadu_pd(in + i);
+        _mm_storeu_pd(out + i, _mm_add_pd(_mm_mul_pd(_mm_sub_pd(v, vo), vs), va));
+    }
+#elif defined(CRATEDIGGER_TEMPO_NEON)
+    const float64x2_t vo = vdupq_n_f64(offset);
+    const float64x2_t vs = vdupq_n_f64(scale);
+    const float64x2_t va = vdupq_n_f64(add);
+    for (; i + 2 <= n; i += 2) {
+        float64x2_t v = vld1q_f64(in + i);
+        vst1q_f64(out + i, vaddq_f64(vmulq_f64(vsubq_f64(v, vo), vs), va));
+    }
+#endif
+    for (; i < n; ++i) {
+        out[i] = (in[i] - offset) * scale + add;
+    }
+}
+
+/// Beat length implied by a stored tempo (0 for a zero tempo)
+double ms_per_beat_for(uint16_t tempo_100x) {
+    return tempo_100x != 0 ? 6000000.0 / tempo_100x : 0.0;
+}
+
+} // anonymous namespace
+
+TempoMap::TempoMap(const BeatGrid& grid) : beat_count_(grid.size()) {
+    const auto& beats = grid.beats;
+    if (beats.empty()) {
+        return;
+    }
+    first_beat_number_ = static_cast<uint16_t>(std::clamp<int>(beats.front().beat_number, 1, kBeatsPerBar));
+
+    for (size_t i = 0; i < beats.size();) {
+        size_t j = i + 1;
+        while (j < beats.size() && beats[j].tempo_100x == beats[i].tempo_100x) ++j;
+
+        TempoSegment segment;
+        segment.start_ms = beats[i].time_ms;
+        segment.first_beat = static_cast<uint32_t>(i);
+        segment.beat_count = static_cast<uint32_t>(j - i);
+        segment.tempo_100x = beats[i].tempo_100x;
+        // Stored times are whole milliseconds; spanning the run keeps sub-ms beat lengths exact
+        if (j < beats.size()) {
+            segment.ms_per_beat = (double(beats[j].time_ms) - segment.start_ms) / double(j - i);
+        } else if (j - i >= 2) {
+            segment.ms_per_beat = (double(beats[j - 1].time_ms) - segment.start_ms) / double(j - i - 1);
+        }
+        if (!(segment.ms_per_beat > 0.0)) {
+            segment.ms_per_beat = ms_per_beat_for(segment.tempo_100x);
+        }
+        if (!(segment.ms_per_beat > 0.0)) {
+            segment.ms_per_beat = segments_.empty() ? 500.0 : segments_.back().ms_per_beat;
+        }
+        segments_.push_back(segment);
+        i = j;
+    }
+    if (segments_.size() == 1) {
+        return;
+    }
+
+    beat_segments_.resize(beat_count_);
+    for (uint32_t s = 0; s < segments_.size(); ++s) {
+        std::fill_n(beat_segments_.begin() + segments_[s].first_beat, segments_[s].beat_count, s);
+    }
+
+    // A corrupt grid whose segments do not start in increasing order gets no bucket table
+    for (size_t s = 0; s + 1 < segments_.size(); ++s) {
+        if (!(segments_[s + 1].start_ms > segments_[s].start_ms)) {
+            return;
+        }
+    }
+
+    // Buckets no longer than the shortest segment leave at most one boundary per bucket
+    bucket_origin_ms_ = segments_.front().start_ms;
+    double span = segments_.back().start_ms - bucket_origin_ms_;
+    double bucket_ms = std::numeric_limits<double>::max();
+    for (size_t s = 0; s + 1 < segments_.size(); ++s) {
+        bucket_ms = std::min(bucket_ms, segments_[s + 1].start_ms - segments_[s].start_ms);
+    }
+    bucket_ms = std::max({bucket_ms, span / kMaxTimeBuckets, 1.0});
+    buckets_per_ms_ = 1.0 / bucket_ms;
+
+    time_buckets_.resize(static_cast<size_t>(span * buckets_per_ms_) + 1);
+    uint32_t segment = 0;
+    for (size_t b = 0; b < time_buckets_.size(); ++b) {
+        double start = bucket_origin_ms_ + static_cast<double>(b) * bucket_ms;
+        while (segment + 1 < segments_.size() && segments_[segment + 1].start_ms <= start) ++segment;
+        time_buckets_[b] = segment;
+    }
+}
+
+size_t TempoMap::segment_index(double time_ms) const {
+    // Without a table (one segment, or a corrupt grid) walk from the first segment
+    size_t s = 0;
+    if (!time_buckets_.empty()) {
+        // Times before the grid (or NaN) use the first segment
+        if (!(time_ms > bucket_origin_ms_)) {
+            return 0;
+        }
+        double bucket = (time_ms - bucket_origin_ms_) * buckets_per_ms_;
+        s = bucket < static_cast<double>(time_buckets_.size()) ? time_buckets_[static_cast<size_t>(bucket)]
+                                                               : segments_.size() - 1;
+    }
+    while (s + 1 < segments_.size() && segments_[s + 1].start_ms <= time_ms) ++s;
+    return s;
+}
+
+size_t TempoMap::segment_index_for_beat(double beat) const {
+    if (beat_segments_.empty() || !(beat > 0.0)) {
+        return 0;
+    }
+    return beat < static_cast<double>(beat_count_) ? beat_segments_[static_cast<size_t>(beat)] : segments_.size() - 1;
+}
+
+double TempoMap::time_to_beat(double time_ms) const {
+    if (empty()) {
+        return 0.0;
+    }
+    const auto& segment = segments_[segment_index(time_ms)];
+    // Same expression as the batched kernel, so both paths agree exactly
+    return (time_ms - segment.start_ms) * (1.0 / segment.ms_per_beat) + segment.first_beat;
+}
+
+double TempoMap::beat_to_time(double beat) const {
+    if (empty()) {
+        return 0.0;
+    }
+    const auto& segment = segments_[segment_index_for_beat(beat)];
+    return (beat - segment.first_beat) * segment.ms_per_beat + segment.start_ms;
+}
+
+BeatPosition TempoMap::position_at(double time_ms) const {
+    BeatPosition position;
+    if (empty()) {
+        return position;
+    }
+    const auto& segment = segments_[segment_index(time_ms)];
+    position.beat = (time_ms - segment.start_ms) * (1.0 / segment.ms_per_beat) + segment.first_beat;
+    position.bpm = segment.bpm();
+
+    double whole = std::floor(position.beat);
+    position.beat_phase = position.beat - whole;
+    int64_t slot = static_cast<int64_t>(whole) + (first_beat_number_ - 1);
+    int64_t in_bar = ((slot % kBeatsPerBar) + kBeatsPerBar) % kBeatsPerBar;
+    position.bar = (slot - in_bar) / kBeatsPerBar;
+    position.beat_in_bar = static_cast<uint16_t>(in_bar + 1);
+    position.bar_phase = (static_cast<double>(in_bar) + position.beat_phase) / kBeatsPerBar;
+    return position;
+}
+
+void TempoMap::times_to_beats(const double* times, size_t count, double* beats) const {
+    if (empty()) {
+        std::fill_n(beats, count, 0.0);
+        return;
+    }
+    constexpr double kInf = std::numeric_limits<double>::infinity();
+    for (size_t i = 0; i < count;) {
+        size_t s = segment_index(times[i]);
+        const auto& segment = segments_[s];
+        double lo = s == 0 ? -kInf : segment.start_ms;
+        double hi = s + 1 < segments_.size() ? segments_[s + 1].start_ms : kInf;
+        size_t j = i + 1;
+        while (j < count && times[j] >= lo && times[j] < hi) ++j;
+        affine(times + i, j - i, beats + i, segment.start_ms, 1.0 / segment.ms_per_beat, segment.first_beat);
+        i = j;
+    }
+}
+
+void TempoMap::beats_to_times(const double* beats, size_t count, double* times) const {
+    if (empty()) {
+        std::fill_n(times, count, 0.0);
+        return;
+    }
+    constexpr double kInf = std::numeric_limits<double>::infinity();
+    for (size_t i = 0; i < count;) {
+        size_t s = segment_index_for_beat(beats[i]);
+        const auto& segment = segments_[s];
+        double lo = s == 0 ? -kInf : segment.first_beat;
+        double hi = s + 1 < segments_.size() ? segments_[s + 1].first_beat : kInf;
+        size_t j = i + 1;
+        while (j < count && beats[j] >= lo && beats[j] < hi) ++j;
+        affine(beats + i, j - i, times + i, segment.first_beat, segment.ms_per_beat, segment.start_ms);
+        i = j;
+    }
+}
+
+void TempoMap::quantize(const double* times, size_t count, double* out, double resolution) const {
+    if (!(resolution > 0.0)) resolution = 1.0;
+    times_to_beats(times, count, out);
+    for (size_t i = 0; i < count; ++i) {
+        out[i] = std::round(out[i] / resolution) * resolution;
+    }
+    beats_to_times(out, count, out);
+}
+
+} // namespace cratedigger
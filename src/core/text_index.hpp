@@ -0,0 +1,254 @@
+#pragma once
+/**
+ * @file text_index.hpp
+ * @brief Internal n-gram index for substring, prefix and fuzzy text search
+ *
+ * Each document is an ID plus FieldCount strings borrowed from the caller
+ * (they must outlive the index). freeze() records, per document, the
+ * case-folded byte trigrams of every field plus the first one and two bytes
+ * of every word, in one CSR posting table keyed by gram. A query looks up
+ * the grams it contains and intersects their document-ordered postings.
+ * The survivors are only candidates: callers verify them with match(),
+ * which reads the original strings, so the index stores no string copies.
+ */
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace cratedigger {
+
+/// How a folded query occurs in a field (strongest first)
+enum class TextMatchKind : uint8_t {
+    None,
+    Exact,       // Whole field
+    Prefix,      // Start of the field
+    WordPrefix,  // Start of a later word
+    Substring    // Anywhere
+};
+
+template<typename IdType, size_t FieldCount>
+class TextIndex {
+public:
+    using Fields = std::array<std::string_view, FieldCount>;
+
+    /// Stage a document (before freeze; insert in ascending ID order)
+    void insert(IdType id, const Fields& fields) {
+        ids_.push_back(id);
+        fields_.push_back(fields);
+    }
+
+    /// Build the gram postings
+    void freeze() {
+        std::vector<uint32_t> grams;
+
+        // Pass 1: assign dense gram numbers and count postings
+        std::vector<uint32_t> counts;
+        for (const auto& fields : fields_) {
+            document_grams(fields, grams);
+            for (uint32_t gram : grams) {
+                auto [it, inserted] = gram_slots_.emplace(gram, static_cast<uint32_t>(counts.size()));
+                if (inserted) counts.push_back(0);
+                ++counts[it->second];
+            }
+        }
+
+        offsets_.assign(counts.size() + 1, 0);
+        for (size_t g = 0; g < counts.size(); ++g) {
+            offsets_[g + 1] = offsets_[g] + counts[g];
+        }
+
+        // Pass 2: fill; documents are visited in order, so postings come out sorted
+        postings_.resize(offsets_.back());
+        std::vector<uint32_t> cursor(offsets_.begin(), offsets_.end() - 1);
+        for (size_t doc = 0; doc < fields_.size(); ++doc) {
+            document_grams(fields_[doc], grams);
+            for (uint32_t gram : grams) {
+                postings_[cursor[gram_slots_.find(gram)->second]++] = static_cast<uint32_t>(doc);
+            }
+        }
+        ids_.shrink_to_fit();
+        fields_.shrink_to_fit();
+    }
+
+    /**
+     * @brief Documents containing every gram of a folded query
+     *
+     * With word_start set (or for queries shorter than a trigram) the query
+     * must also begin a word somewhere in the document. Returns document
+     * numbers in ascending order; empty for an empty query.
+     */
+    [[nodiscard]] std::vector<uint32_t> candidates(std::string_view query, bool word_start) const {
+        std::vector<uint32_t> grams = trigrams(query);
+        if ((word_start || query.size() < 3) && !query.empty() && is_word_byte(query[0])) {
+            grams.push_back(query.size() == 1 || !is_word_byte(query[1])
+                ? unigram_key(query[0]) : bigram_key(query[0], query[1]));
+        }
+        if (grams.empty()) return {};
+
+        std::vector<std::pair<const uint32_t*, const uint32_t*>> lists;
+        for (uint32_t gram : grams) {
+            auto it = gram_slots_.find(gram);
+            if (it == gram_slots_.end()) return {};
+            lists.emplace_back(postings_.data() + offsets_[it->second],
+                               postings_.data() + offsets_[it->second + 1]);
+        }
+        std::sort(lists.begin(), lists.end(), [](const auto& a, const auto& b) {
+            return a.second - a.first < b.second - b.first;
+        });
+
+        std::vector<uint32_t> result(lists.front().first, lists.front().second);
+        for (size_t l = 1; l < lists.size() && !result.empty(); ++l) {
+            auto out = result.begin();
+            const uint32_t* it = lists[l].first;
+            for (uint32_t doc : result) {
+                it = std::lower_bound(it, lists[l].second, doc);
+                if (it == lists[l].second) break;
+                if (*it == doc) *out++ = doc;
+            }
+            result.erase(out, result.end());
+        }
+        return result;
+    }
+
+    /// Documents sharing at least min_shared of the given trigrams
+    [[nodiscard]] std::vector<uint32_t> overlapping(const std::vector<uint32_t>& grams, uint32_t min_shared) const {
+        std::vector<uint16_t> shared(fields_.size(), 0);
+        for (uint32_t gram : grams) {
+            auto it = gram_slots_.find(gram);
+            if (it == gram_slots_.end()) continue;
+            for (uint32_t p = offsets_[it->second]; p < offsets_[it->second + 1]; ++p) {
+                if (shared[postings_[p]] < UINT16_MAX) ++shared[postings_[p]];
+            }
+        }
+        std::vector<uint32_t> result;
+        for (size_t doc = 0; doc < shared.size(); ++doc) {
+            if (shared[doc] >= min_shared) result.push_back(static_cast<uint32_t>(doc));
+        }
+        return result;
+    }
+
+    [[nodiscard]] IdType id_at(uint32_t doc) const { return ids_[doc]; }
+    [[nodiscard]] const Fields& fields_at(uint32_t doc) const { return fields_[doc]; }
+    [[nodiscard]] size_t size() const { return ids_.size(); }
+
+    /// Case folding used for grams (same as FlatNameIndex)
+    static char fold_char(char c) {
+        return static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    }
+
+    static std::string fold(std::string_view text) {
+        std::string folded(text);
+        for (auto& c : folded) c = fold_char(c);
+        return folded;
+    }
+
+    /// Bytes that belong to a word (UTF-8 continuation bytes count as letters)
+    static bool is_word_byte(char c) {
+        auto u = static_cast<unsigned char>(c);
+        return u >= 0x80 || std::isalnum(u);
+    }
+
+    /// Sorted, distinct trigram keys of a string (folded on the fly)
+    static std::vector<uint32_t> trigrams(std::string_view text) {
+        std::vector<uint32_t> grams;
+        if (text.size() < 3) return grams;
+        grams.reserve(text.size() - 2);
+        for (size_t i = 0; i + 2 < text.size(); ++i) {
+            grams.push_back(trigram_key(text[i], text[i + 1], text[i + 2]));
+        }
+        std::sort(grams.begin(), grams.end());
+        grams.erase(std::unique(grams.begin(), grams.end()), grams.end());
+        return grams;
+    }
+
+    /// Dice coefficient between sorted query trigrams and a field's trigrams
+    static float similarity(const std::vector<uint32_t>& query_grams, std::string_view text) {
+        auto text_grams = trigrams(text);
+        if (query_grams.empty() || text_grams.empty()) return 0.0f;
+        size_t shared = 0;
+        auto a = query_grams.begin();
+        auto b = text_grams.begin();
+        while (a != query_grams.end() && b != text_grams.end()) {
+            if (*a < *b) ++a;
+            else if (*b < *a) ++b;
+            else { ++shared; ++a; ++b; }
+        }
+        return 2.0f * static_cast<float>(shared) /
+               static_cast<float>(query_grams.size() + text_grams.size());
+    }
+
+    /// Strongest occurrence of a folded query in a field
+    static TextMatchKind match(std::string_view text, std::string_view query) {
+        if (query.empty() || query.size() > text.size()) return TextMatchKind::None;
+
+        TextMatchKind best = TextMatchKind::None;
+        for (size_t pos = 0; pos + query.size() <= text.size(); ++pos) {
+            bool equal = true;
+            for (size_t k = 0; k < query.size(); ++k) {
+                if (fold_char(text[pos + k]) != query[k]) {
+                    equal = false;
+                    break;
+                }
+            }
+            if (!equal) continue;
+            if (pos == 0) {
+                return query.size() == text.size() ? TextMatchKind::Exact : TextMatchKind::Prefix;
+            }
+            if (!is_word_byte(text[pos - 1]) && is_word_byte(text[pos])) return TextMatchKind::WordPrefix;
+            best = TextMatchKind::Substring;
+        }
+        return best;
+    }
+
+private:
+    // Gram keys: trigrams use the low 24 bits; word-initial grams are tagged above them
+    static uint32_t trigram_key(char a, char b, char c) {
+        return (static_cast<uint32_t>(static_cast<unsigned char>(fold_char(a))) << 16) |
+               (static_cast<uint32_t>(static_cast<unsigned char>(fold_char(b))) << 8) |
+               static_cast<uint32_t>(static_cast<unsigned char>(fold_char(c)));
+    }
+
+    static uint32_t unigram_key(char a) {
+        return (1u << 24) | static_cast<uint32_t>(static_cast<unsigned char>(fold_char(a)));
+    }
+
+    static uint32_t bigram_key(char a, char b) {
+        return (2u << 24) |
+               (static_cast<uint32_t>(static_cast<unsigned char>(fold_char(a))) << 8) |
+               static_cast<uint32_t>(static_cast<unsigned char>(fold_char(b)));
+    }
+
+    /// Distinct grams of all fields of a document
+    static void document_grams(const Fields& fields, std::vector<uint32_t>& grams) {
+        grams.clear();
+        for (std::string_view text : fields) {
+            for (size_t i = 0; i < text.size(); ++i) {
+                if (i + 2 < text.size()) {
+                    grams.push_back(trigram_key(text[i], text[i + 1], text[i + 2]));
+                }
+                if (is_word_byte(text[i]) && (i == 0 || !is_word_byte(text[i - 1]))) {
+                    grams.push_back(unigram_key(text[i]));
+                    if (i + 1 < text.size() && is_word_byte(text[i + 1])) {
+                        grams.push_back(bigram_key(text[i], text[i + 1]));
+                    }
+                }
+            }
+        }
+        std::sort(grams.begin(), grams.end());
+        grams.erase(std::unique(grams.begin(), grams.end()), grams.end());
+    }
+
+    std::vector<IdType> ids_;
+    std::vector<Fields> fields_;
+    std::unordered_map<uint32_t, uint32_t> gram_slots_;  // Gram key -> slot in offsets_
+    std::vector<uint32_t> offsets_;
+    std::vector<uint32_t> postings_;                     // Document numbers
+};
+
+} // namespace cratedigger
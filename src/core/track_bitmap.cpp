@@ -0,0 +1,262 @@
+#include "cratedigger/track_bitmap.hpp"
+#include <algorithm>
+#include <iterator>
+
+namespace cratedigger {
+
+namespace {
+
+/// Largest container kept as a sorted array (beyond it a bitmap is smaller)
+constexpr size_t kArrayMax = 4096;
+
+/// 64-bit words of a bitmap container
+constexpr size_t kWords = 65536 / 64;
+
+unsigned popcount(uint64_t word) {
+#if defined(__GNUC__) || defined(__clang__)
+    return static_cast<unsigned>(__builtin_popcountll(word));
+#else
+    word = word - ((word >> 1) & 0x5555555555555555ull);
+    word = (word & 0x3333333333333333ull) + ((word >> 2) & 0x3333333333333333ull);
+    word = (word + (word >> 4)) & 0x0F0F0F0F0F0F0F0Full;
+    return static_cast<unsigned>((word * 0x0101010101010101ull) >> 56);
+#endif
+}
+
+bool test_bit(const std::vector<uint64_t>& words, uint16_t low) {
+    return (words[low >> 6] >> (low & 63)) & 1;
+}
+
+} // anonymous namespace
+
+/// Container kernels; results are normalized (array up to kArrayMax, bitmap above)
+struct TrackBitmap::Ops {
+    static void set_array(Container& c, std::vector<uint16_t>&& values) {
+        c.cardinality = static_cast<uint32_t>(values.size());
+        if (values.size() <= kArrayMax) {
+            c.values = std::move(values);
+            c.words.clear();
+            return;
+        }
+        c.words.assign(kWords, 0);
+        for (uint16_t low : values) c.words[low >> 6] |= uint64_t{1} << (low & 63);
+        c.values.clear();
+    }
+
+    static void set_words(Container& c, std::vector<uint64_t>&& words) {
+        uint32_t count = 0;
+        for (uint64_t word : words) count += popcount(word);
+        c.cardinality = count;
+        if (count > kArrayMax) {
+            c.words = std::move(words);
+            c.values.clear();
+            return;
+        }
+        c.values.clear();
+        c.values.reserve(count);
+        for (size_t w = 0; w < words.size(); ++w) {
+            for (uint64_t word = words[w]; word != 0; word &= word - 1) {
+                c.values.push_back(static_cast<uint16_t>(w * 64 + lowest_bit(word)));
+            }
+        }
+        c.words.clear();
+    }
+
+    static Container intersect(const Container& a, const Container& b) {
+        Container out;
+        out.key = a.key;
+        bool a_bits = !a.words.empty();
+        bool b_bits = !b.words.empty();
+        if (a_bits && b_bits) {
+            std::vector<uint64_t> words(kWords);
+            for (size_t w = 0; w < kWords; ++w) words[w] = a.words[w] & b.words[w];
+            set_words(out, std::move(words));
+        } else if (a_bits || b_bits) {
+            const Container& array = a_bits ? b : a;
+            const Container& bits = a_bits ? a : b;
+            std::vector<uint16_t> values;
+            for (uint16_t low : array.values) {
+                if (test_bit(bits.words, low)) values.push_back(low);
+            }
+            set_array(out, std::move(values));
+        } else {
+            std::vector<uint16_t> values;
+            std::set_intersection(a.values.begin(), a.values.end(), b.values.begin(), b.values.end(),
+                                  std::back_inserter(values));
+            set_array(out, std::move(values));
+        }
+        return out;
+    }
+
+    static Container unite(const Container& a, const Container& b) {
+        Container out;
+        out.key = a.key;
+        bool a_bits = !a.words.empty();
+        bool b_bits = !b.words.empty();
+        if (a_bits || b_bits) {
+            std::vector<uint64_t> words = a_bits ? a.words : b.words;
+            const Container& other = a_bits ? b : a;
+            if (!other.words.empty()) {
+                for (size_t w = 0; w < kWords; ++w) words[w] |= other.words[w];
+            } else {
+                for (uint16_t low : other.values) words[low >> 6] |= uint64_t{1} << (low & 63);
+            }
+            set_words(out, std::move(words));
+        } else {
+            std::vector<uint16_t> values;
+            values.reserve(a.values.size() + b.values.size());
+            std::set_union(a.values.begin(), a.values.end(), b.values.begin(), b.values.end(),
+                           std::back_inserter(values));
+            set_array(out, std::move(values));
+        }
+        return out;
+    }
+
+    static Container subtract(const Container& a, const Container& b) {
+        Container out;
+        out.key = a.key;
+        if (!a.words.empty()) {
+            std::vector<uint64_t> words = a.words;
+            if (!b.words.empty()) {
+                for (size_t w = 0; w < kWords; ++w) words[w] &= ~b.words[w];
+            } else {
+                for (uint16_t low : b.values) words[low >> 6] &= ~(uint64_t{1} << (low & 63));
+            }
+            set_words(out, std::move(words));
+        } else {
+            std::vector<uint16_t> values;
+            if (!b.words.empty()) {
+                for (uint16_t low : a.values) {
+                    if (!test_bit(b.words, low)) values.push_back(low);
+                }
+            } else {
+                std::set_difference(a.values.begin(), a.values.end(), b.values.begin(), b.values.end(),
+                                    std::back_inserter(values));
+            }
+            set_array(out, std::move(values));
+        }
+        return out;
+    }
+};
+
+TrackBitmap TrackBitmap::from_ids(Span<const TrackId> ids) {
+    std::vector<uint32_t> sorted;
+    sorted.reserve(ids.size());
+    for (TrackId id : ids) sorted.push_back(static_cast<uint32_t>(id.value));
+    if (!std::is_sorted(sorted.begin(), sorted.end())) {
+        std::sort(sorted.begin(), sorted.end());
+    }
+    sorted.erase(std::unique(sorted.begin(), sorted.end()), sorted.end());
+
+    TrackBitmap bitmap;
+    for (size_t i = 0; i < sorted.size();) {
+        uint32_t high = sorted[i] >> 16;
+        size_t j = i;
+        std::vector<uint16_t> values;
+        for (; j < sorted.size() && (sorted[j] >> 16) == high; ++j) {
+            values.push_back(static_cast<uint16_t>(sorted[j]));
+        }
+        Container c;
+        c.key = static_cast<uint16_t>(high);
+        Ops::set_array(c, std::move(values));
+        bitmap.containers_.push_back(std::move(c));
+        i = j;
+    }
+    return bitmap;
+}
+
+bool TrackBitmap::contains(TrackId id) const {
+    auto value = static_cast<uint32_t>(id.value);
+    auto key = static_cast<uint16_t>(value >> 16);
+    auto it = std::lower_bound(containers_.begin(), containers_.end(), key,
+                               [](const Container& c, uint16_t k) { return c.key < k; });
+    if (it == containers_.end() || it->key != key) return false;
+    auto low = static_cast<uint16_t>(value);
+    return it->words.empty() ? std::binary_search(it->values.begin(), it->values.end(), low)
+                             : test_bit(it->words, low);
+}
+
+size_t TrackBitmap::cardinality() const {
+    size_t count = 0;
+    for (const auto& c : containers_) count += c.cardinality;
+    return count;
+}
+
+std::vector<TrackId> TrackBitmap::to_vector() const {
+    std::vector<TrackId> ids;
+    ids.reserve(cardinality());
+    for_each([&ids](TrackId id) { ids.push_back(id); });
+    return ids;
+}
+
+TrackBitmap TrackBitmap::operator&(const TrackBitmap& other) const {
+    TrackBitmap out;
+    auto a = containers_.begin();
+    auto b = other.containers_.begin();
+    while (a != containers_.end() && b != other.containers_.end()) {
+        if (a->key < b->key) {
+            ++a;
+        } else if (b->key < a->key) {
+            ++b;
+        } else {
+            Container c = Ops::intersect(*a++, *b++);
+            if (c.cardinality != 0) out.containers_.push_back(std::move(c));
+        }
+    }
+    return out;
+}
+
+TrackBitmap TrackBitmap::operator|(const TrackBitmap& other) const {
+    TrackBitmap out;
+    out.containers_.reserve(containers_.size() + other.containers_.size());
+    auto a = containers_.begin();
+    auto b = other.containers_.begin();
+    while (a != containers_.end() || b != other.containers_.end()) {
+        if (b == other.containers_.end() || (a != containers_.end() && a->key < b->key)) {
+            out.containers_.push_back(*a++);
+        } else if (a == containers_.end() || b->key < a->key) {
+            out.containers_.push_back(*b++);
+        } else {
+            out.containers_.push_back(Ops::unite(*a++, *b++));
+        }
+    }
+    return out;
+}
+
+TrackBitmap TrackBitmap::operator-(const TrackBitmap& other) const {
+    TrackBitmap out;
+    auto b = other.containers_.begin();
+    for (const auto& c : containers_) {
+        while (b != other.containers_.end() && b->key < c.key) ++b;
+        if (b == other.containers_.end() || b->key != c.key) {
+            out.containers_.push_back(c);
+            continue;
+        }
+        Container diff = Ops::subtract(c, *b);
+        if (diff.cardinality != 0) out.containers_.push_back(std::move(diff));
+    }
+    return out;
+}
+
+size_t TrackBitmap::bytes() const {
+    size_t total = containers_.capacity() * sizeof(Container);
+    for (const auto& c : containers_) {
+        total += c.values.capacity() * sizeof(uint16_t) + c.words.capacity() * sizeof(uint64_t);
+    }
+    return total;
+}
+
+bool TrackBitmap::operator==(const TrackBitmap& other) const {
+    if (containers_.size() != other.containers_.size()) return false;
+    for (size_t i = 0; i < containers_.size(); ++i) {
+        const auto& a = containers_[i];
+        const auto& b = other.containers_[i];
+        // Normalized containers of equal sets have the same representation
+        if (a.key != b.key || a.cardinality != b.cardinality || a.values != b.values || a.words != b.words) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace cratedigger
@@ -0,0 +1,181 @@
+#include "utf16.hpp"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define CRATEDIGGER_UTF16_AVX2 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define CRATEDIGGER_UTF16_SSE2 1
+#elif defined(__aarch64__) && defined(__ARM_NEON) && (!defined(__BYTE_ORDER__) || __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+#include <arm_neon.h>
+#define CRATEDIGGER_UTF16_NEON 1
+#endif
+
+namespace cratedigger::detail {
+
+namespace {
+
+constexpr uint32_t kReplacementChar = 0xFFFD;
+
+inline uint16_t load_unit(const uint8_t* p, Utf16Order order) {
+    return order == Utf16Order::LittleEndian
+        ? static_cast<uint16_t>(p[0] | (p[1] << 8))
+        : static_cast<uint16_t>((p[0] << 8) | p[1]);
+}
+
+inline char* put_code_point(char* dst, uint32_t cp) {
+    if (cp < 0x80) {
+        *dst++ = static_cast<char>(cp);
+    } else if (cp < 0x800) {
+        *dst++ = static_cast<char>(0xC0 | (cp >> 6));
+        *dst++ = static_cast<char>(0x80 | (cp & 0x3F));
+    } else if (cp < 0x10000) {
+        *dst++ = static_cast<char>(0xE0 | (cp >> 12));
+        *dst++ = static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        *dst++ = static_cast<char>(0x80 | (cp & 0x3F));
+    } else {
+        *dst++ = static_cast<char>(0xF0 | (cp >> 18));
+        *dst++ = static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+        *dst++ = static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        *dst++ = static_cast<char>(0x80 | (cp & 0x3F));
+    }
+    return dst;
+}
+
+/**
+ * @brief Decode code units [i, block_end) one at a time
+ *
+ * A high surrogate at the end of the block may consume its partner from
+ * beyond block_end (up to unit_count). Returns the next unit index, or
+ * unit_count after a NUL.
+ */
+size_t decode_scalar(const uint8_t* data, size_t i, size_t block_end, size_t unit_count,
+                     Utf16Order order, char*& dst) {
+    while (i < block_end) {
+        uint32_t unit = load_unit(data + i * 2, order);
+        ++i;
+        if (unit == 0) return unit_count;
+
+        if (unit >= 0xD800 && unit <= 0xDBFF) {
+            uint32_t low = i < unit_count ? load_unit(data + i * 2, order) : 0;
+            if (low >= 0xDC00 && low <= 0xDFFF) {
+                ++i;
+                dst = put_code_point(dst, 0x10000 + ((unit - 0xD800) << 10) + (low - 0xDC00));
+            } else {
+                dst = put_code_point(dst, kReplacementChar);
+            }
+        } else if (unit >= 0xDC00 && unit <= 0xDFFF) {
+            dst = put_code_point(dst, kReplacementChar);
+        } else {
+            dst = put_code_point(dst, unit);
+        }
+    }
+    return i;
+}
+
+#if defined(CRATEDIGGER_UTF16_AVX2)
+
+constexpr size_t kBlockUnits = 16;
+
+/// Narrow a block of 16 units if all are non-NUL ASCII
+inline bool narrow_ascii_block(const uint8_t* src, Utf16Order order, char* dst) {
+    __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src));
+    if (order == Utf16Order::BigEndian) {
+        v = _mm256_or_si256(_mm256_slli_epi16(v, 8), _mm256_srli_epi16(v, 8));
+    }
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i non_ascii = _mm256_and_si256(v, _mm256_set1_epi16(static_cast<short>(0xFF80)));
+    __m256i bad = _mm256_or_si256(_mm256_xor_si256(_mm256_cmpeq_epi16(non_ascii, zero), _mm256_set1_epi8(-1)),
+                                  _mm256_cmpeq_epi16(v, zero));
+    if (_mm256_movemask_epi8(bad) != 0) return false;
+
+    // packus works per 128-bit lane; gather the two packed halves
+    __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(v, v), 0x08);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), _mm256_castsi256_si128(packed));
+    return true;
+}
+
+#elif defined(CRATEDIGGER_UTF16_SSE2)
+
+constexpr size_t kBlockUnits = 8;
+
+/// Narrow a block of 8 units if all are non-NUL ASCII
+inline bool narrow_ascii_block(const uint8_t* src, Utf16Order order, char* dst) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+    if (order == Utf16Order::BigEndian) {
+        v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+    }
+    const __m128i zero = _mm_setzero_si128();
+    __m128i ascii = _mm_cmpeq_epi16(_mm_and_si128(v, _mm_set1_epi16(static_cast<short>(0xFF80))), zero);
+    __m128i nul = _mm_cmpeq_epi16(v, zero);
+    if (_mm_movemask_epi8(_mm_andnot_si128(nul, ascii)) != 0xFFFF) return false;
+
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(dst), _mm_packus_epi16(v, v));
+    return true;
+}
+
+#elif defined(CRATEDIGGER_UTF16_NEON)
+
+constexpr size_t kBlockUnits = 8;
+
+/// Narrow a block of 8 units if all are non-NUL ASCII
+inline bool narrow_ascii_block(const uint8_t* src, Utf16Order order, char* dst) {
+    uint8x16_t bytes = vld1q_u8(src);
+    if (order == Utf16Order::BigEndian) {
+        bytes = vrev16q_u8(bytes);
+    }
+    uint16x8_t v = vreinterpretq_u16_u8(bytes);
+    if (vmaxvq_u16(v) >= 0x80 || vminvq_u16(v) == 0) return false;
+
+    vst1_u8(reinterpret_cast<uint8_t*>(dst), vmovn_u16(v));
+    return true;
+}
+
+#else
+
+constexpr size_t kBlockUnits = 8;
+
+/// Portable fallback: check 8 units, then narrow
+inline bool narrow_ascii_block(const uint8_t* src, Utf16Order order, char* dst) {
+    uint16_t units[kBlockUnits];
+    for (size_t k = 0; k < kBlockUnits; ++k) {
+        units[k] = load_unit(src + k * 2, order);
+        if (units[k] == 0 || units[k] >= 0x80) return false;
+    }
+    for (size_t k = 0; k < kBlockUnits; ++k) {
+        dst[k] = static_cast<char>(units[k]);
+    }
+    return true;
+}
+
+#endif
+
+} // anonymous namespace
+
+void append_utf16_as_utf8(const uint8_t* data, size_t unit_count, Utf16Order order, std::string& out) {
+    if (unit_count == 0) return;
+
+    // Worst case is 3 bytes per unit (a surrogate pair is 2 units -> 4 bytes)
+    size_t start = out.size();
+    out.resize(start + unit_count * 3);
+    char* const begin = &out[start];
+    char* dst = begin;
+
+    size_t i = 0;
+    while (i < unit_count) {
+        if (unit_count - i >= kBlockUnits) {
+            if (narrow_ascii_block(data + i * 2, order, dst)) {
+                i += kBlockUnits;
+                dst += kBlockUnits;
+                continue;
+            }
+            i = decode_scalar(data, i, i + kBlockUnits, unit_count, order, dst);
+        } else {
+            i = decode_scalar(data, i, unit_count, unit_count, order, dst);
+        }
+    }
+
+    out.resize(start + static_cast<size_t>(dst - begin));
+}
+
+} // namespace cratedigger::detail
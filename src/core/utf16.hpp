@@ -0,0 +1,37 @@
+#pragma once
+/**
+ * @file utf16.hpp
+ * @brief Internal UTF-16 -> UTF-8 transcoder shared by the PDB and ANLZ parsers
+ *
+ * Runs of ASCII code units are narrowed 8 (SSE2/NEON) or 16 (AVX2) at a
+ * time; everything else goes through a scalar path that pairs surrogates
+ * and replaces unpaired ones with U+FFFD.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace cratedigger::detail {
+
+/// Byte order of the UTF-16 input
+enum class Utf16Order : uint8_t {
+    LittleEndian,  // export.pdb (DeviceSQL)
+    BigEndian      // ANLZ files
+};
+
+/**
+ * @brief Append the UTF-8 encoding of up to unit_count UTF-16 code units
+ *
+ * Decoding stops at the first NUL code unit. data need not be aligned.
+ */
+void append_utf16_as_utf8(const uint8_t* data, size_t unit_count, Utf16Order order, std::string& out);
+
+/// Convenience wrapper returning a new string
+inline std::string utf16_to_utf8(const uint8_t* data, size_t unit_count, Utf16Order order) {
+    std::string out;
+    append_utf16_as_utf8(data, unit_count, order, out);
+    return out;
+}
+
+} // namespace cratedigger::detail
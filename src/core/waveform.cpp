@@ -0,0 +1,294 @@
+#include "cratedigger/waveform.hpp"
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define CRATEDIGGER_WAVEFORM_SSE2 1
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#define CRATEDIGGER_WAVEFORM_NEON 1
+#endif
+
+namespace cratedigger {
+
+namespace {
+
+/// Runs up to this length are reduced directly instead of climbing a mip level
+constexpr size_t kDirectRun = 64;
+
+// ============================================================================
+// Reduction Kernels
+// ============================================================================
+
+struct MaxOp {
+    static constexpr uint8_t kIdentity = 0;
+    static uint8_t apply(uint8_t a, uint8_t b) { return std::max(a, b); }
+#if defined(CRATEDIGGER_WAVEFORM_SSE2)
+    static __m128i apply(__m128i a, __m128i b) { return _mm_max_epu8(a, b); }
+#elif defined(CRATEDIGGER_WAVEFORM_NEON)
+    static uint8x16_t apply(uint8x16_t a, uint8x16_t b) { return vmaxq_u8(a, b); }
+    static uint8_t horizontal(uint8x16_t v) { return vmaxvq_u8(v); }
+#endif
+};
+
+struct MinOp {
+    static constexpr uint8_t kIdentity = 0xFF;
+    static uint8_t apply(uint8_t a, uint8_t b) { return std::min(a, b); }
+#if defined(CRATEDIGGER_WAVEFORM_SSE2)
+    static __m128i apply(__m128i a, __m128i b) { return _mm_min_epu8(a, b); }
+#elif defined(CRATEDIGGER_WAVEFORM_NEON)
+    static uint8x16_t apply(uint8x16_t a, uint8x16_t b) { return vminq_u8(a, b); }
+    static uint8_t horizontal(uint8x16_t v) { return vminvq_u8(v); }
+#endif
+};
+
+/// Reduce values[0, n) with Op
+template<typename Op>
+uint8_t reduce_run(const uint8_t* values, size_t n) {
+    uint8_t result = Op::kIdentity;
+    size_t i = 0;
+#if defined(CRATEDIGGER_WAVEFORM_SSE2)
+    if (n >= 16) {
+        __m128i acc = _mm_loadu_si128(reinterpret_cast<const __m128i*>(values));
+        for (i = 16; i + 16 <= n; i += 16) {
+            acc = Op::apply(acc, _mm_loadu_si128(reinterpret_cast<const __m128i*>(values + i)));
+        }
+        acc = Op::apply(acc, _mm_srli_si128(acc, 8));
+        acc = Op::apply(acc, _mm_srli_si128(acc, 4));
+        acc = Op::apply(acc, _mm_srli_si128(acc, 2));
+        acc = Op::apply(acc, _mm_srli_si128(acc, 1));
+        result = static_cast<uint8_t>(_mm_cvtsi128_si32(acc));
+    }
+#elif defined(CRATEDIGGER_WAVEFORM_NEON)
+    if (n >= 16) {
+        uint8x16_t acc = vld1q_u8(values);
+        for (i = 16; i + 16 <= n; i += 16) acc = Op::apply(acc, vld1q_u8(values + i));
+        result = Op::horizontal(acc);
+    }
+#endif
+    for (; i < n; ++i) result = Op::apply(result, values[i]);
+    return result;
+}
+
+/// out[j] = Op(in[2j], in[2j + 1]); an odd last value is copied
+template<typename Op>
+void reduce_pairs(const uint8_t* in, size_t n, uint8_t* out) {
+    size_t pairs = n / 2;
+    size_t j = 0;
+#if defined(CRATEDIGGER_WAVEFORM_SSE2)
+    const __m128i low_bytes = _mm_set1_epi16(0x00FF);
+    for (; j + 16 <= pairs; j += 16) {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + 2 * j));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + 2 * j + 16));
+        // The low byte of each 16-bit lane meets its high byte, then lanes narrow to bytes
+        a = _mm_and_si128(Op::apply(a, _mm_srli_epi16(a, 8)), low_bytes);
+        b = _mm_and_si128(Op::apply(b, _mm_srli_epi16(b, 8)), low_bytes);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + j), _mm_packus_epi16(a, b));
+    }
+#elif defined(CRATEDIGGER_WAVEFORM_NEON)
+    for (; j + 16 <= pairs; j += 16) {
+        uint8x16x2_t v = vld2q_u8(in + 2 * j);
+        vst1q_u8(out + j, Op::apply(v.val[0], v.val[1]));
+    }
+#endif
+    for (; j < pairs; ++j) out[j] = Op::apply(in[2 * j], in[2 * j + 1]);
+    if (n % 2 != 0) out[pairs] = in[n - 1];
+}
+
+// ============================================================================
+// Channels
+// ============================================================================
+
+using Channel = std::vector<uint8_t> WaveformColumns::*;
+
+constexpr Channel kRgbChannels[] = {&WaveformColumns::red, &WaveformColumns::green, &WaveformColumns::blue};
+constexpr Channel kBandChannels[] = {&WaveformColumns::low, &WaveformColumns::mid, &WaveformColumns::high};
+
+/// Call fn for every channel reduced by its peak (all but min_height)
+template<typename Fn>
+void for_each_peak_channel(WaveformStyle style, Fn&& fn) {
+    fn(&WaveformColumns::max_height);
+    if (style == WaveformStyle::RGB) {
+        for (auto channel : kRgbChannels) fn(channel);
+    } else if (style == WaveformStyle::ThreeBand) {
+        for (auto channel : kBandChannels) fn(channel);
+    }
+}
+
+/// Size the channels present for a style and empty the others
+void reset_columns(WaveformColumns& columns, WaveformStyle style, size_t size) {
+    columns.style = style;
+    columns.min_height.resize(size);
+    for (auto channel : kRgbChannels) {
+        (columns.*channel).resize(style == WaveformStyle::RGB ? size : 0);
+    }
+    for (auto channel : kBandChannels) {
+        (columns.*channel).resize(style == WaveformStyle::ThreeBand ? size : 0);
+    }
+    columns.max_height.resize(size);
+}
+
+/// Decode raw entries (same interpretation as the WaveformData accessors)
+void decode_entries(const WaveformData& waveform, WaveformColumns& out) {
+    const size_t count = waveform.entry_count;
+    const auto& data = waveform.data;
+    reset_columns(out, waveform.style, count);
+
+    switch (waveform.style) {
+        case WaveformStyle::Blue:
+            for (size_t i = 0; i < count; ++i) {
+                out.max_height[i] = i < data.size() ? data[i] & 0x1F : 0;
+            }
+            break;
+        case WaveformStyle::RGB:
+            for (size_t i = 0; i < count; ++i) {
+                size_t offset = i * 2;
+                if (offset + 1 >= data.size()) {
+                    out.max_height[i] = 0;
+                    out.red[i] = out.green[i] = out.blue[i] = 0xFF;
+                    continue;
+                }
+                uint16_t packed = static_cast<uint16_t>((data[offset] << 8) | data[offset + 1]);
+                out.max_height[i] = data[offset + 1] & 0x1F;
+                out.red[i] = static_cast<uint8_t>(((packed >> 11) & 0x1F) << 3);
+                out.green[i] = static_cast<uint8_t>(((packed >> 5) & 0x3F) << 2);
+                out.blue[i] = static_cast<uint8_t>((packed & 0x1F) << 3);
+            }
+            break;
+        case WaveformStyle::ThreeBand:
+            for (size_t i = 0; i < count; ++i) {
+                size_t offset = i * 3;
+                bool present = offset + 2 < data.size();
+                out.low[i] = present ? data[offset] & 0x1F : 0;
+                out.mid[i] = present ? data[offset + 1] & 0x1F : 0;
+                out.high[i] = present ? data[offset + 2] & 0x1F : 0;
+                out.max_height[i] = std::max({out.low[i], out.mid[i], out.high[i]});
+            }
+            break;
+    }
+    out.min_height = out.max_height;
+}
+
+/// Consecutive values [begin, begin + length) of one mip level
+struct ReductionRun {
+    size_t level;
+    size_t begin;
+    size_t length;
+};
+
+/// Reduce one channel of every column straight from the decoded entries
+template<typename Op>
+void reduce_entries(const WaveformColumns& entries, Channel channel, const std::vector<size_t>& bounds,
+                    WaveformColumns& out) {
+    const uint8_t* values = (entries.*channel).data();
+    auto& result = out.*channel;
+    for (size_t x = 0; x + 1 < bounds.size(); ++x) {
+        size_t begin = bounds[x];
+        size_t length = std::max<size_t>(1, bounds[x + 1] - begin);
+        result[x] = reduce_run<Op>(values + begin, length);
+    }
+}
+
+/// Reduce one channel of every column from its runs of mip-level values
+template<typename Op>
+void reduce_columns(const std::vector<WaveformColumns>& levels, Channel channel, const std::vector<ReductionRun>& runs,
+                    const std::vector<size_t>& column_runs, WaveformColumns& out) {
+    std::vector<const uint8_t*> level_values;
+    for (const auto& level : levels) level_values.push_back((level.*channel).data());
+
+    auto& result = out.*channel;
+    for (size_t x = 0; x + 1 < column_runs.size(); ++x) {
+        uint8_t acc = Op::kIdentity;
+        for (size_t i = column_runs[x]; i < column_runs[x + 1]; ++i) {
+            const auto& run = runs[i];
+            const uint8_t* values = level_values[run.level] + run.begin;
+            acc = Op::apply(acc, run.length == 1 ? *values : reduce_run<Op>(values, run.length));
+        }
+        result[x] = acc;
+    }
+}
+
+} // anonymous namespace
+
+// ============================================================================
+// DecodedWaveform
+// ============================================================================
+
+DecodedWaveform::DecodedWaveform(const WaveformData& waveform) {
+    decode_entries(waveform, levels_[0]);
+
+    while (levels_.back().size() > 1) {
+        const size_t n = levels_.back().size();
+        WaveformColumns next;
+        reset_columns(next, waveform.style, (n + 1) / 2);
+        const auto& prev = levels_.back();
+        reduce_pairs<MinOp>(prev.min_height.data(), n, next.min_height.data());
+        for_each_peak_channel(waveform.style, [&](Channel channel) {
+            reduce_pairs<MaxOp>((prev.*channel).data(), n, (next.*channel).data());
+        });
+        levels_.push_back(std::move(next));
+    }
+}
+
+WaveformColumns DecodedWaveform::render(size_t first, size_t last, size_t width) const {
+    WaveformColumns columns;
+    render_into(first, last, width, columns);
+    return columns;
+}
+
+void DecodedWaveform::render_into(size_t first, size_t last, size_t width, WaveformColumns& out) const {
+    last = std::min(last, size());
+    const size_t n = first < last ? last - first : 0;
+    const size_t columns = n != 0 ? width : 0;
+    reset_columns(out, style(), columns);
+
+    // Column x covers [bounds[x], max(bounds[x] + 1, bounds[x + 1])), stepped without divisions
+    std::vector<size_t> bounds(columns + 1, last);
+    const size_t step = columns != 0 ? n / columns : 0;
+    const size_t remainder = columns != 0 ? n % columns : 0;
+    for (size_t x = 0, position = first, fraction = 0; x < columns; ++x) {
+        bounds[x] = position;
+        position += step;
+        fraction += remainder;
+        if (fraction >= columns) {
+            fraction -= columns;
+            ++position;
+        }
+    }
+
+    if (step + 1 <= kDirectRun) {
+        // Short columns: reduce the entries directly
+        reduce_entries<MinOp>(levels_[0], &WaveformColumns::min_height, bounds, out);
+        for_each_peak_channel(style(), [&](Channel channel) {
+            reduce_entries<MaxOp>(levels_[0], channel, bounds, out);
+        });
+        return;
+    }
+
+    // A column is covered by whole nodes of the coarsest levels that fit, climbing like
+    // a bottom-up segment tree: at most two nodes per level plus one contiguous run.
+    // The runs depend only on the geometry, so they are found once for every channel.
+    std::vector<ReductionRun> runs;
+    std::vector<size_t> column_runs(columns + 1, 0);
+    for (size_t x = 0; x < columns; ++x) {
+        size_t l = bounds[x];
+        size_t r = bounds[x + 1];
+        size_t k = 0;
+        while (r - l > kDirectRun && k + 1 < levels_.size()) {
+            if (l & 1) runs.push_back({k, l++, 1});
+            if (r & 1) runs.push_back({k, --r, 1});
+            l >>= 1;
+            r >>= 1;
+            ++k;
+        }
+        if (l < r) runs.push_back({k, l, r - l});
+        column_runs[x + 1] = runs.size();
+    }
+
+    reduce_columns<MinOp>(levels_, &WaveformColumns::min_height, runs, column_runs, out);
+    for_each_peak_channel(style(), [&](Channel channel) {
+        reduce_columns<MaxOp>(levels_, channel, runs, column_runs, out);
+    });
+}
+
+} // namespace cratedigger
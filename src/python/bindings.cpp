@@ -13,12 +13,65 @@
 #include <nanobind/stl/vector.h>
 #include <nanobind/stl/optional.h>
 #include <nanobind/stl/filesystem.h>
+#include <nanobind/stl/shared_ptr.h>
+#include <nanobind/ndarray.h>
 
 #include "cratedigger/cratedigger.hpp"
 
 namespace nb = nanobind;
 using namespace cratedigger;
 
+namespace {
+
+/// Read-only 1-D NumPy view over a column owned by the Database
+template<typename T>
+using ColumnView = nb::ndarray<nb::numpy, const T, nb::ndim<1>>;
+
+/// Borrow a column; the reference_internal policy keeps the Database alive
+template<typename T>
+ColumnView<T> column_view(const std::vector<T>& column) {
+    return ColumnView<T>(column.data(), {column.size()}, nb::handle());
+}
+
+/// Borrow an ID span as int64 (handle types are a single int64_t)
+template<typename IdType>
+ColumnView<int64_t> id_view(Span<const IdType> ids) {
+    static_assert(sizeof(IdType) == sizeof(int64_t), "handle types wrap one int64_t");
+    return ColumnView<int64_t>(reinterpret_cast<const int64_t*>(ids.data()), {ids.size()}, nb::handle());
+}
+
+/// Input array of doubles (any float array is converted by nanobind)
+using DoubleArray = nb::ndarray<const double, nb::ndim<1>, nb::c_contig, nb::device::cpu>;
+
+/// Caller-provided output array of doubles
+using DoubleOut = nb::ndarray<nb::numpy, double, nb::ndim<1>, nb::c_contig>;
+
+/// New NumPy array of count elements that owns its buffer
+template<typename T>
+nb::ndarray<nb::numpy, T, nb::ndim<1>> new_array(size_t count) {
+    auto* data = new T[count];
+    nb::capsule owner(data, [](void* p) noexcept { delete[] static_cast<T*>(p); });
+    return nb::ndarray<nb::numpy, T, nb::ndim<1>>(data, {count}, owner);
+}
+
+/// Output array of doubles: out when given (must match count), otherwise a new NumPy array
+nb::ndarray<nb::numpy, double, nb::ndim<1>> output_array(std::optional<DoubleOut> out, size_t count) {
+    if (out) {
+        if (out->shape(0) != count) throw nb::value_error("out must have the same length as the input");
+        return nb::ndarray<nb::numpy, double, nb::ndim<1>>(out->data(), {count}, out->handle());
+    }
+    return new_array<double>(count);
+}
+
+/// Python strings for a column of views
+nb::list string_list(const std::string_view* views, size_t count) {
+    nb::list list;
+    for (size_t i = 0; i < count; ++i) list.append(nb::str(views[i].data(), views[i].size()));
+    return list;
+}
+
+} // anonymous namespace
+
 NB_MODULE(crate_digger, m) {
     m.doc() = "Crate Digger - Rekordbox database parser for Python/AI integration";
 
@@ -191,6 +244,28 @@ NB_MODULE(crate_digger, m) {
                    ", title=\"" + t.title + "\")";
         });
 
+    // Borrowed view: string fields are converted to str on access
+    nb::class_<TrackRowView>(m, "TrackRowView")
+        .def_ro("id", &TrackRowView::id)
+        .def_ro("title", &TrackRowView::title)
+        .def_ro("artist_id", &TrackRowView::artist_id)
+        .def_ro("album_id", &TrackRowView::album_id)
+        .def_ro("genre_id", &TrackRowView::genre_id)
+        .def_ro("key_id", &TrackRowView::key_id)
+        .def_ro("duration_seconds", &TrackRowView::duration_seconds)
+        .def_ro("bpm_100x", &TrackRowView::bpm_100x)
+        .def_ro("rating", &TrackRowView::rating)
+        .def_ro("year", &TrackRowView::year)
+        .def_ro("file_path", &TrackRowView::file_path)
+        .def_ro("filename", &TrackRowView::filename)
+        .def_ro("analyze_path", &TrackRowView::analyze_path)
+        .def_prop_ro("bpm", &TrackRowView::bpm)
+        .def("to_row", &TrackRowView::to_row, "Copy into an owning TrackRow")
+        .def("__repr__", [](const TrackRowView& t) {
+            return "TrackRowView(id=" + std::to_string(t.id.value) +
+                   ", title=\"" + std::string(t.title) + "\")";
+        });
+
     nb::class_<ArtistRow>(m, "ArtistRow")
         .def_ro("id", &ArtistRow::id)
         .def_ro("name", &ArtistRow::name)
@@ -316,6 +391,55 @@ NB_MODULE(crate_digger, m) {
                    ", avg_bpm=" + std::to_string(bg.average_bpm()) + ")";
         });
 
+    nb::class_<TempoSegment>(m, "TempoSegment")
+        .def_ro("start_ms", &TempoSegment::start_ms)
+        .def_ro("ms_per_beat", &TempoSegment::ms_per_beat)
+        .def_ro("first_beat", &TempoSegment::first_beat)
+        .def_ro("beat_count", &TempoSegment::beat_count)
+        .def_ro("tempo_100x", &TempoSegment::tempo_100x)
+        .def_prop_ro("bpm", &TempoSegment::bpm);
+
+    nb::class_<BeatPosition>(m, "BeatPosition")
+        .def_ro("beat", &BeatPosition::beat)
+        .def_ro("bar", &BeatPosition::bar)
+        .def_ro("beat_in_bar", &BeatPosition::beat_in_bar)
+        .def_ro("beat_phase", &BeatPosition::beat_phase)
+        .def_ro("bar_phase", &BeatPosition::bar_phase)
+        .def_ro("bpm", &BeatPosition::bpm);
+
+    nb::class_<TempoMap>(m, "TempoMap")
+        .def(nb::init<const BeatGrid&>(), nb::arg("grid"),
+             "Split a beat grid into constant-tempo segments for O(1) time/beat conversion")
+        .def("empty", &TempoMap::empty)
+        .def_prop_ro("beat_count", &TempoMap::beat_count)
+        .def_prop_ro("segments", &TempoMap::segments)
+        .def("time_to_beat", &TempoMap::time_to_beat, nb::arg("time_ms"))
+        .def("beat_to_time", &TempoMap::beat_to_time, nb::arg("beat"))
+        .def("position_at", &TempoMap::position_at, nb::arg("time_ms"),
+             "Fractional beat, bar, beat in bar and phases at a time")
+        .def("bpm_at", &TempoMap::bpm_at, nb::arg("time_ms"))
+        .def("times_to_beats", [](const TempoMap& t, DoubleArray times,
+                                  std::optional<DoubleOut> out) {
+            auto result = output_array(out, times.shape(0));
+            t.times_to_beats(times.data(), times.shape(0), result.data());
+            return result;
+        }, nb::arg("times_ms"), nb::arg("out") = nb::none(),
+           "Fractional beats for an array of times (written into out when given)")
+        .def("beats_to_times", [](const TempoMap& t, DoubleArray beats,
+                                  std::optional<DoubleOut> out) {
+            auto result = output_array(out, beats.shape(0));
+            t.beats_to_times(beats.data(), beats.shape(0), result.data());
+            return result;
+        }, nb::arg("beats"), nb::arg("out") = nb::none(),
+           "Times for an array of fractional beats (written into out when given)")
+        .def("quantize", [](const TempoMap& t, DoubleArray times, double resolution,
+                            std::optional<DoubleOut> out) {
+            auto result = output_array(out, times.shape(0));
+            t.quantize(times.data(), times.shape(0), result.data(), resolution);
+            return result;
+        }, nb::arg("times_ms"), nb::arg("resolution") = 1.0, nb::arg("out") = nb::none(),
+           "Snap times to the nearest multiple of resolution beats");
+
     // ========================================================================
     // Waveform Types
     // ========================================================================
@@ -325,6 +449,16 @@ NB_MODULE(crate_digger, m) {
         .value("RGB", WaveformStyle::RGB)
         .value("ThreeBand", WaveformStyle::ThreeBand);
 
+    nb::enum_<AnlzSections>(m, "AnlzSections", nb::is_flag())
+        .value("NONE", AnlzSections::None)
+        .value("CuePoints", AnlzSections::CuePoints)
+        .value("BeatGrid", AnlzSections::BeatGrid)
+        .value("WaveformPreviews", AnlzSections::WaveformPreviews)
+        .value("WaveformDetails", AnlzSections::WaveformDetails)
+        .value("SongStructure", AnlzSections::SongStructure)
+        .value("Waveforms", AnlzSections::Waveforms)
+        .value("All", AnlzSections::All);
+
     nb::class_<WaveformData>(m, "WaveformData")
         .def_ro("style", &WaveformData::style)
         .def_ro("entry_count", &WaveformData::entry_count)
@@ -347,6 +481,36 @@ NB_MODULE(crate_digger, m) {
                    ", entries=" + std::to_string(w.entry_count) + ")";
         });
 
+    nb::class_<WaveformColumns>(m, "WaveformColumns")
+        .def_ro("style", &WaveformColumns::style)
+        .def("__len__", &WaveformColumns::size)
+        .def("min_height", [](const WaveformColumns& c) { return column_view(c.min_height); },
+             nb::rv_policy::reference_internal)
+        .def("max_height", [](const WaveformColumns& c) { return column_view(c.max_height); },
+             nb::rv_policy::reference_internal)
+        .def("red", [](const WaveformColumns& c) { return column_view(c.red); }, nb::rv_policy::reference_internal)
+        .def("green", [](const WaveformColumns& c) { return column_view(c.green); },
+             nb::rv_policy::reference_internal)
+        .def("blue", [](const WaveformColumns& c) { return column_view(c.blue); }, nb::rv_policy::reference_internal)
+        .def("low", [](const WaveformColumns& c) { return column_view(c.low); }, nb::rv_policy::reference_internal)
+        .def("mid", [](const WaveformColumns& c) { return column_view(c.mid); }, nb::rv_policy::reference_internal)
+        .def("high", [](const WaveformColumns& c) { return column_view(c.high); }, nb::rv_policy::reference_internal);
+
+    nb::class_<DecodedWaveform>(m, "DecodedWaveform")
+        .def(nb::init<const WaveformData&>(), nb::arg("waveform"),
+             "Decode every entry into planar uint8 channels and build mip levels")
+        .def_prop_ro("style", &DecodedWaveform::style)
+        .def("__len__", &DecodedWaveform::size)
+        .def("entries", &DecodedWaveform::entries, nb::rv_policy::reference_internal,
+             "Decoded entries (channels as NumPy views)")
+        .def("level_count", &DecodedWaveform::level_count)
+        .def("level", &DecodedWaveform::level, nb::arg("k"), nb::rv_policy::reference_internal)
+        .def("render", [](const DecodedWaveform& w, size_t width, size_t first, std::optional<size_t> last) {
+            return w.render(first, last.value_or(w.size()), width);
+        }, nb::arg("width"), nb::arg("first") = 0, nb::arg("last") = nb::none(),
+           nb::call_guard<nb::gil_scoped_release>(),
+           "Reduce entries [first, last) to width columns (min/max height, peak colors and bands)");
+
     nb::class_<TrackWaveforms>(m, "TrackWaveforms")
         .def_ro("preview", &TrackWaveforms::preview)
         .def_ro("detail", &TrackWaveforms::detail)
@@ -426,31 +590,271 @@ NB_MODULE(crate_digger, m) {
                    ", phrases=" + std::to_string(s.size()) + ")";
         });
 
+    nb::class_<TrackAnalysis>(m, "TrackAnalysis")
+        .def_prop_ro("cue_points", [](const TrackAnalysis& a) {
+            std::vector<CuePoint> result;
+            result.reserve(a.cue_points.size());
+            for (const auto& data : a.cue_points) {
+                CuePoint cue;
+                cue.type = data.type;
+                cue.time_ms = data.time_ms;
+                cue.loop_time_ms = data.loop_time_ms;
+                cue.hot_cue_number = static_cast<uint8_t>(data.hot_cue_number);
+                cue.color_id = data.color_id;
+                cue.comment = data.comment;
+                result.push_back(std::move(cue));
+            }
+            return result;
+        })
+        .def_ro("beat_grid", &TrackAnalysis::beat_grid)
+        .def_ro("waveforms", &TrackAnalysis::waveforms)
+        .def_ro("song_structure", &TrackAnalysis::song_structure)
+        .def("empty", &TrackAnalysis::empty)
+        .def("__repr__", [](const TrackAnalysis& a) {
+            return "TrackAnalysis(cues=" + std::to_string(a.cue_points.size()) +
+                   ", beats=" + std::to_string(a.beat_grid.size()) + ")";
+        });
+
+    // ========================================================================
+    // Track Query
+    // ========================================================================
+
+    nb::class_<TrackQuery>(m, "TrackQuery")
+        .def(nb::init<>())
+        .def_rw("min_bpm", &TrackQuery::min_bpm)
+        .def_rw("max_bpm", &TrackQuery::max_bpm)
+        .def_rw("key", &TrackQuery::key)
+        .def_rw("genre", &TrackQuery::genre)
+        .def_rw("artist", &TrackQuery::artist)
+        .def_rw("min_rating", &TrackQuery::min_rating)
+        .def_rw("max_rating", &TrackQuery::max_rating)
+        .def_rw("min_year", &TrackQuery::min_year)
+        .def_rw("max_year", &TrackQuery::max_year)
+        .def_rw("min_duration", &TrackQuery::min_duration)
+        .def_rw("max_duration", &TrackQuery::max_duration);
+
+    // ========================================================================
+    // Text Search
+    // ========================================================================
+
+    nb::enum_<TextField>(m, "TextField")
+        .value("Title", TextField::Title)
+        .value("Artist", TextField::Artist)
+        .value("Album", TextField::Album)
+        .value("FileName", TextField::FileName)
+        .value("FilePath", TextField::FilePath);
+
+    nb::class_<TextSearchOptions>(m, "TextSearchOptions")
+        .def(nb::init<>())
+        .def_rw("limit", &TextSearchOptions::limit)
+        .def_rw("fields", &TextSearchOptions::fields)
+        .def_rw("prefix_only", &TextSearchOptions::prefix_only)
+        .def_rw("fuzzy", &TextSearchOptions::fuzzy);
+
+    nb::class_<TextSearchHit>(m, "TextSearchHit")
+        .def_ro("track_id", &TextSearchHit::track_id)
+        .def_ro("field", &TextSearchHit::field)
+        .def_ro("score", &TextSearchHit::score)
+        .def("__repr__", [](const TextSearchHit& h) {
+            return "TextSearchHit(track_id=" + std::to_string(h.track_id.value) +
+                   ", score=" + std::to_string(h.score) + ")";
+        });
+
+    // ========================================================================
+    // Metrics
+    // ========================================================================
+
+    nb::class_<TableMetrics>(m, "TableMetrics")
+        .def_ro("table", &TableMetrics::table)
+        .def_ro("pages", &TableMetrics::pages)
+        .def_ro("rows", &TableMetrics::rows)
+        .def_ro("bytes", &TableMetrics::bytes)
+        .def_ro("parse_ns", &TableMetrics::parse_ns);
+
+    nb::class_<AnlzMetrics>(m, "AnlzMetrics")
+        .def_ro("files_parsed", &AnlzMetrics::files_parsed)
+        .def_ro("files_failed", &AnlzMetrics::files_failed)
+        .def_ro("bytes_read", &AnlzMetrics::bytes_read)
+        .def_ro("load_ns", &AnlzMetrics::load_ns)
+        .def_ro("snapshot_hits", &AnlzMetrics::snapshot_hits)
+        .def_ro("snapshot_misses", &AnlzMetrics::snapshot_misses)
+        .def_ro("cache_hits", &AnlzMetrics::cache_hits)
+        .def_ro("cache_misses", &AnlzMetrics::cache_misses)
+        .def_prop_ro("files_per_second", &AnlzMetrics::files_per_second)
+        .def_prop_ro("cache_hit_rate", &AnlzMetrics::cache_hit_rate);
+
+    nb::class_<DatabaseMetrics>(m, "DatabaseMetrics")
+        .def_ro("open_ns", &DatabaseMetrics::open_ns)
+        .def_ro("read_ns", &DatabaseMetrics::read_ns)
+        .def_ro("index_ns", &DatabaseMetrics::index_ns)
+        .def_ro("file_bytes", &DatabaseMetrics::file_bytes)
+        .def_ro("page_size", &DatabaseMetrics::page_size)
+        .def_ro("snapshot_restored", &DatabaseMetrics::snapshot_restored)
+        .def_ro("tables", &DatabaseMetrics::tables)
+        .def_ro("pooled_strings", &DatabaseMetrics::pooled_strings)
+        .def_ro("pooled_string_bytes", &DatabaseMetrics::pooled_string_bytes)
+        .def_ro("anlz", &DatabaseMetrics::anlz)
+        .def("to_json", [](const DatabaseMetrics& metrics) { return to_json(metrics); },
+             "Metrics as one JSON object (json.loads() gives a dict)");
+
+    // ========================================================================
+    // Playlist Tree
+    // ========================================================================
+
+    nb::class_<PlaylistTree>(m, "PlaylistTree")
+        .def("__len__", &PlaylistTree::size)
+        .def_ro("root_count", &PlaylistTree::root_count)
+        .def("find", [](const PlaylistTree& t, PlaylistId id) -> std::optional<uint32_t> {
+            uint32_t node = t.find(id);
+            if (node == PlaylistTree::kNoParent) return std::nullopt;
+            return node;
+        }, nb::arg("playlist_id"), "Node index of a folder or playlist (None if not in the tree)")
+        .def("id", [](const PlaylistTree& t) { return column_view(t.id); }, nb::rv_policy::reference_internal)
+        .def("parent", [](const PlaylistTree& t) { return column_view(t.parent); },
+             nb::rv_policy::reference_internal, "Parent node index (0xFFFFFFFF at top level)")
+        .def("first_child", [](const PlaylistTree& t) { return column_view(t.first_child); },
+             nb::rv_policy::reference_internal)
+        .def("child_count", [](const PlaylistTree& t) { return column_view(t.child_count); },
+             nb::rv_policy::reference_internal)
+        .def("depth", [](const PlaylistTree& t) { return column_view(t.depth); }, nb::rv_policy::reference_internal)
+        .def("is_folder", [](const PlaylistTree& t) { return column_view(t.is_folder); },
+             nb::rv_policy::reference_internal)
+        .def("track_count", [](const PlaylistTree& t) { return column_view(t.track_count); },
+             nb::rv_policy::reference_internal)
+        .def("names", [](const PlaylistTree& t) { return string_list(t.name.data(), t.name.size()); });
+
+    // ========================================================================
+    // Tag Queries
+    // ========================================================================
+
+    nb::class_<TrackBitmap>(m, "TrackBitmap")
+        .def(nb::init<>())
+        .def_static("from_ids", [](const std::vector<TrackId>& ids) { return TrackBitmap::from_ids(ids); },
+                    nb::arg("ids"))
+        .def("__len__", &TrackBitmap::cardinality)
+        .def("__contains__", &TrackBitmap::contains, nb::arg("track_id"))
+        .def("ids", [](const TrackBitmap& b) {
+            auto ids = new_array<int64_t>(b.cardinality());
+            int64_t* out = ids.data();
+            b.for_each([&out](TrackId id) { *out++ = id.value; });
+            return ids;
+        }, "Track IDs in ascending order as a new int64 array")
+        .def_prop_ro("container_count", &TrackBitmap::container_count)
+        .def_prop_ro("bytes", &TrackBitmap::bytes)
+        .def("__and__", &TrackBitmap::operator&)
+        .def("__or__", &TrackBitmap::operator|)
+        .def("__sub__", &TrackBitmap::operator-)
+        .def("__eq__", &TrackBitmap::operator==)
+        .def("__repr__", [](const TrackBitmap& b) {
+            return "TrackBitmap(" + std::to_string(b.cardinality()) + " tracks)";
+        });
+
+    nb::class_<TagQuery>(m, "TagQuery")
+        .def(nb::init<>(), "Query matching every track")
+        .def_static("tag", &TagQuery::tag, nb::arg("tag_id"))
+        .def_static("category", &TagQuery::category, nb::arg("category_id"))
+        .def_static("parse", [](std::string_view text, const Database& ext) {
+            auto result = TagQuery::parse(text, ext);
+            if (!result) throw std::runtime_error(result.error().message);
+            return std::move(*result);
+        }, nb::arg("text"), nb::arg("ext"), "Parse e.g. '(Peak Time OR Warmup) AND Vocal AND NOT Remix'")
+        .def("__and__", &TagQuery::operator&)
+        .def("__or__", &TagQuery::operator|)
+        .def("__invert__", &TagQuery::operator!);
+
+    // ========================================================================
+    // Similarity
+    // ========================================================================
+
+    nb::class_<CamelotKey>(m, "CamelotKey")
+        .def(nb::init<>())
+        .def_rw("number", &CamelotKey::number)
+        .def_rw("major", &CamelotKey::major)
+        .def("valid", &CamelotKey::valid)
+        .def("__repr__", [](const CamelotKey& k) {
+            return k.valid() ? std::to_string(k.number) + (k.major ? "B" : "A") : std::string("?");
+        });
+
+    m.def("camelot_key", &camelot_key, nb::arg("name"), "Camelot position of a key name ('Am', 'F#', '8A')");
+    m.def("camelot_distance", &camelot_distance, nb::arg("a"), nb::arg("b"),
+          "Harmonic distance in Camelot steps (255 if either key is unknown)");
+
+    nb::class_<SimilarityWeights>(m, "SimilarityWeights")
+        .def(nb::init<>())
+        .def_rw("bpm", &SimilarityWeights::bpm)
+        .def_rw("key", &SimilarityWeights::key)
+        .def_rw("genre", &SimilarityWeights::genre)
+        .def_rw("year", &SimilarityWeights::year)
+        .def_rw("energy", &SimilarityWeights::energy)
+        .def_rw("mood", &SimilarityWeights::mood);
+
+    nb::class_<SimilarityQuery>(m, "SimilarityQuery")
+        .def(nb::init<>())
+        .def_rw("limit", &SimilarityQuery::limit)
+        .def_rw("bpm_tolerance", &SimilarityQuery::bpm_tolerance)
+        .def_rw("half_double_time", &SimilarityQuery::half_double_time)
+        .def_rw("max_key_distance", &SimilarityQuery::max_key_distance)
+        .def_rw("same_genre", &SimilarityQuery::same_genre)
+        .def_rw("weights", &SimilarityQuery::weights)
+        .def_ro_static("ANY_KEY", &SimilarityQuery::kAnyKey);
+
+    nb::class_<SimilarityHit>(m, "SimilarityHit")
+        .def_ro("id", &SimilarityHit::id)
+        .def_ro("distance", &SimilarityHit::distance);
+
+    nb::class_<TrackFeatures>(m, "TrackFeatures")
+        .def_ro("id", &TrackFeatures::id)
+        .def_ro("bpm", &TrackFeatures::bpm)
+        .def_ro("key", &TrackFeatures::key)
+        .def_ro("genre_id", &TrackFeatures::genre_id)
+        .def_ro("year", &TrackFeatures::year)
+        .def_ro("energy", &TrackFeatures::energy)
+        .def_ro("mood", &TrackFeatures::mood);
+
+    nb::class_<SimilarityIndex>(m, "SimilarityIndex")
+        .def(nb::init<const Database&, bool>(), nb::arg("db"), nb::arg("use_analysis") = true,
+             "Extract per-track features (load ANLZ data first for energy and mood)")
+        .def("__len__", &SimilarityIndex::size)
+        .def("features", &SimilarityIndex::features, nb::arg("track_id"))
+        .def("nearest", &SimilarityIndex::nearest, nb::arg("seed"), nb::arg("query") = SimilarityQuery{},
+             nb::call_guard<nb::gil_scoped_release>(), "Most similar tracks to seed, closest first");
+
     // ========================================================================
     // Database Class
     // ========================================================================
 
     nb::class_<Database>(m, "Database")
-        .def_static("open", [](const std::filesystem::path& path) {
-            auto result = Database::open(path);
+        .def_static("open", [](const std::filesystem::path& path, bool memory_map, size_t threads,
+                               bool parallel_indexing) {
+            DatabaseOptions options;
+            options.io_mode = memory_map ? IoMode::MemoryMapped : IoMode::Buffered;
+            options.thread_count = threads;
+            options.parallel_indexing = parallel_indexing;
+            auto result = Database::open(path, options);
             if (!result) {
                 throw std::runtime_error(result.error().message);
             }
             return std::move(*result);
-        }, nb::arg("path"),
-           "Open a rekordbox export.pdb database file")
+        }, nb::arg("path"), nb::arg("memory_map") = false, nb::arg("threads") = 1,
+           nb::arg("parallel_indexing") = false,
+           "Open a rekordbox export.pdb database file (optionally memory-mapped; threads=0 uses all cores for "
+           "ANLZ loading and, with parallel_indexing=True, for building the indices)")
 
-        .def_static("open_ext", [](const std::filesystem::path& path) {
-            auto result = Database::open_ext(path);
+        .def_static("open_ext", [](const std::filesystem::path& path, bool memory_map) {
+            DatabaseOptions options;
+            options.io_mode = memory_map ? IoMode::MemoryMapped : IoMode::Buffered;
+            auto result = Database::open_ext(path, options);
             if (!result) {
                 throw std::runtime_error(result.error().message);
             }
             return std::move(*result);
-        }, nb::arg("path"),
-           "Open a rekordbox exportExt.pdb database file")
+        }, nb::arg("path"), nb::arg("memory_map") = false,
+           "Open a rekordbox exportExt.pdb database file (optionally memory-mapped)")
 
         // Primary index access
         .def("get_track", &Database::get_track, nb::arg("track_id"))
+        .def("get_track_view", &Database::get_track_view, nb::arg("track_id"),
+             nb::rv_policy::reference_internal, "Get a track without copying its strings (None if not found)")
         .def("get_artist", &Database::get_artist, nb::arg("artist_id"))
         .def("get_album", &Database::get_album, nb::arg("album_id"))
         .def("get_genre", &Database::get_genre, nb::arg("genre_id"))
@@ -481,12 +885,58 @@ NB_MODULE(crate_digger, m) {
              "Find tracks by specific year")
         .def("find_tracks_by_rating", &Database::find_tracks_by_rating, nb::arg("rating"),
              "Find tracks by specific rating (0-5)")
+        .def("find_tracks", &Database::find_tracks, nb::arg("query"),
+             "Find tracks matching every set predicate of a TrackQuery")
+        .def("search_tracks", &Database::search_tracks,
+             nb::arg("query"), nb::arg("options") = TextSearchOptions{},
+             "Ranked case-insensitive search over titles, artists, albums and file paths")
+        .def("find_tracks_by_filename", &Database::find_tracks_by_filename, nb::arg("filename"),
+             "Find tracks by file name (case-insensitive)")
 
         // Playlist access
         .def("get_playlist", &Database::get_playlist, nb::arg("playlist_id"))
         .def("get_playlist_folder", &Database::get_playlist_folder, nb::arg("folder_id"))
         .def("get_history_playlist", &Database::get_history_playlist, nb::arg("playlist_id"))
         .def("find_history_playlist_by_name", &Database::find_history_playlist_by_name, nb::arg("name"))
+        .def("playlist_tree", &Database::playlist_tree, nb::rv_policy::reference_internal,
+             "Flattened playlist hierarchy as zero-copy node columns")
+        .def("materialize_playlist", [](const Database& db, PlaylistId id) {
+            size_t count = db.get_playlist_view(id).size();
+            auto track_id = new_array<int64_t>(count);
+            auto bpm_100x = new_array<uint32_t>(count);
+            auto duration = new_array<uint32_t>(count);
+            auto rating = new_array<uint16_t>(count);
+            auto key_id = new_array<int64_t>(count);
+            std::vector<std::string_view> title(count), artist(count), album(count), genre(count), key(count);
+
+            PlaylistRowBuffers out;
+            out.capacity = count;
+            out.track_id = track_id.data();
+            out.bpm_100x = bpm_100x.data();
+            out.duration = duration.data();
+            out.rating = rating.data();
+            out.key_id = key_id.data();
+            out.title = title.data();
+            out.artist = artist.data();
+            out.album = album.data();
+            out.genre = genre.data();
+            out.key = key.data();
+            db.materialize_playlist(id, out);
+
+            nb::dict columns;
+            columns["track_id"] = track_id;
+            columns["bpm_100x"] = bpm_100x;
+            columns["duration"] = duration;
+            columns["rating"] = rating;
+            columns["key_id"] = key_id;
+            columns["title"] = string_list(title.data(), count);
+            columns["artist"] = string_list(artist.data(), count);
+            columns["album"] = string_list(album.data(), count);
+            columns["genre"] = string_list(genre.data(), count);
+            columns["key"] = string_list(key.data(), count);
+            return columns;
+        }, nb::arg("playlist_id"),
+           "Playlist entries joined with track metadata: NumPy arrays for numbers, lists for names")
 
         // Tag access (exportExt.pdb)
         .def("get_tag", &Database::get_tag, nb::arg("tag_id"))
@@ -495,6 +945,11 @@ NB_MODULE(crate_digger, m) {
         .def("find_tags_by_track", &Database::find_tags_by_track, nb::arg("track_id"))
         .def("all_tag_ids", &Database::all_tag_ids)
         .def_prop_ro("tag_count", &Database::tag_count)
+        .def("find_tracks_by_tags", &Database::find_tracks_by_tags, nb::arg("query"),
+             nb::arg("tracks").none() = nb::none(),
+             "Evaluate a TagQuery (NOT is relative to the tracks database when given)")
+        .def("track_views", &Database::track_views, nb::arg("ids"), nb::rv_policy::reference_internal,
+             "Track rows of a TrackBitmap, in ascending ID order")
 
         // Tag category access (exportExt.pdb)
         .def("get_category", &Database::get_category, nb::arg("category_id"),
@@ -510,9 +965,20 @@ NB_MODULE(crate_digger, m) {
 
         // Cue point access (ANLZ files)
         .def("load_cue_points", &Database::load_cue_points, nb::arg("anlz_dir"),
-             "Load cue points from an ANLZ directory")
+             nb::arg("sections") = AnlzSections::All, nb::call_guard<nb::gil_scoped_release>(),
+             "Load cue points from an ANLZ directory, parsing only the given sections")
         .def("load_anlz_file", &Database::load_anlz_file, nb::arg("path"),
-             "Load cue points from a single ANLZ file")
+             nb::arg("sections") = AnlzSections::All,
+             "Load cue points from a single ANLZ file, parsing only the given sections")
+        .def("enable_lazy_anlz_loading", &Database::enable_lazy_anlz_loading,
+             nb::arg("cache_capacity") = 64, nb::arg("export_root") = std::filesystem::path{},
+             "Load ANLZ data per track on first access, keeping an LRU cache of cache_capacity tracks")
+        .def("get_analysis_for_track", [](const Database& db, TrackId id) {
+            // Shared ownership keeps the data alive after eviction from the lazy cache
+            return std::const_pointer_cast<TrackAnalysis>(db.get_analysis_for_track(id));
+        }, nb::arg("track_id"), nb::call_guard<nb::gil_scoped_release>(),
+           "Get cue points, beat grid, waveforms and song structure for a track")
+        .def_prop_ro("cached_analysis_count", &Database::cached_analysis_count)
         .def("get_cue_points", &Database::get_cue_points, nb::arg("track_path"),
              "Get cue points for a track by its file path")
         .def("get_cue_points_for_track", &Database::get_cue_points_for_track, nb::arg("track_id"),
@@ -525,9 +991,10 @@ NB_MODULE(crate_digger, m) {
         .def("get_beat_grid", &Database::get_beat_grid, nb::arg("track_path"),
              nb::rv_policy::reference,
              "Get beat grid for a track by its file path")
-        .def("get_beat_grid_for_track", &Database::get_beat_grid_for_track, nb::arg("track_id"),
-             nb::rv_policy::reference,
-             "Get beat grid for a track by ID")
+        .def("get_beat_grid_for_track", [](const Database& db, TrackId id) {
+            return std::const_pointer_cast<BeatGrid>(db.get_beat_grid_for_track(id));
+        }, nb::arg("track_id"), nb::call_guard<nb::gil_scoped_release>(),
+           "Get beat grid for a track by ID (shares ownership of the track's analysis)")
         .def("find_beat_grid_by_filename", &Database::find_beat_grid_by_filename, nb::arg("filename"),
              nb::rv_policy::reference,
              "Find beat grid by filename pattern")
@@ -537,9 +1004,10 @@ NB_MODULE(crate_digger, m) {
         .def("get_waveforms", &Database::get_waveforms, nb::arg("track_path"),
              nb::rv_policy::reference,
              "Get waveforms for a track by its file path")
-        .def("get_waveforms_for_track", &Database::get_waveforms_for_track, nb::arg("track_id"),
-             nb::rv_policy::reference,
-             "Get waveforms for a track by ID")
+        .def("get_waveforms_for_track", [](const Database& db, TrackId id) {
+            return std::const_pointer_cast<TrackWaveforms>(db.get_waveforms_for_track(id));
+        }, nb::arg("track_id"), nb::call_guard<nb::gil_scoped_release>(),
+           "Get waveforms for a track by ID (shares ownership of the track's analysis)")
         .def("find_waveforms_by_filename", &Database::find_waveforms_by_filename, nb::arg("filename"),
              nb::rv_policy::reference,
              "Find waveforms by filename pattern")
@@ -549,9 +1017,10 @@ NB_MODULE(crate_digger, m) {
         .def("get_song_structure", &Database::get_song_structure, nb::arg("track_path"),
              nb::rv_policy::reference,
              "Get song structure for a track by its file path")
-        .def("get_song_structure_for_track", &Database::get_song_structure_for_track, nb::arg("track_id"),
-             nb::rv_policy::reference,
-             "Get song structure for a track by ID")
+        .def("get_song_structure_for_track", [](const Database& db, TrackId id) {
+            return std::const_pointer_cast<SongStructure>(db.get_song_structure_for_track(id));
+        }, nb::arg("track_id"), nb::call_guard<nb::gil_scoped_release>(),
+           "Get song structure for a track by ID (shares ownership of the track's analysis)")
         .def("find_song_structure_by_filename", &Database::find_song_structure_by_filename, nb::arg("filename"),
              nb::rv_policy::reference,
              "Find song structure by filename pattern")
@@ -571,6 +1040,9 @@ NB_MODULE(crate_digger, m) {
         .def_prop_ro("genre_count", &Database::genre_count)
         .def_prop_ro("playlist_count", &Database::playlist_count)
         .def_prop_ro("source_file", &Database::source_file)
+        .def_prop_ro("export_root", &Database::export_root)
+        .def("metrics", &Database::metrics,
+             "Open phase times, per-table scans and ANLZ load counters")
 
         // Bulk data extraction for NumPy (returns lists that can be converted)
         .def("get_all_bpms", &Database::get_all_bpms,
@@ -586,9 +1058,254 @@ NB_MODULE(crate_digger, m) {
         .def("get_all_sample_rates", &Database::get_all_sample_rates,
              "Get all track sample rates as a list (for numpy.array)")
 
+        // Zero-copy columnar views (read-only NumPy arrays, track ID order)
+        .def("track_id_column", [](const Database& db) {
+            return column_view(db.track_columns().track_id);
+        }, nb::rv_policy::reference_internal, "Track IDs (int64) in column order")
+        .def("bpm_100x_column", [](const Database& db) {
+            return column_view(db.track_columns().bpm_100x);
+        }, nb::rv_policy::reference_internal, "BPM * 100 (uint32) per track")
+        .def("duration_column", [](const Database& db) {
+            return column_view(db.track_columns().duration);
+        }, nb::rv_policy::reference_internal, "Duration in seconds (uint32) per track")
+        .def("year_column", [](const Database& db) {
+            return column_view(db.track_columns().year);
+        }, nb::rv_policy::reference_internal, "Release year (uint16) per track")
+        .def("rating_column", [](const Database& db) {
+            return column_view(db.track_columns().rating);
+        }, nb::rv_policy::reference_internal, "Rating (uint16) per track")
+        .def("bitrate_column", [](const Database& db) {
+            return column_view(db.track_columns().bitrate);
+        }, nb::rv_policy::reference_internal, "Bitrate (uint32) per track")
+        .def("sample_rate_column", [](const Database& db) {
+            return column_view(db.track_columns().sample_rate);
+        }, nb::rv_policy::reference_internal, "Sample rate (uint32) per track")
+        .def("key_id_column", [](const Database& db) {
+            return column_view(db.track_columns().key_id);
+        }, nb::rv_policy::reference_internal, "Key ID (int64) per track")
+        .def("genre_id_column", [](const Database& db) {
+            return column_view(db.track_columns().genre_id);
+        }, nb::rv_policy::reference_internal, "Genre ID (int64) per track")
+        .def("artist_id_column", [](const Database& db) {
+            return column_view(db.track_columns().artist_id);
+        }, nb::rv_policy::reference_internal, "Artist ID (int64) per track")
+        .def("play_count_column", [](const Database& db) {
+            return column_view(db.track_columns().play_count);
+        }, nb::rv_policy::reference_internal, "Play count (uint16) per track")
+
+        // Zero-copy posting views (read-only int64 NumPy arrays, sorted by ID)
+        .def("find_tracks_by_artist_view", [](const Database& db, ArtistId id) {
+            return id_view(db.find_tracks_by_artist_view(id));
+        }, nb::arg("artist_id"), nb::rv_policy::reference_internal)
+        .def("find_tracks_by_album_view", [](const Database& db, AlbumId id) {
+            return id_view(db.find_tracks_by_album_view(id));
+        }, nb::arg("album_id"), nb::rv_policy::reference_internal)
+        .def("find_tracks_by_genre_view", [](const Database& db, GenreId id) {
+            return id_view(db.find_tracks_by_genre_view(id));
+        }, nb::arg("genre_id"), nb::rv_policy::reference_internal)
+        .def("find_tracks_by_tag_view", [](const Database& db, TagId id) {
+            return id_view(db.find_tracks_by_tag_view(id));
+        }, nb::arg("tag_id"), nb::rv_policy::reference_internal)
+        .def("find_tags_by_track_view", [](const Database& db, TrackId id) {
+            return id_view(db.find_tags_by_track_view(id));
+        }, nb::arg("track_id"), nb::rv_policy::reference_internal)
+        .def("get_playlist_view", [](const Database& db, PlaylistId id) {
+            return id_view(db.get_playlist_view(id));
+        }, nb::arg("playlist_id"), nb::rv_policy::reference_internal,
+           "Playlist entries (int64 track IDs) in playlist order")
+
         .def("__repr__", [](const Database& db) {
             return "Database(tracks=" + std::to_string(db.track_count()) +
                    ", artists=" + std::to_string(db.artist_count()) +
                    ", albums=" + std::to_string(db.album_count()) + ")";
         });
+
+    // ========================================================================
+    // Database Sets
+    // ========================================================================
+
+    nb::class_<SourcedTrack>(m, "SourcedTrack")
+        .def(nb::init<>())
+        .def_rw("source", &SourcedTrack::source)
+        .def_rw("track_id", &SourcedTrack::track_id)
+        .def("__eq__", &SourcedTrack::operator==)
+        .def("__repr__", [](const SourcedTrack& t) {
+            return "SourcedTrack(source=" + std::to_string(t.source) +
+                   ", track_id=" + std::to_string(t.track_id.value) + ")";
+        });
+
+    nb::class_<DatabaseSet>(m, "DatabaseSet")
+        .def_static("open", [](const std::vector<std::filesystem::path>& paths, size_t threads, bool load_anlz) {
+            DatabaseSetOptions options;
+            options.thread_count = threads;
+            options.load_anlz = load_anlz;
+            auto result = DatabaseSet::open(paths, options);
+            if (!result) {
+                throw std::runtime_error(result.error().message);
+            }
+            return std::move(*result);
+        }, nb::arg("paths"), nb::arg("threads") = 0, nb::arg("load_anlz") = false,
+           nb::call_guard<nb::gil_scoped_release>(), "Open several exports and index them together")
+        .def("__len__", &DatabaseSet::size)
+        .def("member", nb::overload_cast<uint32_t>(&DatabaseSet::member, nb::const_), nb::arg("source"),
+             nb::rv_policy::reference_internal)
+        .def("source_path", &DatabaseSet::source_path, nb::arg("source"))
+        .def("failed_paths", [](const DatabaseSet& set) {
+            std::vector<std::filesystem::path> paths;
+            for (const auto& failure : set.failures()) paths.push_back(failure.path);
+            return paths;
+        })
+        .def("track_count", &DatabaseSet::track_count)
+        .def("shared_string_count", &DatabaseSet::shared_string_count)
+        .def("find_tracks_by_isrc", &DatabaseSet::find_tracks_by_isrc, nb::arg("isrc"))
+        .def("find_tracks_by_title", &DatabaseSet::find_tracks_by_title, nb::arg("title"))
+        .def("find_copies", &DatabaseSet::find_copies, nb::arg("track"))
+        .def("find_tracks", &DatabaseSet::find_tracks, nb::arg("query"))
+        .def("find_tracks_by_bpm_range", &DatabaseSet::find_tracks_by_bpm_range,
+             nb::arg("min_bpm"), nb::arg("max_bpm"))
+        .def("__repr__", [](const DatabaseSet& set) {
+            return "DatabaseSet(members=" + std::to_string(set.size()) +
+                   ", tracks=" + std::to_string(set.track_count()) + ")";
+        });
+
+    // ========================================================================
+    // Asynchronous Open
+    // ========================================================================
+
+    nb::enum_<OpenPhase>(m, "OpenPhase")
+        .value("Reading", OpenPhase::Reading)
+        .value("Indexing", OpenPhase::Indexing)
+        .value("LoadingAnlz", OpenPhase::LoadingAnlz)
+        .value("Done", OpenPhase::Done)
+        .value("Failed", OpenPhase::Failed);
+
+    nb::class_<OpenProgress>(m, "OpenProgress")
+        .def_ro("phase", &OpenProgress::phase)
+        .def_ro("tables_done", &OpenProgress::tables_done)
+        .def_ro("tables_total", &OpenProgress::tables_total)
+        .def_ro("anlz_files_done", &OpenProgress::anlz_files_done)
+        .def_ro("anlz_files_total", &OpenProgress::anlz_files_total)
+        .def_prop_ro("finished", &OpenProgress::finished);
+
+    // Poll progress() from the UI loop; no Python callback runs on the loader threads
+    nb::class_<OpenTask>(m, "OpenTask")
+        .def("cancel", &OpenTask::cancel)
+        .def("progress", &OpenTask::progress)
+        .def("ready", &OpenTask::ready)
+        .def("wait_for", [](const OpenTask& task, double seconds) {
+            return task.wait_for(std::chrono::milliseconds(static_cast<int64_t>(seconds * 1000.0)));
+        }, nb::arg("seconds"), nb::call_guard<nb::gil_scoped_release>(),
+           "Wait up to seconds for the open to finish; True if it has")
+        .def("metadata", [](const OpenTask& task) {
+            return std::const_pointer_cast<Database>(task.metadata());
+        }, "Database with core metadata once indexed (None before); ANLZ data arrives with get()")
+        .def("wait_metadata", [](const OpenTask& task) {
+            return std::const_pointer_cast<Database>(task.wait_metadata());
+        }, nb::call_guard<nb::gil_scoped_release>())
+        .def("get", [](OpenTask& task) {
+            auto result = task.get();
+            if (!result) {
+                throw std::runtime_error(result.error().message);
+            }
+            return std::move(*result);
+        }, nb::call_guard<nb::gil_scoped_release>(), "Wait for the open and take the database (once)");
+
+    m.def("open_async", [](const std::filesystem::path& path, const std::filesystem::path& anlz_dir,
+                           bool memory_map, size_t threads, bool parallel_indexing, AnlzSections sections) {
+        AsyncOpenOptions options;
+        options.database.io_mode = memory_map ? IoMode::MemoryMapped : IoMode::Buffered;
+        options.database.thread_count = threads;
+        options.database.parallel_indexing = parallel_indexing;
+        options.anlz_dir = anlz_dir;
+        options.sections = sections;
+        return open_async(path, options);
+    }, nb::arg("path"), nb::arg("anlz_dir") = std::filesystem::path(), nb::arg("memory_map") = false,
+       nb::arg("threads") = 1, nb::arg("parallel_indexing") = false, nb::arg("sections") = AnlzSections::All,
+       "Start opening export.pdb (and scanning anlz_dir) on background threads");
+
+    // ========================================================================
+    // Artwork Cache
+    // ========================================================================
+
+    nb::enum_<ArtworkVariant>(m, "ArtworkVariant")
+        .value("Original", ArtworkVariant::Original)
+        .value("HighRes", ArtworkVariant::HighRes);
+
+    nb::class_<ArtworkCacheStats>(m, "ArtworkCacheStats")
+        .def_ro("hits", &ArtworkCacheStats::hits)
+        .def_ro("misses", &ArtworkCacheStats::misses)
+        .def_ro("files_read", &ArtworkCacheStats::files_read)
+        .def_ro("files_missing", &ArtworkCacheStats::files_missing)
+        .def_ro("bytes_read", &ArtworkCacheStats::bytes_read)
+        .def_ro("evictions", &ArtworkCacheStats::evictions)
+        .def_ro("cached_items", &ArtworkCacheStats::cached_items)
+        .def_ro("cached_bytes", &ArtworkCacheStats::cached_bytes)
+        .def_ro("pending", &ArtworkCacheStats::pending);
+
+    // Poll peek() from the UI loop; no Python callback runs on the I/O workers
+    auto artwork_bytes = [](const ArtworkBytes& bytes) -> std::optional<nb::bytes> {
+        if (!bytes) return std::nullopt;
+        return nb::bytes(reinterpret_cast<const char*>(bytes->data()), bytes->size());
+    };
+    nb::class_<ArtworkCache>(m, "ArtworkCache")
+        .def("__init__", [](ArtworkCache* self, const Database& db, size_t capacity_bytes, size_t threads,
+                            const std::filesystem::path& export_root) {
+            ArtworkCacheOptions options;
+            options.capacity_bytes = capacity_bytes;
+            options.thread_count = threads;
+            options.export_root = export_root;
+            new (self) ArtworkCache(db, options);
+        }, nb::arg("db"), nb::arg("capacity_bytes") = size_t{64u << 20}, nb::arg("threads") = 2,
+           nb::arg("export_root") = std::filesystem::path())
+        .def("path", &ArtworkCache::path, nb::arg("artwork_id"), nb::arg("variant") = ArtworkVariant::Original)
+        .def("get", [artwork_bytes](ArtworkCache& cache, ArtworkId id, ArtworkVariant variant) {
+            ArtworkBytes bytes;
+            {
+                nb::gil_scoped_release release;
+                bytes = cache.get(id, variant);
+            }
+            return artwork_bytes(bytes);
+        }, nb::arg("artwork_id"), nb::arg("variant") = ArtworkVariant::Original,
+           "File contents, reading them now if not cached (None if missing)")
+        .def("peek", [artwork_bytes](const ArtworkCache& cache, ArtworkId id, ArtworkVariant variant) {
+            return artwork_bytes(cache.peek(id, variant));
+        }, nb::arg("artwork_id"), nb::arg("variant") = ArtworkVariant::Original,
+           "Cached file contents only (None if not loaded yet)")
+        .def("prefetch", [](ArtworkCache& cache, const std::vector<ArtworkId>& ids, ArtworkVariant variant) {
+            cache.prefetch(ids, variant);
+        }, nb::arg("ids"), nb::arg("variant") = ArtworkVariant::Original,
+           "Replace the queued prefetches with ids, in order")
+        .def("prefetch_tracks", [](ArtworkCache& cache, const std::vector<TrackId>& tracks, ArtworkVariant variant) {
+            cache.prefetch_tracks(tracks, variant);
+        }, nb::arg("tracks"), nb::arg("variant") = ArtworkVariant::Original)
+        .def("cancel_prefetch", &ArtworkCache::cancel_prefetch)
+        .def("wait_idle", &ArtworkCache::wait_idle, nb::call_guard<nb::gil_scoped_release>())
+        .def("stats", &ArtworkCache::stats)
+        .def("clear", &ArtworkCache::clear);
+
+#ifdef CRATE_DIGGER_ARROW_EXPORT
+    // ========================================================================
+    // Columnar Export
+    // ========================================================================
+
+    nb::class_<ArrowExportStats>(m, "ArrowExportStats")
+        .def_ro("rows", &ArrowExportStats::rows)
+        .def_ro("batches", &ArrowExportStats::batches)
+        .def_ro("bytes", &ArrowExportStats::bytes);
+
+    m.def("export_tracks_arrow", [](const Database& db, const std::filesystem::path& path, bool stream,
+                                    size_t batch_rows, bool include_analysis) {
+        ArrowExportOptions options;
+        options.format = stream ? ArrowFormat::Stream : ArrowFormat::File;
+        options.batch_rows = batch_rows;
+        options.include_analysis = include_analysis;
+        auto result = export_tracks_arrow(db, path, options);
+        if (!result) {
+            throw std::runtime_error(result.error().message);
+        }
+        return *result;
+    }, nb::arg("db"), nb::arg("path"), nb::arg("stream") = false, nb::arg("batch_rows") = 65536,
+       nb::arg("include_analysis") = true, nb::call_guard<nb::gil_scoped_release>(),
+       "Write every track to an Arrow IPC file (read with pyarrow.ipc / polars / DuckDB)");
+#endif
 }
@@ -176,6 +176,15 @@ def test_numpy_integration(pdb_path: str):
     if len(durations) > 0:
         print(f"  Duration stats: min={durations.min()}s, max={durations.max()}s, mean={durations.mean():.1f}s")
 
+    # Zero-copy column views borrow the database's memory
+    bpm_100x = db.bpm_100x_column()
+    track_ids = db.track_id_column()
+    assert bpm_100x.dtype == np.uint32 and track_ids.dtype == np.int64
+    assert len(bpm_100x) == len(track_ids) == len(bpms)
+    assert not bpm_100x.flags.writeable
+    if len(bpms) > 0:
+        assert np.allclose(bpm_100x / 100.0, bpms)
+
     print("  PASSED")
     return True
 
@@ -0,0 +1,804 @@
+/**
+ * @file synthetic_export.cpp
+ * @brief Synthetic rekordbox export generator
+ *
+ * The layouts written here mirror what RekordboxPdb::read_page and the
+ * DatabaseImpl::index_* functions expect (see rekordbox_pdb.hpp for the raw
+ * row structures) and what RekordboxAnlz::parse_sections reads.
+ */
+
+#include "synthetic_export.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+
+namespace cratedigger::synthetic {
+
+namespace {
+
+// ============================================================================
+// Byte Helpers
+// ============================================================================
+
+void put_u16_le(std::vector<uint8_t>& buf, size_t pos, uint16_t v) {
+    buf[pos] = static_cast<uint8_t>(v);
+    buf[pos + 1] = static_cast<uint8_t>(v >> 8);
+}
+
+void put_u32_le(std::vector<uint8_t>& buf, size_t pos, uint32_t v) {
+    for (int i = 0; i < 4; ++i) {
+        buf[pos + i] = static_cast<uint8_t>(v >> (8 * i));
+    }
+}
+
+void append_u16_be(std::vector<uint8_t>& buf, uint16_t v) {
+    buf.push_back(static_cast<uint8_t>(v >> 8));
+    buf.push_back(static_cast<uint8_t>(v));
+}
+
+void append_u32_be(std::vector<uint8_t>& buf, uint32_t v) {
+    for (int i = 3; i >= 0; --i) {
+        buf.push_back(static_cast<uint8_t>(v >> (8 * i)));
+    }
+}
+
+void put_u32_be(std::vector<uint8_t>& buf, size_t pos, uint32_t v) {
+    for (int i = 0; i < 4; ++i) {
+        buf[pos + i] = static_cast<uint8_t>(v >> (8 * (3 - i)));
+    }
+}
+
+/// Decode UTF-8 into UTF-16 code units (input is trusted test data)
+std::vector<uint16_t> utf8_to_utf16(const std::string& s) {
+    std::vector<uint16_t> out;
+    size_t i = 0;
+    while (i < s.size()) {
+        auto c = static_cast<unsigned char>(s[i]);
+        uint32_t cp = 0;
+        size_t extra = 0;
+        if (c < 0x80) { cp = c; }
+        else if ((c & 0xE0) == 0xC0) { cp = c & 0x1F; extra = 1; }
+        else if ((c & 0xF0) == 0xE0) { cp = c & 0x0F; extra = 2; }
+        else { cp = c & 0x07; extra = 3; }
+        for (size_t k = 1; k <= extra && i + k < s.size(); ++k) {
+            cp = (cp << 6) | (static_cast<unsigned char>(s[i + k]) & 0x3F);
+        }
+        i += extra + 1;
+        if (cp >= 0x10000) {
+            cp -= 0x10000;
+            out.push_back(static_cast<uint16_t>(0xD800 | (cp >> 10)));
+            out.push_back(static_cast<uint16_t>(0xDC00 | (cp & 0x3FF)));
+        } else {
+            out.push_back(static_cast<uint16_t>(cp));
+        }
+    }
+    return out;
+}
+
+bool is_ascii(const std::string& s) {
+    for (char c : s) {
+        if (static_cast<unsigned char>(c) >= 0x80) return false;
+    }
+    return true;
+}
+
+/// Encode a DeviceSQL string (short ASCII, long ASCII or UTF-16LE)
+std::vector<uint8_t> encode_device_string(const std::string& s) {
+    std::vector<uint8_t> out;
+    if (is_ascii(s) && s.size() <= 126) {
+        out.push_back(static_cast<uint8_t>(((s.size() + 1) << 1) | 1));
+        out.insert(out.end(), s.begin(), s.end());
+    } else if (is_ascii(s)) {
+        out.resize(4);
+        out[0] = 0x40;
+        put_u16_le(out, 1, static_cast<uint16_t>(s.size() + 4));
+        out.insert(out.end(), s.begin(), s.end());
+    } else {
+        auto units = utf8_to_utf16(s);
+        out.resize(4 + units.size() * 2);
+        out[0] = 0x90;
+        put_u16_le(out, 1, static_cast<uint16_t>(4 + units.size() * 2));
+        for (size_t i = 0; i < units.size(); ++i) {
+            put_u16_le(out, 4 + i * 2, units[i]);
+        }
+    }
+    return out;
+}
+
+/// Append a UTF-16BE string (ANLZ encoding), optionally NUL-terminated
+void append_utf16be(std::vector<uint8_t>& buf, const std::string& s, bool nul) {
+    for (uint16_t unit : utf8_to_utf16(s)) {
+        append_u16_be(buf, unit);
+    }
+    if (nul) append_u16_be(buf, 0);
+}
+
+size_t utf16_byte_len(const std::string& s, bool nul) {
+    return (utf8_to_utf16(s).size() + (nul ? 1 : 0)) * 2;
+}
+
+std::string hex_string(uint32_t v, int width) {
+    char buf[16];
+    std::snprintf(buf, sizeof(buf), "%0*X", width, v);
+    return buf;
+}
+
+std::string padded(size_t v, int width) {
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%0*zu", width, v);
+    return buf;
+}
+
+// Camelot order: 1A, 1B, 2A, 2B, ...
+const char* const kKeyNames[24] = {
+    "Abm", "B", "Ebm", "F#", "Bbm", "Db", "Fm", "Ab", "Cm", "Eb", "Gm", "Bb",
+    "Dm", "F", "Am", "C", "Em", "G", "Bm", "D", "F#m", "A", "Dbm", "E"
+};
+
+const char* const kGenreNames[8] = {
+    "House", "Techno", "Drum & Bass", "Disco", "Ambient", "Electro", "Garage", "Dub"
+};
+
+const char* const kColorNames[8] = {
+    "Pink", "Red", "Orange", "Yellow", "Green", "Aqua", "Blue", "Purple"
+};
+
+// ============================================================================
+// PDB Writer
+// ============================================================================
+
+/// Packs rows into page chains and assembles a PDB image
+class PdbWriter {
+public:
+    explicit PdbWriter(uint32_t page_size) : page_size_(page_size) {
+        image_.assign(page_size_, 0);  // Page 0 is the file header
+    }
+
+    /// Append a table whose rows are packed in order into a fresh page chain
+    void add_table(uint32_t type, const std::vector<std::vector<uint8_t>>& rows) {
+        std::vector<uint32_t> pages;
+        size_t i = 0;
+        do {
+            uint32_t page = new_page(type);
+            pages.push_back(page);
+            i = fill_page(page, rows, i);
+        } while (i < rows.size());
+
+        for (size_t p = 0; p + 1 < pages.size(); ++p) {
+            put_u32_le(image_, page_offset(pages[p]) + 12, pages[p + 1]);
+        }
+        put_u32_le(image_, page_offset(pages.back()) + 12, page_count());
+        tables_.push_back({type, pages.front(), pages.back()});
+    }
+
+    std::vector<uint8_t> finish() {
+        put_u32_le(image_, 4, page_size_);
+        put_u32_le(image_, 8, static_cast<uint32_t>(tables_.size()));
+        put_u32_le(image_, 12, page_count());
+        put_u32_le(image_, 20, 1);  // sequence
+        size_t pos = 28;
+        for (const auto& t : tables_) {
+            put_u32_le(image_, pos, t.type);
+            put_u32_le(image_, pos + 4, page_count());
+            put_u32_le(image_, pos + 8, t.first);
+            put_u32_le(image_, pos + 12, t.last);
+            pos += 16;
+        }
+        return std::move(image_);
+    }
+
+private:
+    struct Table {
+        uint32_t type;
+        uint32_t first;
+        uint32_t last;
+    };
+
+    static constexpr size_t kHeapStart = 40;
+    static constexpr size_t kGroupSize = 0x24;
+
+    uint32_t page_count() const { return static_cast<uint32_t>(image_.size() / page_size_); }
+    size_t page_offset(uint32_t page) const { return static_cast<size_t>(page) * page_size_; }
+
+    uint32_t new_page(uint32_t type) {
+        uint32_t page = page_count();
+        image_.resize(image_.size() + page_size_, 0);
+        put_u32_le(image_, page_offset(page) + 4, page);
+        put_u32_le(image_, page_offset(page) + 8, type);
+        return page;
+    }
+
+    /// Fill a page with rows starting at `first`; returns the next unwritten row
+    size_t fill_page(uint32_t page, const std::vector<std::vector<uint8_t>>& rows, size_t first) {
+        size_t base = page_offset(page);
+        size_t heap_used = 0;
+        size_t count = 0;
+        size_t i = first;
+
+        while (i < rows.size()) {
+            size_t row_pos = (heap_used + 3) & ~size_t{3};
+            size_t groups = count / 16 + 1;
+            size_t index_bytes = groups * kGroupSize;
+            if (kHeapStart + row_pos + rows[i].size() + index_bytes > page_size_) {
+                if (count == 0) ++i;  // Row can never fit; drop it rather than loop forever
+                break;
+            }
+
+            std::copy(rows[i].begin(), rows[i].end(), image_.begin() + static_cast<std::ptrdiff_t>(base + kHeapStart + row_pos));
+
+            size_t group = count / 16;
+            size_t slot = count % 16;
+            size_t group_base = base + page_size_ - group * kGroupSize;
+            put_u16_le(image_, group_base - (6 + 2 * slot), static_cast<uint16_t>(row_pos));
+            uint16_t flags = static_cast<uint16_t>(image_[group_base - 4] | (image_[group_base - 3] << 8));
+            put_u16_le(image_, group_base - 4, static_cast<uint16_t>(flags | (1u << slot)));
+
+            heap_used = row_pos + rows[i].size();
+            ++count;
+            ++i;
+        }
+
+        // row_info: num_row_offsets (13 bits), num_rows (11 bits), page_flags (8 bits)
+        uint32_t row_info = static_cast<uint32_t>(count & 0x1FFF) |
+                            (static_cast<uint32_t>(count & 0x7FF) << 13) |
+                            (0x24u << 24);
+        put_u32_le(image_, base + 20, row_info);
+        size_t index_bytes = (count + 15) / 16 * kGroupSize;
+        put_u16_le(image_, base + 24, static_cast<uint16_t>(page_size_ - kHeapStart - heap_used - index_bytes));
+        put_u16_le(image_, base + 26, static_cast<uint16_t>(heap_used));
+        return i;
+    }
+
+    uint32_t page_size_;
+    std::vector<uint8_t> image_;
+    std::vector<Table> tables_;
+};
+
+/// Fixed-size row prefix followed by a single string
+std::vector<uint8_t> simple_row(size_t fixed_size, const std::string& name) {
+    std::vector<uint8_t> row(fixed_size, 0);
+    auto s = encode_device_string(name);
+    row.insert(row.end(), s.begin(), s.end());
+    return row;
+}
+
+std::vector<uint8_t> track_row(const ExpectedTrack& t, size_t index, const ExportSpec& spec) {
+    constexpr size_t kFixed = 136;
+    constexpr size_t kStringOffsets = 94;
+    std::vector<uint8_t> row(kFixed, 0);
+
+    put_u16_le(row, 0, 0x24);
+    put_u16_le(row, 2, static_cast<uint16_t>(index * 0x20));
+    put_u32_le(row, 8, 44100);                                          // sample_rate
+    put_u32_le(row, 16, 5000000 + static_cast<uint32_t>(index) * 1000); // file_size
+    put_u32_le(row, 28, static_cast<uint32_t>(t.album_id));             // artwork_id
+    put_u32_le(row, 32, static_cast<uint32_t>(t.key_id));
+    put_u32_le(row, 40, static_cast<uint32_t>(index % spec.label_count + 1));
+    put_u32_le(row, 48, 320);                                           // bitrate
+    put_u32_le(row, 52, static_cast<uint32_t>(index % 12 + 1));         // track_number
+    put_u32_le(row, 56, t.bpm_100x);
+    put_u32_le(row, 60, static_cast<uint32_t>(t.genre_id));
+    put_u32_le(row, 64, static_cast<uint32_t>(t.album_id));
+    put_u32_le(row, 68, static_cast<uint32_t>(t.artist_id));
+    put_u32_le(row, 72, static_cast<uint32_t>(t.id));
+    put_u16_le(row, 76, 1);                                             // disc_number
+    put_u16_le(row, 78, static_cast<uint16_t>(index % 50));             // play_count
+    put_u16_le(row, 80, t.year);
+    put_u16_le(row, 82, 16);                                            // sample_depth
+    put_u16_le(row, 84, static_cast<uint16_t>(t.duration_seconds));
+    row[88] = static_cast<uint8_t>(index % 9);                          // color_id
+    row[89] = static_cast<uint8_t>(t.rating);
+
+    std::string strings[21];
+    strings[0] = t.isrc;
+    strings[10] = "2024-01-" + padded(index % 28 + 1, 2);
+    strings[14] = t.analyze_path;
+    strings[16] = "synthetic comment " + std::to_string(t.id);
+    strings[17] = t.title;
+    strings[19] = t.file_path.substr(t.file_path.rfind('/') + 1);
+    strings[20] = t.file_path;
+
+    // All empty strings share one encoded empty string at the end of the row
+    for (int i = 0; i < 21; ++i) {
+        if (strings[i].empty()) continue;
+        put_u16_le(row, kStringOffsets + 2 * i, static_cast<uint16_t>(row.size()));
+        auto s = encode_device_string(strings[i]);
+        row.insert(row.end(), s.begin(), s.end());
+    }
+    auto empty_offset = static_cast<uint16_t>(row.size());
+    row.push_back(0x03);
+    for (int i = 0; i < 21; ++i) {
+        if (strings[i].empty()) put_u16_le(row, kStringOffsets + 2 * i, empty_offset);
+    }
+    return row;
+}
+
+std::vector<uint8_t> artist_row(int64_t id, const std::string& name) {
+    // Odd ids use the far name offset variant
+    bool far = (id % 2) == 1;
+    std::vector<uint8_t> row(far ? 12 : 10, 0);
+    put_u16_le(row, 0, far ? 0x64 : 0x60);
+    put_u32_le(row, 4, static_cast<uint32_t>(id));
+    row[8] = 0x03;
+    if (far) {
+        row[9] = 0;
+        put_u16_le(row, 0x0a, 12);
+    } else {
+        row[9] = 10;
+    }
+    auto s = encode_device_string(name);
+    row.insert(row.end(), s.begin(), s.end());
+    return row;
+}
+
+std::vector<uint8_t> album_row(int64_t id, int64_t artist_id, const std::string& name) {
+    bool far = (id % 2) == 0;
+    std::vector<uint8_t> row(far ? 24 : 22, 0);
+    put_u16_le(row, 0, far ? 0x84 : 0x80);
+    put_u32_le(row, 8, static_cast<uint32_t>(artist_id));
+    put_u32_le(row, 12, static_cast<uint32_t>(id));
+    row[20] = 0x03;
+    if (far) {
+        put_u16_le(row, 0x16, 24);
+    } else {
+        row[21] = 22;
+    }
+    auto s = encode_device_string(name);
+    row.insert(row.end(), s.begin(), s.end());
+    return row;
+}
+
+std::vector<uint8_t> id_name_row(size_t fixed, int64_t id, const std::string& name) {
+    auto row = simple_row(fixed, name);
+    put_u32_le(row, 0, static_cast<uint32_t>(id));
+    return row;
+}
+
+std::vector<uint8_t> color_row(int64_t id, const std::string& name) {
+    // Real layout: 5 bytes padding, u16 id, u8 unknown, then the name
+    auto row = simple_row(8, name);
+    put_u16_le(row, 5, static_cast<uint16_t>(id));
+    return row;
+}
+
+std::vector<uint8_t> playlist_tree_row(int64_t parent, uint32_t sort_order, int64_t id,
+                                       bool is_folder, const std::string& name) {
+    auto row = simple_row(20, name);
+    put_u32_le(row, 0, static_cast<uint32_t>(parent));
+    put_u32_le(row, 8, sort_order);
+    put_u32_le(row, 12, static_cast<uint32_t>(id));
+    put_u32_le(row, 16, is_folder ? 1 : 0);
+    return row;
+}
+
+std::vector<uint8_t> triple_row(uint32_t a, uint32_t b, uint32_t c) {
+    std::vector<uint8_t> row(12, 0);
+    put_u32_le(row, 0, a);
+    put_u32_le(row, 4, b);
+    put_u32_le(row, 8, c);
+    return row;
+}
+
+std::vector<uint8_t> tag_row(uint32_t index, int64_t category, uint32_t pos, int64_t id,
+                             bool is_category, const std::string& name) {
+    constexpr size_t kFixed = 32;
+    std::vector<uint8_t> row(kFixed, 0);
+    put_u16_le(row, 0, 0x0680);
+    put_u16_le(row, 2, static_cast<uint16_t>(index * 0x20));
+    put_u32_le(row, 12, static_cast<uint32_t>(category));
+    put_u32_le(row, 16, pos);
+    put_u32_le(row, 20, static_cast<uint32_t>(id));
+    put_u32_le(row, 24, is_category ? 1 : 0);
+    row[28] = 0x03;
+    row[29] = static_cast<uint8_t>(kFixed);
+    auto s = encode_device_string(name);
+    row.insert(row.end(), s.begin(), s.end());
+    row[30] = static_cast<uint8_t>(row.size());
+    row.push_back(0x03);
+    return row;
+}
+
+// ============================================================================
+// ANLZ Writer
+// ============================================================================
+
+void append_section(std::vector<uint8_t>& file, uint32_t type, const std::vector<uint8_t>& body) {
+    append_u32_be(file, type);
+    append_u32_be(file, 12);
+    append_u32_be(file, static_cast<uint32_t>(12 + body.size()));
+    file.insert(file.end(), body.begin(), body.end());
+}
+
+struct SyntheticCue {
+    uint32_t hot_cue;
+    uint8_t type;
+    uint32_t time_ms;
+    uint32_t loop_ms;
+    uint8_t color;
+    std::string comment;
+};
+
+std::vector<SyntheticCue> cues_for(const ExpectedTrack& t) {
+    auto base = static_cast<uint32_t>(t.id % 1000);
+    return {
+        {0, 0, 100 + base, 0, 0, ""},
+        {1, 0, 30000 + base, 0, 3, "Drop"},
+        {2, 4, 60000 + base, 64000 + base, 5, "Loop"},
+    };
+}
+
+std::vector<uint8_t> cue_list_body(const ExpectedTrack& t, bool is_ext) {
+    auto cues = cues_for(t);
+    std::vector<uint8_t> body;
+    append_u32_be(body, static_cast<uint32_t>(cues.size()));
+
+    for (const auto& cue : cues) {
+        size_t entry_start = body.size();
+        size_t fixed = is_ext ? 60 : 56;
+        body.resize(entry_start + fixed, 0);
+        put_u32_be(body, entry_start, is_ext ? 0x50435032 : 0x50435054);  // "PCP2" / "PCPT"
+        put_u32_be(body, entry_start + 4, 16);
+        put_u32_be(body, entry_start + 12, cue.hot_cue);
+        put_u32_be(body, entry_start + 16, 1);  // active
+        body[entry_start + 32] = cue.type;
+        put_u32_be(body, entry_start + 36, cue.time_ms);
+        put_u32_be(body, entry_start + 40, cue.loop_ms);
+        if (is_ext) {
+            body[entry_start + 44] = cue.color;
+            size_t comment_len = cue.comment.empty() ? 0 : utf16_byte_len(cue.comment, true);
+            put_u32_be(body, entry_start + 56, static_cast<uint32_t>(comment_len));
+            if (comment_len > 0) append_utf16be(body, cue.comment, true);
+            // Keep the entry at least as large as the extended entry layout
+            if (body.size() - entry_start < 64) body.resize(entry_start + 64, 0);
+        }
+        put_u32_be(body, entry_start + 8, static_cast<uint32_t>(body.size() - entry_start));
+    }
+    return body;
+}
+
+std::vector<uint8_t> beat_grid_body(const ExportSpec& spec, const ExpectedTrack& t) {
+    std::vector<uint8_t> body;
+    append_u32_be(body, 0);
+    append_u32_be(body, static_cast<uint32_t>(spec.beats_per_track));
+    double interval_ms = 6000000.0 / static_cast<double>(t.bpm_100x);
+    for (size_t k = 0; k < spec.beats_per_track; ++k) {
+        append_u16_be(body, static_cast<uint16_t>(k % 4 + 1));
+        append_u16_be(body, static_cast<uint16_t>(t.bpm_100x));
+        append_u32_be(body, static_cast<uint32_t>(100.0 + interval_ms * static_cast<double>(k) + 0.5));
+    }
+    return body;
+}
+
+/// Deterministic waveform byte for entry i of a track
+uint8_t wave_byte(const ExpectedTrack& t, size_t i, unsigned salt) {
+    uint32_t x = static_cast<uint32_t>(t.id) * 2654435761u + static_cast<uint32_t>(i) * 40503u + salt;
+    x ^= x >> 13;
+    return static_cast<uint8_t>(x);
+}
+
+std::vector<uint8_t> waveform_body(const ExpectedTrack& t, uint32_t bytes_per_entry,
+                                   size_t entries, bool preview_layout, unsigned salt) {
+    std::vector<uint8_t> body;
+    size_t data_len = bytes_per_entry * entries;
+    if (preview_layout) {
+        append_u32_be(body, static_cast<uint32_t>(data_len));
+        append_u32_be(body, 0x10000);
+    } else {
+        append_u32_be(body, bytes_per_entry);
+        append_u32_be(body, static_cast<uint32_t>(entries));
+        append_u32_be(body, 0x960000);
+    }
+    for (size_t i = 0; i < data_len; ++i) {
+        body.push_back(wave_byte(t, i, salt));
+    }
+    return body;
+}
+
+std::vector<uint8_t> song_structure_body(const ExportSpec& spec) {
+    constexpr uint16_t kPhrases = 4;
+    auto step = static_cast<uint16_t>(spec.beats_per_track / kPhrases);
+    if (step == 0) step = 1;
+
+    std::vector<uint8_t> body;
+    append_u32_be(body, 24);
+    append_u16_be(body, kPhrases);
+    append_u16_be(body, 1);  // mood: high
+    body.insert(body.end(), 6, 0);
+    append_u16_be(body, static_cast<uint16_t>(spec.beats_per_track));
+    body.insert(body.end(), 2, 0);
+    body.push_back(0);  // bank
+    body.push_back(0);
+    for (uint16_t p = 0; p < kPhrases; ++p) {
+        size_t e = body.size();
+        body.resize(e + 24, 0);
+        body[e] = static_cast<uint8_t>((p + 1) >> 8);
+        body[e + 1] = static_cast<uint8_t>(p + 1);
+        auto beat = static_cast<uint16_t>(1 + p * step);
+        body[e + 2] = static_cast<uint8_t>(beat >> 8);
+        body[e + 3] = static_cast<uint8_t>(beat);
+        body[e + 5] = static_cast<uint8_t>(p % 3 + 1);  // kind
+    }
+    return body;
+}
+
+/// USBANLZ-relative directory for a track ("Pxxx/xxxxxxxx")
+std::string anlz_subdir(int64_t id) {
+    auto folder = static_cast<uint32_t>(id >> 8) & 0xFFF;
+    auto hash = static_cast<uint32_t>(id) * 2654435761u;
+    return "P" + hex_string(folder, 3) + "/" + hex_string(hash, 8);
+}
+
+} // anonymous namespace
+
+// ============================================================================
+// Public API
+// ============================================================================
+
+ExpectedExport expected_export(const ExportSpec& spec) {
+    ExpectedExport e;
+
+    for (size_t a = 1; a <= spec.artist_count; ++a) {
+        e.artist_names.push_back("Artist " + padded(a, 3));
+    }
+    for (size_t b = 1; b <= spec.album_count; ++b) {
+        e.album_names.push_back("Album " + padded(b, 3));
+    }
+    for (size_t g = 1; g <= spec.genre_count; ++g) {
+        e.genre_names.push_back(g <= 8 ? kGenreNames[g - 1] : "Genre " + std::to_string(g));
+    }
+
+    e.tracks.reserve(spec.track_count);
+    for (size_t i = 0; i < spec.track_count; ++i) {
+        ExpectedTrack t;
+        t.id = static_cast<int64_t>(i + 1);
+        t.artist_id = static_cast<int64_t>(i % spec.artist_count + 1);
+        t.album_id = static_cast<int64_t>(i % spec.album_count + 1);
+        t.genre_id = static_cast<int64_t>(i % spec.genre_count + 1);
+        t.key_id = static_cast<int64_t>(i % spec.key_count + 1);
+        t.bpm_100x = 9000 + static_cast<uint32_t>((i * 731) % 8000);
+        t.duration_seconds = 120 + static_cast<uint32_t>((i * 37) % 360);
+        t.year = static_cast<uint16_t>(1990 + i % 35);
+        t.rating = static_cast<uint16_t>(i % 6);
+        t.title = "Track " + padded(i + 1, 6);
+        if (spec.unicode_titles && i % 10 == 5) {
+            t.title = "Tr\xC3\xA4" "ck " + padded(i + 1, 6) + " \xE2\x99\xAA";  // "Träck N ♪"
+        } else if (spec.unicode_titles && i % 10 == 0) {
+            // "トラック N (Extended Mix) 🎵": CJK, a long ASCII run and a surrogate pair
+            t.title = "\xE3\x83\x88\xE3\x83\xA9\xE3\x83\x83\xE3\x82\xAF " + padded(i + 1, 6) +
+                      " (Extended Mix) \xF0\x9F\x8E\xB5";
+        }
+        const auto& artist = e.artist_names[static_cast<size_t>(t.artist_id - 1)];
+        const auto& album = e.album_names[static_cast<size_t>(t.album_id - 1)];
+        t.file_path = "/Contents/" + artist + "/" + album + "/Track " + padded(i + 1, 6) + ".mp3";
+        t.analyze_path = "/PIONEER/USBANLZ/" + anlz_subdir(t.id) + "/ANLZ0000.DAT";
+        t.isrc = "SYN" + padded(i + 1, 9);
+        e.tracks.push_back(std::move(t));
+    }
+
+    e.playlists.resize(spec.playlist_count);
+    if (spec.playlist_count > 0) {
+        for (size_t i = 0; i < spec.track_count; ++i) {
+            e.playlists[i % spec.playlist_count].push_back(static_cast<int64_t>(i + 1));
+        }
+    }
+
+    e.tag_tracks.resize(spec.tag_count);
+    if (spec.tag_count > 0) {
+        for (size_t i = 0; i < spec.track_count; ++i) {
+            size_t first = i % spec.tag_count;
+            size_t second = (i * 7 + 3) % spec.tag_count;
+            e.tag_tracks[first].push_back(static_cast<int64_t>(i + 1));
+            if (second != first) e.tag_tracks[second].push_back(static_cast<int64_t>(i + 1));
+        }
+    }
+    return e;
+}
+
+std::vector<uint8_t> build_pdb(const ExportSpec& spec) {
+    auto e = expected_export(spec);
+    PdbWriter writer(spec.page_size);
+
+    std::vector<std::vector<uint8_t>> rows;
+    for (size_t i = 0; i < e.tracks.size(); ++i) {
+        rows.push_back(track_row(e.tracks[i], i, spec));
+    }
+    writer.add_table(0, rows);  // Tracks
+
+    rows.clear();
+    for (size_t g = 0; g < e.genre_names.size(); ++g) {
+        rows.push_back(id_name_row(4, static_cast<int64_t>(g + 1), e.genre_names[g]));
+    }
+    writer.add_table(1, rows);  // Genres
+
+    rows.clear();
+    for (size_t a = 0; a < e.artist_names.size(); ++a) {
+        rows.push_back(artist_row(static_cast<int64_t>(a + 1), e.artist_names[a]));
+    }
+    writer.add_table(2, rows);  // Artists
+
+    rows.clear();
+    for (size_t b = 0; b < e.album_names.size(); ++b) {
+        auto artist = static_cast<int64_t>(b % spec.artist_count + 1);
+        rows.push_back(album_row(static_cast<int64_t>(b + 1), artist, e.album_names[b]));
+    }
+    writer.add_table(3, rows);  // Albums
+
+    rows.clear();
+    for (size_t l = 1; l <= spec.label_count; ++l) {
+        rows.push_back(id_name_row(4, static_cast<int64_t>(l), "Label " + padded(l, 2)));
+    }
+    writer.add_table(4, rows);  // Labels
+
+    rows.clear();
+    for (size_t k = 1; k <= spec.key_count && k <= 24; ++k) {
+        auto row = id_name_row(8, static_cast<int64_t>(k), kKeyNames[k - 1]);
+        put_u32_le(row, 4, static_cast<uint32_t>(k));
+        rows.push_back(std::move(row));
+    }
+    writer.add_table(5, rows);  // Keys
+
+    rows.clear();
+    for (size_t c = 1; c <= 8; ++c) {
+        rows.push_back(color_row(static_cast<int64_t>(c), kColorNames[c - 1]));
+    }
+    writer.add_table(6, rows);  // Colors
+
+    rows.clear();
+    for (size_t p = 1; p <= spec.playlist_count; ++p) {
+        rows.push_back(playlist_tree_row(0, static_cast<uint32_t>(p - 1), static_cast<int64_t>(p),
+                                         false, "Playlist " + std::to_string(p)));
+    }
+    // One folder holding an empty playlist and an empty subfolder
+    auto folder = static_cast<int64_t>(spec.playlist_count + 1);
+    rows.push_back(playlist_tree_row(0, static_cast<uint32_t>(spec.playlist_count), folder, true, "Folder"));
+    rows.push_back(playlist_tree_row(folder, 0, folder + 1, false, "Nested"));
+    rows.push_back(playlist_tree_row(folder, 1, folder + 2, true, "Subfolder"));
+    writer.add_table(7, rows);  // PlaylistTree
+
+    rows.clear();
+    for (size_t p = 0; p < e.playlists.size(); ++p) {
+        for (size_t n = 0; n < e.playlists[p].size(); ++n) {
+            rows.push_back(triple_row(static_cast<uint32_t>(n),
+                                      static_cast<uint32_t>(e.playlists[p][n]),
+                                      static_cast<uint32_t>(p + 1)));
+        }
+    }
+    writer.add_table(8, rows);  // PlaylistEntries
+
+    rows.clear();
+    rows.push_back(id_name_row(4, 1, "HISTORY 001"));
+    writer.add_table(11, rows);  // HistoryPlaylists
+
+    rows.clear();
+    for (size_t i = 0; i < e.tracks.size() && i < 10; ++i) {
+        rows.push_back(triple_row(static_cast<uint32_t>(e.tracks[i].id), 1, static_cast<uint32_t>(i)));
+    }
+    writer.add_table(12, rows);  // HistoryEntries
+
+    rows.clear();
+    for (size_t b = 1; b <= spec.album_count; ++b) {
+        rows.push_back(id_name_row(4, static_cast<int64_t>(b), "/PIONEER/Artwork/00001/b" + std::to_string(b) + ".jpg"));
+    }
+    writer.add_table(13, rows);  // Artwork
+
+    return writer.finish();
+}
+
+std::vector<uint8_t> build_ext_pdb(const ExportSpec& spec) {
+    auto e = expected_export(spec);
+    PdbWriter writer(spec.page_size);
+
+    std::vector<std::vector<uint8_t>> rows;
+    uint32_t row_index = 0;
+    for (size_t c = 1; c <= spec.category_count; ++c) {
+        rows.push_back(tag_row(row_index++, 0, static_cast<uint32_t>(c - 1), static_cast<int64_t>(c),
+                               true, "Category " + std::to_string(c)));
+    }
+    for (size_t t = 0; t < spec.tag_count; ++t) {
+        auto category = spec.category_count == 0 ? 0 : static_cast<int64_t>(t % spec.category_count + 1);
+        auto pos = static_cast<uint32_t>(spec.category_count == 0 ? t : t / spec.category_count);
+        rows.push_back(tag_row(row_index++, category, pos, static_cast<int64_t>(100 + t + 1),
+                               false, "Tag " + std::to_string(t + 1)));
+    }
+    writer.add_table(3, rows);  // Tags
+
+    rows.clear();
+    for (size_t t = 0; t < e.tag_tracks.size(); ++t) {
+        for (int64_t track : e.tag_tracks[t]) {
+            std::vector<uint8_t> row(8, 0);
+            put_u32_le(row, 0, static_cast<uint32_t>(100 + t + 1));
+            put_u32_le(row, 4, static_cast<uint32_t>(track));
+            rows.push_back(std::move(row));
+        }
+    }
+    writer.add_table(4, rows);  // TagTracks
+
+    return writer.finish();
+}
+
+std::vector<uint8_t> build_anlz(const ExportSpec& spec, const ExpectedTrack& track, bool is_ext) {
+    std::vector<uint8_t> file;
+    append_u32_be(file, 0x504D4149);  // "PMAI"
+    append_u32_be(file, 28);
+    append_u32_be(file, 0);           // len_file, patched below
+    file.resize(28, 0);
+
+    std::vector<uint8_t> path_body;
+    append_u32_be(path_body, static_cast<uint32_t>(utf16_byte_len(track.file_path, true)));
+    append_utf16be(path_body, track.file_path, true);
+    append_section(file, 0x50505448, path_body);  // PPTH
+
+    if (is_ext) {
+        append_section(file, 0x50435832, cue_list_body(track, true));  // PCX2
+        append_section(file, 0x50575633, waveform_body(track, 1, spec.waveform_detail_entries, false, 3));  // PWV3
+        append_section(file, 0x50575634, waveform_body(track, 6, 400, false, 4));  // PWV4
+        append_section(file, 0x50575635, waveform_body(track, 2, spec.waveform_detail_entries, false, 5));  // PWV5
+        append_section(file, 0x50534932, song_structure_body(spec));  // PSI2
+    } else {
+        append_section(file, 0x50435545, cue_list_body(track, false));  // PCUE
+        append_section(file, 0x50424954, beat_grid_body(spec, track));  // PBIT
+        append_section(file, 0x50574156, waveform_body(track, 1, 400, true, 1));  // PWAV
+    }
+
+    put_u32_be(file, 8, static_cast<uint32_t>(file.size()));
+    return file;
+}
+
+bool write_file(const std::filesystem::path& path, const std::vector<uint8_t>& bytes) {
+    std::error_code ec;
+    std::filesystem::create_directories(path.parent_path(), ec);
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) return false;
+    out.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+    return static_cast<bool>(out);
+}
+
+bool write_export(const std::filesystem::path& root, const ExportSpec& spec) {
+    if (!write_file(pdb_path(root), build_pdb(spec))) return false;
+    if (!write_file(ext_pdb_path(root), build_ext_pdb(spec))) return false;
+
+    auto e = expected_export(spec);
+    size_t anlz_count = spec.anlz_track_limit == 0 ? e.tracks.size()
+                                                   : std::min(spec.anlz_track_limit, e.tracks.size());
+    for (size_t i = 0; i < anlz_count; ++i) {
+        const auto& track = e.tracks[i];
+        auto dir = anlz_dir(root) / anlz_subdir(track.id);
+        if (!write_file(dir / "ANLZ0000.DAT", build_anlz(spec, track, false))) return false;
+        if (!write_file(dir / "ANLZ0000.EXT", build_anlz(spec, track, true))) return false;
+    }
+
+    auto artwork_dir = root / "PIONEER" / "Artwork" / "00001";
+    for (size_t b = 1; b <= spec.album_count; ++b) {
+        auto id = static_cast<int64_t>(b);
+        auto stem = "b" + std::to_string(b);
+        if (!write_file(artwork_dir / (stem + ".jpg"), artwork_bytes(id, false))) return false;
+        if (b % 2 == 1 && !write_file(artwork_dir / (stem + "_m.jpg"), artwork_bytes(id, true))) return false;
+    }
+    return true;
+}
+
+std::vector<uint8_t> artwork_bytes(int64_t artwork_id, bool high_res) {
+    // SOI, a payload that differs per ID and variant, EOI
+    size_t payload = (high_res ? 1024 : 256) + static_cast<size_t>(artwork_id) * 13 % 200;
+    std::vector<uint8_t> bytes = {0xFF, 0xD8};
+    for (size_t i = 0; i < payload; ++i) {
+        bytes.push_back(static_cast<uint8_t>(artwork_id * 31 + static_cast<int64_t>(i) + (high_res ? 7 : 0)));
+    }
+    bytes.push_back(0xFF);
+    bytes.push_back(0xD9);
+    return bytes;
+}
+
+std::filesystem::path pdb_path(const std::filesystem::path& root) {
+    return root / "PIONEER" / "rekordbox" / "export.pdb";
+}
+
+std::filesystem::path ext_pdb_path(const std::filesystem::path& root) {
+    return root / "PIONEER" / "rekordbox" / "exportExt.pdb";
+}
+
+std::filesystem::path anlz_dir(const std::filesystem::path& root) {
+    return root / "PIONEER" / "USBANLZ";
+}
+
+} // namespace cratedigger::synthetic
@@ -0,0 +1,101 @@
+#pragma once
+/**
+ * @file synthetic_export.hpp
+ * @brief Synthetic rekordbox export generator (test and benchmark fixtures)
+ *
+ * Writes export.pdb / exportExt.pdb images and USBANLZ trees laid out the way
+ * RekordboxPdb and RekordboxAnlz read them, with deterministic contents that
+ * tests can check against.
+ */
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace cratedigger::synthetic {
+
+/// Shape of the generated export
+struct ExportSpec {
+    size_t track_count{100};
+    size_t artist_count{20};
+    size_t album_count{10};
+    size_t genre_count{8};
+    size_t label_count{4};
+    size_t key_count{24};
+    size_t playlist_count{4};
+    size_t tag_count{12};
+    size_t category_count{3};
+    uint32_t page_size{4096};
+    bool unicode_titles{false};       // Emit UTF-16 titles for some tracks
+    size_t waveform_detail_entries{600};
+    size_t beats_per_track{64};
+    size_t anlz_track_limit{0};       // Write ANLZ files for the first N tracks only (0 = all)
+};
+
+/// Expected contents of one generated track
+struct ExpectedTrack {
+    int64_t id{0};
+    std::string title;
+    int64_t artist_id{0};
+    int64_t album_id{0};
+    int64_t genre_id{0};
+    int64_t key_id{0};
+    uint32_t bpm_100x{0};
+    uint32_t duration_seconds{0};
+    uint16_t year{0};
+    uint16_t rating{0};
+    std::string file_path;
+    std::string analyze_path;
+    std::string isrc;
+};
+
+/// Expected contents of the whole export
+struct ExpectedExport {
+    std::vector<ExpectedTrack> tracks;
+    std::vector<std::string> artist_names;  // index = id - 1
+    std::vector<std::string> album_names;   // index = id - 1
+    std::vector<std::string> genre_names;   // index = id - 1
+    std::vector<std::vector<int64_t>> playlists;  // index = id - 1
+    std::vector<std::vector<int64_t>> tag_tracks; // index = tag id - 1
+};
+
+/// Compute the expected contents for a spec (no I/O)
+[[nodiscard]] ExpectedExport expected_export(const ExportSpec& spec);
+
+/// Build an export.pdb image in memory
+[[nodiscard]] std::vector<uint8_t> build_pdb(const ExportSpec& spec);
+
+/// Build an exportExt.pdb image in memory (tags and tag-track links)
+[[nodiscard]] std::vector<uint8_t> build_ext_pdb(const ExportSpec& spec);
+
+/// Build the .DAT (is_ext=false) or .EXT (is_ext=true) ANLZ file for a track
+[[nodiscard]] std::vector<uint8_t> build_anlz(const ExportSpec& spec, const ExpectedTrack& track, bool is_ext);
+
+/**
+ * @brief Write a complete export under root
+ *
+ * Layout: root/PIONEER/rekordbox/export.pdb, root/PIONEER/rekordbox/exportExt.pdb
+ * root/PIONEER/USBANLZ/Pxxx/xxxxxxxx/ANLZ0000.{DAT,EXT} and
+ * root/PIONEER/Artwork/00001/b<id>.jpg (plus b<id>_m.jpg for odd IDs).
+ *
+ * @return true on success
+ */
+bool write_export(const std::filesystem::path& root, const ExportSpec& spec);
+
+/// Contents of the artwork file for an artwork ID (a JPEG-framed stand-in; high_res is the "_m" file)
+[[nodiscard]] std::vector<uint8_t> artwork_bytes(int64_t artwork_id, bool high_res);
+
+/// Write bytes to a file, creating parent directories
+bool write_file(const std::filesystem::path& path, const std::vector<uint8_t>& bytes);
+
+/// Path of export.pdb under a root written by write_export
+[[nodiscard]] std::filesystem::path pdb_path(const std::filesystem::path& root);
+
+/// Path of exportExt.pdb under a root written by write_export
+[[nodiscard]] std::filesystem::path ext_pdb_path(const std::filesystem::path& root);
+
+/// Path of the USBANLZ directory under a root written by write_export
+[[nodiscard]] std::filesystem::path anlz_dir(const std::filesystem::path& root);
+
+} // namespace cratedigger::synthetic
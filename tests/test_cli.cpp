@@ -0,0 +1,419 @@
+/**
+ * @file test_cli.cpp
+ * @brief Unit tests for the JSONL CLI (JSON reader/writer and command dispatch)
+ */
+
+#include "cratedigger/cratedigger.hpp"
+#include "json.hpp"
+#include "session.hpp"
+#include "synthetic_export.hpp"
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+
+using namespace cratedigger;
+using namespace cratedigger::cli;
+
+namespace {
+
+int tests_passed = 0;
+int tests_failed = 0;
+
+#define TEST(name) \
+    void test_##name(); \
+    struct TestRunner_##name { \
+        TestRunner_##name() { \
+            std::cout << "Running test: " << #name << "... "; \
+            try { \
+                test_##name(); \
+                std::cout << "PASSED\n"; \
+                ++tests_passed; \
+            } catch (const std::exception& e) { \
+                std::cout << "FAILED: " << e.what() << "\n"; \
+                ++tests_failed; \
+            } \
+        } \
+    } test_runner_##name; \
+    void test_##name()
+
+#define ASSERT_TRUE(cond) \
+    if (!(cond)) throw std::runtime_error("Assertion failed: " #cond)
+
+#define ASSERT_EQ(a, b) \
+    if ((a) != (b)) throw std::runtime_error("Assertion failed: " #a " == " #b)
+
+#define ASSERT_NE(a, b) \
+    if ((a) == (b)) throw std::runtime_error("Assertion failed: " #a " != " #b)
+
+/// Unescaped string value of a parsed JSON text
+std::string parse_string(std::string_view json) {
+    JsonDocument doc;
+    if (!doc.parse(json)) throw std::runtime_error("parse failed: " + doc.error());
+    std::string scratch;
+    return std::string(doc.root().as_string(scratch));
+}
+
+/// Everything a JsonWriter produced, captured through a temporary file
+template<typename Write>
+std::string capture(Write&& write) {
+    std::FILE* file = std::tmpfile();
+    if (!file) throw std::runtime_error("tmpfile failed");
+    {
+        JsonWriter out(file);
+        write(out);
+    }
+    std::string text;
+    std::rewind(file);
+    char buffer[4096];
+    size_t n = 0;
+    while ((n = std::fread(buffer, 1, sizeof(buffer), file)) > 0) text.append(buffer, n);
+    std::fclose(file);
+    return text;
+}
+
+/// Output lines of a session fed the given input lines
+std::vector<std::string> run_session(Database& db, const std::vector<std::string>& input) {
+    std::string text = capture([&](JsonWriter& out) {
+        Session session(db, out);
+        for (const auto& line : input) {
+            if (!session.process_line(line)) break;
+        }
+    });
+    std::vector<std::string> lines;
+    size_t start = 0;
+    for (size_t nl = text.find('\n'); nl != std::string::npos; nl = text.find('\n', start)) {
+        lines.push_back(text.substr(start, nl - start));
+        start = nl + 1;
+    }
+    if (start != text.size()) throw std::runtime_error("unterminated output line");
+    return lines;
+}
+
+/// Small export shared by the session tests
+synthetic::ExportSpec export_spec() {
+    synthetic::ExportSpec spec;
+    spec.track_count = 20;
+    spec.unicode_titles = true;
+    spec.anlz_track_limit = 4;
+    return spec;
+}
+
+const std::filesystem::path& export_root() {
+    static const std::filesystem::path root = [] {
+        auto dir = std::filesystem::temp_directory_path() / "crate_digger_test_cli";
+        std::filesystem::remove_all(dir);
+        if (!synthetic::write_export(dir, export_spec())) {
+            throw std::runtime_error("Failed to write synthetic export");
+        }
+        return dir;
+    }();
+    return root;
+}
+
+Database open_export() {
+    Logger::instance().set_level(LogLevel::Error);
+    auto db = Database::open(synthetic::pdb_path(export_root()));
+    if (!db) throw std::runtime_error(db.error().message);
+    return std::move(*db);
+}
+
+// ============================================================================
+// Reader Tests
+// ============================================================================
+
+TEST(json_parses_values) {
+    JsonDocument doc;
+    ASSERT_TRUE(doc.parse(R"( {"a": 12, "b": [true, false, null], "c": -2.5e1, "s": "x y", "o": {}} )"));
+    auto root = doc.root();
+    ASSERT_TRUE(root.is_object());
+    ASSERT_EQ(root.find("a").as_int(), 12);
+    ASSERT_EQ(root.find("c").as_double(), -25.0);
+    ASSERT_EQ(root.find("c").as_int(-1), -25);
+    ASSERT_EQ(root.find("s").raw(), "\"x y\"");
+    ASSERT_EQ(root.find("b").raw(), "[true, false, null]");
+    ASSERT_TRUE(root.find("o").is_object());
+    ASSERT_TRUE(!root.find("missing").valid());
+    ASSERT_EQ(root.find("missing").raw(), "null");
+
+    std::vector<JsonType> types;
+    root.find("b").for_each([&types](JsonValue v) { types.push_back(v.type()); });
+    ASSERT_EQ(types.size(), 3u);
+    ASSERT_TRUE(types[0] == JsonType::Bool && types[1] == JsonType::Bool && types[2] == JsonType::Null);
+
+    // Fractional numbers and wrong types fall back
+    ASSERT_TRUE(doc.parse("[1.5, \"7\"]"));
+    std::vector<int64_t> ints;
+    doc.root().for_each([&ints](JsonValue v) { ints.push_back(v.as_int(-1)); });
+    ASSERT_EQ(ints[0], -1);
+    ASSERT_EQ(ints[1], -1);
+}
+
+TEST(json_out_of_range_integers_fall_back) {
+    JsonDocument doc;
+    ASSERT_TRUE(doc.parse("[1e30, 99999999999999999999, -1e300, 9223372036854775808, 1e3, -9223372036854775808]"));
+    std::vector<int64_t> ints;
+    doc.root().for_each([&ints](JsonValue v) { ints.push_back(v.as_int(-1)); });
+    ASSERT_EQ(ints.size(), 6u);
+    ASSERT_EQ(ints[0], -1);
+    ASSERT_EQ(ints[1], -1);
+    ASSERT_EQ(ints[2], -1);
+    ASSERT_EQ(ints[3], -1);
+    ASSERT_EQ(ints[4], 1000);
+    ASSERT_TRUE(ints[5] == std::numeric_limits<int64_t>::min());
+}
+
+TEST(json_unescapes_strings) {
+    ASSERT_EQ(parse_string(R"("plain")"), "plain");
+    ASSERT_EQ(parse_string(R"("q\"b\\s\/b\bf\fn\nr\rt\t")"), "q\"b\\s/b\bf\fn\nr\rt\t");
+    ASSERT_EQ(parse_string(R"("A\u00e9\u20AC")"), "A\xC3\xA9\xE2\x82\xAC");
+    ASSERT_EQ(parse_string(R"("\u12")"), "\\u12");  // Truncated escape is kept verbatim
+}
+
+TEST(json_decodes_surrogate_pairs) {
+    ASSERT_EQ(parse_string(R"("\uD83D\uDE00")"), "\xF0\x9F\x98\x80");
+    ASSERT_EQ(parse_string(R"("a\ud834\udd1eb")"), "a\xF0\x9D\x84\x9E" "b");
+
+    // Unpaired surrogates are replaced with U+FFFD rather than encoded
+    ASSERT_EQ(parse_string(R"("\uD800")"), "\xEF\xBF\xBD");
+    ASSERT_EQ(parse_string(R"("\uD800x")"), "\xEF\xBF\xBDx");
+    ASSERT_EQ(parse_string(R"("\uDC00")"), "\xEF\xBF\xBD");
+    ASSERT_EQ(parse_string(R"("\uD800\u0041")"), "\xEF\xBF\xBD" "A");
+    ASSERT_EQ(parse_string(R"("\uDE00\uD83D")"), "\xEF\xBF\xBD\xEF\xBF\xBD");
+}
+
+TEST(json_rejects_invalid_input) {
+    const char* bad[] = {
+        "", "   ", "{", "[", "[1,]", "[1 2]", "{\"a\"}", "{\"a\":1,}", "{a:1}", "tru", "nul",
+        "1.", "-", "1e", "\"abc", "\"a\x01\"", "{} x", "]", "\"\\", "+1",
+    };
+    JsonDocument doc;
+    for (const char* text : bad) {
+        ASSERT_TRUE(!doc.parse(text));
+        ASSERT_TRUE(doc.error().find(" at offset ") != std::string::npos);
+    }
+}
+
+TEST(json_limits_nesting_depth) {
+    auto nested = [](int depth) {
+        auto n = static_cast<size_t>(depth);
+        return std::string(n, '[') + std::string(n, ']');
+    };
+    JsonDocument doc;
+    ASSERT_TRUE(doc.parse(nested(JsonDocument::kMaxDepth + 1)));
+    ASSERT_TRUE(!doc.parse(nested(JsonDocument::kMaxDepth + 2)));
+    ASSERT_TRUE(doc.error().find("nesting too deep") != std::string::npos);
+
+    // Far past the limit: an error, not a stack overflow
+    ASSERT_TRUE(!doc.parse(std::string(200000, '[')));
+    std::string objects;
+    for (int i = 0; i < 100000; ++i) objects += "{\"a\":";
+    ASSERT_TRUE(!doc.parse(objects));
+    ASSERT_TRUE(doc.error().find("nesting too deep") != std::string::npos);
+}
+
+TEST(json_document_reused_between_lines) {
+    JsonDocument doc;
+    ASSERT_TRUE(doc.parse(R"({"cmd":"a","list":[1,2,3,4,5,6,7,8],"old":true})"));
+    size_t first_nodes = doc.nodes().size();
+    size_t capacity = doc.nodes().capacity();
+
+    ASSERT_TRUE(doc.parse(R"({"cmd":"b"})"));
+    auto root = doc.root();
+    ASSERT_EQ(doc.nodes().size(), 2u);
+    ASSERT_TRUE(doc.nodes().size() < first_nodes);
+    ASSERT_EQ(doc.nodes().capacity(), capacity);
+    std::string scratch;
+    ASSERT_EQ(root.find("cmd").as_string(scratch), "b");
+    ASSERT_TRUE(!root.find("old").valid());
+
+    // A failed parse leaves no stale root behind it either way
+    ASSERT_TRUE(!doc.parse("{\"cmd\":"));
+    ASSERT_TRUE(doc.parse("[]"));
+    ASSERT_TRUE(doc.root().is_array());
+    ASSERT_EQ(doc.nodes().size(), 1u);
+}
+
+// ============================================================================
+// Writer Tests
+// ============================================================================
+
+TEST(json_writer_output) {
+    auto text = capture([](JsonWriter& out) {
+        out.begin_object()
+            .key("s").value("a\"b\\c\n\x01")
+            .key("i").value(-42)
+            .key("d").value(1.5)
+            .key("f").value(0.9f)
+            .key("b").value(true)
+            .key("n").null()
+            .key("a").begin_array().value(1).value(2).begin_object().end_object().end_array()
+            .end_object();
+        out.end_line();
+    });
+    ASSERT_EQ(text, "{\"s\":\"a\\\"b\\\\c\\n\\u0001\",\"i\":-42,\"d\":1.5,\"f\":0.9,\"b\":true,\"n\":null,"
+                    "\"a\":[1,2,{}]}\n");
+}
+
+TEST(json_writer_non_finite_numbers_are_null) {
+    auto text = capture([](JsonWriter& out) {
+        out.begin_array()
+            .value(std::numeric_limits<double>::quiet_NaN())
+            .value(std::numeric_limits<double>::infinity())
+            .value(-std::numeric_limits<double>::infinity())
+            .value(std::numeric_limits<float>::infinity())
+            .value(2.0)
+            .end_array();
+        out.end_line();
+    });
+    ASSERT_EQ(text, "[null,null,null,null,2]\n");
+
+    JsonDocument doc;
+    ASSERT_TRUE(doc.parse(std::string_view(text).substr(0, text.size() - 1)));
+}
+
+// ============================================================================
+// Session Tests
+// ============================================================================
+
+TEST(cli_answers_single_commands) {
+    auto db = open_export();
+    auto lines = run_session(db, {
+        R"({"cmd":"track_count"})",
+        "",
+        R"({"request_id":"r1","cmd":"get_track","id":1})",
+    });
+    ASSERT_EQ(lines.size(), 2u);  // Blank lines are ignored
+
+    JsonDocument doc;
+    ASSERT_TRUE(doc.parse(lines[0]));
+    ASSERT_EQ(doc.root().find("count").as_int(), 20);
+
+    ASSERT_TRUE(doc.parse(lines[1]));
+    auto expected = synthetic::expected_export(export_spec());
+    std::string scratch;
+    ASSERT_EQ(lines[1].rfind("{\"request_id\":\"r1\",", 0), 0u);  // Echoed first
+    ASSERT_EQ(doc.root().find("id").as_int(), 1);
+    ASSERT_EQ(doc.root().find("title").as_string(scratch), expected.tracks[0].title);
+    ASSERT_EQ(doc.root().find("file_path").as_string(scratch), expected.tracks[0].file_path);
+}
+
+TEST(cli_batches_answer_in_order) {
+    auto db = open_export();
+    auto lines = run_session(db, {
+        R"([{"cmd":"get_track","id":3,"request_id":1},)"
+        R"({"cmd":"track_count","request_id":"two"},)"
+        R"({"cmd":"no_such_command","request_id":[3,{"k":null}]},)"
+        R"({"cmd":"get_track","id":2}])",
+    });
+    ASSERT_EQ(lines.size(), 1u);
+
+    JsonDocument doc;
+    ASSERT_TRUE(doc.parse(lines[0]));
+    std::vector<JsonValue> answers;
+    doc.root().for_each([&answers](JsonValue v) { answers.push_back(v); });
+    ASSERT_EQ(answers.size(), 4u);
+
+    ASSERT_EQ(answers[0].find("request_id").raw(), "1");
+    ASSERT_EQ(answers[0].find("id").as_int(), 3);
+    ASSERT_EQ(answers[1].find("request_id").raw(), "\"two\"");
+    ASSERT_EQ(answers[1].find("count").as_int(), 20);
+    ASSERT_EQ(answers[2].find("request_id").raw(), "[3,{\"k\":null}]");
+    std::string scratch;
+    ASSERT_EQ(answers[2].find("error").as_string(scratch), "Unknown command: no_such_command");
+    ASSERT_TRUE(!answers[3].find("request_id").valid());
+    ASSERT_EQ(answers[3].find("id").as_int(), 2);
+}
+
+TEST(cli_reports_errors_as_objects) {
+    auto db = open_export();
+    auto lines = run_session(db, {
+        R"({"cmd":"get_track",)",
+        R"({"request_id":5})",
+        R"({"cmd":"get_track","request_id":6})",
+        R"({"cmd":"get_track","id":999999})",
+        R"({"cmd":"find_tracks_by_title","title":7})",
+        R"([1,{"cmd":"artist_count"}])",
+        R"("not a command")",
+        R"({"cmd":"get_track","id":1e30})",
+    });
+    ASSERT_EQ(lines.size(), 8u);
+
+    JsonDocument doc;
+    std::string scratch;
+    auto error_of = [&](size_t i) {
+        if (!doc.parse(lines[i])) throw std::runtime_error("bad output line: " + lines[i]);
+        return std::string(doc.root().find("error").as_string(scratch));
+    };
+    ASSERT_EQ(error_of(0).rfind("Invalid JSON: ", 0), 0u);
+    ASSERT_EQ(error_of(1), "Missing cmd");
+    ASSERT_EQ(doc.root().find("request_id").as_int(), 5);
+    ASSERT_EQ(error_of(2), "Missing numeric parameter: track_id");
+    ASSERT_EQ(doc.root().find("request_id").as_int(), 6);
+    ASSERT_EQ(error_of(3), "Track not found");
+    ASSERT_EQ(error_of(4), "Missing string parameter: title");
+    ASSERT_EQ(error_of(6), "Command must be a JSON object");
+    ASSERT_EQ(error_of(7), "Track not found");  // Out of int64_t range
+
+    ASSERT_TRUE(doc.parse(lines[5]));
+    std::vector<JsonValue> answers;
+    doc.root().for_each([&answers](JsonValue v) { answers.push_back(v); });
+    ASSERT_EQ(answers.size(), 2u);
+    ASSERT_EQ(answers[0].find("error").as_string(scratch), "Command must be a JSON object");
+    ASSERT_TRUE(answers[1].find("count").valid());
+}
+
+TEST(cli_lazy_analysis_matches_eager) {
+    const std::vector<std::string> requests = {
+        R"([{"cmd":"get_beat_grid","id":1},{"cmd":"get_cue_points","id":2},{"cmd":"get_waveform","id":1},)"
+        R"({"cmd":"get_cue_points","id":3},{"cmd":"get_waveform","id":2,"kind":"detail","max_points":16},)"
+        R"({"cmd":"get_beat_grid","id":20}])",
+    };
+    auto eager = open_export();
+    eager.load_cue_points(synthetic::anlz_dir(export_root()));
+    auto expected = run_session(eager, requests);
+    ASSERT_EQ(expected.size(), 1u);
+    ASSERT_TRUE(expected[0].find("\"beat_numbers\":[") != std::string::npos);
+    ASSERT_TRUE(expected[0].find("\"error\":\"Beat grid not found\"") != std::string::npos);  // No ANLZ file
+
+    // A one-track cache evicts on every request, so each answer has to hold its own copy
+    auto lazy = open_export();
+    lazy.enable_lazy_anlz_loading(1);
+    ASSERT_EQ(run_session(lazy, requests), expected);
+}
+
+TEST(cli_stops_at_exit) {
+    auto db = open_export();
+    auto lines = run_session(db, {
+        R"({"cmd":"track_count"})",
+        R"([{"cmd":"track_count"},{"cmd":"exit"},{"cmd":"track_count"}])",
+        R"({"cmd":"track_count"})",
+    });
+    ASSERT_EQ(lines.size(), 2u);
+
+    // The batch answers up to and including the exit, then the session ends
+    JsonDocument doc;
+    ASSERT_TRUE(doc.parse(lines[1]));
+    size_t answers = 0;
+    doc.root().for_each([&answers](JsonValue) { ++answers; });
+    ASSERT_EQ(answers, 2u);
+
+    ASSERT_EQ(run_session(db, {R"({"cmd":"quit"})", R"({"cmd":"track_count"})"}).size(), 0u);
+}
+
+} // anonymous namespace
+
+int main() {
+    std::cout << "\n=== CLI Tests ===\n\n";
+
+    // Tests are automatically registered and run by TestRunner constructors
+
+    std::cout << "\n=== Summary ===\n";
+    std::cout << "Passed: " << tests_passed << "\n";
+    std::cout << "Failed: " << tests_failed << "\n";
+
+    return tests_failed > 0 ? 1 : 0;
+}
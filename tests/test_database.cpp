@@ -4,8 +4,23 @@
  */
 
 #include "cratedigger/cratedigger.hpp"
+#include "cratedigger/rekordbox_anlz.hpp"
+#include "cratedigger/rekordbox_pdb.hpp"
+#include "synthetic_export.hpp"
 #include <iostream>
+#include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <cctype>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <optional>
+#include <set>
+#include <thread>
+#include <vector>
 
 using namespace cratedigger;
 
@@ -194,6 +209,1588 @@ TEST(cue_point_loop_duration) {
     ASSERT_EQ(cue.loop_duration_ms(), 0u);
 }
 
+// ============================================================================
+// Synthetic Export Tests
+// ============================================================================
+
+/// Spec shared by the synthetic export tests (several pages per table)
+const synthetic::ExportSpec& test_spec() {
+    static const synthetic::ExportSpec spec = [] {
+        synthetic::ExportSpec s;
+        s.track_count = 250;
+        s.unicode_titles = true;
+        return s;
+    }();
+    return spec;
+}
+
+/// Export written once per test run under the system temp directory
+const std::filesystem::path& synthetic_root() {
+    static const std::filesystem::path root = [] {
+        auto dir = std::filesystem::temp_directory_path() / "crate_digger_test_export";
+        std::filesystem::remove_all(dir);
+        if (!synthetic::write_export(dir, test_spec())) {
+            throw std::runtime_error("Failed to write synthetic export");
+        }
+        return dir;
+    }();
+    return root;
+}
+
+/// File offsets of every row of a table, in page chain order
+std::vector<size_t> table_row_offsets(const std::filesystem::path& pdb, PageType type) {
+    std::vector<size_t> rows;
+    auto parsed = RekordboxPdb::open(pdb);
+    if (!parsed) return rows;
+    for (const auto& table : parsed->tables()) {
+        if (table.type != type) continue;
+        for (uint32_t page = table.first_page_index;; ) {
+            auto cursor = parsed->page_rows(page);
+            size_t row_base = 0;
+            while (cursor.next(row_base)) rows.push_back(row_base);
+            if (page == table.last_page_index) break;
+            page = cursor.next_page_index();
+        }
+    }
+    return rows;
+}
+
+/// Store a little-endian u32 in a PDB image
+void patch_u32(std::vector<uint8_t>& image, size_t offset, uint32_t value) {
+    for (size_t i = 0; i < 4; ++i) image[offset + i] = static_cast<uint8_t>(value >> (8 * i));
+}
+
+TEST(synthetic_export_tracks) {
+    auto db = Database::open(synthetic::pdb_path(synthetic_root()));
+    ASSERT_TRUE(db.has_value());
+
+    auto expected = synthetic::expected_export(test_spec());
+    ASSERT_EQ(db->track_count(), expected.tracks.size());
+    ASSERT_EQ(db->artist_count(), expected.artist_names.size());
+    ASSERT_EQ(db->album_count(), expected.album_names.size());
+
+    for (const auto& e : expected.tracks) {
+        auto track = db->get_track(TrackId{e.id});
+        ASSERT_TRUE(track.has_value());
+        ASSERT_EQ(track->title, e.title);
+        ASSERT_EQ(track->artist_id.value, e.artist_id);
+        ASSERT_EQ(track->album_id.value, e.album_id);
+        ASSERT_EQ(track->bpm_100x, e.bpm_100x);
+        ASSERT_EQ(track->file_path, e.file_path);
+        ASSERT_EQ(track->analyze_path, e.analyze_path);
+    }
+
+    auto artist = db->get_artist(ArtistId{1});
+    ASSERT_TRUE(artist.has_value());
+    ASSERT_EQ(artist->name, expected.artist_names[0]);
+    auto album = db->get_album(AlbumId{2});
+    ASSERT_TRUE(album.has_value());
+    ASSERT_EQ(album->name, expected.album_names[1]);
+}
+
+TEST(database_open_memory_mapped) {
+    auto path = synthetic::pdb_path(synthetic_root());
+    auto buffered = Database::open(path);
+    DatabaseOptions options;
+    options.io_mode = IoMode::MemoryMapped;
+    auto mapped = Database::open(path, options);
+    ASSERT_TRUE(buffered.has_value());
+    ASSERT_TRUE(mapped.has_value());
+    ASSERT_EQ(mapped->options().io_mode, IoMode::MemoryMapped);
+
+    ASSERT_EQ(mapped->track_count(), buffered->track_count());
+    for (auto id : buffered->all_track_ids()) {
+        auto a = buffered->get_track(id);
+        auto b = mapped->get_track(id);
+        ASSERT_TRUE(b.has_value());
+        ASSERT_EQ(a->title, b->title);
+        ASSERT_EQ(a->file_path, b->file_path);
+        ASSERT_EQ(a->duration_seconds, b->duration_seconds);
+    }
+    ASSERT_EQ(mapped->get_playlist(PlaylistId{1}), buffered->get_playlist(PlaylistId{1}));
+
+    auto ext = Database::open_ext(synthetic::ext_pdb_path(synthetic_root()), options);
+    ASSERT_TRUE(ext.has_value());
+    ASSERT_EQ(ext->tag_count(), test_spec().tag_count);
+}
+
+TEST(anlz_open_memory_mapped) {
+    auto expected = synthetic::expected_export(test_spec());
+    const auto& track = expected.tracks[3];
+    auto dat = synthetic_root() / "dat_only.DAT";
+    ASSERT_TRUE(synthetic::write_file(dat, synthetic::build_anlz(test_spec(), track, false)));
+
+    auto buffered = RekordboxAnlz::open(dat);
+    auto mapped = RekordboxAnlz::open(dat, IoMode::MemoryMapped);
+    ASSERT_TRUE(buffered.has_value());
+    ASSERT_TRUE(mapped.has_value());
+    ASSERT_EQ(mapped->track_path(), track.file_path);
+    ASSERT_EQ(mapped->cue_points().size(), buffered->cue_points().size());
+    ASSERT_EQ(mapped->beat_grid().beats.size(), test_spec().beats_per_track);
+    ASSERT_EQ(mapped->beat_grid().beats.size(), buffered->beat_grid().beats.size());
+
+    auto missing = RekordboxAnlz::open(synthetic_root() / "missing.DAT", IoMode::MemoryMapped);
+    ASSERT_TRUE(!missing.has_value());
+    ASSERT_EQ(missing.error().code, ErrorCode::FileNotFound);
+}
+
+TEST(load_cue_points_memory_mapped) {
+    DatabaseOptions options;
+    options.io_mode = IoMode::MemoryMapped;
+    auto db = Database::open(synthetic::pdb_path(synthetic_root()), options);
+    ASSERT_TRUE(db.has_value());
+
+    db->load_cue_points(synthetic::anlz_dir(synthetic_root()));
+    ASSERT_EQ(db->cue_point_track_count(), test_spec().track_count);
+    ASSERT_EQ(db->beat_grid_track_count(), test_spec().track_count);
+
+    // .EXT cues (with comments) take priority over .DAT cues
+    auto cues = db->get_cue_points_for_track(TrackId{7});
+    ASSERT_EQ(cues.size(), 3u);
+    ASSERT_EQ(cues[1].comment, "Drop");
+    ASSERT_TRUE(db->get_waveforms_for_track(TrackId{7}) != nullptr);
+    ASSERT_TRUE(db->get_song_structure_for_track(TrackId{7}) != nullptr);
+}
+
+TEST(anlz_section_mask_skips_payloads) {
+    // Detail waveforms of a five-minute track, as on a real stick
+    auto spec = test_spec();
+    spec.waveform_detail_entries = 45000;
+    auto expected = synthetic::expected_export(spec);
+    auto ext = synthetic_root() / "masked.EXT";
+    ASSERT_TRUE(synthetic::write_file(ext, synthetic::build_anlz(spec, expected.tracks[6], true)));
+    auto file_size = std::filesystem::file_size(ext);
+
+    for (auto mode : {IoMode::Buffered, IoMode::MemoryMapped}) {
+        auto full = RekordboxAnlz::open(ext, mode);
+        auto cues = RekordboxAnlz::open(ext, mode, AnlzSections::CuePoints);
+        ASSERT_TRUE(full.has_value() && cues.has_value());
+        ASSERT_TRUE(full->bytes_read() >= file_size);
+        ASSERT_TRUE(cues->bytes_read() * 20 < file_size);
+        ASSERT_EQ(cues->track_path(), full->track_path());
+        ASSERT_EQ(cues->cue_points().size(), full->cue_points().size());
+        ASSERT_EQ(cues->cue_points()[1].comment, full->cue_points()[1].comment);
+        ASSERT_TRUE(full->has_waveforms() && !cues->has_waveforms());
+    }
+
+    // Directory scans skip the waveform sections of every file
+    auto db = Database::open(synthetic::pdb_path(synthetic_root()));
+    ASSERT_TRUE(db.has_value());
+    db->load_cue_points(synthetic::anlz_dir(synthetic_root()), AnlzSections::CuePoints | AnlzSections::BeatGrid);
+    ASSERT_EQ(db->cue_point_track_count(), test_spec().track_count);
+    ASSERT_EQ(db->beat_grid_track_count(), test_spec().track_count);
+    ASSERT_TRUE(db->get_waveforms_for_track(TrackId{7}) == nullptr);
+    ASSERT_EQ(db->get_cue_points_for_track(TrackId{7})[1].comment, "Drop");
+}
+
+TEST(load_cue_points_parallel_matches_serial) {
+    auto path = synthetic::pdb_path(synthetic_root());
+    auto serial = Database::open(path);
+    DatabaseOptions options;
+    options.thread_count = 4;
+    auto parallel = Database::open(path, options);
+    ASSERT_TRUE(serial.has_value());
+    ASSERT_TRUE(parallel.has_value());
+
+    serial->load_cue_points(synthetic::anlz_dir(synthetic_root()));
+    parallel->load_cue_points(synthetic::anlz_dir(synthetic_root()));
+    ASSERT_EQ(parallel->cue_point_track_count(), serial->cue_point_track_count());
+    ASSERT_EQ(parallel->waveform_track_count(), serial->waveform_track_count());
+    ASSERT_EQ(parallel->song_structure_track_count(), serial->song_structure_track_count());
+
+    for (auto id : serial->all_track_ids()) {
+        auto a = serial->get_cue_points_for_track(id);
+        auto b = parallel->get_cue_points_for_track(id);
+        ASSERT_EQ(a.size(), b.size());
+        for (size_t i = 0; i < a.size(); ++i) {
+            ASSERT_EQ(a[i].time_ms, b[i].time_ms);
+            ASSERT_EQ(a[i].color_id, b[i].color_id);
+            ASSERT_EQ(a[i].comment, b[i].comment);
+        }
+
+        auto grid_a = serial->get_beat_grid_for_track(id);
+        auto grid_b = parallel->get_beat_grid_for_track(id);
+        ASSERT_TRUE(grid_a != nullptr && grid_b != nullptr);
+        ASSERT_EQ(grid_a->beats.size(), grid_b->beats.size());
+
+        // Colored PWV5 detail wins over blue PWV3 in both paths
+        auto wave_a = serial->get_waveforms_for_track(id);
+        auto wave_b = parallel->get_waveforms_for_track(id);
+        ASSERT_TRUE(wave_a != nullptr && wave_b != nullptr);
+        ASSERT_TRUE(wave_b->detail.has_value() && wave_b->preview.has_value());
+        ASSERT_EQ(wave_b->detail->style, WaveformStyle::RGB);
+        ASSERT_TRUE(wave_a->detail->data == wave_b->detail->data);
+    }
+}
+
+TEST(lazy_anlz_loading) {
+    auto db = Database::open(synthetic::pdb_path(synthetic_root()));
+    ASSERT_TRUE(db.has_value());
+
+    // Export root is derived from the export.pdb location
+    db->enable_lazy_anlz_loading(8);
+    ASSERT_EQ(db->cached_analysis_count(), 0u);
+    ASSERT_EQ(db->cue_point_track_count(), 0u);
+
+    auto cues = db->get_cue_points_for_track(TrackId{7});
+    ASSERT_EQ(cues.size(), 3u);
+    ASSERT_EQ(cues[1].comment, "Drop");  // .EXT priority over .DAT
+    ASSERT_EQ(db->cached_analysis_count(), 1u);
+
+    auto grid = db->get_beat_grid_for_track(TrackId{7});
+    ASSERT_TRUE(grid != nullptr);
+    ASSERT_EQ(grid->beats.size(), test_spec().beats_per_track);
+    auto waveforms = db->get_waveforms_for_track(TrackId{7});
+    ASSERT_TRUE(waveforms != nullptr && waveforms->detail.has_value());
+    ASSERT_EQ(waveforms->detail->style, WaveformStyle::RGB);
+    ASSERT_EQ(db->cached_analysis_count(), 1u);
+
+    // The cache stays bounded; held results survive eviction
+    auto held = db->get_analysis_for_track(TrackId{1});
+    ASSERT_TRUE(held != nullptr);
+    auto held_grid = db->get_beat_grid_for_track(TrackId{2});
+    auto held_waves = db->get_waveforms_for_track(TrackId{2});
+    auto held_cues = db->get_cue_points_view(TrackId{2});
+    for (int64_t id = 3; id <= 40; ++id) {
+        ASSERT_TRUE(db->get_analysis_for_track(TrackId{id}) != nullptr);
+    }
+    ASSERT_EQ(db->cached_analysis_count(), 8u);
+    ASSERT_EQ(held->cue_points.size(), 3u);
+    ASSERT_TRUE(!held->song_structure.empty());
+    ASSERT_EQ(held_grid->beats.size(), test_spec().beats_per_track);
+    ASSERT_TRUE(held_waves->detail.has_value() && held_waves->detail->entry_count > 0);
+    ASSERT_EQ(held_cues.size(), 3u);
+    ASSERT_EQ(held_cues[1].comment, "Drop");
+
+    ASSERT_TRUE(db->get_analysis_for_track(TrackId{999999}) == nullptr);
+}
+
+TEST(metrics_cover_open_and_anlz_loads) {
+    auto path = synthetic::pdb_path(synthetic_root());
+    auto db = Database::open(path);
+    ASSERT_TRUE(db.has_value());
+    auto metrics = db->metrics();
+    ASSERT_EQ(metrics.file_bytes, std::filesystem::file_size(path));
+    ASSERT_EQ(metrics.open_ns, metrics.read_ns + metrics.index_ns);
+    ASSERT_TRUE(!metrics.snapshot_restored && metrics.pooled_strings > 0);
+    auto tracks = std::find_if(metrics.tables.begin(), metrics.tables.end(),
+                               [](const TableMetrics& t) { return t.table == "tracks"; });
+    ASSERT_TRUE(tracks != metrics.tables.end());
+    ASSERT_EQ(tracks->rows, test_spec().track_count);
+    ASSERT_TRUE(tracks->pages > 0 && tracks->parse_ns > 0);
+    ASSERT_EQ(tracks->bytes, tracks->pages * metrics.page_size);
+
+    size_t anlz_files = 0;
+    for (const auto& entry : std::filesystem::recursive_directory_iterator(synthetic::anlz_dir(synthetic_root()))) {
+        if (entry.is_regular_file()) ++anlz_files;
+    }
+    db->load_cue_points(synthetic::anlz_dir(synthetic_root()));
+    auto anlz = db->metrics().anlz;
+    ASSERT_EQ(anlz.files_parsed + anlz.files_failed, anlz_files);
+    ASSERT_TRUE(anlz.bytes_read > 0 && anlz.files_per_second() > 0.0);
+
+    // Lazy lookups: one miss, then a hit
+    auto lazy = Database::open(path);
+    ASSERT_TRUE(lazy.has_value());
+    lazy->enable_lazy_anlz_loading(8);
+    ASSERT_TRUE(lazy->get_analysis_for_track(TrackId{7}) != nullptr);
+    ASSERT_TRUE(lazy->get_analysis_for_track(TrackId{7}) != nullptr);
+    anlz = lazy->metrics().anlz;
+    ASSERT_EQ(anlz.cache_misses, 1u);
+    ASSERT_EQ(anlz.cache_hits, 1u);
+    ASSERT_TRUE(anlz.cache_hit_rate() == 0.5);
+
+    auto json = to_json(lazy->metrics());
+    ASSERT_TRUE(json.front() == '{' && json.back() == '}');
+    ASSERT_TRUE(json.find("\"tables\":[{\"table\":\"") != std::string::npos);
+    ASSERT_TRUE(json.find("\"cache_hit_rate\":0.5") != std::string::npos);
+
+    // Messages below the active level are never built
+    int built = 0;
+    auto message = [&built] {
+        ++built;
+        return std::string("metrics test");
+    };
+    std::vector<std::string> lines;
+    Logger::instance().set_callback([&lines](LogLevel, std::string_view line) { lines.emplace_back(line); });
+    LOG_DEBUG(message());
+    ASSERT_EQ(built, 0);
+    LOG_WARN(message());
+    Logger::instance().set_callback(nullptr);
+    ASSERT_EQ(built, 1);
+    ASSERT_EQ(lines.size(), 1u);
+    ASSERT_TRUE(lines[0].find("\"level\":\"warning\",\"message\":\"metrics test\"") != std::string::npos);
+}
+
+TEST(moved_from_anlz_manager_stays_usable) {
+    auto dir = synthetic::anlz_dir(synthetic_root());
+    CuePointManager original;
+    CuePointManager moved(std::move(original));
+    CuePointManager assigned;
+    assigned = std::move(moved);
+
+    // Loads on the moved-from managers are not counted, but must not crash
+    for (auto* manager : {&original, &moved}) {
+        manager->scan_directory(dir);
+        for (const auto& entry : std::filesystem::recursive_directory_iterator(dir)) {
+            if (entry.is_regular_file()) manager->load_anlz_file(entry.path());
+        }
+        manager->enable_lazy_loading(synthetic_root(), 4);
+        ASSERT_TRUE(manager->load_analysis(synthetic::expected_export(test_spec()).tracks[0].analyze_path) != nullptr);
+        ASSERT_EQ(manager->metrics().files_parsed, 0u);
+    }
+    ASSERT_TRUE(original.beat_grid_count() > 0);
+
+    assigned.scan_directory(dir);
+    ASSERT_TRUE(assigned.metrics().files_parsed > 0);
+}
+
+TEST(flat_index_lookups) {
+    auto db = Database::open(synthetic::pdb_path(synthetic_root()));
+    ASSERT_TRUE(db.has_value());
+    auto expected = synthetic::expected_export(test_spec());
+
+    // Postings come back sorted and de-duplicated
+    std::vector<TrackId> by_album;
+    for (const auto& e : expected.tracks) {
+        if (e.album_id == 3) by_album.push_back(TrackId{e.id});
+    }
+    ASSERT_TRUE(db->find_tracks_by_album(AlbumId{3}) == by_album);
+    ASSERT_TRUE(db->find_tracks_by_album(AlbumId{999}).empty());
+
+    // Name lookups fold case
+    std::string upper = expected.artist_names[4];
+    for (auto& c : upper) c = static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+    auto artists = db->find_artists_by_name(upper);
+    ASSERT_EQ(artists.size(), 1u);
+    ASSERT_EQ(artists[0].value, 5);
+    ASSERT_TRUE(db->find_artists_by_name("No Such Artist").empty());
+
+    ASSERT_TRUE(db->get_track(TrackId{0}) == std::nullopt);
+    ASSERT_TRUE(db->get_track(TrackId{-1}) == std::nullopt);
+    ASSERT_TRUE(db->get_track(TrackId{static_cast<int64_t>(expected.tracks.size()) + 1}) == std::nullopt);
+
+    auto ext = Database::open_ext(synthetic::ext_pdb_path(synthetic_root()));
+    ASSERT_TRUE(ext.has_value());
+    std::vector<TrackId> tagged;
+    for (int64_t id : expected.tag_tracks[0]) tagged.push_back(TrackId{id});
+    ASSERT_TRUE(ext->find_tracks_by_tag(TagId{101}) == tagged);
+    auto tags = ext->find_tags_by_name("TAG 1");
+    ASSERT_EQ(tags.size(), 1u);
+    ASSERT_EQ(tags[0].value, 101);
+}
+
+TEST(track_columns_match_rows) {
+    auto db = Database::open(synthetic::pdb_path(synthetic_root()));
+    ASSERT_TRUE(db.has_value());
+    auto expected = synthetic::expected_export(test_spec());
+
+    const auto& columns = db->track_columns();
+    ASSERT_EQ(columns.size(), expected.tracks.size());
+    ASSERT_EQ(columns.bpm_100x.size(), columns.size());
+    ASSERT_EQ(columns.play_count.size(), columns.size());
+    for (size_t i = 0; i < expected.tracks.size(); ++i) {
+        const auto& e = expected.tracks[i];
+        ASSERT_EQ(columns.track_id[i], e.id);
+        ASSERT_EQ(columns.bpm_100x[i], e.bpm_100x);
+        ASSERT_EQ(columns.duration[i], e.duration_seconds);
+        ASSERT_EQ(columns.year[i], e.year);
+        ASSERT_EQ(columns.rating[i], e.rating);
+        ASSERT_EQ(columns.key_id[i], e.key_id);
+        ASSERT_EQ(columns.genre_id[i], e.genre_id);
+        ASSERT_EQ(columns.artist_id[i], e.artist_id);
+    }
+
+    // Bulk getters are derived from the same columns
+    auto bpms = db->get_all_bpms();
+    ASSERT_EQ(bpms.size(), columns.size());
+    ASSERT_EQ(bpms[0], columns.bpm_100x[0] / 100.0f);
+    ASSERT_EQ(db->get_all_years()[3], static_cast<int32_t>(columns.year[3]));
+
+    // The store is built once; repeated calls return the same memory
+    ASSERT_TRUE(db->track_columns().bpm_100x.data() == columns.bpm_100x.data());
+}
+
+TEST(parallel_indexing_matches_serial) {
+    auto serial = Database::open(synthetic::pdb_path(synthetic_root()));
+    ASSERT_TRUE(serial.has_value());
+
+    DatabaseOptions options;
+    options.parallel_indexing = true;
+    options.thread_count = 4;
+    auto parallel = Database::open(synthetic::pdb_path(synthetic_root()), options);
+    ASSERT_TRUE(parallel.has_value());
+
+    ASSERT_EQ(parallel->track_count(), serial->track_count());
+    ASSERT_EQ(parallel->artist_count(), serial->artist_count());
+    ASSERT_EQ(parallel->album_count(), serial->album_count());
+    ASSERT_EQ(parallel->genre_count(), serial->genre_count());
+    ASSERT_EQ(parallel->playlist_count(), serial->playlist_count());
+    ASSERT_TRUE(parallel->all_track_ids() == serial->all_track_ids());
+    ASSERT_TRUE(parallel->track_columns().bpm_100x == serial->track_columns().bpm_100x);
+    ASSERT_TRUE(parallel->find_tracks_by_artist(ArtistId{3}) == serial->find_tracks_by_artist(ArtistId{3}));
+    for (auto id : serial->all_playlist_ids()) {
+        ASSERT_TRUE(parallel->get_playlist(id) == serial->get_playlist(id));
+    }
+    for (auto id : serial->all_track_ids()) {
+        ASSERT_EQ(parallel->get_track(id)->title, serial->get_track(id)->title);
+    }
+
+    auto ext_serial = Database::open_ext(synthetic::ext_pdb_path(synthetic_root()));
+    auto ext_parallel = Database::open_ext(synthetic::ext_pdb_path(synthetic_root()), options);
+    ASSERT_TRUE(ext_serial.has_value() && ext_parallel.has_value());
+    ASSERT_EQ(ext_parallel->tag_count(), ext_serial->tag_count());
+    ASSERT_TRUE(ext_parallel->find_tracks_by_tag(TagId{105}) == ext_serial->find_tracks_by_tag(TagId{105}));
+}
+
+TEST(page_row_cursor_matches_read_page) {
+    auto pdb = RekordboxPdb::open(synthetic::pdb_path(synthetic_root()));
+    ASSERT_TRUE(pdb.has_value());
+
+    size_t pages_checked = 0;
+    for (const auto& table : pdb->tables()) {
+        uint32_t page_index = table.first_page_index;
+        for (size_t guard = 0; guard < 1000; ++guard) {
+            auto page = pdb->read_page(page_index);
+            ASSERT_TRUE(page.has_value());
+
+            std::vector<size_t> expected_rows;
+            if (page->is_data_page) {
+                for (const auto& group : page->row_groups) {
+                    for (size_t r = 0; r < group.row_offsets.size(); ++r) {
+                        if ((group.row_present_flags >> r) & 1) {
+                            expected_rows.push_back(group.heap_pos + group.row_offsets[r]);
+                        }
+                    }
+                }
+            }
+
+            auto cursor = pdb->page_rows(page_index);
+            ASSERT_TRUE(cursor.valid());
+            ASSERT_EQ(cursor.is_data_page(), page->is_data_page);
+            ASSERT_EQ(cursor.next_page_index(), page->next_page_index);
+            std::vector<size_t> rows;
+            size_t row_base = 0;
+            while (cursor.next(row_base)) rows.push_back(row_base);
+            ASSERT_TRUE(rows == expected_rows);
+            ++pages_checked;
+
+            if (page_index == table.last_page_index) break;
+            page_index = page->next_page_index;
+        }
+    }
+    ASSERT_TRUE(pages_checked > 0);
+
+    ASSERT_TRUE(!pdb->page_rows(1u << 30).valid());
+}
+
+TEST(row_views_borrow_database_strings) {
+    auto db = Database::open(synthetic::pdb_path(synthetic_root()));
+    ASSERT_TRUE(db.has_value());
+    auto expected = synthetic::expected_export(test_spec());
+
+    for (const auto& e : expected.tracks) {
+        const auto* view = db->get_track_view(TrackId{e.id});
+        ASSERT_TRUE(view != nullptr);
+        ASSERT_EQ(view->title, e.title);  // Track 1, 6, ... are UTF-16 in the file
+        ASSERT_EQ(view->file_path, e.file_path);
+        ASSERT_EQ(view->isrc, e.isrc);
+        ASSERT_EQ(view->to_row().analyze_path, db->get_track(TrackId{e.id})->analyze_path);
+    }
+
+    // Views are stable: repeated lookups return the same storage
+    const auto* first = db->get_track_view(TrackId{1});
+    ASSERT_TRUE(first->title.data() == db->get_track_view(TrackId{1})->title.data());
+    ASSERT_TRUE(db->get_track_view(TrackId{999999}) == nullptr);
+
+    const auto* artist = db->get_artist_view(ArtistId{2});
+    ASSERT_TRUE(artist != nullptr);
+    ASSERT_EQ(artist->name, expected.artist_names[1]);
+    const auto* album = db->get_album_view(AlbumId{1});
+    ASSERT_TRUE(album != nullptr);
+    ASSERT_EQ(album->to_row().name, expected.album_names[0]);
+    ASSERT_TRUE(db->get_genre_view(GenreId{1}) != nullptr);
+}
+
+TEST(track_query_matches_linear_scan) {
+    auto db = Database::open(synthetic::pdb_path(synthetic_root()));
+    ASSERT_TRUE(db.has_value());
+    auto expected = synthetic::expected_export(test_spec());
+
+    auto scan = [&](auto predicate) {
+        std::vector<TrackId> ids;
+        for (const auto& e : expected.tracks) {
+            if (predicate(e)) ids.push_back(TrackId{e.id});
+        }
+        std::sort(ids.begin(), ids.end());
+        return ids;
+    };
+
+    ASSERT_TRUE(db->find_tracks_by_bpm_range(120.0f, 130.0f) ==
+                scan([](const auto& e) { return e.bpm_100x >= 12000 && e.bpm_100x <= 13000; }));
+    ASSERT_TRUE(db->find_tracks_by_year_range(2000, 2009) ==
+                scan([](const auto& e) { return e.year >= 2000 && e.year <= 2009; }));
+    ASSERT_TRUE(db->find_tracks_by_rating(3) == scan([](const auto& e) { return e.rating == 3; }));
+    ASSERT_TRUE(db->find_tracks_by_year_range(2010, 2000).empty());
+
+    TrackQuery query;
+    query.min_bpm = 100.0f;
+    query.max_bpm = 150.0f;
+    query.key = KeyId{9};
+    query.genre = GenreId{1};
+    query.min_rating = 1;
+    auto matched = db->find_tracks(query);
+    ASSERT_TRUE(!matched.empty());
+    ASSERT_TRUE(matched == scan([](const auto& e) {
+        return e.bpm_100x >= 10000 && e.bpm_100x <= 15000 && e.key_id == 9 &&
+               e.genre_id == 1 && e.rating >= 1;
+    }));
+
+    TrackQuery open_range;
+    open_range.min_year = 2015;
+    ASSERT_TRUE(db->find_tracks(open_range) == scan([](const auto& e) { return e.year >= 2015; }));
+    ASSERT_EQ(db->find_tracks(TrackQuery{}).size(), db->track_count());
+}
+
+TEST(text_search_ranks_matches) {
+    auto db = Database::open(synthetic::pdb_path(synthetic_root()));
+    ASSERT_TRUE(db.has_value());
+    auto expected = synthetic::expected_export(test_spec());
+
+    auto ids_of = [](const std::vector<TextSearchHit>& hits) {
+        std::vector<TrackId> ids;
+        for (const auto& hit : hits) ids.push_back(hit.track_id);
+        return ids;
+    };
+
+    // Titles outrank file names; tracks 21 and 26 only match through their file name
+    auto hits = db->search_tracks("track 00002");
+    ASSERT_EQ(hits.size(), 10u);
+    ASSERT_TRUE(hits.front().field == TextField::Title);
+    ASSERT_EQ(hits[8].track_id.value, 21);
+    ASSERT_EQ(hits[9].track_id.value, 26);
+    ASSERT_TRUE(hits[9].field == TextField::FileName);
+
+    std::vector<TrackId> by_artist;
+    for (const auto& e : expected.tracks) {
+        if (e.artist_id == 7) by_artist.push_back(TrackId{e.id});
+    }
+    hits = db->search_tracks("ARTIST 007");
+    ASSERT_TRUE(ids_of(hits) == by_artist);
+    ASSERT_TRUE(hits.front().field == TextField::Artist);
+
+    TextSearchOptions prefix;
+    prefix.prefix_only = true;
+    ASSERT_EQ(db->search_tracks("extended", prefix).size(), test_spec().track_count / 10);
+    ASSERT_TRUE(db->search_tracks("xtended", prefix).empty());
+    ASSERT_EQ(db->search_tracks("xtended").size(), test_spec().track_count / 10);
+    prefix.limit = 0;
+    ASSERT_EQ(db->search_tracks("tr", prefix).size(), test_spec().track_count);
+    ASSERT_EQ(db->search_tracks("tr").size(), 50u);
+
+    TextSearchOptions fuzzy;
+    fuzzy.limit = 0;
+    ASSERT_TRUE(db->search_tracks("artsit 007", fuzzy).empty());
+    fuzzy.fuzzy = true;
+    ASSERT_TRUE(ids_of(db->search_tracks("artsit 007", fuzzy)) == by_artist);
+
+    // File name lookups (PDB and ANLZ) resolve the last path component directly
+    ASSERT_TRUE(db->find_tracks_by_filename("track 000042.MP3") == std::vector<TrackId>{TrackId{42}});
+    ASSERT_TRUE(db->find_tracks_by_filename(expected.tracks[41].file_path) == std::vector<TrackId>{TrackId{42}});
+    db->load_cue_points(synthetic::anlz_dir(synthetic_root()));
+    auto grid = db->get_beat_grid_for_track(TrackId{42});
+    ASSERT_TRUE(grid != nullptr);
+    ASSERT_TRUE(db->find_beat_grid_by_filename("Track 000042.mp3") == grid.get());
+    ASSERT_TRUE(db->find_beat_grid_by_filename("Track 000042") == grid.get());
+    ASSERT_TRUE(db->find_beat_grid_by_filename("Missing.mp3") == nullptr);
+}
+
+TEST(analysis_records_keyed_by_track) {
+    auto db = Database::open(synthetic::pdb_path(synthetic_root()));
+    ASSERT_TRUE(db.has_value());
+    auto expected = synthetic::expected_export(test_spec());
+
+    // Files loaded one at a time are picked up by the next per-track lookup
+    ASSERT_TRUE(db->get_beat_grid_for_track(TrackId{5}) == nullptr);
+    auto dat = synthetic_root() / "track5.DAT";
+    ASSERT_TRUE(synthetic::write_file(dat, synthetic::build_anlz(test_spec(), expected.tracks[4], false)));
+    db->load_anlz_file(dat);
+    auto grid = db->get_beat_grid_for_track(TrackId{5});
+    ASSERT_TRUE(grid != nullptr);
+    ASSERT_EQ(db->beat_grid_track_count(), 1u);
+
+    // Loading the rest publishes a new generation; a snapshot keeps the old record
+    auto before = db->snapshot();
+    db->load_cue_points(synthetic::anlz_dir(synthetic_root()));
+    ASSERT_TRUE(before->get_beat_grid_for_track(TrackId{5}) == grid);
+    ASSERT_EQ(before->beat_grid_track_count(), 1u);
+    ASSERT_EQ(db->get_beat_grid_for_track(TrackId{5})->size(), grid->size());
+    ASSERT_EQ(db->beat_grid_track_count(), test_spec().track_count);
+    for (const auto& e : expected.tracks) {
+        TrackId id{e.id};
+        ASSERT_TRUE(db->get_beat_grid_for_track(id).get() == db->get_beat_grid(e.file_path));
+        ASSERT_TRUE(db->get_waveforms_for_track(id).get() == db->get_waveforms(e.file_path));
+        ASSERT_EQ(db->get_cue_points_for_track(id).size(), db->get_cue_points(e.file_path).size());
+    }
+    auto analysis = db->get_analysis_for_track(TrackId{5});
+    ASSERT_TRUE(analysis != nullptr);
+    ASSERT_EQ(analysis->beat_grid.size(), grid->size());
+    ASSERT_TRUE(db->get_beat_grid_for_track(TrackId{999999}) == nullptr);
+
+    // Eager results alias the loaded record (no copy) and pin its generation
+    ASSERT_TRUE(&analysis->beat_grid == db->get_beat_grid_for_track(TrackId{5}).get());
+    const auto* eager_grid = &analysis->beat_grid;
+    db->enable_lazy_anlz_loading(1);
+    ASSERT_TRUE(db->get_analysis_for_track(TrackId{5}).get() != analysis.get());
+    ASSERT_TRUE(&analysis->beat_grid == eager_grid && analysis->beat_grid.size() == grid->size());
+}
+
+TEST(posting_views_match_copying_accessors) {
+    auto db = Database::open(synthetic::pdb_path(synthetic_root()));
+    ASSERT_TRUE(db.has_value());
+
+    auto artist = db->find_tracks_by_artist_view(ArtistId{3});
+    ASSERT_TRUE(artist.to_vector() == db->find_tracks_by_artist(ArtistId{3}));
+    ASSERT_TRUE(artist.data() == db->find_tracks_by_artist_view(ArtistId{3}).data());
+    ASSERT_TRUE(db->find_tracks_by_album_view(AlbumId{2}).to_vector() == db->find_tracks_by_album(AlbumId{2}));
+    ASSERT_TRUE(db->find_tracks_by_genre_view(GenreId{4}).to_vector() == db->find_tracks_by_genre(GenreId{4}));
+    ASSERT_TRUE(db->find_tracks_by_title_view("TRACK 000002").to_vector() == std::vector<TrackId>{TrackId{2}});
+    ASSERT_TRUE(db->find_tracks_by_filename_view("track 000002.mp3").to_vector() == std::vector<TrackId>{TrackId{2}});
+    ASSERT_TRUE(db->find_tracks_by_artist_view(ArtistId{999}).empty());
+
+    for (auto id : db->all_playlist_ids()) {
+        ASSERT_TRUE(db->get_playlist_view(id).to_vector() == *db->get_playlist(id));
+    }
+    ASSERT_TRUE(db->get_playlist_view(PlaylistId{999}).empty());
+
+    std::vector<TrackId> visited;
+    db->for_each_track([&](const TrackRowView& track) { visited.push_back(track.id); });
+    ASSERT_TRUE(visited == db->all_track_ids());
+    ASSERT_EQ(db->track_view_at(1).id.value, visited[1].value);
+
+    db->load_cue_points(synthetic::anlz_dir(synthetic_root()));
+    auto cues = db->get_cue_points_view(TrackId{7});
+    ASSERT_EQ(cues.size(), 3u);
+    ASSERT_EQ(cues[1].comment, db->get_cue_points_for_track(TrackId{7})[1].comment);
+    ASSERT_TRUE(db->get_cue_points_view(TrackId{999999}).empty());
+
+    auto ext = Database::open_ext(synthetic::ext_pdb_path(synthetic_root()));
+    ASSERT_TRUE(ext.has_value());
+    ASSERT_TRUE(ext->find_tracks_by_tag_view(TagId{105}).to_vector() == ext->find_tracks_by_tag(TagId{105}));
+    ASSERT_TRUE(ext->find_tags_by_track_view(TrackId{4}).to_vector() == ext->find_tags_by_track(TrackId{4}));
+}
+
+TEST(playlist_tree_flattens_folders) {
+    auto db = Database::open(synthetic::pdb_path(synthetic_root()));
+    ASSERT_TRUE(db.has_value());
+    auto expected = synthetic::expected_export(test_spec());
+    const auto& tree = db->playlist_tree();
+    size_t playlists = test_spec().playlist_count;
+
+    // Top level: the playlists in sort order, then the folder and its two children
+    ASSERT_EQ(tree.size(), playlists + 3);
+    ASSERT_EQ(tree.root_count, playlists + 1);
+    uint32_t folder = tree.find(PlaylistId{static_cast<int64_t>(playlists + 1)});
+    ASSERT_EQ(folder, playlists);
+    ASSERT_TRUE(tree.is_folder[folder] && tree.name[folder] == "Folder");
+    ASSERT_EQ(tree.child_count[folder], 2u);
+    uint32_t child = tree.first_child[folder];
+    ASSERT_TRUE(tree.name[child] == "Nested" && tree.name[child + 1] == "Subfolder");
+    ASSERT_TRUE(tree.parent[child] == folder && tree.depth[child + 1] == 1);
+    ASSERT_TRUE(tree.child_count[child + 1] == 0 && tree.parent[0] == PlaylistTree::kNoParent);
+    ASSERT_EQ(tree.find(PlaylistId{999}), PlaylistTree::kNoParent);
+
+    // Materialize in two pages and compare with per-entry lookups
+    for (size_t p = 0; p < playlists; ++p) {
+        PlaylistId id{static_cast<int64_t>(p + 1)};
+        uint32_t node = tree.find(id);
+        ASSERT_EQ(tree.track_count[node], expected.playlists[p].size());
+
+        size_t total = expected.playlists[p].size();
+        std::vector<int64_t> ids(total);
+        std::vector<uint32_t> bpm(total);
+        std::vector<std::string_view> titles(total), artists(total), keys(total);
+        size_t half = total / 2;
+        PlaylistRowBuffers out;
+        out.capacity = half;
+        out.track_id = ids.data();
+        out.bpm_100x = bpm.data();
+        out.title = titles.data();
+        out.artist = artists.data();
+        out.key = keys.data();
+        ASSERT_EQ(db->materialize_playlist(id, out, 0), half);
+        out.capacity = total;  // More room than entries left
+        out.track_id += half;
+        out.bpm_100x += half;
+        out.title += half;
+        out.artist += half;
+        out.key += half;
+        ASSERT_EQ(db->materialize_playlist(id, out, half), total - half);
+
+        for (size_t i = 0; i < total; ++i) {
+            const auto* track = db->get_track_view(TrackId{expected.playlists[p][i]});
+            ASSERT_TRUE(track != nullptr && ids[i] == track->id.value && bpm[i] == track->bpm_100x);
+            ASSERT_TRUE(titles[i] == track->title);
+            ASSERT_TRUE(artists[i] == db->get_artist_view(track->artist_id)->name);
+            ASSERT_TRUE(keys[i] == db->get_key_view(track->key_id)->name);
+        }
+    }
+    PlaylistRowBuffers none;
+    none.capacity = 8;
+    ASSERT_EQ(db->materialize_playlist(PlaylistId{999}, none), 0u);
+    ASSERT_EQ(db->materialize_playlist(PlaylistId{1}, none, expected.playlists[0].size()), 0u);
+}
+
+TEST(tag_query_matches_set_algebra) {
+    // Sparse, dense (bitmap container) and high-key IDs against std::set
+    std::vector<TrackId> a_ids, b_ids;
+    for (int64_t i = 1; i < 9000; ++i) a_ids.push_back(TrackId{i});
+    for (int64_t i = 0; i < 300000; i += 37) a_ids.push_back(TrackId{i});
+    for (int64_t i = 5000; i < 12000; i += 2) b_ids.push_back(TrackId{i});
+    for (int64_t i = 0; i < 300000; i += 91) b_ids.push_back(TrackId{i});
+    std::reverse(b_ids.begin(), b_ids.end());
+    auto a = TrackBitmap::from_ids(a_ids);
+    auto b = TrackBitmap::from_ids(b_ids);
+    std::set<int64_t> sa, sb;
+    for (TrackId id : a_ids) sa.insert(id.value);
+    for (TrackId id : b_ids) sb.insert(id.value);
+    ASSERT_EQ(a.cardinality(), sa.size());
+    ASSERT_TRUE(a.contains(TrackId{8999}) && a.contains(TrackId{37 * 8000}) && !a.contains(TrackId{9001}));
+
+    auto check = [](const TrackBitmap& bitmap, const std::vector<int64_t>& expected) {
+        std::vector<TrackId> ids;
+        for (int64_t id : expected) ids.push_back(TrackId{id});
+        return bitmap.to_vector() == ids && bitmap == TrackBitmap::from_ids(ids);
+    };
+    std::vector<int64_t> both, either, only_a;
+    std::set_intersection(sa.begin(), sa.end(), sb.begin(), sb.end(), std::back_inserter(both));
+    std::set_union(sa.begin(), sa.end(), sb.begin(), sb.end(), std::back_inserter(either));
+    std::set_difference(sa.begin(), sa.end(), sb.begin(), sb.end(), std::back_inserter(only_a));
+    ASSERT_TRUE(check(a & b, both));
+    ASSERT_TRUE(check(a | b, either));
+    ASSERT_TRUE(check(a - b, only_a));
+    ASSERT_TRUE((a - a).empty() && (a | TrackBitmap{}) == a);
+
+    // Queries over the synthetic tags: tag t + 1 is "Tag t + 1", ID 101 + t, in category t % 3 + 1
+    auto db = Database::open(synthetic::pdb_path(synthetic_root()));
+    auto ext = Database::open_ext(synthetic::ext_pdb_path(synthetic_root()));
+    ASSERT_TRUE(db.has_value() && ext.has_value());
+    auto expected = synthetic::expected_export(test_spec());
+    auto has = [&](size_t tag, int64_t track) {
+        const auto& tracks = expected.tag_tracks[tag - 1];
+        return std::find(tracks.begin(), tracks.end(), track) != tracks.end();
+    };
+    std::vector<int64_t> matching;
+    for (const auto& track : expected.tracks) {
+        bool category3 = has(3, track.id) || has(6, track.id) || has(9, track.id) || has(12, track.id);
+        bool any = has(1, track.id) || has(2, track.id) || has(3, track.id);
+        if (any && !category3 && !has(11, track.id)) matching.push_back(track.id);
+    }
+    ASSERT_TRUE(!matching.empty());
+
+    auto built = (TagQuery::tag(TagId{101}) | TagQuery::tag(TagId{102}) | TagQuery::tag(TagId{103}))
+               & !TagQuery::category(TagId{3}) & !TagQuery::tag(TagId{111});
+    ASSERT_TRUE(check(ext->find_tracks_by_tags(built, &*db), matching));
+    auto parsed = TagQuery::parse("(Tag 1 OR tag 2 | Tag 3) AND NOT Category 3 & !\"Tag 11\"", *ext);
+    ASSERT_TRUE(parsed.has_value());
+    ASSERT_TRUE(check(ext->find_tracks_by_tags(*parsed, &*db), matching));
+    auto rows = db->track_views(ext->find_tracks_by_tags(*parsed));
+    ASSERT_EQ(rows.size(), matching.size());
+    ASSERT_TRUE(rows.front()->id.value == matching.front() && rows.back()->id.value == matching.back());
+
+    // NOT and the match-all query are relative to the track database
+    auto not_tag1 = ext->find_tracks_by_tags(!TagQuery::tag(TagId{101}), &*db);
+    ASSERT_EQ(not_tag1.cardinality(), expected.tracks.size() - expected.tag_tracks[0].size());
+    ASSERT_EQ(ext->find_tracks_by_tags(TagQuery{}, &*db).cardinality(), expected.tracks.size());
+    auto complement = TagQuery::parse("NOT (Tag 1 OR Tag 3) OR Tag 6", *ext);
+    ASSERT_TRUE(complement.has_value());
+    ASSERT_EQ(ext->find_tracks_by_tags(*complement, &*db).cardinality(),
+              expected.tracks.size() - expected.tag_tracks[0].size());
+    ASSERT_TRUE(ext->find_tracks_by_tags(TagQuery::tag(TagId{999})).empty());
+
+    for (const char* bad : {"Tag 1 AND", "(Tag 1", "Unknown Tag", "Tag 1 OR \"Tag 2", ")"}) {
+        auto result = TagQuery::parse(bad, *ext);
+        ASSERT_TRUE(!result.has_value() && result.error().code == ErrorCode::InvalidParameter);
+    }
+}
+
+TEST(tag_query_rejects_deep_nesting) {
+    auto ext = Database::open_ext(synthetic::ext_pdb_path(synthetic_root()));
+    ASSERT_TRUE(ext.has_value());
+
+    auto nested = [](size_t depth) { return std::string(depth, '(') + "Tag 1" + std::string(depth, ')'); };
+    ASSERT_TRUE(TagQuery::parse(nested(200), *ext).has_value());
+    ASSERT_TRUE(TagQuery::parse(std::string(200, '!') + "Tag 1", *ext).has_value());
+
+    // Far past the limit: an error, not a stack overflow
+    for (const auto& text : {nested(257), std::string(200000, '('), std::string(200000, '!') + "Tag 1"}) {
+        auto result = TagQuery::parse(text, *ext);
+        ASSERT_TRUE(!result.has_value() && result.error().code == ErrorCode::InvalidParameter);
+    }
+}
+
+TEST(index_snapshot_round_trip) {
+    auto dir = std::filesystem::temp_directory_path() / "crate_digger_test_snapshot";
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+    auto pdb = dir / "export.pdb";
+    std::filesystem::copy_file(synthetic::pdb_path(synthetic_root()), pdb);
+    auto anlz = synthetic::anlz_dir(synthetic_root());
+
+    DatabaseOptions options;
+    options.snapshot_dir = dir / "snapshots";
+    auto snapshot_times = [&] {
+        std::vector<std::filesystem::file_time_type> times;
+        for (const auto& entry : std::filesystem::directory_iterator(options.snapshot_dir)) {
+            times.push_back(entry.last_write_time());
+        }
+        std::sort(times.begin(), times.end());
+        return times;
+    };
+    auto same_contents = [](const Database& a, const Database& b) {
+        if (a.all_track_ids() != b.all_track_ids()) return false;
+        for (auto id : a.all_track_ids()) {
+            const auto* x = a.get_track_view(id);
+            const auto* y = b.get_track_view(id);
+            if (x->title != y->title || x->file_path != y->file_path || x->filename != y->filename ||
+                x->analyze_path != y->analyze_path || x->bpm_100x != y->bpm_100x || x->key_id != y->key_id) {
+                return false;
+            }
+        }
+        TrackQuery query;
+        query.min_bpm = 120.0f;
+        query.genre = GenreId{1};
+        return a.find_tracks(query) == b.find_tracks(query) &&
+               a.find_tracks_by_title("Track 000002") == b.find_tracks_by_title("Track 000002") &&
+               a.find_tracks_by_artist(ArtistId{3}) == b.find_tracks_by_artist(ArtistId{3}) &&
+               a.search_tracks("album 004") == b.search_tracks("album 004") &&
+               a.get_artist(ArtistId{3})->name == b.get_artist(ArtistId{3})->name &&
+               a.all_playlist_ids() == b.all_playlist_ids() &&
+               a.track_columns().bpm_100x == b.track_columns().bpm_100x;
+    };
+
+    {
+        auto cold = Database::open(pdb, options);
+        ASSERT_TRUE(cold.has_value());
+        auto saved = snapshot_times();
+        ASSERT_EQ(saved.size(), 1u);
+
+        // Warm open reuses the snapshot instead of rewriting it
+        auto warm = Database::open(pdb, options);
+        ASSERT_TRUE(warm.has_value());
+        ASSERT_TRUE(snapshot_times() == saved);
+        ASSERT_TRUE(same_contents(*cold, *warm));
+
+        cold->load_cue_points(anlz);
+        ASSERT_EQ(snapshot_times().size(), 2u);
+        warm->load_cue_points(anlz);
+        ASSERT_EQ(snapshot_times().size(), 2u);
+        ASSERT_EQ(warm->cue_point_track_count(), cold->cue_point_track_count());
+        ASSERT_EQ(warm->waveform_track_count(), cold->waveform_track_count());
+        for (auto id : cold->all_track_ids()) {
+            auto grid = cold->get_beat_grid_for_track(id);
+            auto restored = warm->get_beat_grid_for_track(id);
+            ASSERT_EQ(grid == nullptr, restored == nullptr);
+            if (grid) ASSERT_EQ(grid->size(), restored->size());
+        }
+        ASSERT_EQ(warm->get_cue_points_for_track(TrackId{7})[1].comment,
+                  cold->get_cue_points_for_track(TrackId{7})[1].comment);
+    }
+
+    // A touched source invalidates the snapshot; a damaged snapshot falls back to parsing
+    auto reference = Database::open(pdb);
+    ASSERT_TRUE(reference.has_value());
+    auto before = snapshot_times();
+    std::filesystem::last_write_time(pdb, std::filesystem::last_write_time(pdb) + std::chrono::hours(1));
+    {
+        auto reparsed = Database::open(pdb, options);
+        ASSERT_TRUE(reparsed.has_value());
+        ASSERT_TRUE(snapshot_times() != before);
+        ASSERT_TRUE(same_contents(*reference, *reparsed));
+    }
+    for (const auto& entry : std::filesystem::directory_iterator(options.snapshot_dir)) {
+        std::filesystem::resize_file(entry.path(), entry.file_size() / 2);
+    }
+    auto recovered = Database::open(pdb, options);
+    ASSERT_TRUE(recovered.has_value());
+    ASSERT_TRUE(same_contents(*reference, *recovered));
+    recovered->load_cue_points(anlz);
+    reference->load_cue_points(anlz);
+    ASSERT_EQ(recovered->cue_point_track_count(), reference->cue_point_track_count());
+    ASSERT_EQ(recovered->beat_grid_track_count(), reference->beat_grid_track_count());
+}
+
+TEST(incremental_refresh_matches_reopen) {
+    auto root = std::filesystem::temp_directory_path() / "crate_digger_test_refresh";
+    std::filesystem::remove_all(root);
+    ASSERT_TRUE(synthetic::write_export(root, test_spec()));
+    auto pdb = synthetic::pdb_path(root);
+    auto anlz = synthetic::anlz_dir(root);
+    auto expected = synthetic::expected_export(test_spec());
+
+    auto db = Database::open(pdb);
+    ASSERT_TRUE(db.has_value());
+    db->load_cue_points(anlz);
+
+    auto unchanged = db->refresh();
+    ASSERT_TRUE(unchanged.has_value());
+    ASSERT_TRUE(!unchanged->changed());
+    ASSERT_EQ(db->generation(), 1u);  // Published by load_cue_points
+
+    // Edit one track's rating in place (no page size changes), as rekordbox does
+    auto image = synthetic::build_pdb(test_spec());
+    size_t rows_on_page = 0;
+    {
+        auto parsed = RekordboxPdb::open(pdb);
+        ASSERT_TRUE(parsed.has_value());
+        for (const auto& table : parsed->tables()) {
+            if (table.type != PageType::Tracks) continue;
+            for (uint32_t page = table.first_page_index;; ) {
+                auto cursor = parsed->page_rows(page);
+                size_t row_base = 0;
+                size_t rows = 0;
+                bool patched = false;
+                while (cursor.next(row_base)) {
+                    RawTrackRow raw;
+                    std::memcpy(&raw, image.data() + row_base, sizeof(raw));
+                    ++rows;
+                    if (raw.id != 7) continue;
+                    image[row_base + offsetof(RawTrackRow, rating)] = 5;
+                    patched = true;
+                }
+                if (patched) rows_on_page = rows;
+                if (page == table.last_page_index) break;
+                page = cursor.next_page_index();
+            }
+        }
+    }
+    ASSERT_TRUE(synthetic::write_file(pdb, image));
+    std::filesystem::last_write_time(pdb, std::filesystem::last_write_time(pdb) + std::chrono::hours(1));
+
+    // Rewrite one track's beat grid and drop another track's .EXT file
+    auto shorter = test_spec();
+    shorter.beats_per_track = 16;
+    const auto& rewritten = expected.tracks[2];
+    auto dat = root / std::filesystem::path(rewritten.analyze_path).relative_path();
+    ASSERT_TRUE(synthetic::write_file(dat, synthetic::build_anlz(shorter, rewritten, false)));
+    std::filesystem::last_write_time(dat, std::filesystem::last_write_time(dat) + std::chrono::hours(1));
+    auto ext = root / std::filesystem::path(expected.tracks[4].analyze_path).relative_path();
+    ext.replace_extension(".EXT");
+    ASSERT_TRUE(std::filesystem::remove(ext));
+
+    auto stats = db->refresh();
+    ASSERT_TRUE(stats.has_value());
+    ASSERT_TRUE(stats->pdb_changed);
+    ASSERT_EQ(stats->pages_changed, 1u);
+    ASSERT_EQ(stats->tracks_reparsed, rows_on_page);
+    ASSERT_EQ(stats->tracks_reused + stats->tracks_reparsed, expected.tracks.size());
+    ASSERT_EQ(stats->tables_reindexed, 0u);
+    ASSERT_EQ(stats->anlz_files_changed, 2u);
+    ASSERT_EQ(stats->anlz_tracks_reloaded, 2u);
+    ASSERT_EQ(db->generation(), 2u);
+
+    auto reopened = Database::open(pdb);
+    ASSERT_TRUE(reopened.has_value());
+    reopened->load_cue_points(anlz);
+    ASSERT_EQ(db->get_track(TrackId{7})->rating, 5);
+    ASSERT_TRUE(db->all_track_ids() == reopened->all_track_ids());
+    for (auto id : reopened->all_track_ids()) {
+        const auto* a = db->get_track_view(id);
+        const auto* b = reopened->get_track_view(id);
+        ASSERT_TRUE(a->title == b->title && a->file_path == b->file_path && a->isrc == b->isrc);
+        ASSERT_EQ(a->rating, b->rating);
+        ASSERT_EQ(db->get_cue_points_for_track(id).size(), reopened->get_cue_points_for_track(id).size());
+        auto grid = db->get_beat_grid_for_track(id);
+        auto fresh = reopened->get_beat_grid_for_track(id);
+        ASSERT_EQ(grid == nullptr, fresh == nullptr);
+        if (grid) ASSERT_EQ(grid->size(), fresh->size());
+    }
+    ASSERT_EQ(db->get_beat_grid_for_track(TrackId{rewritten.id})->size(), 16u);
+    ASSERT_TRUE(db->find_tracks_by_rating(5) == reopened->find_tracks_by_rating(5));
+    ASSERT_TRUE(db->search_tracks("track") == reopened->search_tracks("track"));
+    ASSERT_EQ(db->get_artist(ArtistId{3})->name, reopened->get_artist(ArtistId{3})->name);
+    ASSERT_EQ(db->cue_point_track_count(), reopened->cue_point_track_count());
+    ASSERT_EQ(db->beat_grid_track_count(), reopened->beat_grid_track_count());
+
+    auto again = db->refresh();
+    ASSERT_TRUE(again.has_value());
+    ASSERT_TRUE(!again->changed());
+    ASSERT_EQ(db->generation(), 2u);
+}
+
+TEST(snapshots_isolate_concurrent_readers) {
+    auto root = std::filesystem::temp_directory_path() / "crate_digger_test_snapshots";
+    std::filesystem::remove_all(root);
+    ASSERT_TRUE(synthetic::write_export(root, test_spec()));
+    auto pdb = synthetic::pdb_path(root);
+    auto expected = synthetic::expected_export(test_spec());
+
+    auto db = Database::open(pdb);
+    ASSERT_TRUE(db.has_value());
+    auto before = db->snapshot();
+
+    // Readers pin a generation per query while the writer publishes new ones
+    std::atomic<bool> stop{false};
+    std::atomic<bool> consistent{true};
+    std::atomic<size_t> queries{0};
+    std::vector<std::thread> readers;
+    for (int t = 0; t < 4; ++t) {
+        readers.emplace_back([&, t] {
+            size_t i = static_cast<size_t>(t);
+            while (!stop.load()) {
+                auto snap = db->snapshot();
+                const auto& e = expected.tracks[i++ % expected.tracks.size()];
+                const auto* track = snap->get_track_view(TrackId{e.id});
+                bool ok = track != nullptr && track->title == e.title &&
+                          snap->track_count() == expected.tracks.size() &&
+                          !snap->find_tracks_by_title_view(e.title).empty();
+                // Within one snapshot the ANLZ counts and records always agree
+                bool loaded = snap->beat_grid_track_count() != 0;
+                ok = ok && loaded == (snap->get_beat_grid_for_track(TrackId{e.id}) != nullptr);
+                if (!ok) consistent.store(false);
+                queries.fetch_add(1);
+            }
+        });
+    }
+
+    db->load_cue_points(synthetic::anlz_dir(root));
+    std::filesystem::last_write_time(pdb, std::filesystem::last_write_time(pdb) + std::chrono::hours(1));
+    auto stats = db->refresh();
+    while (queries.load() < 1000) std::this_thread::yield();
+    stop.store(true);
+    for (auto& reader : readers) reader.join();
+
+    ASSERT_TRUE(consistent.load());
+    ASSERT_TRUE(stats.has_value() && stats->pdb_changed);
+    ASSERT_EQ(db->generation(), 2u);
+    ASSERT_EQ(db->beat_grid_track_count(), expected.tracks.size());
+    ASSERT_EQ(before->generation(), 0u);
+    ASSERT_EQ(before->beat_grid_track_count(), 0u);
+    ASSERT_TRUE(before->get_track_view(TrackId{1})->title == expected.tracks[0].title);
+}
+
+TEST(async_open_reports_progress_and_cancels) {
+    auto pdb = synthetic::pdb_path(synthetic_root());
+    auto anlz_dir = synthetic::anlz_dir(synthetic_root());
+    size_t anlz_files = 0;
+    for (const auto& entry : std::filesystem::recursive_directory_iterator(anlz_dir)) {
+        if (entry.is_regular_file()) ++anlz_files;
+    }
+
+    AsyncOpenOptions options;
+    options.database.thread_count = 2;
+    options.database.parallel_indexing = true;
+    options.anlz_dir = anlz_dir;
+    std::vector<OpenProgress> reports;  // on_progress calls never overlap
+    options.on_progress = [&reports](const OpenProgress& p) { reports.push_back(p); };
+    auto task = open_async(pdb, options);
+
+    auto metadata = task.wait_metadata();
+    ASSERT_TRUE(metadata != nullptr);
+    ASSERT_EQ(metadata->track_count(), test_spec().track_count);
+    auto db = task.get();
+    ASSERT_TRUE(db.has_value());
+    ASSERT_TRUE(task.ready() && !task.get().has_value());
+    ASSERT_EQ(metadata->beat_grid_track_count(), 0u);  // Pinned before the scan was published
+    ASSERT_EQ(db->beat_grid_track_count(), test_spec().track_count);
+
+    auto final_progress = task.progress();
+    ASSERT_TRUE(final_progress.phase == OpenPhase::Done && reports.back().phase == OpenPhase::Done);
+    ASSERT_TRUE(final_progress.tables_total > 0 && final_progress.tables_done == final_progress.tables_total);
+    ASSERT_EQ(final_progress.anlz_files_total, anlz_files);
+    ASSERT_EQ(final_progress.anlz_files_done, anlz_files);
+    for (size_t i = 1; i < reports.size(); ++i) {
+        ASSERT_TRUE(reports[i].tables_done >= reports[i - 1].tables_done);
+        ASSERT_TRUE(reports[i].anlz_files_done >= reports[i - 1].anlz_files_done);
+    }
+
+    // Cancel from the UI thread while the scan is blocked on its first file
+    std::atomic<bool> scanning{false};
+    std::atomic<bool> cancelled{false};
+    options.on_progress = [&](const OpenProgress& p) {
+        if (p.anlz_files_done == 1 && !scanning.exchange(true)) {
+            while (!cancelled.load()) std::this_thread::yield();
+        }
+    };
+    options.database.parallel_indexing = false;
+    options.database.thread_count = 1;
+    auto stopped = open_async(pdb, options);
+    while (!scanning.load()) std::this_thread::yield();
+    stopped.cancel();
+    cancelled.store(true);
+    auto result = stopped.get();
+    ASSERT_TRUE(!result.has_value() && result.error().code == ErrorCode::Cancelled);
+    ASSERT_TRUE(stopped.progress().phase == OpenPhase::Failed);
+    ASSERT_TRUE(stopped.progress().anlz_files_done < anlz_files);
+
+    // Dropping the handle from on_progress cancels without the loader joining itself
+    std::optional<OpenTask> dropped;
+    std::atomic<bool> held{false};
+    std::atomic<bool> finished{false};
+    options.on_progress = [&](const OpenProgress& p) {
+        while (!held.load()) std::this_thread::yield();
+        if (p.anlz_files_done >= 1) dropped.reset();
+        if (p.finished()) finished.store(true);
+    };
+    dropped.emplace(open_async(pdb, options));
+    held.store(true);
+    while (!finished.load()) std::this_thread::yield();
+    ASSERT_TRUE(!dropped.has_value());
+}
+
+TEST(artwork_cache_prefetches_and_evicts) {
+    auto db = Database::open(synthetic::pdb_path(synthetic_root()));
+    ASSERT_TRUE(db.has_value());
+    std::atomic<size_t> loaded{0};
+    ArtworkCacheOptions options;
+    options.on_loaded = [&loaded](ArtworkId, ArtworkVariant) { loaded.fetch_add(1); };
+    ArtworkCache covers(*db, options);
+
+    auto dir = synthetic_root() / "PIONEER" / "Artwork" / "00001";
+    ASSERT_TRUE(covers.path(ArtworkId{3}) == dir / "b3.jpg");
+    ASSERT_TRUE(covers.path(ArtworkId{3}, ArtworkVariant::HighRes) == dir / "b3_m.jpg");
+    ASSERT_TRUE(covers.path(ArtworkId{999}).empty() && !covers.get(ArtworkId{999}));
+
+    // Read-through get(), then peek() serves the same bytes; HighRes falls back without an _m file
+    ASSERT_TRUE(!covers.peek(ArtworkId{1}));
+    auto first = covers.get(ArtworkId{1});
+    ASSERT_TRUE(first && *first == synthetic::artwork_bytes(1, false));
+    ASSERT_TRUE(covers.peek(ArtworkId{1}) == first);
+    ASSERT_TRUE(*covers.get(ArtworkId{3}, ArtworkVariant::HighRes) == synthetic::artwork_bytes(3, true));
+    ASSERT_TRUE(*covers.get(ArtworkId{2}, ArtworkVariant::HighRes) == synthetic::artwork_bytes(2, false));
+
+    // Prefetch a playlist's covers in the background
+    auto playlist = db->get_playlist_view(PlaylistId{1});
+    covers.prefetch_tracks(playlist);
+    covers.wait_idle();
+    std::set<int64_t> artwork;
+    for (TrackId id : playlist) {
+        int64_t art = db->get_track_view(id)->artwork_id.value;
+        artwork.insert(art);
+        auto bytes = covers.peek(ArtworkId{art});
+        ASSERT_TRUE(bytes && *bytes == synthetic::artwork_bytes(art, false));
+    }
+    artwork.erase(1);  // Cached before the prefetch
+    ASSERT_EQ(loaded.load(), artwork.size());
+    auto stats = covers.stats();
+    ASSERT_TRUE(stats.pending == 0 && stats.files_missing == 1 && stats.hits >= playlist.size());
+    ASSERT_EQ(stats.files_read, artwork.size() + 3);
+    covers.clear();
+    ASSERT_TRUE(covers.stats().cached_items == 0 && !covers.peek(ArtworkId{1}));
+
+    // A small cache keeps the most recent files within its byte limit
+    ArtworkCacheOptions small;
+    small.capacity_bytes = 1000;
+    small.thread_count = 1;
+    ArtworkCache bounded(*db, small);
+    std::vector<ArtworkId> ids;
+    for (int64_t b = 1; b <= static_cast<int64_t>(test_spec().album_count); ++b) ids.push_back(ArtworkId{b});
+    bounded.prefetch(ids);
+    bounded.wait_idle();
+    auto bounded_stats = bounded.stats();
+    ASSERT_TRUE(bounded_stats.cached_bytes <= small.capacity_bytes && bounded_stats.evictions > 0);
+    ASSERT_EQ(bounded_stats.cached_items + bounded_stats.evictions, ids.size());
+    ASSERT_TRUE(bounded.peek(ids.back()) && !bounded.peek(ids.front()));
+}
+
+TEST(corrupt_rows_decode_safely) {
+    auto root = std::filesystem::temp_directory_path() / "crate_digger_test_corrupt";
+    std::filesystem::remove_all(root);
+    ASSERT_TRUE(synthetic::write_export(root, test_spec()));
+    auto pdb = synthetic::pdb_path(root);
+    auto expected = synthetic::expected_export(test_spec());
+
+    // Color rows carry an unaligned u16 ID at offset 5
+    {
+        auto db = Database::open(pdb);
+        ASSERT_TRUE(db.has_value());
+        ASSERT_EQ(db->get_color_view(ColorId{1})->name, "Pink");
+        ASSERT_EQ(db->get_color_view(ColorId{8})->name, "Purple");
+        ASSERT_TRUE(db->find_colors_by_name("aqua") == std::vector<ColorId>{ColorId{6}});
+    }
+
+    auto image = synthetic::build_pdb(test_spec());
+    auto track_rows = table_row_offsets(pdb, PageType::Tracks);
+    auto artist_rows = table_row_offsets(pdb, PageType::Artists);
+    ASSERT_EQ(track_rows.size(), expected.tracks.size());
+
+    // Wild string offsets and a far-variant subtype on a near row
+    auto patched = image;
+    for (size_t i = 0; i < 21; ++i) {
+        patched[track_rows[0] + offsetof(RawTrackRow, ofs_strings) + 2 * i] = 0xFF;
+        patched[track_rows[0] + offsetof(RawTrackRow, ofs_strings) + 2 * i + 1] = 0xFF;
+    }
+    patched[artist_rows[1]] |= 0x04;
+    ASSERT_TRUE(synthetic::write_file(pdb, patched));
+    {
+        auto db = Database::open(pdb);
+        ASSERT_TRUE(db.has_value());
+        ASSERT_EQ(db->track_count(), expected.tracks.size());
+        ASSERT_TRUE(db->get_track_view(TrackId{expected.tracks[0].id}) != nullptr);
+        ASSERT_TRUE(db->get_artist_view(ArtistId{2}) != nullptr);
+    }
+
+    // Random bytes inside rows never take the open down
+    uint32_t state = 12345;
+    auto next = [&state] { state = state * 1664525u + 1013904223u; return state >> 8; };
+    for (int round = 0; round < 24; ++round) {
+        auto mutated = image;
+        for (int k = 0; k < 64; ++k) {
+            const auto& rows = k % 4 == 0 ? artist_rows : track_rows;
+            size_t at = rows[next() % rows.size()] + next() % 160;
+            if (at < mutated.size()) mutated[at] = static_cast<uint8_t>(next());
+        }
+        ASSERT_TRUE(synthetic::write_file(pdb, mutated));
+        auto db = Database::open(pdb);
+        ASSERT_TRUE(db.has_value());
+        ASSERT_TRUE(db->track_count() <= expected.tracks.size());
+        size_t text_bytes = 0;
+        db->for_each_track([&text_bytes](const TrackRowView& track) {
+            text_bytes += track.title.size() + track.file_path.size() + track.comment.size();
+        });
+        ASSERT_TRUE(text_bytes > 0);
+    }
+}
+
+TEST(corrupt_list_positions_are_compacted) {
+    auto root = std::filesystem::temp_directory_path() / "crate_digger_test_positions";
+    std::filesystem::remove_all(root);
+    ASSERT_TRUE(synthetic::write_export(root, test_spec()));
+    auto pdb = synthetic::pdb_path(root);
+    auto expected = synthetic::expected_export(test_spec());
+    const auto& first = expected.playlists[0];
+    const auto& second = expected.playlists[1];
+
+    // Playlist 1's first two entries and its tree row get positions that would wrap or allocate gigabytes
+    auto image = synthetic::build_pdb(test_spec());
+    auto entry_rows = table_row_offsets(pdb, PageType::PlaylistEntries);
+    auto tree_rows = table_row_offsets(pdb, PageType::PlaylistTree);
+    auto history_rows = table_row_offsets(pdb, PageType::HistoryEntries);
+    ASSERT_TRUE(first.size() >= 3 && second.size() >= 2);
+    ASSERT_TRUE(entry_rows.size() >= first.size() + second.size());
+    ASSERT_EQ(tree_rows.size(), test_spec().playlist_count + 3);
+    ASSERT_EQ(history_rows.size(), 10u);
+    patch_u32(image, entry_rows[0] + offsetof(RawPlaylistEntryRow, entry_index), 0xFFFFFFFFu);
+    patch_u32(image, entry_rows[1] + offsetof(RawPlaylistEntryRow, entry_index), 0x40000000u);
+    patch_u32(image, tree_rows[0] + offsetof(RawPlaylistTreeRow, sort_order), 0xFFFFFFFFu);
+    patch_u32(image, history_rows[0] + offsetof(RawHistoryEntryRow, entry_index), 0xFFFFFFFFu);
+
+    // Sparse but plausible positions: a gap before playlist 2's last entry, the folder's first child moved to 9
+    size_t last = first.size() + second.size() - 1;
+    patch_u32(image, entry_rows[last] + offsetof(RawPlaylistEntryRow, entry_index),
+              static_cast<uint32_t>(second.size() + 2));
+    patch_u32(image, tree_rows[test_spec().playlist_count + 1] + offsetof(RawPlaylistTreeRow, sort_order), 9);
+    ASSERT_TRUE(synthetic::write_file(pdb, image));
+
+    auto db = Database::open(pdb);
+    ASSERT_TRUE(db.has_value());
+    ASSERT_EQ(db->playlist_count(), expected.playlists.size());
+
+    // Corrupt lists keep every row in position order, the corrupt ones last
+    auto view = db->get_playlist_view(PlaylistId{1});
+    ASSERT_EQ(view.size(), first.size());
+    for (size_t i = 2; i < first.size(); ++i) ASSERT_EQ(view[i - 2].value, first[i]);
+    ASSERT_EQ(view[first.size() - 2].value, first[1]);
+    ASSERT_EQ(view[first.size() - 1].value, first[0]);
+
+    auto history = db->get_history_playlist(PlaylistId{1});
+    ASSERT_TRUE(history.has_value() && history->size() == 10);
+    ASSERT_EQ(history->front().value, expected.tracks[1].id);
+    ASSERT_EQ(history->back().value, expected.tracks[0].id);
+
+    auto roots = db->get_playlist_folder(PlaylistId{0});
+    ASSERT_TRUE(roots.has_value());
+    ASSERT_EQ(roots->size(), test_spec().playlist_count + 1);
+    ASSERT_EQ(roots->front().id.value, 2);
+    ASSERT_EQ(roots->back().id.value, 1);
+
+    // Sparse lists keep their exact positions, gaps included
+    view = db->get_playlist_view(PlaylistId{2});
+    ASSERT_EQ(view.size(), second.size() + 3);
+    for (size_t i = 0; i + 1 < second.size(); ++i) ASSERT_EQ(view[i].value, second[i]);
+    ASSERT_EQ(view[second.size() - 1].value, 0);
+    ASSERT_EQ(view[second.size() + 2].value, second.back());
+
+    auto folder = static_cast<int64_t>(test_spec().playlist_count + 1);
+    auto children = db->get_playlist_folder(PlaylistId{folder});
+    ASSERT_TRUE(children.has_value() && children->size() == 10);
+    ASSERT_EQ((*children)[0].id.value, 0);
+    ASSERT_EQ((*children)[1].id.value, folder + 2);
+    ASSERT_EQ((*children)[9].id.value, folder + 1);
+}
+
+TEST(database_set_federates_exports) {
+    auto second = std::filesystem::temp_directory_path() / "crate_digger_test_set";
+    std::filesystem::remove_all(second);
+    ASSERT_TRUE(synthetic::write_export(second, test_spec()));
+    auto expected = synthetic::expected_export(test_spec());
+
+    DatabaseSetOptions options;
+    options.thread_count = 4;
+    options.load_anlz = true;
+    auto set = DatabaseSet::open({synthetic::pdb_path(synthetic_root()), second / "missing.pdb",
+                                  synthetic::pdb_path(second)},
+                                 options);
+    ASSERT_TRUE(set.has_value());
+    ASSERT_EQ(set->size(), 2u);
+    ASSERT_EQ(set->failures().size(), 1u);
+    ASSERT_TRUE(set->source_path(1) == synthetic::pdb_path(second));
+    ASSERT_EQ(set->track_count(), 2 * expected.tracks.size());
+    ASSERT_EQ(set->member(1).beat_grid_track_count(), expected.tracks.size());
+
+    // Identical libraries share every decoded string
+    auto single = DatabaseSet::open({synthetic::pdb_path(second)});
+    ASSERT_TRUE(single.has_value());
+    ASSERT_EQ(set->shared_string_count(), single->shared_string_count());
+
+    const auto& e = expected.tracks[7];
+    std::vector<SourcedTrack> both = {{0, TrackId{e.id}}, {1, TrackId{e.id}}};
+    ASSERT_TRUE(set->find_tracks_by_isrc(e.isrc) == both);
+    ASSERT_TRUE(set->find_copies({1, TrackId{e.id}}) == both);
+    auto by_title = set->find_tracks_by_title(e.title);
+    ASSERT_TRUE(std::find(by_title.begin(), by_title.end(), both[1]) != by_title.end());
+    ASSERT_EQ(set->get_track_view(both[1])->title, e.title);
+    ASSERT_TRUE(set->get_track_view({2, TrackId{e.id}}) == nullptr);
+    ASSERT_EQ(set->find_tracks_by_bpm_range(0.0f, 1000.0f).size(), set->track_count());
+
+    ASSERT_TRUE(!DatabaseSet::open({second / "missing.pdb"}).has_value());
+}
+
+TEST(decoded_waveform_render_matches_entries) {
+    for (auto style : {WaveformStyle::Blue, WaveformStyle::RGB, WaveformStyle::ThreeBand}) {
+        WaveformData raw;
+        raw.style = style;
+        raw.bytes_per_entry = style == WaveformStyle::Blue ? 1 : style == WaveformStyle::RGB ? 2 : 3;
+        raw.entry_count = 1237;
+        uint32_t seed = 12345;
+        for (size_t i = 0; i < raw.entry_count * raw.bytes_per_entry; ++i) {
+            seed = seed * 1103515245u + 12345u;
+            raw.data.push_back(static_cast<uint8_t>(seed >> 16));
+        }
+
+        DecodedWaveform wave(raw);
+        ASSERT_EQ(wave.size(), raw.size());
+        ASSERT_EQ(wave.level_count(), 12u);  // 1237 entries halve down to 1
+        ASSERT_EQ(wave.level(1).size(), 619u);
+        const auto& entries = wave.entries();
+        for (size_t i = 0; i < raw.size(); ++i) {
+            ASSERT_EQ(entries.max_height[i], raw.height_at(i));
+            if (style == WaveformStyle::RGB) {
+                uint32_t rgb = (uint32_t{entries.red[i]} << 16) | (uint32_t{entries.green[i]} << 8) | entries.blue[i];
+                ASSERT_EQ(rgb, raw.color_at(i));
+            } else if (style == WaveformStyle::ThreeBand) {
+                ASSERT_TRUE(std::make_tuple(entries.low[i], entries.mid[i], entries.high[i]) == raw.bands_at(i));
+            }
+        }
+
+        // Mip-assisted columns equal a direct scan of each column's entries
+        const std::pair<size_t, size_t> ranges[] = {{0, raw.size()}, {3, 1000}, {700, 740}};
+        for (auto [first, last] : ranges) {
+            for (size_t width : {1u, 7u, 100u, 333u, 2000u}) {
+                auto columns = wave.render(first, last, width);
+                ASSERT_EQ(columns.size(), width);
+                size_t n = last - first;
+                for (size_t x = 0; x < width; ++x) {
+                    size_t begin = first + x * n / width;
+                    size_t end = std::max(begin + 1, first + (x + 1) * n / width);
+                    uint8_t lo = 0xFF, hi = 0, low = 0, green = 0;
+                    for (size_t i = begin; i < end; ++i) {
+                        lo = std::min(lo, entries.min_height[i]);
+                        hi = std::max(hi, entries.max_height[i]);
+                        if (style == WaveformStyle::RGB) green = std::max(green, entries.green[i]);
+                        if (style == WaveformStyle::ThreeBand) low = std::max(low, entries.low[i]);
+                    }
+                    ASSERT_EQ(columns.min_height[x], lo);
+                    ASSERT_EQ(columns.max_height[x], hi);
+                    if (style == WaveformStyle::RGB) ASSERT_EQ(columns.green[x], green);
+                    if (style == WaveformStyle::ThreeBand) ASSERT_EQ(columns.low[x], low);
+                }
+            }
+        }
+    }
+    ASSERT_EQ(DecodedWaveform().render(100).size(), 0u);
+}
+
+TEST(tempo_map_matches_beat_grid) {
+    // 120 BPM from 100 ms, starting on beat 3 of a bar, then 128 BPM (468.75 ms beats, stored rounded)
+    BeatGrid grid;
+    for (uint32_t i = 0; i < 32; ++i) {
+        grid.beats.push_back({static_cast<uint16_t>((i + 2) % 4 + 1), 12000, 100 + i * 500});
+    }
+    for (uint32_t i = 0; i < 32; ++i) {
+        auto time = static_cast<uint32_t>(std::lround(16100 + i * 468.75));
+        grid.beats.push_back({static_cast<uint16_t>((i + 2) % 4 + 1), 12800, time});
+    }
+    TempoMap tempo(grid);
+    ASSERT_EQ(tempo.segments().size(), 2u);
+    ASSERT_TRUE(tempo.segments()[0].ms_per_beat == 500.0);
+    ASSERT_TRUE(std::abs(tempo.segments()[1].ms_per_beat - 468.75) < 0.01);
+    ASSERT_TRUE(tempo.bpm_at(20000) == 128.0f);
+
+    for (size_t k = 0; k < grid.size(); ++k) {
+        ASSERT_TRUE(std::abs(tempo.time_to_beat(grid[k].time_ms) - double(k)) < 0.002);
+        ASSERT_TRUE(std::abs(tempo.beat_to_time(double(k)) - grid[k].time_ms) < 1.0);
+    }
+    for (uint32_t t = 100; t < 30000; t += 37) {
+        double beat = tempo.time_to_beat(t);
+        if (std::abs(beat - std::floor(beat) - 0.5) < 0.01) continue;  // Midpoints round either way
+        ASSERT_EQ(static_cast<size_t>(std::lround(beat)), grid.find_beat_at(t));
+    }
+
+    auto pos = tempo.position_at(350.0);
+    ASSERT_TRUE(pos.beat == 0.5 && pos.beat_phase == 0.5);
+    ASSERT_EQ(pos.bar, 0);
+    ASSERT_EQ(pos.beat_in_bar, 3);
+    ASSERT_TRUE(pos.bar_phase == 0.625);
+    pos = tempo.position_at(-1400.0);  // Extrapolated three beats before the grid
+    ASSERT_EQ(pos.bar, -1);
+    ASSERT_EQ(pos.beat_in_bar, 4);
+
+    // Batched conversions equal the scalar ones in any input order, in place too
+    std::vector<double> times;
+    for (int i = 0; i < 101; ++i) times.push_back(-500.0 + ((i * 7919) % 101) * 350.0);
+    std::vector<double> beats(times.size());
+    tempo.times_to_beats(times.data(), times.size(), beats.data());
+    std::vector<double> back = beats;
+    tempo.beats_to_times(back.data(), back.size(), back.data());
+    for (size_t i = 0; i < times.size(); ++i) {
+        ASSERT_TRUE(std::abs(beats[i] - tempo.time_to_beat(times[i])) < 1e-9);
+        ASSERT_TRUE(std::abs(back[i] - times[i]) < 1e-6);
+    }
+
+    std::vector<double> bars(times.size());
+    tempo.quantize(times.data(), times.size(), bars.data(), 4.0);
+    for (size_t i = 0; i < times.size(); ++i) {
+        double beat = tempo.time_to_beat(bars[i]);
+        ASSERT_TRUE(std::abs(beat - 4.0 * std::round(beat / 4.0)) < 1e-6);
+        ASSERT_TRUE(std::abs(beat - tempo.time_to_beat(times[i])) <= 2.0 + 1e-6);
+    }
+
+    TempoMap empty;
+    ASSERT_TRUE(empty.empty() && empty.time_to_beat(1000.0) == 0.0);
+}
+
+TEST(tempo_map_tolerates_out_of_order_segments) {
+    // A corrupt grid whose second tempo run starts before the first one
+    BeatGrid grid;
+    grid.beats = {{1, 12000, 100000}, {2, 12000, 100500}, {3, 13000, 500}, {4, 13000, 960}};
+    TempoMap tempo(grid);
+    ASSERT_EQ(tempo.segments().size(), 2u);
+    for (size_t k = 0; k < grid.size(); ++k) {
+        ASSERT_TRUE(std::abs(tempo.beat_to_time(double(k)) - grid[k].time_ms) < 1e-6);
+    }
+    std::vector<double> times = {0.0, 499.0, 500.0, 960.0, 50000.0, 100000.0, 100250.0, 200000.0};
+    std::vector<double> beats(times.size());
+    tempo.times_to_beats(times.data(), times.size(), beats.data());
+    for (size_t i = 0; i < times.size(); ++i) {
+        ASSERT_TRUE(std::isfinite(beats[i]) && beats[i] == tempo.time_to_beat(times[i]));
+    }
+    ASSERT_TRUE(tempo.bpm_at(200.0) == 120.0f && tempo.bpm_at(100000.0) == 130.0f);
+}
+
+TEST(similarity_index_respects_harmonic_limits) {
+    auto am = camelot_key("Am");
+    ASSERT_TRUE(am.number == 8 && !am.major);
+    ASSERT_TRUE(camelot_key("C").number == 8 && camelot_key("C").major);
+    ASSERT_TRUE(camelot_key("F#m").number == 11 && camelot_key("Dbm").number == 12);
+    ASSERT_TRUE(camelot_key("12b").number == 12 && camelot_key("12b").major && camelot_key("Ebmaj").number == 5);
+    ASSERT_TRUE(!camelot_key("H").valid() && !camelot_key("13A").valid() && !camelot_key("Cx").valid());
+    ASSERT_EQ(camelot_distance(am, camelot_key("C")), 1);
+    ASSERT_EQ(camelot_distance(camelot_key("1A"), camelot_key("12A")), 1);
+    ASSERT_EQ(camelot_distance(am, camelot_key("9B")), 2);
+    ASSERT_EQ(camelot_distance(am, CamelotKey{}), 0xFF);
+
+    auto db = Database::open(synthetic::pdb_path(synthetic_root()));
+    ASSERT_TRUE(db.has_value());
+    db->load_cue_points(synthetic::anlz_dir(synthetic_root()));
+    SimilarityIndex index(*db);
+    auto expected = synthetic::expected_export(test_spec());
+    ASSERT_EQ(index.size(), expected.tracks.size());
+    for (const auto& track : expected.tracks) {
+        // Synthetic key k is Camelot (k + 1) / 2, A for odd k
+        auto f = index.features(TrackId{track.id});
+        ASSERT_TRUE(f.key.number == (track.key_id + 1) / 2 && f.key.major == (track.key_id % 2 == 0));
+        ASSERT_TRUE(std::abs(f.bpm - track.bpm_100x / 100.0f) < 0.01f && f.year == track.year);
+        ASSERT_TRUE(f.energy >= 0.0f && f.energy <= 1.0f && f.mood == 1.0f);
+    }
+    ASSERT_EQ(index.features(TrackId{999999}).id.value, 0);
+
+    // Unlimited hits are exactly the tracks within the limits, closest first; top-k is their prefix
+    TrackId seed{expected.tracks[17].id};
+    auto seed_features = index.features(seed);
+    SimilarityQuery query;
+    query.limit = expected.tracks.size();
+    query.bpm_tolerance = 0.2f;
+    auto all = index.nearest(seed, query);
+    size_t passing = 0;
+    for (const auto& track : expected.tracks) {
+        if (track.id == seed.value) continue;
+        auto f = index.features(TrackId{track.id});
+        double octaves = std::log2(f.bpm / seed_features.bpm);
+        bool bpm_ok = std::abs(octaves - std::nearbyint(octaves)) <= std::log2(1.2) + 1e-6;
+        if (bpm_ok && camelot_distance(f.key, seed_features.key) <= 1) ++passing;
+    }
+    ASSERT_TRUE(passing > 20);
+    ASSERT_EQ(all.size(), passing);
+    for (size_t i = 1; i < all.size(); ++i) ASSERT_TRUE(all[i - 1].distance <= all[i].distance);
+    query.limit = 20;
+    auto top = index.nearest(seed, query);
+    ASSERT_EQ(top.size(), 20u);
+    for (size_t i = 0; i < top.size(); ++i) ASSERT_TRUE(top[i].id == all[i].id);
+
+    // Key weight alone: the distance is the squared Camelot distance
+    SimilarityQuery key_only;
+    key_only.limit = expected.tracks.size();
+    key_only.bpm_tolerance = 0.0f;
+    key_only.max_key_distance = SimilarityQuery::kAnyKey;
+    key_only.weights = SimilarityWeights{0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f};
+    auto by_key = index.nearest(seed, key_only);
+    ASSERT_EQ(by_key.size(), expected.tracks.size() - 1);
+    for (const auto& hit : by_key) {
+        float d = camelot_distance(index.features(hit.id).key, seed_features.key);
+        ASSERT_TRUE(hit.distance == d * d);
+    }
+    ASSERT_TRUE(index.nearest(TrackId{999999}).empty());
+}
+
+#ifdef CRATE_DIGGER_ARROW_EXPORT
+TEST(arrow_export_streams_record_batches) {
+    auto db = Database::open(synthetic::pdb_path(synthetic_root()));
+    ASSERT_TRUE(db.has_value());
+    db->load_cue_points(synthetic::anlz_dir(synthetic_root()));
+
+    auto path = std::filesystem::temp_directory_path() / "crate_digger_test_export.arrow";
+    ArrowExportOptions options;
+    options.batch_rows = 100;
+    auto stats = export_tracks_arrow(*db, path, options);
+    ASSERT_TRUE(stats.has_value());
+    ASSERT_EQ(stats->rows, db->track_count());
+    ASSERT_EQ(stats->batches, (db->track_count() + 99) / 100);
+    ASSERT_EQ(stats->bytes, std::filesystem::file_size(path));
+
+    std::ifstream file(path, std::ios::binary);
+    std::vector<char> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    ASSERT_TRUE(std::memcmp(bytes.data(), "ARROW1", 6) == 0);
+    ASSERT_TRUE(std::memcmp(bytes.data() + bytes.size() - 6, "ARROW1", 6) == 0);
+
+    // Skip the schema message; the first batch body starts with the track_id column
+    auto u32_at = [&bytes](size_t offset) {
+        uint32_t v;
+        std::memcpy(&v, bytes.data() + offset, sizeof(v));
+        return v;
+    };
+    size_t batch = 8 + 8 + u32_at(12);
+    ASSERT_EQ(u32_at(batch), 0xFFFFFFFFu);
+    size_t body = batch + 8 + u32_at(batch + 4);
+    ASSERT_TRUE(body + 16 <= bytes.size());
+    int64_t first_ids[2];
+    std::memcpy(first_ids, bytes.data() + body, sizeof(first_ids));
+    auto ids = db->all_track_ids();
+    ASSERT_EQ(first_ids[0], ids[0].value);
+    ASSERT_EQ(first_ids[1], ids[1].value);
+}
+#endif
+
 } // anonymous namespace
 
 int main() {